@@ -0,0 +1,377 @@
+// ai.c - Enemy behaviour scripts (content.txt "ai" lines) and their VM
+//
+// Every enemy type gets a short list of rules, first one that applies wins:
+//
+//   heal 30 when hp_below 40 once, enrage 50 when hp_below 60 once, attack
+//
+// At startup each list is compiled into fixed 4 byte instructions
+// (op, arg, skip, once slot): a rule is its conditions followed by its
+// action, and a condition that fails skips ahead to the next rule. The
+// compiler always tacks a plain "attack" on the end so every script ends
+// in an action. ai_enemy_turn runs the code with computed gotos (one
+// indirect jump per instruction, no switch in a loop) against an AiState
+// the caller owns, so a turn allocates nothing and costs a few ns on top
+// of the attack itself, which matters for auto-battle and projections
+// that play out millions of fights.
+#include "ai.h"
+#include "content.h"
+#include "rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AI_MAX_ONCE 32 // once_used bits
+
+enum {
+    // conditions: fall through to the next instruction or skip to the next rule
+    AI_OP_HP_BELOW,        // enemy hp under arg % of max
+    AI_OP_PLAYER_HP_BELOW, // player hp under arg % of max
+    AI_OP_CHANCE,          // arg % of the time
+    AI_OP_EVERY,           // every arg'th enemy turn
+    AI_OP_AFTER,           // from enemy turn arg + 1 on
+    AI_OP_NOT_POISONED,    // the player isn't poisoned right now
+    AI_OP_ONCE,            // only the first time the rest of the rule passes
+    // actions: end the turn
+    AI_OP_ATTACK,          // arg % of the enemy's damage
+    AI_OP_HEAL,            // arg % of the enemy's max hp
+    AI_OP_ENRAGE,          // damage goes up by arg % of what it started at
+    AI_OP_FLEE,
+    AI_OP_POISON,          // normal hit, then the player takes damage / 4 for arg turns
+    AI_OP_COUNT
+};
+
+typedef struct {
+    const char *word;
+    int op;
+    bool has_arg;
+} AiWord;
+
+static const AiWord ACTION_WORDS[] = {
+    { "attack", AI_OP_ATTACK, true }, // arg optional, defaults to 100
+    { "heal", AI_OP_HEAL, true },
+    { "enrage", AI_OP_ENRAGE, true },
+    { "flee", AI_OP_FLEE, false },
+    { "poison", AI_OP_POISON, true }
+};
+
+static const AiWord CONDITION_WORDS[] = {
+    { "hp_below", AI_OP_HP_BELOW, true },
+    { "player_hp_below", AI_OP_PLAYER_HP_BELOW, true },
+    { "chance", AI_OP_CHANCE, true },
+    { "every", AI_OP_EVERY, true },
+    { "after", AI_OP_AFTER, true },
+    { "not_poisoned", AI_OP_NOT_POISONED, false },
+    { "once", AI_OP_ONCE, false }
+};
+
+// what every type runs before ai_init (and what "attack" compiles to)
+static const unsigned char PLAIN_CODE[4] = { AI_OP_ATTACK, 100, 0, 0 };
+static const unsigned char PLAIN_CYCLE[1] = { 100 };
+
+static unsigned char g_code[CONTENT_ENEMY_TYPES][AI_CODE_MAX * 4];
+// see ai_attack_cycle, length 0 = the script does more than that
+static unsigned char g_cycle[CONTENT_ENEMY_TYPES][AI_CYCLE_MAX];
+static int g_cycle_length[CONTENT_ENEMY_TYPES];
+static bool g_random[CONTENT_ENEMY_TYPES];
+static bool g_ready = false;
+
+static const AiWord *lookup_word(const char *word, const AiWord *words, int count) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(word, words[i].word) == 0) return &words[i];
+    }
+    return NULL;
+}
+
+// the next token as an argument (0-255), false if it isn't one
+static bool parse_arg(char **save, int *out) {
+    char *token = strtok_r(NULL, " \t", save);
+    if (token == NULL) return false;
+    char *end;
+    long value = strtol(token, &end, 10);
+    if (*end != '\0' || value < 0 || value > 255) return false;
+    *out = (int)value;
+    return true;
+}
+
+static void emit(unsigned char *insn, int op, int arg, int skip, int slot) {
+    insn[0] = (unsigned char)op;
+    insn[1] = (unsigned char)arg;
+    insn[2] = (unsigned char)skip;
+    insn[3] = (unsigned char)slot;
+}
+
+bool ai_compile(const char *script, unsigned char code[AI_CODE_MAX * 4], const char **why) {
+    char text[256];
+    if (strlen(script) >= sizeof(text)) {
+        *why = "ai script too long";
+        return false;
+    }
+    strcpy(text, script);
+
+    int count = 0; // instructions so far
+    int once_slots = 0;
+    char *rule_save;
+    for (char *rule = strtok_r(text, ",", &rule_save); rule != NULL; rule = strtok_r(NULL, ",", &rule_save)) {
+        char *save;
+        char *word = strtok_r(rule, " \t", &save);
+        if (word == NULL) continue; // empty rule, "attack,,flee"
+
+        const AiWord *action = lookup_word(word, ACTION_WORDS, sizeof(ACTION_WORDS) / sizeof(ACTION_WORDS[0]));
+        if (action == NULL) {
+            *why = "unknown ai action (attack, heal, enrage, flee or poison)";
+            return false;
+        }
+        int action_arg = 100;
+        word = strtok_r(NULL, " \t", &save);
+        if (action->has_arg && word != NULL && strcmp(word, "when") != 0) {
+            char *end;
+            long value = strtol(word, &end, 10);
+            if (*end != '\0' || value < 0 || value > 255) {
+                *why = "ai action amounts are 0-255";
+                return false;
+            }
+            action_arg = (int)value;
+            word = strtok_r(NULL, " \t", &save);
+        } else if (action->has_arg && action->op != AI_OP_ATTACK) {
+            *why = "heal, enrage and poison need an amount";
+            return false;
+        }
+
+        // conditions, "once" goes last so it only gets used up when the
+        // rest of the rule passed
+        int conditions[AI_CODE_MAX][2];
+        int condition_count = 0;
+        bool once = false;
+        if (word != NULL && strcmp(word, "when") != 0) {
+            *why = "expected 'when' after the ai action";
+            return false;
+        }
+        while (word != NULL && (word = strtok_r(NULL, " \t", &save)) != NULL) {
+            const AiWord *condition = lookup_word(word, CONDITION_WORDS, sizeof(CONDITION_WORDS) / sizeof(CONDITION_WORDS[0]));
+            int arg = 0;
+            if (condition == NULL || (condition->has_arg && !parse_arg(&save, &arg)) ||
+                (condition->op == AI_OP_EVERY && arg == 0)) {
+                *why = "bad ai condition (hp_below N, player_hp_below N, chance N, every N, after N, not_poisoned, once)";
+                return false;
+            }
+            if (condition->op == AI_OP_ONCE) {
+                once = true;
+            } else if (condition_count < AI_CODE_MAX) {
+                conditions[condition_count][0] = condition->op;
+                conditions[condition_count][1] = arg;
+                condition_count++;
+            }
+        }
+
+        // + the action, and the fallback attack still has to fit after this
+        int length = condition_count + (once ? 1 : 0) + 1;
+        if (count + length + 1 > AI_CODE_MAX) {
+            *why = "ai script too long";
+            return false;
+        }
+        if (once && once_slots >= AI_MAX_ONCE) {
+            *why = "too many 'once' rules";
+            return false;
+        }
+        for (int i = 0; i < condition_count; i++) {
+            emit(&code[(count + i) * 4], conditions[i][0], conditions[i][1], length - i, 0);
+        }
+        if (once) {
+            emit(&code[(count + condition_count) * 4], AI_OP_ONCE, 0, 2, once_slots++);
+        }
+        emit(&code[(count + length - 1) * 4], action->op, action->op == AI_OP_FLEE ? 0 : action_arg, 0, 0);
+        count += length;
+    }
+
+    memcpy(&code[count * 4], PLAIN_CODE, sizeof(PLAIN_CODE));
+    return true;
+}
+
+// instructions that can ever run: up to the first rule without
+// conditions (the tacked on "attack" at the latest)
+static int code_length(const unsigned char *code) {
+    bool conditions = false;
+    for (int i = 0; i < AI_CODE_MAX; i++) {
+        int op = code[i * 4];
+        if (op < AI_OP_ATTACK) {
+            conditions = true;
+        } else if (!conditions) {
+            return i + 1;
+        } else {
+            conditions = false;
+        }
+    }
+    return AI_CODE_MAX;
+}
+
+static bool code_is_random(const unsigned char *code) {
+    int length = code_length(code);
+    for (int i = 0; i < length; i++) {
+        if (code[i * 4] == AI_OP_CHANCE) return true;
+    }
+    return false;
+}
+
+// Fill cycle with the attack % for enemy turns 1..N if the script only
+// picks between attacks by turn number, returns N (the lcm of the
+// "every"s) or 0 if it looks at anything else or takes too long to repeat
+static int code_attack_cycle(const unsigned char *code, unsigned char cycle[AI_CYCLE_MAX]) {
+    int length = code_length(code);
+    int period = 1;
+    for (int i = 0; i < length; i++) {
+        int op = code[i * 4];
+        if (op == AI_OP_EVERY) {
+            int a = period, b = code[i * 4 + 1];
+            while (b != 0) {
+                int t = a % b;
+                a = b;
+                b = t;
+            }
+            period = period / a * code[i * 4 + 1];
+            if (period > AI_CYCLE_MAX) return 0;
+        } else if (op != AI_OP_ATTACK) {
+            return 0;
+        }
+    }
+
+    // let the script itself say what each turn does, an enemy with 100
+    // damage hits for exactly the %
+    for (int turn = 1; turn <= period; turn++) {
+        AiState state;
+        memset(&state, 0, sizeof(state));
+        state.code = code;
+        state.base_damage = 100;
+        state.damage = 100;
+        state.turn = turn - 1;
+        int amount = 0;
+        ai_enemy_turn(&state, 1, 1, 1, 1, &amount);
+        cycle[turn - 1] = (unsigned char)amount;
+    }
+    return period;
+}
+
+bool ai_init() {
+    const ContentTables *content = content_get();
+    for (int type = 0; type < CONTENT_ENEMY_TYPES; type++) {
+        const char *why = NULL;
+        if (!ai_compile(content->ai_scripts[type], g_code[type], &why)) {
+            fprintf(stderr, "Error: %s's ai script: %s\n", content->enemies[type].name, why);
+            ai_shutdown();
+            return false;
+        }
+        g_cycle_length[type] = code_attack_cycle(g_code[type], g_cycle[type]);
+        g_random[type] = code_is_random(g_code[type]);
+    }
+    g_ready = true;
+    return true;
+}
+
+void ai_shutdown() {
+    g_ready = false;
+}
+
+static const unsigned char *code_for(enum EnemyType type) {
+    if (!g_ready || (int)type < 0 || (int)type >= CONTENT_ENEMY_TYPES) return PLAIN_CODE;
+    return g_code[type];
+}
+
+bool ai_is_plain(enum EnemyType type) {
+    const unsigned char *code = code_for(type);
+    return code[0] == AI_OP_ATTACK && code[1] == 100;
+}
+
+int ai_attack_cycle(enum EnemyType type, const unsigned char **percent) {
+    if (!g_ready || (int)type < 0 || (int)type >= CONTENT_ENEMY_TYPES) {
+        *percent = PLAIN_CYCLE;
+        return 1;
+    }
+    *percent = g_cycle[type];
+    return g_cycle_length[type];
+}
+
+bool ai_is_random(enum EnemyType type) {
+    if (!g_ready || (int)type < 0 || (int)type >= CONTENT_ENEMY_TYPES) return false;
+    return g_random[type];
+}
+
+void ai_begin(AiState *state, const Enemy *enemy, unsigned int seed) {
+    memset(state, 0, sizeof(AiState));
+    state->code = code_for(enemy->type);
+    state->base_damage = enemy->damage;
+    state->damage = enemy->damage;
+    state->rng = rng_seed(seed);
+}
+
+int ai_poison_tick(AiState *state) {
+    if (state->poison_turns <= 0) return 0;
+    state->poison_turns--;
+    return state->poison_damage;
+}
+
+AiAction ai_enemy_turn(AiState *state, int enemy_hp, int enemy_max_hp,
+                       int player_hp, int player_max_hp, int *amount) {
+    static const void *const dispatch[AI_OP_COUNT] = {
+        [AI_OP_HP_BELOW] = &&op_hp_below,
+        [AI_OP_PLAYER_HP_BELOW] = &&op_player_hp_below,
+        [AI_OP_CHANCE] = &&op_chance,
+        [AI_OP_EVERY] = &&op_every,
+        [AI_OP_AFTER] = &&op_after,
+        [AI_OP_NOT_POISONED] = &&op_not_poisoned,
+        [AI_OP_ONCE] = &&op_once,
+        [AI_OP_ATTACK] = &&op_attack,
+        [AI_OP_HEAL] = &&op_heal,
+        [AI_OP_ENRAGE] = &&op_enrage,
+        [AI_OP_FLEE] = &&op_flee,
+        [AI_OP_POISON] = &&op_poison
+    };
+    const unsigned char *ip = state->code;
+    int turn = ++state->turn;
+
+// a condition: next instruction if it holds, next rule if not
+#define AI_NEXT() goto *dispatch[ip[0]]
+#define AI_TEST(holds) do { ip += (holds) ? 4 : ip[2] * 4; AI_NEXT(); } while (0)
+
+    AI_NEXT();
+
+op_hp_below:
+    AI_TEST(enemy_hp * 100 < enemy_max_hp * ip[1]);
+op_player_hp_below:
+    AI_TEST(player_hp * 100 < player_max_hp * ip[1]);
+op_chance:
+    AI_TEST(rng_range(&state->rng, 100) < ip[1]);
+op_every:
+    AI_TEST(turn % ip[1] == 0);
+op_after:
+    AI_TEST(turn > ip[1]);
+op_not_poisoned:
+    AI_TEST(state->poison_turns == 0);
+op_once:
+    if (state->once_used & (1u << ip[3])) AI_TEST(false);
+    state->once_used |= 1u << ip[3];
+    AI_TEST(true);
+
+op_attack:
+    *amount = state->damage * ip[1] / 100;
+    return AI_ATTACK;
+op_heal: {
+    int heal = enemy_max_hp * ip[1] / 100;
+    int missing = enemy_max_hp - enemy_hp;
+    *amount = heal < missing ? heal : missing;
+    return AI_HEAL;
+}
+op_enrage:
+    state->damage += state->base_damage * ip[1] / 100;
+    *amount = state->damage;
+    return AI_ENRAGE;
+op_flee:
+    *amount = 0;
+    return AI_FLEE;
+op_poison:
+    state->poison_turns = ip[1];
+    state->poison_damage = state->damage / 4 > 0 ? state->damage / 4 : 1;
+    *amount = state->damage;
+    return AI_POISON;
+
+#undef AI_TEST
+#undef AI_NEXT
+}
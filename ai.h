@@ -0,0 +1,74 @@
+// ai.h - Enemy behaviour scripts (content.txt "ai" lines) and their VM
+#ifndef AI_H
+#define AI_H
+
+#include <stdbool.h>
+#include "enemy.h"
+
+// most instructions one enemy type's script can compile to (4 bytes each)
+#define AI_CODE_MAX 64
+
+// longest attack cycle ai_attack_cycle works out (turns before it repeats)
+#define AI_CYCLE_MAX 64
+
+// what the enemy does with its turn
+typedef enum {
+    AI_ATTACK,  // amount = damage to the player
+    AI_HEAL,    // amount = hp the enemy got back
+    AI_ENRAGE,  // amount = the enemy's damage from now on
+    AI_FLEE,    // the fight is over, nobody wins
+    AI_POISON   // amount = damage to the player, who is poisoned too
+} AiAction;
+
+// Everything the script remembers during one fight. Lives wherever the
+// fight does (on the stack is fine), nothing is allocated
+typedef struct {
+    const unsigned char *code; // the enemy type's compiled script
+    int base_damage;           // enemy->damage when the fight started
+    int damage;                // after enrages
+    int turn;                  // enemy turns so far
+    unsigned int once_used;    // one bit per "once" rule that has fired
+    int poison_turns;          // left on the player
+    int poison_damage;         // per turn
+    unsigned int rng;          // for "chance" (see rng.h)
+} AiState;
+
+// compile every enemy type's script from the current content tables
+// (call after content_load, read-only after this)
+bool ai_init();
+
+// back to plain attacks for everyone
+void ai_shutdown();
+
+// Compile one script (the rules of an ai line joined by commas) into code.
+// returns false and points *why at the reason if it doesn't parse
+bool ai_compile(const char *script, unsigned char code[AI_CODE_MAX * 4], const char **why);
+
+// true if the type just attacks for its damage every turn
+bool ai_is_plain(enum EnemyType type);
+
+// If the type only ever attacks, picking how hard by turn number ("attack
+// 150 when every 3, attack"), fights against it can be worked out without
+// playing them. Points *percent at the % of its damage it hits for on each
+// turn (turn t uses (*percent)[(t - 1) % length]) and returns the length,
+// 0 if the script looks at hp, rolls dice, heals, poisons or flees.
+// A plain attacker is length 1 at 100%
+int ai_attack_cycle(enum EnemyType type, const unsigned char **percent);
+
+// true if the type's script rolls dice ("chance"), so two fights from the
+// same start can end differently
+bool ai_is_random(enum EnemyType type);
+
+// get ready for a fight against enemy, seed feeds the "chance" rolls
+void ai_begin(AiState *state, const Enemy *enemy, unsigned int seed);
+
+// Poison ticking on the player at the start of the enemy's turn, returns
+// the damage (0 once it has worn off)
+int ai_poison_tick(AiState *state);
+
+// Run the script for one enemy turn and say what the enemy does. The
+// caller applies *amount (see AiAction) since it knows where the hp lives
+AiAction ai_enemy_turn(AiState *state, int enemy_hp, int enemy_max_hp,
+                       int player_hp, int player_max_hp, int *amount);
+
+#endif // AI_H
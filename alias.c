@@ -0,0 +1,77 @@
+// alias.c - Vose's alias method
+//
+// Everything is done in integers so the table is exact: each weight is
+// scaled by count, which makes the average column exactly the total weight.
+// Columns under the average get topped up from one over it, and whatever is
+// left over at the end is full (aliased to itself so both branches agree).
+#include "alias.h"
+#include <stdlib.h>
+
+bool alias_build(AliasTable *table, const int *weights, int count) {
+    table->count = 0;
+    table->threshold = NULL;
+    table->alias = NULL;
+    if (weights == NULL || count <= 0) return false;
+
+    int64_t total = 0;
+    for (int i = 0; i < count; i++) {
+        if (weights[i] < 0) return false;
+        total += weights[i];
+    }
+    if (total == 0 || total > INT32_MAX) return false; // keeps the math below in 64 bits
+
+    int64_t *scaled = malloc(sizeof(int64_t) * count);
+    int *small = malloc(sizeof(int) * count);
+    int *large = malloc(sizeof(int) * count);
+    table->threshold = malloc(sizeof(uint32_t) * count);
+    table->alias = malloc(sizeof(int) * count);
+    bool ok = scaled != NULL && small != NULL && large != NULL &&
+              table->threshold != NULL && table->alias != NULL;
+
+    if (ok) {
+        int small_count = 0, large_count = 0;
+        for (int i = 0; i < count; i++) {
+            scaled[i] = (int64_t)weights[i] * count;
+            if (scaled[i] < total) small[small_count++] = i;
+            else large[large_count++] = i;
+        }
+
+        while (small_count > 0 && large_count > 0) {
+            int less = small[--small_count];
+            int more = large[--large_count];
+            // less keeps scaled/total of its column, more fills the rest
+            table->threshold[less] = (uint32_t)(((uint64_t)scaled[less] << 32) / (uint64_t)total);
+            table->alias[less] = more;
+            scaled[more] -= total - scaled[less];
+            if (scaled[more] < total) small[small_count++] = more;
+            else large[large_count++] = more;
+        }
+        // leftovers are full columns (small ones only from rounding, which
+        // can't happen with integers, but be safe)
+        while (large_count > 0) {
+            int i = large[--large_count];
+            table->threshold[i] = UINT32_MAX;
+            table->alias[i] = i;
+        }
+        while (small_count > 0) {
+            int i = small[--small_count];
+            table->threshold[i] = UINT32_MAX;
+            table->alias[i] = i;
+        }
+        table->count = count;
+    }
+
+    free(scaled);
+    free(small);
+    free(large);
+    if (!ok) alias_free(table);
+    return ok;
+}
+
+void alias_free(AliasTable *table) {
+    free(table->threshold);
+    free(table->alias);
+    table->threshold = NULL;
+    table->alias = NULL;
+    table->count = 0;
+}
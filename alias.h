@@ -0,0 +1,31 @@
+// alias.h - O(1) weighted random picks (Vose's alias method)
+#ifndef ALIAS_H
+#define ALIAS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Built once from a list of weights, then every pick is two random
+// numbers, one multiply and one compare no matter how many entries
+// there are. Column i keeps i with probability threshold[i] / 2^32
+// and hands out alias[i] otherwise.
+typedef struct {
+    int count;
+    uint32_t *threshold;
+    int *alias;
+} AliasTable;
+
+// weights must be >= 0 with at least one > 0 and the total has to fit in
+// an int, returns false otherwise
+// (or if malloc fails). Free with alias_free
+bool alias_build(AliasTable *table, const int *weights, int count);
+
+void alias_free(AliasTable *table);
+
+// pick an index 0..count-1, a and b are two independent random numbers
+static inline int alias_pick(const AliasTable *table, uint32_t a, uint32_t b) {
+    int column = (int)(((uint64_t)a * (uint32_t)table->count) >> 32);
+    return b < table->threshold[column] ? column : table->alias[column];
+}
+
+#endif // ALIAS_H
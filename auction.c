@@ -0,0 +1,1162 @@
+// auction.c - Player auction house (order books + matching)
+//
+// One order book per item prototype (the item's name), bids in a max heap
+// and asks in a min heap ordered by price and then arrival, so the best
+// price always trades first and ties go to whoever was there first.
+//
+// Session threads never touch the books. auction_submit pushes the order
+// onto a lock-free stack (one CAS), and auction_pump swaps the whole stack
+// out, flips it back into arrival order and matches it, on whichever
+// thread calls it, under the one lock the books have.
+//
+// Nobody's save gets touched by a trade. Gold and items escrowed with an
+// order come back (as proceeds, purchases or refunds) into a per player
+// ledger, which auction_collect hands over next time they drop by.
+//
+// The two things that do touch a save (escrow going in with an order, a
+// collect handing things out) are "steps". Each one is journaled before
+// the player is changed and saved, the ledger counts them and remembers
+// what the last one did, and the save keeps the count (auction_seq). A
+// crash between the journal write and the save leaves the save one step
+// behind, and auction_reconcile does that step again at the next login.
+//
+// On disk: a snapshot of the resting orders and ledgers, plus a journal
+// of every command in the order it was applied, written once per pump.
+// Matching is deterministic, so replaying the journal rebuilds the exact
+// same books. The books belong to one game process at a time.
+#include "auction.h"
+#include "storage.h"
+#include "items.h"
+#include "utils.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JOURNAL_SUFFIX ".journal"
+#define SNAPSHOT_HEADER "# auction v1\n"
+#define BOOK_BUCKETS 1024
+#define ORDER_BUCKETS 65536 // by id, ids are sequential so no hashing needed
+#define LEDGER_BUCKETS 1024
+#define LINE_MAX_LENGTH (AUCTION_ITEM_LENGTH + SAVE_RECORD_NAME_LENGTH + 96)
+
+extern char saveFileName[MAX_FILENAME_LENGTH];
+
+typedef enum {
+    COMMAND_ORDER,
+    COMMAND_CANCEL
+} CommandKind;
+
+// a queued command, an order that rests on a book stays in the same node
+typedef struct AuctionOrder {
+    CommandKind kind;
+    unsigned long long id;
+    unsigned long long seq; // arrival at the matcher, breaks price ties
+    AuctionSide side;
+    int price;      // limit, gold per item
+    int quantity;   // still open (0 = filled or cancelled, heap drops it lazily)
+    int item_value;
+    char player[SAVE_RECORD_NAME_LENGTH];
+    char item[AUCTION_ITEM_LENGTH];
+    struct AuctionOrder *next;    // submission stack
+    struct AuctionOrder *id_next; // orders by id
+} AuctionOrder;
+
+typedef struct {
+    AuctionOrder **orders;
+    int count;
+    int capacity;
+} OrderHeap;
+
+typedef struct Book {
+    char item[AUCTION_ITEM_LENGTH];
+    OrderHeap bids;
+    OrderHeap asks;
+    int bid_orders; // live ones (the heaps can hold dead ones too)
+    int ask_orders;
+    int last_price;
+    struct Book *next;
+} Book;
+
+typedef struct {
+    char item[AUCTION_ITEM_LENGTH];
+    int value;
+    int count;
+} OwedItem;
+
+typedef struct Ledger {
+    char player[SAVE_RECORD_NAME_LENGTH];
+    int gold;
+    OwedItem *items;
+    int item_count;
+    int item_capacity;
+    unsigned int seq;      // steps so far
+    int last_gold;         // what the last step did to their gold
+    OwedItem *last_items;  // and inventory (count < 0 = went into escrow)
+    int last_item_count;
+    int last_item_capacity;
+    struct Ledger *next;
+} Ledger;
+
+typedef struct {
+    pthread_mutex_t lock;         // books, ledgers, journal
+    AuctionOrder *queue;          // lock-free submission stack (newest first)
+    unsigned long long next_id;   // atomic
+    unsigned long long next_seq;
+    Book *books[BOOK_BUCKETS];
+    AuctionOrder *by_id[ORDER_BUCKETS];
+    Ledger *ledgers[LEDGER_BUCKETS];
+    char *journal;                // lines waiting for the next write
+    size_t journal_len;
+    size_t journal_capacity;
+    bool replaying;               // loading, dont journal what we apply
+    bool ready;
+} AuctionHouse;
+
+static AuctionHouse g_auction = { .lock = PTHREAD_MUTEX_INITIALIZER, .next_id = 1 };
+
+// FNV-1a like everywhere else
+static unsigned int hash_string(const char *text) {
+    unsigned int h = 2166136261u;
+    for (; *text; text++) {
+        h ^= (unsigned char)*text;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// ---------------------------------------------------------------------
+// Heaps
+// ---------------------------------------------------------------------
+
+// should a come off the heap before b? best price, then first in
+static bool order_before(AuctionSide side, const AuctionOrder *a, const AuctionOrder *b) {
+    if (a->price != b->price) return side == AUCTION_BUY ? a->price > b->price : a->price < b->price;
+    return a->seq < b->seq;
+}
+
+static bool heap_push(OrderHeap *heap, AuctionSide side, AuctionOrder *order) {
+    if (heap->count == heap->capacity) {
+        int capacity = heap->capacity == 0 ? 16 : heap->capacity * 2;
+        AuctionOrder **orders = realloc(heap->orders, sizeof(AuctionOrder *) * capacity);
+        if (orders == NULL) return false;
+        heap->orders = orders;
+        heap->capacity = capacity;
+    }
+    int i = heap->count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!order_before(side, order, heap->orders[parent])) break;
+        heap->orders[i] = heap->orders[parent];
+        i = parent;
+    }
+    heap->orders[i] = order;
+    return true;
+}
+
+static void heap_pop(OrderHeap *heap, AuctionSide side) {
+    if (heap->count == 0) return;
+    AuctionOrder *last = heap->orders[--heap->count];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && order_before(side, heap->orders[child + 1], heap->orders[child])) child++;
+        if (!order_before(side, heap->orders[child], last)) break;
+        heap->orders[i] = heap->orders[child];
+        i = child;
+    }
+    if (heap->count > 0) heap->orders[i] = last;
+}
+
+// best live order, dead ones (filled/cancelled) get dropped on the way
+static AuctionOrder *heap_top(OrderHeap *heap, AuctionSide side) {
+    while (heap->count > 0 && heap->orders[0]->quantity == 0) {
+        AuctionOrder *dead = heap->orders[0];
+        heap_pop(heap, side);
+        free(dead);
+    }
+    return heap->count > 0 ? heap->orders[0] : NULL;
+}
+
+static void heap_free(OrderHeap *heap) {
+    for (int i = 0; i < heap->count; i++) free(heap->orders[i]);
+    free(heap->orders);
+    memset(heap, 0, sizeof(*heap));
+}
+
+// ---------------------------------------------------------------------
+// Books, orders by id, ledgers (caller holds the lock for all of these)
+// ---------------------------------------------------------------------
+
+static Book *find_book(const char *item, bool create) {
+    unsigned int slot = hash_string(item) % BOOK_BUCKETS;
+    for (Book *book = g_auction.books[slot]; book != NULL; book = book->next) {
+        if (strcmp(book->item, item) == 0) return book;
+    }
+    if (!create) return NULL;
+    Book *book = calloc(1, sizeof(Book));
+    if (book == NULL) return NULL;
+    strncpy(book->item, item, AUCTION_ITEM_LENGTH - 1);
+    book->next = g_auction.books[slot];
+    g_auction.books[slot] = book;
+    return book;
+}
+
+static void add_by_id(AuctionOrder *order) {
+    unsigned int slot = (unsigned int)(order->id % ORDER_BUCKETS);
+    order->id_next = g_auction.by_id[slot];
+    g_auction.by_id[slot] = order;
+}
+
+static AuctionOrder *take_by_id(unsigned long long id) {
+    AuctionOrder **link = &g_auction.by_id[id % ORDER_BUCKETS];
+    for (; *link != NULL; link = &(*link)->id_next) {
+        if ((*link)->id == id) {
+            AuctionOrder *order = *link;
+            *link = order->id_next;
+            return order;
+        }
+    }
+    return NULL;
+}
+
+static Ledger *find_ledger(const char *player, bool create) {
+    unsigned int slot = hash_string(player) % LEDGER_BUCKETS;
+    for (Ledger *ledger = g_auction.ledgers[slot]; ledger != NULL; ledger = ledger->next) {
+        if (strcmp(ledger->player, player) == 0) return ledger;
+    }
+    if (!create) return NULL;
+    Ledger *ledger = calloc(1, sizeof(Ledger));
+    if (ledger == NULL) return NULL;
+    strncpy(ledger->player, player, SAVE_RECORD_NAME_LENGTH - 1);
+    ledger->next = g_auction.ledgers[slot];
+    g_auction.ledgers[slot] = ledger;
+    return ledger;
+}
+
+static void owe_gold(const char *player, int gold) {
+    if (gold <= 0) return;
+    Ledger *ledger = find_ledger(player, true);
+    if (ledger != NULL) ledger->gold += gold;
+}
+
+// count more of an item in a list, same name and value share an entry
+static void add_items(OwedItem **items, int *item_count, int *item_capacity,
+                      const char *item, int value, int count) {
+    for (int i = 0; i < *item_count; i++) {
+        if ((*items)[i].value == value && strcmp((*items)[i].item, item) == 0) {
+            (*items)[i].count += count;
+            return;
+        }
+    }
+    if (*item_count == *item_capacity) {
+        int capacity = *item_capacity == 0 ? 4 : *item_capacity * 2;
+        OwedItem *bigger = realloc(*items, sizeof(OwedItem) * capacity);
+        if (bigger == NULL) return;
+        *items = bigger;
+        *item_capacity = capacity;
+    }
+    OwedItem *owed = &(*items)[(*item_count)++];
+    memset(owed, 0, sizeof(*owed));
+    strncpy(owed->item, item, AUCTION_ITEM_LENGTH - 1);
+    owed->value = value;
+    owed->count = count;
+}
+
+static void owe_items(const char *player, const char *item, int value, int count) {
+    Ledger *ledger = find_ledger(player, true);
+    if (ledger == NULL || count <= 0) return;
+    add_items(&ledger->items, &ledger->item_count, &ledger->item_capacity, item, value, count);
+}
+
+// a new step for this player, forget what the last one did
+static void begin_step(Ledger *ledger) {
+    ledger->seq++;
+    ledger->last_gold = 0;
+    ledger->last_item_count = 0;
+}
+
+static void step_items(Ledger *ledger, const char *item, int value, int count) {
+    add_items(&ledger->last_items, &ledger->last_item_count, &ledger->last_item_capacity, item, value, count);
+}
+
+// ---------------------------------------------------------------------
+// Journal
+// ---------------------------------------------------------------------
+
+static void journal_line(const char *line, int len) {
+    if (g_auction.replaying || len <= 0) return;
+    if (g_auction.journal_len + (size_t)len > g_auction.journal_capacity) {
+        size_t capacity = g_auction.journal_capacity == 0 ? 4096 : g_auction.journal_capacity * 2;
+        while (capacity < g_auction.journal_len + (size_t)len) capacity *= 2;
+        char *bigger = realloc(g_auction.journal, capacity);
+        if (bigger == NULL) {
+            fprintf(stderr, "Error: Out of memory for the auction journal.\n");
+            return;
+        }
+        g_auction.journal = bigger;
+        g_auction.journal_capacity = capacity;
+    }
+    memcpy(g_auction.journal + g_auction.journal_len, line, (size_t)len);
+    g_auction.journal_len += (size_t)len;
+}
+
+// everything applied since the last flush goes out in one append
+static void journal_flush() {
+    if (g_auction.journal_len == 0) return;
+    StorageBackend *store = storage_active();
+    if (!store->append(store, AUCTION_FILE JOURNAL_SUFFIX, g_auction.journal, g_auction.journal_len)) {
+        fprintf(stderr, "Error: Could not write the auction journal.\n");
+    }
+    g_auction.journal_len = 0;
+}
+
+// "O,id,side,price,quantity,value,item,player" (player last, it can have commas)
+static int format_order(char *out, size_t size, char tag, const AuctionOrder *order) {
+    if (tag == 'R') {
+        return snprintf(out, size, "R,%llu,%llu,%d,%d,%d,%d,%s,%s\n", order->id, order->seq, (int)order->side,
+                        order->price, order->quantity, order->item_value, order->item, order->player);
+    }
+    return snprintf(out, size, "O,%llu,%d,%d,%d,%d,%s,%s\n", order->id, (int)order->side, order->price,
+                    order->quantity, order->item_value, order->item, order->player);
+}
+
+// ---------------------------------------------------------------------
+// Matching
+// ---------------------------------------------------------------------
+
+// q items at price p: seller gets the gold, buyer gets the items plus
+// back whatever they offered over p
+static void settle(const AuctionOrder *buy, const AuctionOrder *sell, int quantity, int price) {
+    owe_gold(sell->player, price * quantity);
+    owe_gold(buy->player, (buy->price - price) * quantity);
+    owe_items(buy->player, sell->item, sell->item_value, quantity);
+}
+
+// put a resting order on its book as is (no matching)
+static bool rest_order(Book *book, AuctionOrder *order) {
+    OrderHeap *heap = order->side == AUCTION_BUY ? &book->bids : &book->asks;
+    if (!heap_push(heap, order->side, order)) return false;
+    add_by_id(order);
+    if (order->side == AUCTION_BUY) book->bid_orders++;
+    else book->ask_orders++;
+    return true;
+}
+
+// match an incoming order against the other side, rest what's left
+static void apply_order(AuctionOrder *order) {
+    // the escrow leaving their save is the player's step
+    Ledger *ledger = find_ledger(order->player, true);
+    if (ledger != NULL) {
+        begin_step(ledger);
+        if (order->side == AUCTION_BUY) ledger->last_gold = -order->price * order->quantity;
+        else step_items(ledger, order->item, order->item_value, -order->quantity);
+    }
+
+    Book *book = find_book(order->item, true);
+    if (book == NULL) {
+        // cant even make a book, give the escrow back
+        if (order->side == AUCTION_BUY) owe_gold(order->player, order->price * order->quantity);
+        else owe_items(order->player, order->item, order->item_value, order->quantity);
+        free(order);
+        return;
+    }
+
+    bool buying = order->side == AUCTION_BUY;
+    AuctionSide other_side = buying ? AUCTION_SELL : AUCTION_BUY;
+    OrderHeap *other = buying ? &book->asks : &book->bids;
+    while (order->quantity > 0) {
+        AuctionOrder *best = heap_top(other, other_side);
+        if (best == NULL) break;
+        if (buying ? best->price > order->price : best->price < order->price) break;
+
+        // trades at the resting order's price
+        int quantity = best->quantity < order->quantity ? best->quantity : order->quantity;
+        if (buying) settle(order, best, quantity, best->price);
+        else settle(best, order, quantity, best->price);
+        book->last_price = best->price;
+        best->quantity -= quantity;
+        order->quantity -= quantity;
+        if (best->quantity == 0) {
+            take_by_id(best->id);
+            heap_pop(other, other_side);
+            free(best);
+            if (buying) book->ask_orders--;
+            else book->bid_orders--;
+        }
+    }
+
+    if (order->quantity == 0) {
+        free(order);
+        return;
+    }
+    order->seq = g_auction.next_seq++;
+    if (!rest_order(book, order)) {
+        if (buying) owe_gold(order->player, order->price * order->quantity);
+        else owe_items(order->player, order->item, order->item_value, order->quantity);
+        free(order);
+    }
+}
+
+// pull an order off its book and hand the escrow back
+static void apply_cancel(unsigned long long id, const char *player) {
+    AuctionOrder *order = take_by_id(id);
+    if (order == NULL) return; // already filled or cancelled
+    if (strcmp(order->player, player) != 0) {
+        add_by_id(order); // not theirs to cancel
+        return;
+    }
+
+    Book *book = find_book(order->item, false);
+    if (order->side == AUCTION_BUY) {
+        owe_gold(order->player, order->price * order->quantity);
+        if (book != NULL) book->bid_orders--;
+    } else {
+        owe_items(order->player, order->item, order->item_value, order->quantity);
+        if (book != NULL) book->ask_orders--;
+    }
+    order->quantity = 0; // the heap frees it when it gets to the top
+}
+
+// run one queued command
+static void apply_command(AuctionOrder *command) {
+    char line[LINE_MAX_LENGTH];
+    if (command->kind == COMMAND_CANCEL) {
+        journal_line(line, snprintf(line, sizeof(line), "X,%llu,%s\n", command->id, command->player));
+        apply_cancel(command->id, command->player);
+        free(command);
+    } else {
+        journal_line(line, format_order(line, sizeof(line), 'O', command));
+        apply_order(command);
+    }
+}
+
+// hand over up to max_items items (player NULL = replaying, just drop them)
+// it's a step either way. returns gold + items handed over
+static int take_owed(Ledger *ledger, int max_items, Player *player) {
+    begin_step(ledger);
+    ledger->last_gold = ledger->gold;
+    int handed = ledger->gold;
+    if (player != NULL && ledger->gold > 0) {
+        player->gold += ledger->gold;
+        mark_player_dirty(player, DIRTY_GOLD);
+    }
+    ledger->gold = 0;
+
+    int kept = 0;
+    for (int i = 0; i < ledger->item_count; i++) {
+        OwedItem *owed = &ledger->items[i];
+        int taken = 0;
+        while (owed->count > 0 && max_items > 0) {
+            if (player != NULL) {
+                Item *item = create_item(HEALING, "%s", owed->item, owed->value);
+                if (item == NULL) break;
+                mark_inventory_dirty(player, player->inventory_size);
+                player->inventory[player->inventory_size++] = item;
+            }
+            owed->count--;
+            max_items--;
+            taken++;
+        }
+        if (taken > 0) step_items(ledger, owed->item, owed->value, taken);
+        handed += taken;
+        if (owed->count > 0) ledger->items[kept++] = *owed;
+    }
+    ledger->item_count = kept;
+    return handed;
+}
+
+// ---------------------------------------------------------------------
+// Loading and saving
+// ---------------------------------------------------------------------
+
+// split off a field ending in ',' (the last field runs to the end)
+static char *next_field(char **cursor) {
+    char *field = *cursor;
+    char *comma = strchr(field, ',');
+    if (comma != NULL) {
+        *comma = '\0';
+        *cursor = comma + 1;
+    } else {
+        *cursor = field + strlen(field);
+    }
+    return field;
+}
+
+static AuctionOrder *parse_order(char *cursor, bool resting) {
+    AuctionOrder *order = calloc(1, sizeof(AuctionOrder));
+    if (order == NULL) return NULL;
+    order->kind = COMMAND_ORDER;
+    order->id = strtoull(next_field(&cursor), NULL, 10);
+    if (resting) order->seq = strtoull(next_field(&cursor), NULL, 10);
+    order->side = atoi(next_field(&cursor)) == AUCTION_SELL ? AUCTION_SELL : AUCTION_BUY;
+    order->price = atoi(next_field(&cursor));
+    order->quantity = atoi(next_field(&cursor));
+    order->item_value = atoi(next_field(&cursor));
+    strncpy(order->item, next_field(&cursor), AUCTION_ITEM_LENGTH - 1);
+    strncpy(order->player, cursor, SAVE_RECORD_NAME_LENGTH - 1);
+    if (order->id == 0 || order->price <= 0 || order->quantity <= 0 ||
+        order->item[0] == '\0' || order->player[0] == '\0') {
+        free(order);
+        return NULL;
+    }
+    if (order->id >= g_auction.next_id) g_auction.next_id = order->id + 1;
+    if (resting && order->seq >= g_auction.next_seq) g_auction.next_seq = order->seq + 1;
+    return order;
+}
+
+// apply a snapshot or journal, caller holds the lock
+static void apply_lines(char *data) {
+    char *save_ptr = NULL;
+    for (char *line = strtok_r(data, "\n", &save_ptr); line != NULL; line = strtok_r(NULL, "\n", &save_ptr)) {
+        if (line[0] == '#' || line[0] == '\0' || line[1] != ',') continue;
+        char *cursor = line + 2;
+        bool ok = true;
+        switch (line[0]) {
+            case 'O': // new order, matched like the first time
+            case 'R': { // resting order from a snapshot, straight onto the book
+                AuctionOrder *order = parse_order(cursor, line[0] == 'R');
+                Book *book = order != NULL ? find_book(order->item, true) : NULL;
+                ok = book != NULL;
+                if (!ok) free(order);
+                else if (line[0] == 'O') apply_order(order);
+                else if (!rest_order(book, order)) free(order);
+                break;
+            }
+            case 'X': { // cancel
+                unsigned long long id = strtoull(next_field(&cursor), NULL, 10);
+                apply_cancel(id, cursor);
+                break;
+            }
+            case 'C': { // collect
+                int max_items = atoi(next_field(&cursor));
+                Ledger *ledger = find_ledger(cursor, false);
+                if (ledger != NULL) take_owed(ledger, max_items, NULL);
+                break;
+            }
+            case 'G': { // owed gold
+                int gold = atoi(next_field(&cursor));
+                owe_gold(cursor, gold);
+                break;
+            }
+            case 'I': { // owed items: value,count,item,player
+                int value = atoi(next_field(&cursor));
+                int count = atoi(next_field(&cursor));
+                char *item = next_field(&cursor);
+                owe_items(cursor, item, value, count);
+                break;
+            }
+            case 'S': { // a ledger's steps: seq,last_gold,player (its T lines follow)
+                unsigned int seq = (unsigned int)strtoul(next_field(&cursor), NULL, 10);
+                int last_gold = atoi(next_field(&cursor));
+                Ledger *ledger = find_ledger(cursor, true);
+                ok = ledger != NULL;
+                if (ok) {
+                    ledger->seq = seq;
+                    ledger->last_gold = last_gold;
+                    ledger->last_item_count = 0;
+                }
+                break;
+            }
+            case 'T': { // what the last step did to the inventory: value,count,item,player
+                int value = atoi(next_field(&cursor));
+                int count = atoi(next_field(&cursor));
+                char *item = next_field(&cursor);
+                Ledger *ledger = find_ledger(cursor, true);
+                ok = ledger != NULL;
+                if (ok) step_items(ledger, item, value, count);
+                break;
+            }
+            case 'L': { // last price: price,item
+                int price = atoi(next_field(&cursor));
+                Book *book = find_book(cursor, true);
+                if (book != NULL) book->last_price = price;
+                break;
+            }
+            case 'N': // where the counters were
+                g_auction.next_id = strtoull(next_field(&cursor), NULL, 10);
+                g_auction.next_seq = strtoull(cursor, NULL, 10);
+                break;
+            default:
+                ok = false;
+                break;
+        }
+        if (!ok) log_event(LOG_ERROR, "Skipping bad auction line");
+    }
+}
+
+// growable buffer for the snapshot
+typedef struct {
+    char *data;
+    size_t len;
+    size_t capacity;
+} SnapshotBuffer;
+
+static void snapshot_add(SnapshotBuffer *buf, const char *line, int len) {
+    if (buf->data == NULL || len <= 0) return;
+    if (buf->len + (size_t)len > buf->capacity) {
+        size_t capacity = buf->capacity * 2;
+        while (capacity < buf->len + (size_t)len) capacity *= 2;
+        char *bigger = realloc(buf->data, capacity);
+        if (bigger == NULL) {
+            free(buf->data);
+            buf->data = NULL;
+            return;
+        }
+        buf->data = bigger;
+        buf->capacity = capacity;
+    }
+    memcpy(buf->data + buf->len, line, (size_t)len);
+    buf->len += (size_t)len;
+}
+
+static int compare_seq(const void *a, const void *b) {
+    const AuctionOrder *x = *(AuctionOrder *const *)a;
+    const AuctionOrder *y = *(AuctionOrder *const *)b;
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+// resting orders of one heap in arrival order (just for a tidy file)
+static void snapshot_heap(SnapshotBuffer *buf, const OrderHeap *heap) {
+    if (heap->count == 0) return;
+    AuctionOrder **sorted = malloc(sizeof(AuctionOrder *) * heap->count);
+    if (sorted == NULL) {
+        free(buf->data);
+        buf->data = NULL;
+        return;
+    }
+    memcpy(sorted, heap->orders, sizeof(AuctionOrder *) * heap->count);
+    qsort(sorted, heap->count, sizeof(AuctionOrder *), compare_seq);
+    char line[LINE_MAX_LENGTH];
+    for (int i = 0; i < heap->count; i++) {
+        if (sorted[i]->quantity > 0) snapshot_add(buf, line, format_order(line, sizeof(line), 'R', sorted[i]));
+    }
+    free(sorted);
+}
+
+// everything as a fresh snapshot, the journal goes in the same batch
+static bool write_snapshot() {
+    SnapshotBuffer buf = { malloc(4096), 0, 4096 };
+    char line[LINE_MAX_LENGTH];
+    snapshot_add(&buf, SNAPSHOT_HEADER, (int)strlen(SNAPSHOT_HEADER));
+    snapshot_add(&buf, line, snprintf(line, sizeof(line), "N,%llu,%llu\n", g_auction.next_id, g_auction.next_seq));
+    for (int b = 0; b < BOOK_BUCKETS; b++) {
+        for (Book *book = g_auction.books[b]; book != NULL; book = book->next) {
+            if (book->last_price > 0) {
+                snapshot_add(&buf, line, snprintf(line, sizeof(line), "L,%d,%s\n", book->last_price, book->item));
+            }
+            snapshot_heap(&buf, &book->bids);
+            snapshot_heap(&buf, &book->asks);
+        }
+    }
+    for (int b = 0; b < LEDGER_BUCKETS; b++) {
+        for (Ledger *ledger = g_auction.ledgers[b]; ledger != NULL; ledger = ledger->next) {
+            if (ledger->gold > 0) {
+                snapshot_add(&buf, line, snprintf(line, sizeof(line), "G,%d,%s\n", ledger->gold, ledger->player));
+            }
+            for (int i = 0; i < ledger->item_count; i++) {
+                const OwedItem *owed = &ledger->items[i];
+                snapshot_add(&buf, line, snprintf(line, sizeof(line), "I,%d,%d,%s,%s\n",
+                                                  owed->value, owed->count, owed->item, ledger->player));
+            }
+            if (ledger->seq > 0) {
+                snapshot_add(&buf, line, snprintf(line, sizeof(line), "S,%u,%d,%s\n",
+                                                  ledger->seq, ledger->last_gold, ledger->player));
+            }
+            for (int i = 0; i < ledger->last_item_count; i++) {
+                const OwedItem *step = &ledger->last_items[i];
+                snapshot_add(&buf, line, snprintf(line, sizeof(line), "T,%d,%d,%s,%s\n",
+                                                  step->value, step->count, step->item, ledger->player));
+            }
+        }
+    }
+    if (buf.data == NULL) return false;
+
+    StorageBackend *store = storage_active();
+    StorageOp ops[2] = {
+        { STORAGE_OP_PUT, AUCTION_FILE, buf.data, buf.len },
+        { STORAGE_OP_DELETE, AUCTION_FILE JOURNAL_SUFFIX, NULL, 0 }
+    };
+    bool ok = store->batch(store, ops, 2);
+    free(buf.data);
+    return ok;
+}
+
+// ---------------------------------------------------------------------
+// Public
+// ---------------------------------------------------------------------
+
+// drain the submission stack, caller holds the lock
+static int pump_locked() {
+    AuctionOrder *stack = __atomic_exchange_n(&g_auction.queue, NULL, __ATOMIC_ACQUIRE);
+
+    // newest first on the stack, flip it so the oldest goes first
+    AuctionOrder *queue = NULL;
+    while (stack != NULL) {
+        AuctionOrder *next = stack->next;
+        stack->next = queue;
+        queue = stack;
+        stack = next;
+    }
+
+    int handled = 0;
+    while (queue != NULL) {
+        AuctionOrder *next = queue->next;
+        queue->next = NULL;
+        apply_command(queue);
+        queue = next;
+        handled++;
+    }
+    journal_flush();
+    return handled;
+}
+
+bool auction_init() {
+    auction_shutdown(); // in case it's a reload
+
+    pthread_mutex_lock(&g_auction.lock);
+    g_auction.replaying = true;
+    StorageBackend *store = storage_active();
+    for (int part = 0; part < 2; part++) {
+        char *data = store->get(store, part == 0 ? AUCTION_FILE : AUCTION_FILE JOURNAL_SUFFIX, NULL);
+        if (data != NULL) {
+            apply_lines(data);
+            free(data);
+        }
+    }
+    g_auction.replaying = false;
+    g_auction.ready = true;
+    pthread_mutex_unlock(&g_auction.lock);
+    return true;
+}
+
+void auction_shutdown() {
+    pthread_mutex_lock(&g_auction.lock);
+    if (g_auction.ready) {
+        pump_locked();
+        StorageBackend *store = storage_active();
+        if (store->size(store, AUCTION_FILE JOURNAL_SUFFIX) >= AUCTION_JOURNAL_MAX_BYTES && !write_snapshot()) {
+            fprintf(stderr, "Error: Could not write the auction snapshot.\n");
+        }
+    }
+
+    // anything still queued (never pumped) just goes away
+    AuctionOrder *stack = __atomic_exchange_n(&g_auction.queue, NULL, __ATOMIC_ACQUIRE);
+    while (stack != NULL) {
+        AuctionOrder *next = stack->next;
+        free(stack);
+        stack = next;
+    }
+    for (int b = 0; b < BOOK_BUCKETS; b++) {
+        Book *book = g_auction.books[b];
+        while (book != NULL) {
+            Book *next = book->next;
+            heap_free(&book->bids);
+            heap_free(&book->asks);
+            free(book);
+            book = next;
+        }
+        g_auction.books[b] = NULL;
+    }
+    for (int b = 0; b < LEDGER_BUCKETS; b++) {
+        Ledger *ledger = g_auction.ledgers[b];
+        while (ledger != NULL) {
+            Ledger *next = ledger->next;
+            free(ledger->items);
+            free(ledger->last_items);
+            free(ledger);
+            ledger = next;
+        }
+        g_auction.ledgers[b] = NULL;
+    }
+    memset(g_auction.by_id, 0, sizeof(g_auction.by_id)); // all freed with the heaps
+    free(g_auction.journal);
+    g_auction.journal = NULL;
+    g_auction.journal_len = 0;
+    g_auction.journal_capacity = 0;
+    g_auction.next_id = 1;
+    g_auction.next_seq = 0;
+    g_auction.ready = false;
+    pthread_mutex_unlock(&g_auction.lock);
+}
+
+// push onto the submission stack, one CAS (retried if someone beat us to it)
+static void enqueue(AuctionOrder *command) {
+    command->next = __atomic_load_n(&g_auction.queue, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&g_auction.queue, &command->next, command, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        // command->next got refreshed with the new head, try again
+    }
+}
+
+unsigned long long auction_submit(AuctionSide side, const char *player, const char *item,
+                                  int item_value, int price, int quantity) {
+    if (player == NULL || item == NULL || player[0] == '\0' || item[0] == '\0' ||
+        strchr(item, ',') != NULL || price <= 0 || quantity <= 0 ||
+        (long long)price * quantity > 1000000000LL) {
+        return 0;
+    }
+    AuctionOrder *order = calloc(1, sizeof(AuctionOrder));
+    if (order == NULL) return 0;
+    order->kind = COMMAND_ORDER;
+    order->id = __atomic_fetch_add(&g_auction.next_id, 1, __ATOMIC_RELAXED);
+    order->side = side;
+    order->price = price;
+    order->quantity = quantity;
+    order->item_value = item_value;
+    strncpy(order->player, player, SAVE_RECORD_NAME_LENGTH - 1);
+    strncpy(order->item, item, AUCTION_ITEM_LENGTH - 1);
+    unsigned long long id = order->id;
+    enqueue(order);
+    return id;
+}
+
+bool auction_cancel(unsigned long long id, const char *player) {
+    if (id == 0 || player == NULL) return false;
+    AuctionOrder *command = calloc(1, sizeof(AuctionOrder));
+    if (command == NULL) return false;
+    command->kind = COMMAND_CANCEL;
+    command->id = id;
+    strncpy(command->player, player, SAVE_RECORD_NAME_LENGTH - 1);
+    enqueue(command);
+    return true;
+}
+
+int auction_pump() {
+    pthread_mutex_lock(&g_auction.lock);
+    int handled = g_auction.ready ? pump_locked() : 0;
+    pthread_mutex_unlock(&g_auction.lock);
+    return handled;
+}
+
+int auction_quotes(AuctionQuote *quotes, int max) {
+    pthread_mutex_lock(&g_auction.lock);
+    int count = 0;
+    for (int b = 0; b < BOOK_BUCKETS && count < max; b++) {
+        for (Book *book = g_auction.books[b]; book != NULL && count < max; book = book->next) {
+            if (book->bid_orders == 0 && book->ask_orders == 0 && book->last_price == 0) continue;
+            AuctionQuote *quote = &quotes[count++];
+            const AuctionOrder *bid = heap_top(&book->bids, AUCTION_BUY);
+            const AuctionOrder *ask = heap_top(&book->asks, AUCTION_SELL);
+            strcpy(quote->item, book->item);
+            quote->best_bid = bid != NULL ? bid->price : 0;
+            quote->best_ask = ask != NULL ? ask->price : 0;
+            quote->bid_orders = book->bid_orders;
+            quote->ask_orders = book->ask_orders;
+            quote->last_price = book->last_price;
+        }
+    }
+    pthread_mutex_unlock(&g_auction.lock);
+    return count;
+}
+
+int auction_orders(const char *player, AuctionOrderInfo *orders, int max) {
+    if (player == NULL) return 0;
+    pthread_mutex_lock(&g_auction.lock);
+    int count = 0;
+    for (int b = 0; b < ORDER_BUCKETS && count < max; b++) {
+        for (const AuctionOrder *order = g_auction.by_id[b]; order != NULL && count < max; order = order->id_next) {
+            if (strcmp(order->player, player) != 0) continue;
+            AuctionOrderInfo *info = &orders[count++];
+            info->id = order->id;
+            info->side = order->side;
+            strcpy(info->item, order->item);
+            info->price = order->price;
+            info->quantity = order->quantity;
+        }
+    }
+    pthread_mutex_unlock(&g_auction.lock);
+    return count;
+}
+
+// the save has seen every step on the ledger (NULL = no steps yet)
+static void sync_locked(Player *player, const Ledger *ledger) {
+    unsigned int seq = ledger != NULL ? ledger->seq : 0;
+    if (player->auction_seq == seq) return;
+    player->auction_seq = seq;
+    mark_player_dirty(player, DIRTY_AUCTION);
+}
+
+int auction_collect(Player *player) {
+    if (player == NULL || player->name == NULL) return 0;
+    pthread_mutex_lock(&g_auction.lock);
+    if (g_auction.ready) pump_locked(); // collect what just traded too
+    int handed = 0;
+    Ledger *ledger = g_auction.ready ? find_ledger(player->name, false) : NULL;
+    if (ledger != NULL && (ledger->gold > 0 || ledger->item_count > 0)) {
+        int room = player->inventory_capacity - player->inventory_size;
+        char line[LINE_MAX_LENGTH];
+        journal_line(line, snprintf(line, sizeof(line), "C,%d,%s\n", room, player->name));
+        handed = take_owed(ledger, room, player);
+        journal_flush();
+        sync_locked(player, ledger);
+    }
+    pthread_mutex_unlock(&g_auction.lock);
+    return handed;
+}
+
+// take one listed item back out of the inventory
+static void take_item(Player *player, const char *name, int value) {
+    for (int i = player->inventory_size - 1; i >= 0; i--) {
+        Item *item = player->inventory[i];
+        if (item == NULL || item->value != value || strncmp(item->name, name, AUCTION_ITEM_LENGTH - 1) != 0) continue;
+        free(item->name);
+        free(item);
+        for (int j = i; j < player->inventory_size - 1; j++) {
+            player->inventory[j] = player->inventory[j + 1];
+        }
+        player->inventory[--player->inventory_size] = NULL;
+        mark_inventory_dirty(player, i);
+        return;
+    }
+}
+
+// do the ledger's last step to the player again, caller holds the lock
+static void redo_step(Ledger *ledger, Player *player) {
+    if (ledger->last_gold != 0) {
+        player->gold += ledger->last_gold;
+        if (player->gold < 0) player->gold = 0;
+        mark_player_dirty(player, DIRTY_GOLD);
+    }
+    char line[LINE_MAX_LENGTH];
+    for (int i = 0; i < ledger->last_item_count; i++) {
+        const OwedItem *step = &ledger->last_items[i];
+        for (int n = step->count; n < 0; n++) take_item(player, step->item, step->value);
+        for (int n = 0; n < step->count; n++) {
+            Item *item = player->inventory_size < player->inventory_capacity
+                ? create_item(HEALING, "%s", step->item, step->value) : NULL;
+            if (item == NULL) {
+                // no room any more, it goes back on the ledger
+                int left = step->count - n;
+                journal_line(line, snprintf(line, sizeof(line), "I,%d,%d,%s,%s\n",
+                                            step->value, left, step->item, ledger->player));
+                owe_items(ledger->player, step->item, step->value, left);
+                break;
+            }
+            mark_inventory_dirty(player, player->inventory_size);
+            player->inventory[player->inventory_size++] = item;
+        }
+    }
+    journal_flush();
+}
+
+bool auction_reconcile(Player *player) {
+    if (player == NULL || player->name == NULL) return false;
+    pthread_mutex_lock(&g_auction.lock);
+    Ledger *ledger = g_auction.ready ? find_ledger(player->name, false) : NULL;
+    unsigned int seq = ledger != NULL ? ledger->seq : 0;
+    if (ledger != NULL && player->auction_seq + 1 == seq) {
+        log_event(LOG_DEBUG, "Redoing auction step %u for %s, the save missed it", seq, player->name);
+        redo_step(ledger, player);
+    } else if (player->auction_seq != seq) {
+        // more than one behind (or ahead) cant come from one crash, just line up
+        log_event(LOG_ERROR, "Auction ledger for %s is at step %u, the save at %u",
+                  player->name, seq, player->auction_seq);
+    }
+    bool changed = player->auction_seq != seq;
+    sync_locked(player, ledger);
+    pthread_mutex_unlock(&g_auction.lock);
+    return changed;
+}
+
+void auction_sync(Player *player) {
+    if (player == NULL || player->name == NULL) return;
+    pthread_mutex_lock(&g_auction.lock);
+    sync_locked(player, g_auction.ready ? find_ledger(player->name, false) : NULL);
+    pthread_mutex_unlock(&g_auction.lock);
+}
+
+void auction_owed(const char *player, int *gold, int *items) {
+    *gold = 0;
+    *items = 0;
+    if (player == NULL) return;
+    pthread_mutex_lock(&g_auction.lock);
+    const Ledger *ledger = g_auction.ready ? find_ledger(player, false) : NULL;
+    if (ledger != NULL) {
+        *gold = ledger->gold;
+        for (int i = 0; i < ledger->item_count; i++) *items += ledger->items[i].count;
+    }
+    pthread_mutex_unlock(&g_auction.lock);
+}
+
+// ---------------------------------------------------------------------
+// Menu
+// ---------------------------------------------------------------------
+
+// number from the user, false on junk (line gets cleared either way)
+static bool read_number(const char *prompt, int *value) {
+    printf("%s", prompt);
+    bool ok = scanf("%d", value) == 1;
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF);
+    if (!ok) printf("Invalid input.\n");
+    return ok;
+}
+
+static void save_after_trade(Player *player) {
+    save_game(player, saveFileName[0] != '\0' ? saveFileName : NULL);
+}
+
+static void list_item(Player *player) {
+    if (player->inventory_size == 0) {
+        printf("You have nothing to sell.\n");
+        return;
+    }
+    for (int i = 0; i < player->inventory_size; i++) {
+        printf("  %d. %s\n", i + 1, player->inventory[i]->name);
+    }
+    int slot, price;
+    if (!read_number("Sell which item? (0 to cancel) ", &slot) || slot == 0) return;
+    if (slot < 1 || slot > player->inventory_size) {
+        printf("Invalid item number.\n");
+        return;
+    }
+    if (!read_number("Asking price (gold): ", &price)) return;
+
+    Item *item = player->inventory[slot - 1];
+    unsigned long long id = auction_submit(AUCTION_SELL, player->name, item->name, item->value, price, 1);
+    if (id == 0) {
+        printf("The auctioneer won't take that listing.\n");
+        return;
+    }
+    // journal the listing first, if we crash before the save below
+    // auction_reconcile takes the item at the next login
+    auction_pump();
+
+    // the item goes into escrow
+    printf("Listed %s for %d gold (order #%llu).\n", item->name, price, id);
+    free(item->name);
+    free(item);
+    for (int j = slot - 1; j < player->inventory_size - 1; j++) {
+        player->inventory[j] = player->inventory[j + 1];
+    }
+    player->inventory[--player->inventory_size] = NULL;
+    mark_inventory_dirty(player, slot - 1);
+    auction_sync(player);
+    save_after_trade(player);
+}
+
+static void place_bid(Player *player) {
+    AuctionQuote quotes[32];
+    int count = auction_quotes(quotes, 32);
+    if (count == 0) {
+        printf("Nothing has been listed yet.\n");
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        printf("  %d. %s\n", i + 1, quotes[i].item);
+    }
+    int choice, price, quantity;
+    if (!read_number("Bid on which item? (0 to cancel) ", &choice) || choice == 0) return;
+    if (choice < 1 || choice > count) {
+        printf("Invalid item number.\n");
+        return;
+    }
+    if (!read_number("Most you'll pay each (gold): ", &price)) return;
+    if (!read_number("How many? ", &quantity)) return;
+    if (price <= 0 || quantity <= 0) {
+        printf("The auctioneer won't take that bid.\n");
+        return;
+    }
+    if ((long long)price * quantity > player->gold) {
+        printf("Not enough gold!\n");
+        return;
+    }
+
+    unsigned long long id = auction_submit(AUCTION_BUY, player->name, quotes[choice - 1].item, 0, price, quantity);
+    if (id == 0) {
+        printf("The auctioneer won't take that bid.\n");
+        return;
+    }
+    auction_pump(); // journaled before the gold leaves the save, like a listing
+
+    // the gold goes into escrow, anything you dont end up paying comes back
+    player->gold -= price * quantity;
+    mark_player_dirty(player, DIRTY_GOLD);
+    printf("Bid %d gold each for %d x %s (order #%llu).\n", price, quantity, quotes[choice - 1].item, id);
+    auction_sync(player);
+    save_after_trade(player);
+}
+
+static void manage_orders(Player *player) {
+    AuctionOrderInfo orders[32];
+    int count = auction_orders(player->name, orders, 32);
+    if (count == 0) {
+        printf("You have no open orders.\n");
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        printf("  %d. %s %d x %s at %d gold (order #%llu)\n", i + 1,
+               orders[i].side == AUCTION_BUY ? "Buying" : "Selling",
+               orders[i].quantity, orders[i].item, orders[i].price, orders[i].id);
+    }
+    int choice;
+    if (!read_number("Cancel which order? (0 to keep them all) ", &choice) || choice == 0) return;
+    if (choice < 1 || choice > count) {
+        printf("Invalid order number.\n");
+        return;
+    }
+    auction_cancel(orders[choice - 1].id, player->name);
+    auction_pump();
+    printf("Order #%llu cancelled, collect to get your escrow back.\n", orders[choice - 1].id);
+}
+
+void show_auction_house(Player *player) {
+    if (player == NULL) return;
+    auction_pump();
+
+    int owed_gold, owed_items;
+    auction_owed(player->name, &owed_gold, &owed_items);
+    printf("\n=== AUCTION HOUSE ===\n");
+    printf("Your Gold: %d", player->gold);
+    if (owed_gold > 0 || owed_items > 0) {
+        printf(" (waiting to collect: %d gold, %d items)", owed_gold, owed_items);
+    }
+    printf("\n");
+
+    AuctionQuote quotes[16];
+    int count = auction_quotes(quotes, 16);
+    for (int i = 0; i < count; i++) {
+        printf("  %-32s bid %5d (%d)  ask %5d (%d)  last %d\n", quotes[i].item,
+               quotes[i].best_bid, quotes[i].bid_orders, quotes[i].best_ask, quotes[i].ask_orders,
+               quotes[i].last_price);
+    }
+    if (count == 0) printf("  Nothing listed yet.\n");
+
+    printf("1. Sell an item\n");
+    printf("2. Place a bid\n");
+    printf("3. My orders\n");
+    printf("4. Collect\n");
+    printf("5. Leave\n");
+
+    int choice;
+    if (!read_number("What would you like to do? ", &choice)) return;
+    switch (choice) {
+        case 1:
+            list_item(player);
+            break;
+        case 2:
+            place_bid(player);
+            break;
+        case 3:
+            manage_orders(player);
+            break;
+        case 4: {
+            int handed = auction_collect(player);
+            if (handed == 0) {
+                printf("Nothing waiting for you.\n");
+            } else {
+                printf("Collected! Gold: %d, inventory %d/%d\n", player->gold,
+                       player->inventory_size, player->inventory_capacity);
+                auction_owed(player->name, &owed_gold, &owed_items);
+                if (owed_items > 0) printf("%d items are still waiting, make some room.\n", owed_items);
+                save_after_trade(player);
+            }
+            break;
+        }
+        default:
+            printf("Leaving the auction house.\n");
+            break;
+    }
+}
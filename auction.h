@@ -0,0 +1,91 @@
+// auction.h - Player auction house (order books + matching)
+#ifndef AUCTION_H
+#define AUCTION_H
+
+#include <stdbool.h>
+#include "player.h"
+#include "save_game.h" // DEFAULT_SAVE_DIR, SAVE_RECORD_NAME_LENGTH
+
+// resting orders + what everyone is owed, with a journal of every command
+// since (same layout as the leaderboard), through the active storage backend
+#define AUCTION_FILE DEFAULT_SAVE_DIR "/auction.book"
+#define AUCTION_JOURNAL_MAX_BYTES (256 * 1024)
+
+// item prototypes are just item names ("Health Potion (Strength 2)")
+#define AUCTION_ITEM_LENGTH 64
+
+typedef enum {
+    AUCTION_BUY,
+    AUCTION_SELL
+} AuctionSide;
+
+// best prices for one item
+typedef struct {
+    char item[AUCTION_ITEM_LENGTH];
+    int best_bid;   // 0 = no buyers
+    int best_ask;   // 0 = no sellers
+    int bid_orders; // resting orders on each side
+    int ask_orders;
+    int last_price; // last trade, 0 = none yet
+} AuctionQuote;
+
+// one of a player's resting orders
+typedef struct {
+    unsigned long long id;
+    AuctionSide side;
+    char item[AUCTION_ITEM_LENGTH];
+    int price;
+    int quantity; // still open
+} AuctionOrderInfo;
+
+// load the books from the snapshot + journal (call after storage_select)
+bool auction_init();
+
+// match whatever's still queued, fold a big journal into the snapshot, free
+void auction_shutdown();
+
+// Queue an order, safe from any thread without taking a lock. Nothing is
+// matched until the next auction_pump. Escrow is the caller's job: submit,
+// auction_pump (that journals it), then take price * quantity gold for a
+// buy or the items for a sell, auction_sync and save. Fills, refunds and
+// cancels come back through auction_collect. item_value is what the item
+// does (sells only).
+// returns the order id, 0 if the order doesnt make sense
+unsigned long long auction_submit(AuctionSide side, const char *player, const char *item,
+                                  int item_value, int price, int quantity);
+
+// queue a cancel, the escrow comes back through auction_collect
+bool auction_cancel(unsigned long long id, const char *player);
+
+// match everything queued so far in arrival order (price-time priority)
+// and journal it in one write. returns how many commands were handled
+int auction_pump();
+
+// quotes for every item with resting orders or trades, returns how many
+int auction_quotes(AuctionQuote *quotes, int max);
+
+// a player's resting orders, returns how many
+int auction_orders(const char *player, AuctionOrderInfo *orders, int max);
+
+// hand the player everything they're owed (gold, bought items, refunds,
+// cancelled listings) as far as their inventory has room. It's journaled
+// before the player changes, save them right after
+// returns gold + items handed over, 0 if nothing was waiting
+int auction_collect(Player *player);
+
+// For a player just loaded from their save: if the save missed the last
+// auction step (crashed between the journal write and the save), do that
+// step to them again. returns true if the player changed and needs saving
+bool auction_reconcile(Player *player);
+
+// mark the player as having seen every auction step so far (new
+// characters, and after taking escrow for an order)
+void auction_sync(Player *player);
+
+// gold and items waiting for a player
+void auction_owed(const char *player, int *gold, int *items);
+
+// the auction house menu (from the shop)
+void show_auction_house(Player *player);
+
+#endif // AUCTION_H
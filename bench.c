@@ -0,0 +1,965 @@
+// bench.c - Micro/macro benchmarks for the game code (make bench)
+//
+// Runs each benchmark in batches, reports ns/op, allocations/op and
+// p50/p90/p99 (per-op time of each batch) as JSON. With -baseline FILE
+// it compares against a stored run and exits 1 on regressions.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+
+#include "player.h"
+#include "enemy.h"
+#include "game.h"
+#include "items.h"
+#include "utils.h"
+#include "spells.h"
+#include "loot.h"
+#include "spawn.h"
+#include "combat.h"
+#include "project.h"
+#include "leaderboard.h"
+#include "auction.h"
+#include "trade.h"
+#include "broadcast.h"
+#include "shard.h"
+#include "party.h"
+#include "raid.h"
+#include "handoff.h"
+#include "hibernate.h"
+#include "player_cache.h"
+#include "ai.h"
+#include "alias.h"
+#include "rng.h"
+#include "save_game.h"
+#include "storage.h"
+#include "stats.h"
+
+// game.c autosaves to this (normally lives in main.c)
+char saveFileName[MAX_FILENAME_LENGTH] = {0};
+
+// ---------------------------------------------------------------------
+// Allocation counting, the Makefile links us with -Wl,--wrap=malloc etc
+// so every malloc in the game objects comes through here first
+// ---------------------------------------------------------------------
+static unsigned long g_alloc_count = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    __atomic_fetch_add(&g_alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    __atomic_fetch_add(&g_alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    __atomic_fetch_add(&g_alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+
+// ---------------------------------------------------------------------
+// Results
+// ---------------------------------------------------------------------
+#define MAX_BENCHMARKS 128 // registered in main, run_bench dies past this
+#define MAX_BATCHES 200
+
+typedef struct {
+    const char *name;
+    long iterations;
+    double ns_per_op;
+    double allocs_per_op;
+    double p50_ns;
+    double p90_ns;
+    double p99_ns;
+} BenchResult;
+
+static BenchResult g_results[MAX_BENCHMARKS];
+static int g_result_count = 0;
+static const char *g_filter = NULL; // only run names containing this
+static double g_scale = 1.0;        // -quick makes this smaller
+
+// a benchmark body does n operations
+typedef void (*BenchFn)(void *ctx, long n);
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int count, double pct) {
+    int index = (int)(pct / 100.0 * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+// time `batches` runs of `batch_size` ops each
+static void run_bench(const char *name, BenchFn fn, void *ctx, long batch_size, int batches) {
+    if (g_filter != NULL && strstr(name, g_filter) == NULL) return;
+    if (g_result_count >= MAX_BENCHMARKS) {
+        // a bench that silently doesnt run looks exactly like one that passed
+        fprintf(stderr, "Error: No room for benchmark '%s', raise MAX_BENCHMARKS (%d)\n", name, MAX_BENCHMARKS);
+        exit(1);
+    }
+
+    batch_size = (long)(batch_size * g_scale);
+    if (batch_size < 1) batch_size = 1;
+    if (batches > MAX_BATCHES) batches = MAX_BATCHES;
+
+    // warm up caches and the allocator first
+    fn(ctx, batch_size);
+
+    double per_op[MAX_BATCHES];
+    double total_ns = 0;
+    unsigned long allocs_before = g_alloc_count;
+    for (int b = 0; b < batches; b++) {
+        double start = now_ns();
+        fn(ctx, batch_size);
+        double elapsed = now_ns() - start;
+        total_ns += elapsed;
+        per_op[b] = elapsed / batch_size;
+    }
+    unsigned long allocs = g_alloc_count - allocs_before;
+
+    qsort(per_op, batches, sizeof(double), compare_doubles);
+
+    BenchResult *r = &g_results[g_result_count++];
+    r->name = name;
+    r->iterations = batch_size * batches;
+    r->ns_per_op = total_ns / r->iterations;
+    r->allocs_per_op = (double)allocs / r->iterations;
+    r->p50_ns = percentile(per_op, batches, 50);
+    r->p90_ns = percentile(per_op, batches, 90);
+    r->p99_ns = percentile(per_op, batches, 99);
+
+    fprintf(stderr, "  %-28s %12.1f ns/op %8.2f allocs/op\n", name, r->ns_per_op, r->allocs_per_op);
+}
+
+// ---------------------------------------------------------------------
+// Fixtures
+// ---------------------------------------------------------------------
+
+// build a player without going through the class prompt
+static void make_player(Player *player, const char *name, enum ClassType cls) {
+    memset(player, 0, sizeof(Player));
+    player->name = malloc(strlen(name) + 1);
+    strcpy(player->name, name);
+    player->playerClass = cls;
+    player->hp = player->maxHp = 60;
+    player->damage = 8;
+    player->level = 1;
+    player->gold = 100;
+    player->area_level = 3;
+    player->inventory_capacity = INITIAL_INVENTORY_CAPACITY;
+    player->inventory = calloc(player->inventory_capacity, sizeof(Item *));
+    for (int i = 0; i < 3; i++) {
+        player->inventory[player->inventory_size++] = create_health_potion(i + 1);
+    }
+    player->dirty = DIRTY_FULL;
+}
+
+// log level goes through the environment like the real game
+static void set_log_level(int level) {
+    char value[16];
+    snprintf(value, sizeof(value), "%d", level);
+    setenv("GAME_LOG_LEVEL", value, 1);
+    setup_env_variables(NULL);
+}
+
+// ---------------------------------------------------------------------
+// Benchmarks
+// ---------------------------------------------------------------------
+
+static void bench_initialize_enemy(void *ctx, long n) {
+    (void)ctx;
+    Enemy enemy;
+    for (long i = 0; i < n; i++) {
+        initialize_enemy(&enemy, (int)(i % 5) + 1, 3);
+        cleanup_enemy(&enemy);
+    }
+}
+
+static void bench_create_item(void *ctx, long n) {
+    (void)ctx;
+    for (long i = 0; i < n; i++) {
+        Item *item = create_item(HEALING, "%s Potion of %d", "Bench", (int)i, 25);
+        free(item->name);
+        free(item);
+    }
+}
+
+static void bench_create_health_potion(void *ctx, long n) {
+    (void)ctx;
+    for (long i = 0; i < n; i++) {
+        Item *item = create_health_potion((int)(i & 7));
+        free(item->name);
+        free(item);
+    }
+}
+
+static void bench_cast_spell(void *ctx, long n) {
+    Player *mage = (Player *)ctx;
+    Enemy target = { .name = "Dummy", .hp = 1000, .maxHp = 1000 };
+    for (long i = 0; i < n; i++) {
+        cast_spell(mage, &target, FIRE_SPELL, (int)(i % 10) + 1, 2);
+        cast_spell(mage, &target, ICE_SPELL, (int)(i % 5) + 1, 0.25);
+    }
+}
+
+// one op = resolving a 1024 cast batch (a raid tick's worth)
+#define BENCH_SPELL_BATCH 1024
+static void bench_spell_batch(void *ctx, long n) {
+    (void)ctx;
+    static SpellCast casts[BENCH_SPELL_BATCH];
+    static int amounts[BENCH_SPELL_BATCH];
+    for (int i = 0; i < BENCH_SPELL_BATCH; i++) {
+        casts[i].spell = (SpellType)(i % 5);
+        casts[i].power = i % 10 + 1;
+    }
+    unsigned int rng = 42;
+    for (long i = 0; i < n; i++) {
+        spell_resolve_batch(casts, BENCH_SPELL_BATCH, amounts, &rng);
+    }
+}
+
+static void bench_loot_roll(void *ctx, long n) {
+    (void)ctx;
+    int drops[CONTENT_LOOT_MAX_ROLLS];
+    unsigned int rng = 42;
+    long dropped = 0;
+    for (long i = 0; i < n; i++) {
+        dropped += loot_roll(DRAGON, drops, CONTENT_LOOT_MAX_ROLLS, &rng);
+    }
+    if (dropped < 0) fprintf(stderr, "impossible\n"); // keep the loop alive
+}
+
+// a pick from a 1024 entry table should cost the same as a 4 entry one
+static void bench_alias_pick(void *ctx, long n) {
+    const AliasTable *table = (const AliasTable *)ctx;
+    unsigned int rng = 42;
+    long sum = 0;
+    for (long i = 0; i < n; i++) {
+        sum += alias_pick(table, rng_next(&rng), rng_next(&rng));
+    }
+    if (sum < 0) fprintf(stderr, "impossible\n");
+}
+
+// one op = picking 1024 area 5 spawns in one batch
+#define BENCH_SPAWN_BATCH 1024
+static void bench_spawn_batch(void *ctx, long n) {
+    (void)ctx;
+    static enum EnemyType types[BENCH_SPAWN_BATCH];
+    for (long i = 0; i < n; i++) {
+        spawn_pick_batch(5, types, BENCH_SPAWN_BATCH, (unsigned int)i);
+    }
+}
+
+// a long attack-only fight, settled by the closed form
+static void bench_combat_closed_form(void *ctx, long n) {
+    Player *player = (Player *)ctx;
+    Enemy enemy = { .name = "Dummy", .hp = 5000, .maxHp = 5000, .damage = 0 };
+    long turns = 0;
+    for (long i = 0; i < n; i++) {
+        turns += combat_resolve(player, &enemy, NULL).turns;
+    }
+    if (turns < 0) fprintf(stderr, "impossible\n");
+}
+
+// a real skeleton ("attack 150 when every 3") that takes a while to die,
+// its script only goes round its attacks so this is still the closed form
+static void bench_combat_attack_cycle(void *ctx, long n) {
+    Player *player = (Player *)ctx;
+    Enemy enemy = { .name = "Dummy", .hp = 5000, .maxHp = 5000, .damage = 1, .type = SKELETON };
+    long turns = 0;
+    for (long i = 0; i < n; i++) {
+        turns += combat_resolve(player, &enemy, NULL).turns;
+    }
+    if (turns < 0) fprintf(stderr, "impossible\n");
+}
+
+// the same fight played out turn by turn (a potion policy with nothing to
+// drink below 0% hp never fires, it just forces the simulation)
+static void bench_combat_simulated(void *ctx, long n) {
+    Player *player = (Player *)ctx;
+    Enemy enemy = { .name = "Dummy", .hp = 5000, .maxHp = 5000, .damage = 0 };
+    CombatPolicy policy = { -1, 0, true, 0, 0, 0 };
+    long turns = 0;
+    for (long i = 0; i < n; i++) {
+        turns += combat_resolve(player, &enemy, &policy).turns;
+    }
+    if (turns < 0) fprintf(stderr, "impossible\n");
+}
+
+// one enemy turn of the boss's script (the longest built-in one): the
+// poison tick plus the rules, with its hp going down and a new fight every
+// 20 turns so the heal/enrage/poison rules all get their turn
+static void bench_enemy_ai_turn(void *ctx, long n) {
+    const Enemy *enemy = (const Enemy *)ctx;
+    AiState state;
+    ai_begin(&state, enemy, 1);
+    long total = 0;
+    for (long i = 0; i < n; i++) {
+        if (state.turn == 20) ai_begin(&state, enemy, (unsigned int)i);
+        int amount = 0;
+        int hp = enemy->maxHp - state.turn * enemy->maxHp / 20;
+        total += ai_poison_tick(&state);
+        total += (long)ai_enemy_turn(&state, hp, enemy->maxHp, 100, 100, &amount) + amount;
+    }
+    if (total < 0) fprintf(stderr, "impossible\n");
+}
+
+// 100 fights for 1000 rogues, table and all (no printing)
+static void bench_project(void *ctx, long n) {
+    const ProjectSpec *spec = (const ProjectSpec *)ctx;
+    ProjectCheckpoint checkpoints[PROJECT_CHECKPOINTS];
+    for (long i = 0; i < n; i++) {
+        project_progression(spec, checkpoints, NULL);
+    }
+}
+
+// boards already hold LEADERBOARD_BENCH_PLAYERS players, this one keeps climbing
+#define LEADERBOARD_BENCH_PLAYERS 100000
+
+static void bench_leaderboard_update(void *ctx, long n) {
+    Player *player = (Player *)ctx;
+    for (long i = 0; i < n; i++) {
+        player->kills++;
+        player->gold = (int)(i * 7919 % 5000);
+        leaderboard_update(player);
+    }
+}
+
+static void bench_leaderboard_rank(void *ctx, long n) {
+    (void)ctx;
+    char name[32];
+    long total = 0;
+    for (long i = 0; i < n; i++) {
+        snprintf(name, sizeof(name), "bench%ld", i * 7919 % LEADERBOARD_BENCH_PLAYERS);
+        total += leaderboard_rank(LEADERBOARD_GOLD, name);
+    }
+    if (total < 0) fprintf(stderr, "impossible\n");
+}
+
+static void bench_leaderboard_top(void *ctx, long n) {
+    (void)ctx;
+    LeaderboardRow rows[10];
+    for (long i = 0; i < n; i++) {
+        leaderboard_range(LEADERBOARD_LEVEL, (int)(i % 1000) * 10 + 1, rows, 10);
+    }
+}
+
+// 10k orders on 8 books, submitted then matched in one pump (books keep
+// whatever rests between iterations, like a real market would)
+static void bench_auction(void *ctx, long n) {
+    (void)ctx;
+    static const char *items[8] = { "Item A", "Item B", "Item C", "Item D", "Item E", "Item F", "Item G", "Item H" };
+    unsigned int rng = 12345;
+    for (long i = 0; i < n; i++) {
+        for (int j = 0; j < 10000; j++) {
+            uint32_t r = rng_next(&rng);
+            AuctionSide side = (r & 1) ? AUCTION_SELL : AUCTION_BUY;
+            auction_submit(side, (r & 2) ? "Bench" : "Rival", items[(r >> 2) & 7], 10, 90 + (int)((r >> 5) % 21), 1 + (int)((r >> 10) & 3));
+        }
+        auction_pump();
+    }
+}
+
+// 4 threads trading over the same 8 players, each trade swaps an item
+// and a bit of gold so everyone stays tradeable (memory backend saves)
+#define TRADE_BENCH_PLAYERS 8
+#define TRADE_BENCH_THREADS 4
+
+typedef struct {
+    Player *players;
+    long trades;
+    unsigned int seed;
+} TradeBenchJob;
+
+static void *trade_bench_worker(void *arg) {
+    TradeBenchJob *job = arg;
+    for (long i = 0; i < job->trades; i++) {
+        uint32_t r = rng_next(&job->seed);
+        int x = (int)(r % TRADE_BENCH_PLAYERS);
+        int y = (x + 1 + (int)((r >> 8) % (TRADE_BENCH_PLAYERS - 1))) % TRADE_BENCH_PLAYERS;
+        TradeSide a, b;
+        trade_side_init(&a, &job->players[x], NULL);
+        trade_side_init(&b, &job->players[y], NULL);
+        a.gold = 1;
+        trade_offer_slot(&a, (int)((r >> 16) % 3));
+        trade_offer_slot(&b, (int)((r >> 20) % 3));
+        trade_execute(&a, &b);
+    }
+    return NULL;
+}
+
+static void bench_trade(void *ctx, long n) {
+    Player *players = ctx;
+    pthread_t threads[TRADE_BENCH_THREADS];
+    TradeBenchJob jobs[TRADE_BENCH_THREADS];
+    for (int t = 0; t < TRADE_BENCH_THREADS; t++) {
+        jobs[t] = (TradeBenchJob){ players, n / TRADE_BENCH_THREADS, 777u + t };
+        pthread_create(&threads[t], NULL, trade_bench_worker, &jobs[t]);
+    }
+    for (int t = 0; t < TRADE_BENCH_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+// one kill message to 5k subscribers in an area, every connection gets a
+// writev (to /dev/null) every 64 messages
+#define BROADCAST_BENCH_SUBSCRIBERS 5000
+
+// this thread owns all the connections, so it's the one that flushes them
+static void flush_listeners(BroadcastSubscriber **listeners) {
+    for (int i = 0; i < BROADCAST_BENCH_SUBSCRIBERS; i++) {
+        broadcast_flush(listeners[i]);
+    }
+}
+
+static void bench_broadcast(void *ctx, long n) {
+    BroadcastSubscriber **listeners = ctx;
+    for (long i = 0; i < n; i++) {
+        broadcast_publish(5, BROADCAST_KILL, "%s (Level %d) defeated a Level %d %s", "Bench", 9, (int)(i & 15), "Dragon");
+        if ((i & 63) == 63) flush_listeners(listeners);
+    }
+    flush_listeners(listeners);
+}
+
+// fresh level 1 characters through the area shards, 20 fights each
+// (they move up areas as they level), one op = one character
+#define SHARD_BENCH_SESSIONS 1000
+
+typedef struct {
+    Player players[SHARD_BENCH_SESSIONS];
+    ShardSession sessions[SHARD_BENCH_SESSIONS];
+} ShardBench;
+
+static void bench_shard(void *ctx, long n) {
+    ShardBench *bench = ctx;
+    while (n > 0) {
+        int count = n < SHARD_BENCH_SESSIONS ? (int)n : SHARD_BENCH_SESSIONS;
+        for (int i = 0; i < count; i++) {
+            Player *player = &bench->players[i];
+            player->hp = player->maxHp = 60;
+            player->damage = 7;
+            player->level = 1;
+            player->xp = player->gold = player->kills = 0;
+            player->area_level = 1;
+            bench->sessions[i] = (ShardSession){ player, 20, 0, 0, NULL };
+            shard_submit(&bench->sessions[i]);
+        }
+        int done = 0;
+        while (done < count) {
+            for (ShardSession *s = shard_collect(); s != NULL; s = s->next) done++;
+            if (done < count) sched_yield();
+        }
+        n -= count;
+    }
+}
+
+// 8 players (attacks, spells, auras) into 4 enemies that never go down,
+// one op = everyone sending an action + the tick that settles them
+static void bench_party_tick(void *ctx, long n) {
+    Party *party = ctx;
+    for (long i = 0; i < n; i++) {
+        for (int slot = 0; slot < party->player_count; slot++) {
+            PartyAction action = { PARTY_ACTION_ATTACK, slot % 4, 0, { FIRE_SPELL, 5, 2, 0.0f } };
+            if (party->players[slot]->playerClass == MAGE) action.type = PARTY_ACTION_SPELL;
+            else if (party->players[slot]->playerClass == PALADIN && (i & 3) == 0) action.type = PARTY_ACTION_AURA;
+            party_submit(party, slot, &action);
+        }
+        party_tick(party, NULL);
+        for (int e = 0; e < party->enemy_count; e++) party->enemies[e].hp = party->enemies[e].maxHp;
+        for (int slot = 0; slot < party->player_count; slot++) party->players[slot]->hp = party->players[slot]->maxHp;
+    }
+}
+
+// 1000 attackers on one boss from 4 threads (250 each) while this thread
+// merges ticks, one op = one hit
+#define RAID_BENCH_THREADS 4
+
+typedef struct {
+    Raid *raid;
+    int first;
+    int count;
+    long hits;
+} RaidBenchJob;
+
+static void *raid_bench_worker(void *arg) {
+    RaidBenchJob *job = arg;
+    for (long i = 0; i < job->hits; i++) {
+        raid_hit(job->raid, job->first + (int)(i % job->count), 7);
+    }
+    return NULL;
+}
+
+static void bench_raid(void *ctx, long n) {
+    Raid *raid = ctx;
+    pthread_t threads[RAID_BENCH_THREADS];
+    RaidBenchJob jobs[RAID_BENCH_THREADS];
+    int per_thread = raid->attacker_count / RAID_BENCH_THREADS;
+    for (int t = 0; t < RAID_BENCH_THREADS; t++) {
+        jobs[t] = (RaidBenchJob){ raid, t * per_thread, per_thread, n / RAID_BENCH_THREADS };
+        pthread_create(&threads[t], NULL, raid_bench_worker, &jobs[t]);
+    }
+    for (int t = 0; t < RAID_BENCH_THREADS; t++) {
+        raid_tick(raid, NULL);
+        pthread_join(threads[t], NULL);
+    }
+    raid_tick(raid, NULL);
+}
+
+typedef struct {
+    int conns[2]; // old process end, new process end
+    HandoffSession session;
+} HandoffBench;
+
+// one op = a session (with its fd) sent, received and resumed
+static void bench_handoff(void *ctx, long n) {
+    HandoffBench *bench = ctx;
+    for (long i = 0; i < n; i++) {
+        HandoffSession resumed;
+        handoff_send(bench->conns[0], &bench->session, 1);
+        if (handoff_receive(bench->conns[1], &resumed, 1) == 1) {
+            for (int f = 0; f < resumed.fd_count; f++) close(resumed.fds[f]);
+            free(resumed.player.name);
+            for (int s = 0; s < resumed.player.inventory_size; s++) {
+                free(resumed.player.inventory[s]->name);
+                free(resumed.player.inventory[s]);
+            }
+            free(resumed.player.inventory);
+        }
+    }
+}
+
+// one op = a session frozen and brought back on its next input
+static void bench_hibernate(void *ctx, long n) {
+    HibernateSession *session = ctx;
+    for (long i = 0; i < n; i++) {
+        hibernate_freeze(session);
+        Player *player = hibernate_acquire(session);
+        player->gold++;
+        hibernate_release(session);
+    }
+}
+
+static void bench_log_event(void *ctx, long n) {
+    (void)ctx;
+    for (long i = 0; i < n; i++) {
+        log_event(LOG_COMBAT, "%s dealt %d damage to %s", "Bench", (int)i, "Dummy");
+    }
+}
+
+static void bench_add_player_xp(void *ctx, long n) {
+    Player *player = (Player *)ctx;
+    for (long i = 0; i < n; i++) {
+        add_player_xp(player, 7);
+        if (player->level > 50) {
+            player->level = 1; // dont let the numbers run away
+        }
+    }
+}
+
+static void bench_save_full(void *ctx, long n) {
+    Player *player = (Player *)ctx;
+    for (long i = 0; i < n; i++) {
+        player->dirty = DIRTY_FULL;
+        save_game(player, NULL);
+    }
+}
+
+static void bench_save_delta(void *ctx, long n) {
+    Player *player = (Player *)ctx;
+    for (long i = 0; i < n; i++) {
+        player->gold++;
+        mark_player_dirty(player, DIRTY_GOLD | DIRTY_HP);
+        save_game(player, NULL);
+    }
+}
+
+static void bench_save_load_roundtrip(void *ctx, long n) {
+    Player *player = (Player *)ctx;
+    for (long i = 0; i < n; i++) {
+        player->gold++;
+        mark_player_dirty(player, DIRTY_GOLD);
+        save_game(player, NULL);
+
+        Player loaded;
+        memset(&loaded, 0, sizeof(Player));
+        loaded.name = malloc(strlen(player->name) + 1);
+        strcpy(loaded.name, player->name);
+        load_game(&loaded, NULL);
+        cleanup_player(&loaded);
+    }
+}
+
+// just the load, what a login pays (player was saved by the bench before)
+static void bench_load_game(void *ctx, long n) {
+    Player *player = (Player *)ctx;
+    for (long i = 0; i < n; i++) {
+        Player loaded;
+        memset(&loaded, 0, sizeof(Player));
+        loaded.name = malloc(strlen(player->name) + 1);
+        strcpy(loaded.name, player->name);
+        load_game(&loaded, NULL);
+        cleanup_player(&loaded);
+    }
+}
+
+// one scripted session: pick class, 10 fights, buy a potion, look at the
+// character sheet, quit. god mode so every fight is one hit.
+static const char *SESSION_SCRIPT =
+    "1\n"
+    "1\n1\n1\n" "1\n1\n1\n" "1\n1\n1\n" "1\n1\n1\n" "1\n1\n1\n"
+    "1\n1\n1\n" "1\n1\n1\n" "1\n1\n1\n" "1\n1\n1\n" "1\n1\n1\n"
+    "2\n1\n"
+    "3\n"
+    "5\ny\n";
+
+static void bench_game_session(void *ctx, long n) {
+    (void)ctx;
+    for (long i = 0; i < n; i++) {
+        rewind(stdin); // replay the script from the top
+
+        Player player;
+        initialize_player(&player, "BenchHero", true);
+        GameState state = GAME_STATE_MENU;
+        for (int step = 0; step < 1000 && state != GAME_STATE_GAME_OVER; step++) {
+            game_loop(&player, &state);
+        }
+        cleanup_player(&player);
+    }
+}
+
+// ---------------------------------------------------------------------
+// Baseline comparison
+// ---------------------------------------------------------------------
+
+// pull "name" and a numeric field out of one line of our own JSON
+static bool parse_result_line(const char *line, char *name, size_t name_size, double *ns, double *allocs) {
+    const char *p = strstr(line, "\"name\": \"");
+    if (p == NULL) return false;
+    p += 9;
+    const char *end = strchr(p, '"');
+    if (end == NULL || (size_t)(end - p) >= name_size) return false;
+    memcpy(name, p, end - p);
+    name[end - p] = '\0';
+
+    const char *ns_field = strstr(line, "\"ns_per_op\": ");
+    const char *alloc_field = strstr(line, "\"allocs_per_op\": ");
+    if (ns_field == NULL || alloc_field == NULL) return false;
+    *ns = atof(ns_field + 13);
+    *allocs = atof(alloc_field + 17);
+    return true;
+}
+
+// returns number of regressions
+static int compare_with_baseline(const char *path, double tolerance_pct) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Warning: no baseline at '%s', skipping compare\n", path);
+        return 0;
+    }
+
+    int regressions = 0;
+    char line[512];
+    fprintf(stderr, "\nCompared to %s (tolerance %.0f%%):\n", path, tolerance_pct);
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char name[64];
+        double base_ns, base_allocs;
+        if (!parse_result_line(line, name, sizeof(name), &base_ns, &base_allocs)) continue;
+
+        bool ran = false;
+        for (int i = 0; i < g_result_count; i++) {
+            BenchResult *r = &g_results[i];
+            if (strcmp(r->name, name) != 0) continue;
+            ran = true;
+
+            double change = base_ns > 0 ? (r->ns_per_op - base_ns) / base_ns * 100.0 : 0;
+            bool slower = change > tolerance_pct;
+            bool more_allocs = r->allocs_per_op > base_allocs + 0.01;
+            fprintf(stderr, "  %-28s %+7.1f%% time, %.2f -> %.2f allocs/op%s\n",
+                    name, change, base_allocs, r->allocs_per_op,
+                    (slower || more_allocs) ? "  <-- REGRESSION" : "");
+            if (slower || more_allocs) regressions++;
+        }
+        // in the baseline but never ran (renamed or dropped), thats a
+        // regression too unless -filter skipped it on purpose
+        if (!ran && (g_filter == NULL || strstr(name, g_filter) != NULL)) {
+            fprintf(stderr, "  %-28s did not run  <-- REGRESSION\n", name);
+            regressions++;
+        }
+    }
+    fclose(file);
+    return regressions;
+}
+
+// ---------------------------------------------------------------------
+
+static void write_json(FILE *out) {
+    fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (int i = 0; i < g_result_count; i++) {
+        BenchResult *r = &g_results[i];
+        // one result per line, compare_with_baseline depends on that
+        fprintf(out, "    {\"name\": \"%s\", \"iterations\": %ld, \"ns_per_op\": %.1f, "
+                     "\"allocs_per_op\": %.2f, \"p50_ns\": %.1f, \"p90_ns\": %.1f, \"p99_ns\": %.1f}%s\n",
+                r->name, r->iterations, r->ns_per_op, r->allocs_per_op,
+                r->p50_ns, r->p90_ns, r->p99_ns, i + 1 < g_result_count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+static void print_usage(const char *program_name) {
+    fprintf(stderr, "Usage: %s [-o FILE] [-baseline FILE] [-tolerance PCT] [-filter NAME] [-quick]\n", program_name);
+}
+
+int main(int argc, char *argv[]) {
+    const char *out_path = NULL;
+    const char *baseline_path = NULL;
+    double tolerance = 25.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "-baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "-tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-filter") == 0 && i + 1 < argc) {
+            g_filter = argv[++i];
+        } else if (strcmp(argv[i], "-quick") == 0) {
+            g_scale = 0.1;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // the game prints a LOT, keep the real stdout for the JSON and send
+    // everything else to /dev/null
+    int json_fd = dup(STDOUT_FILENO);
+    FILE *json_out = out_path != NULL ? fopen(out_path, "w") : fdopen(json_fd, "w");
+    if (json_out == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        fprintf(stderr, "Error: could not set up output\n");
+        return 1;
+    }
+
+    // session script comes in on stdin
+    FILE *script = tmpfile();
+    if (script == NULL) {
+        fprintf(stderr, "Error: could not create session script\n");
+        return 1;
+    }
+    fputs(SESSION_SCRIPT, script);
+    fflush(script);
+    dup2(fileno(script), STDIN_FILENO);
+
+    srand(42); // same enemies every run
+    setenv("GAME_EASTER_EGGS", "0", 1);
+    set_log_level(LOG_NONE);
+    storage_select("memory"); // no disk noise
+    loot_init();
+    spawn_init();
+
+    fprintf(stderr, "Running benchmarks...\n");
+
+    Player player, mage;
+    make_player(&player, "__bench__", PALADIN);
+    make_player(&mage, "BenchMage", MAGE);
+
+    run_bench("initialize_enemy", bench_initialize_enemy, NULL, 2000, 50);
+    run_bench("create_item", bench_create_item, NULL, 5000, 50);
+    run_bench("create_health_potion", bench_create_health_potion, NULL, 5000, 50);
+    run_bench("cast_spell", bench_cast_spell, &mage, 2000, 50);
+    run_bench("spell_resolve_batch_1024", bench_spell_batch, NULL, 200, 50);
+    run_bench("loot_roll", bench_loot_roll, NULL, 100000, 50);
+    run_bench("spawn_pick_batch_1024", bench_spawn_batch, NULL, 200, 50);
+    int big_weights[CONTENT_LOOT_MAX];
+    for (int i = 0; i < CONTENT_LOOT_MAX; i++) big_weights[i] = i % 97 + 1;
+    AliasTable big_table;
+    alias_build(&big_table, big_weights, CONTENT_LOOT_MAX);
+    run_bench("alias_pick_1024", bench_alias_pick, &big_table, 100000, 50);
+    alias_free(&big_table);
+    run_bench("combat_resolve_closed_form", bench_combat_closed_form, &player, 100000, 50);
+    run_bench("combat_resolve_simulated", bench_combat_simulated, &player, 200, 50);
+    // enemy scripts from here on (the two above want plain attackers)
+    ai_init();
+    Enemy scripted;
+    initialize_enemy(&scripted, 5, 20);
+    scripted.type = BOSS;
+    run_bench("enemy_ai_turn", bench_enemy_ai_turn, &scripted, 200000, 50);
+    cleanup_enemy(&scripted);
+    run_bench("combat_resolve_attack_cycle", bench_combat_attack_cycle, &player, 100000, 50);
+    // climbing to area 3, then staying in area 1 with the goblins (their
+    // script rolls dice, so every level gets its fights sampled) and
+    // skeletons (attack cycle, settled once)
+    ProjectSpec climb = { ROGUE, 3, 1, 100, 1000, 7 };
+    run_bench("project_progression_100x1000", bench_project, &climb, 20, 50);
+    ProjectSpec goblins = { ROGUE, 1, 1, 100, 1000, 7 };
+    run_bench("project_progression_area1_100x1000", bench_project, &goblins, 20, 50);
+    // leaderboards with a crowd on them (memory backend, so the journal stays in ram)
+    leaderboard_init();
+    Player rival = { .playerClass = ROGUE, .level = 1 };
+    char rival_name[32];
+    rival.name = rival_name;
+    for (int i = 0; i < LEADERBOARD_BENCH_PLAYERS; i++) {
+        snprintf(rival_name, sizeof(rival_name), "bench%d", i);
+        rival.playerClass = (enum ClassType)(i % 3);
+        rival.level = 1 + rand() % 40;
+        rival.xp = rand() % 100;
+        rival.kills = rand() % 2000;
+        rival.gold = rand() % 5000;
+        leaderboard_update(&rival);
+    }
+    run_bench("leaderboard_update_100k", bench_leaderboard_update, &player, 20000, 50);
+    run_bench("leaderboard_rank_100k", bench_leaderboard_rank, NULL, 20000, 50);
+    run_bench("leaderboard_top10_100k", bench_leaderboard_top, NULL, 20000, 50);
+    leaderboard_shutdown();
+    auction_init();
+    run_bench("auction_match_10k_orders", bench_auction, NULL, 5, 20);
+    auction_shutdown();
+    Player traders[TRADE_BENCH_PLAYERS];
+    for (int i = 0; i < TRADE_BENCH_PLAYERS; i++) {
+        char trader_name[32];
+        snprintf(trader_name, sizeof(trader_name), "__trader%d__", i);
+        make_player(&traders[i], trader_name, PALADIN);
+        traders[i].gold = 1000000;
+    }
+    run_bench("trade_4_threads_8_players", bench_trade, traders, 2000, 20);
+    for (int i = 0; i < TRADE_BENCH_PLAYERS; i++) {
+        cleanup_player(&traders[i]);
+    }
+    int null_fd = open("/dev/null", O_WRONLY);
+    BroadcastSubscriber *listeners[BROADCAST_BENCH_SUBSCRIBERS];
+    for (int i = 0; i < BROADCAST_BENCH_SUBSCRIBERS; i++) {
+        listeners[i] = broadcast_subscribe(null_fd, 5);
+    }
+    run_bench("broadcast_5k_subscribers", bench_broadcast, listeners, 256, 20);
+    for (int i = 0; i < BROADCAST_BENCH_SUBSCRIBERS; i++) {
+        broadcast_unsubscribe(listeners[i]);
+    }
+    close(null_fd);
+    ShardBench *shard_bench = calloc(1, sizeof(ShardBench));
+    for (int i = 0; i < SHARD_BENCH_SESSIONS; i++) {
+        char shard_name[32];
+        snprintf(shard_name, sizeof(shard_name), "shard%d", i);
+        shard_bench->players[i].name = strdup(shard_name);
+    }
+    shard_start(1, 1, 42);
+    run_bench("shard_20_fights_per_session", bench_shard, shard_bench, 1000, 20);
+    shard_stop();
+    for (int i = 0; i < SHARD_BENCH_SESSIONS; i++) {
+        free(shard_bench->players[i].name);
+    }
+    free(shard_bench);
+    Party party;
+    Player party_players[PARTY_MAX_PLAYERS];
+    party_init(&party, 42);
+    for (int i = 0; i < PARTY_MAX_PLAYERS; i++) {
+        char member_name[32];
+        snprintf(member_name, sizeof(member_name), "member%d", i);
+        make_player(&party_players[i], member_name, (enum ClassType)(i % 3));
+        party_add_player(&party, &party_players[i]);
+    }
+    for (int i = 0; i < PARTY_MAX_ENEMIES; i++) {
+        Enemy enemy;
+        initialize_enemy(&enemy, 5, 10);
+        enemy.hp = enemy.maxHp = 1000000;
+        enemy.damage = 1;
+        party_add_enemy(&party, &enemy);
+    }
+    run_bench("party_tick_8_players", bench_party_tick, &party, 20000, 50);
+    party_cleanup(&party);
+    for (int i = 0; i < PARTY_MAX_PLAYERS; i++) {
+        cleanup_player(&party_players[i]);
+    }
+    Raid raid;
+    Enemy raid_boss;
+    initialize_enemy(&raid_boss, 5, 20);
+    raid_init(&raid, &raid_boss, 1LL << 60, 1000);
+    for (int i = 0; i < 1000; i++) {
+        raid_join(&raid, &player);
+    }
+    run_bench("raid_hit_1k_attackers", bench_raid, &raid, 400000, 20);
+    raid_cleanup(&raid);
+    HandoffBench handoff;
+    memset(&handoff, 0, sizeof(handoff));
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, handoff.conns) == 0) {
+        handoff.session.player = player;
+        handoff.session.state = GAME_STATE_EXPLORE;
+        handoff.session.fds[0] = handoff.conns[0]; // any fd will do
+        handoff.session.fd_count = 1;
+        run_bench("handoff_session_roundtrip", bench_handoff, &handoff, 5000, 50);
+        close(handoff.conns[0]);
+        close(handoff.conns[1]);
+    }
+    Player *sleeper = malloc(sizeof(Player));
+    make_player(sleeper, "sleeper", MAGE);
+    HibernateSession *hibernated = hibernate_add(sleeper, NULL);
+    if (hibernated != NULL) {
+        run_bench("hibernate_freeze_thaw", bench_hibernate, hibernated, 20000, 50);
+    }
+    hibernate_shutdown();
+    run_bench("log_event_disabled", bench_log_event, NULL, 100000, 50);
+    set_log_level(LOG_COMBAT);
+    run_bench("log_event_enabled", bench_log_event, NULL, 5000, 50);
+    set_log_level(LOG_NONE);
+    run_bench("add_player_xp", bench_add_player_xp, &player, 5000, 50);
+    run_bench("save_game_full_memory", bench_save_full, &player, 1000, 50);
+    run_bench("save_game_delta_memory", bench_save_delta, &player, 1000, 50);
+    run_bench("save_load_roundtrip_memory", bench_save_load_roundtrip, &player, 500, 50);
+    run_bench("load_game_cached_memory", bench_load_game, &player, 1000, 50);
+    player_cache_set_limit(0);
+    run_bench("load_game_uncached_memory", bench_load_game, &player, 1000, 50);
+    player_cache_set_limit((size_t)PLAYER_CACHE_DEFAULT_KB * 1024);
+    run_bench("game_session_memory", bench_game_session, NULL, 20, 50);
+
+    // same hot paths with stats on, to keep an eye on instrumentation cost
+    stats_init(NULL, 0);
+    run_bench("initialize_enemy_stats", bench_initialize_enemy, NULL, 2000, 50);
+    run_bench("save_game_full_memory_stats", bench_save_full, &player, 1000, 50);
+    stats_shutdown();
+
+    // same persistence workloads against real files for comparison
+    storage_select("file");
+    run_bench("save_game_full_file", bench_save_full, &player, 200, 20);
+    run_bench("save_load_roundtrip_file", bench_save_load_roundtrip, &player, 100, 20);
+    clear_save("__bench__.csv");
+
+    cleanup_player(&player);
+    cleanup_player(&mage);
+    storage_shutdown();
+    loot_shutdown();
+    spawn_shutdown();
+    ai_shutdown();
+    fclose(script);
+
+    write_json(json_out);
+    fclose(json_out);
+
+    if (baseline_path != NULL) {
+        int regressions = compare_with_baseline(baseline_path, tolerance);
+        if (regressions > 0) {
+            fprintf(stderr, "%d regression(s) vs baseline!\n", regressions);
+            return 1;
+        }
+        fprintf(stderr, "No regressions.\n");
+    }
+    return 0;
+}
@@ -0,0 +1,296 @@
+// broadcast.c - Per-area channels (kills, boss fights, chat)
+//
+// A message is formatted once into a buffer with a reference count, and
+// every subscriber in the area gets a pointer to that same buffer pushed
+// onto its queue. The count starts at everyone it's about to be queued
+// for, and whoever writes the last copy out frees it. So a kill in an area
+// with 5k people listening is one snprintf, one malloc and 5k pointer
+// stores.
+//
+// Each subscriber's queue is a ring with one producer (whoever holds the
+// channel lock) and one consumer (the thread that owns the connection),
+// so flushing never takes the channel lock. A flush turns the queued
+// buffers straight into an iovec and hands them to one writev.
+#include "broadcast.h"
+#include "utils.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+typedef struct {
+    int refs;   // queues still holding it
+    size_t len;
+    char data[];
+} BroadcastMessage;
+
+struct BroadcastSubscriber {
+    int fd;
+    int area;
+    int slot;            // index in the channel's array
+    unsigned int head;   // next to write (connection's thread)
+    unsigned int tail;   // next free (publisher, under the channel lock)
+    size_t offset;       // bytes of the head message already written
+    unsigned long dropped;
+    BroadcastMessage *queue[BROADCAST_QUEUE_LENGTH];
+};
+
+typedef struct {
+    pthread_mutex_t lock;
+    BroadcastSubscriber **subscribers;
+    int count; // read without the lock by publish's nobody-home check
+    int capacity;
+} BroadcastChannel;
+
+static BroadcastChannel g_channels[BROADCAST_AREAS] = {
+    [0 ... BROADCAST_AREAS - 1] = { PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0 }
+};
+
+static const char *KIND_TAGS[] = { "[kill] ", "[boss] ", "[chat] " };
+
+static BroadcastChannel *channel_for(int area) {
+    if (area < 1 || area > BROADCAST_AREAS) return NULL;
+    return &g_channels[area - 1];
+}
+
+static void release_message(BroadcastMessage *message) {
+    if (__atomic_sub_fetch(&message->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(message);
+    }
+}
+
+// drop everything still queued for a subscriber
+static void drain_queue(BroadcastSubscriber *subscriber) {
+    unsigned int tail = __atomic_load_n(&subscriber->tail, __ATOMIC_ACQUIRE);
+    for (unsigned int i = subscriber->head; i != tail; i++) {
+        release_message(subscriber->queue[i % BROADCAST_QUEUE_LENGTH]);
+    }
+    subscriber->head = tail;
+    subscriber->offset = 0;
+}
+
+// both with the channel locked
+static bool channel_add(BroadcastChannel *channel, BroadcastSubscriber *subscriber) {
+    if (channel->count == channel->capacity) {
+        int new_capacity = channel->capacity == 0 ? 16 : channel->capacity * 2;
+        BroadcastSubscriber **bigger = realloc(channel->subscribers,
+                                               sizeof(BroadcastSubscriber *) * new_capacity);
+        if (bigger == NULL) return false;
+        channel->subscribers = bigger;
+        channel->capacity = new_capacity;
+    }
+    subscriber->slot = channel->count;
+    channel->subscribers[channel->count] = subscriber;
+    __atomic_store_n(&channel->count, channel->count + 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+static void channel_remove(BroadcastChannel *channel, BroadcastSubscriber *subscriber) {
+    // last one fills the hole
+    int last = channel->count - 1;
+    channel->subscribers[subscriber->slot] = channel->subscribers[last];
+    channel->subscribers[subscriber->slot]->slot = subscriber->slot;
+    __atomic_store_n(&channel->count, last, __ATOMIC_RELAXED);
+}
+
+BroadcastSubscriber *broadcast_subscribe(int fd, int area) {
+    BroadcastChannel *channel = channel_for(area);
+    if (channel == NULL || fd < 0) return NULL;
+
+    BroadcastSubscriber *subscriber = calloc(1, sizeof(BroadcastSubscriber));
+    if (subscriber == NULL) {
+        fprintf(stderr, "Error: Could not allocate broadcast subscriber\n");
+        return NULL;
+    }
+    subscriber->fd = fd;
+    subscriber->area = area;
+
+    pthread_mutex_lock(&channel->lock);
+    bool added = channel_add(channel, subscriber);
+    pthread_mutex_unlock(&channel->lock);
+
+    if (!added) {
+        fprintf(stderr, "Error: Could not grow area %d's channel\n", area);
+        free(subscriber);
+        return NULL;
+    }
+    return subscriber;
+}
+
+bool broadcast_move(BroadcastSubscriber *subscriber, int area) {
+    BroadcastChannel *to = channel_for(area);
+    if (subscriber == NULL || to == NULL) return false;
+    if (area == subscriber->area) return true;
+    BroadcastChannel *from = channel_for(subscriber->area);
+
+    // lower area first so two moves the opposite way cant deadlock
+    BroadcastChannel *first = from < to ? from : to;
+    BroadcastChannel *second = from < to ? to : from;
+    pthread_mutex_lock(&first->lock);
+    pthread_mutex_lock(&second->lock);
+
+    // add before removing so a failed grow leaves them where they were
+    int old_slot = subscriber->slot;
+    bool added = channel_add(to, subscriber);
+    if (added) {
+        int new_slot = subscriber->slot;
+        subscriber->slot = old_slot;
+        channel_remove(from, subscriber);
+        subscriber->slot = new_slot;
+        subscriber->area = area;
+    } else {
+        subscriber->slot = old_slot;
+    }
+
+    pthread_mutex_unlock(&second->lock);
+    pthread_mutex_unlock(&first->lock);
+    return added;
+}
+
+void broadcast_unsubscribe(BroadcastSubscriber *subscriber) {
+    if (subscriber == NULL) return;
+    BroadcastChannel *channel = channel_for(subscriber->area);
+
+    pthread_mutex_lock(&channel->lock);
+    channel_remove(channel, subscriber);
+    pthread_mutex_unlock(&channel->lock);
+
+    drain_queue(subscriber);
+    free(subscriber);
+}
+
+int broadcast_publish(int area, BroadcastKind kind, const char *format, ...) {
+    BroadcastChannel *channel = channel_for(area);
+    if (channel == NULL || format == NULL) return 0;
+    if (kind < BROADCAST_KILL || kind > BROADCAST_CHAT) return 0;
+
+    // nobody listening, dont even format it
+    if (__atomic_load_n(&channel->count, __ATOMIC_RELAXED) == 0) return 0;
+
+    // formatted once, the one copy everyone shares
+    char text[BROADCAST_MESSAGE_MAX];
+    size_t tag_len = strlen(KIND_TAGS[kind]);
+    memcpy(text, KIND_TAGS[kind], tag_len);
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(text + tag_len, sizeof(text) - tag_len - 1, format, args);
+    va_end(args);
+    if (written < 0) return 0;
+
+    size_t len = tag_len + (size_t)written;
+    if (len > sizeof(text) - 2) len = sizeof(text) - 2; // cut off, keep room for \n
+    text[len++] = '\n';
+
+    BroadcastMessage *message = malloc(offsetof(BroadcastMessage, data) + len);
+    if (message == NULL) {
+        fprintf(stderr, "Error: Could not allocate broadcast message\n");
+        return 0;
+    }
+    memcpy(message->data, text, len);
+    message->len = len;
+
+    pthread_mutex_lock(&channel->lock);
+
+    // one ref per subscriber up front (plus ours, so nobody frees it while
+    // we're still handing it out), give back the ones that didnt fit
+    int count = channel->count;
+    message->refs = count + 1;
+    int queued = 0;
+    for (int i = 0; i < count; i++) {
+        BroadcastSubscriber *subscriber = channel->subscribers[i];
+        unsigned int tail = subscriber->tail;
+        unsigned int head = __atomic_load_n(&subscriber->head, __ATOMIC_ACQUIRE);
+        if (tail - head >= BROADCAST_QUEUE_LENGTH) {
+            subscriber->dropped++;
+            continue;
+        }
+        subscriber->queue[tail % BROADCAST_QUEUE_LENGTH] = message;
+        __atomic_store_n(&subscriber->tail, tail + 1, __ATOMIC_RELEASE);
+        queued++;
+    }
+
+    pthread_mutex_unlock(&channel->lock);
+
+    if (__atomic_sub_fetch(&message->refs, count + 1 - queued, __ATOMIC_ACQ_REL) == 0) {
+        free(message);
+    }
+    return queued;
+}
+
+int broadcast_chat(const Player *player, const char *text) {
+    if (player == NULL || player->name == NULL || text == NULL) return 0;
+    return broadcast_publish(player->area_level, BROADCAST_CHAT, "%s: %s", player->name, text);
+}
+
+ssize_t broadcast_flush(BroadcastSubscriber *subscriber) {
+    if (subscriber == NULL) return -1;
+
+    unsigned int head = subscriber->head;
+    unsigned int tail = __atomic_load_n(&subscriber->tail, __ATOMIC_ACQUIRE);
+    if (head == tail) return 0;
+
+    // the queued buffers themselves, nothing copied
+    struct iovec iov[BROADCAST_QUEUE_LENGTH];
+    int iov_count = 0;
+    for (unsigned int i = head; i != tail; i++) {
+        BroadcastMessage *message = subscriber->queue[i % BROADCAST_QUEUE_LENGTH];
+        size_t skip = (i == head) ? subscriber->offset : 0;
+        iov[iov_count].iov_base = message->data + skip;
+        iov[iov_count].iov_len = message->len - skip;
+        iov_count++;
+    }
+
+    ssize_t written = writev(subscriber->fd, iov, iov_count);
+    if (written < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return 0;
+        log_event(LOG_ERROR, "Broadcast write to fd %d failed: %s", subscriber->fd, strerror(errno));
+        return -1;
+    }
+
+    // let go of everything that made it out, remember how far into a
+    // message a short write got
+    size_t left = (size_t)written;
+    for (int i = 0; i < iov_count; i++) {
+        if (left < iov[i].iov_len) {
+            subscriber->offset += left;
+            break;
+        }
+        left -= iov[i].iov_len;
+        release_message(subscriber->queue[head % BROADCAST_QUEUE_LENGTH]);
+        head++;
+        subscriber->offset = 0;
+    }
+    __atomic_store_n(&subscriber->head, head, __ATOMIC_RELEASE);
+    return written;
+}
+
+unsigned long broadcast_dropped(const BroadcastSubscriber *subscriber) {
+    if (subscriber == NULL) return 0;
+    return subscriber->dropped;
+}
+
+int broadcast_listeners(int area) {
+    BroadcastChannel *channel = channel_for(area);
+    if (channel == NULL) return 0;
+    return __atomic_load_n(&channel->count, __ATOMIC_RELAXED);
+}
+
+void broadcast_shutdown() {
+    for (int area = 1; area <= BROADCAST_AREAS; area++) {
+        BroadcastChannel *channel = channel_for(area);
+        pthread_mutex_lock(&channel->lock);
+        for (int i = 0; i < channel->count; i++) {
+            drain_queue(channel->subscribers[i]);
+            free(channel->subscribers[i]);
+        }
+        free(channel->subscribers);
+        channel->subscribers = NULL;
+        channel->count = 0;
+        channel->capacity = 0;
+        pthread_mutex_unlock(&channel->lock);
+    }
+}
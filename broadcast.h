@@ -0,0 +1,66 @@
+// broadcast.h - Per-area channels (kills, boss fights, chat)
+#ifndef BROADCAST_H
+#define BROADCAST_H
+
+#include <stdbool.h>
+#include <sys/types.h> // ssize_t
+#include "player.h"
+#include "content.h" // CONTENT_AREAS
+
+// one channel per area (1..BROADCAST_AREAS)
+#define BROADCAST_AREAS CONTENT_AREAS
+
+// longest message, longer ones get cut off
+#define BROADCAST_MESSAGE_MAX 256
+
+// messages a subscriber can have waiting, anything past that is dropped
+// for them (a connection that stopped reading shouldnt hold up everyone)
+// also the most a flush hands to one writev
+#define BROADCAST_QUEUE_LENGTH 256
+
+typedef enum {
+    BROADCAST_KILL,
+    BROADCAST_BOSS,
+    BROADCAST_CHAT
+} BroadcastKind;
+
+// a connection listening to one area
+typedef struct BroadcastSubscriber BroadcastSubscriber;
+
+// start sending an area's messages to fd (socket, pipe, file...)
+// NULL if the area is out of range or out of memory
+BroadcastSubscriber *broadcast_subscribe(int fd, int area);
+
+// switch to another area's channel (whatever is queued still goes out)
+bool broadcast_move(BroadcastSubscriber *subscriber, int area);
+
+// stop listening, drops whatever hadnt been written yet
+void broadcast_unsubscribe(BroadcastSubscriber *subscriber);
+
+// Format a message once and queue it on everyone in the area. Every
+// subscriber gets a reference to the same buffer, nothing is copied or
+// formatted per subscriber. Safe from any thread. Costs nothing (not
+// even the formatting) when nobody is listening.
+// returns how many subscribers it was queued for
+int broadcast_publish(int area, BroadcastKind kind, const char *format, ...);
+
+// chat line from a player to their area
+int broadcast_chat(const Player *player, const char *text);
+
+// write whats queued for one subscriber with a single writev, picks up
+// where a short write left off. One thread per subscriber (the one that
+// owns the connection) flushes and unsubscribes it.
+// returns bytes written, 0 if nothing was waiting or the fd would block,
+// -1 on a write error
+ssize_t broadcast_flush(BroadcastSubscriber *subscriber);
+
+// messages dropped for a subscriber because their queue was full
+unsigned long broadcast_dropped(const BroadcastSubscriber *subscriber);
+
+// subscribers in an area
+int broadcast_listeners(int area);
+
+// unsubscribe everyone and free whats left
+void broadcast_shutdown();
+
+#endif // BROADCAST_H
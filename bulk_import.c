@@ -0,0 +1,270 @@
+// bulk_import.c - Offline migration of CSV saves into the save backend
+#include "bulk_import.h"
+#include "save_game.h"
+#include "player.h"
+#include "utils.h" // csv_scan_lines
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// work shared by all the import threads
+typedef struct {
+    char **paths;
+    size_t count;
+    size_t next; // next file to grab, bumped atomically
+} ImportJob;
+
+// each thread fills its own batch, the backend does the locking
+typedef struct {
+    pthread_t thread;
+    ImportJob *job;
+    Player batch[SAVE_BATCH_MAX];
+    int batch_count;
+    long records;
+    long skipped;
+    size_t bytes_in;
+    bool failed; // a batch didnt make it to the backend
+} ImportWorker;
+
+// read a whole file into a malloc'd buffer (with room for a '\0')
+static char *read_whole_file(const char *path, size_t *len_out) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    char *buf = malloc((size_t)size + 1);
+    if (buf != NULL) {
+        *len_out = fread(buf, 1, (size_t)size, file);
+        buf[*len_out] = '\0';
+    }
+    fclose(file);
+    return buf;
+}
+
+// scanner callback, just feeds the record
+static void apply_line(const char *key, const char *value, void *ctx) {
+    save_record_apply((SaveRecord *)ctx, key, value);
+}
+
+// parse one file (+ journal) into the record, false if its not there
+static bool parse_save_file(ImportWorker *worker, const char *path, SaveRecord *record) {
+    size_t len = 0;
+    char *buf = read_whole_file(path, &len);
+    if (buf == NULL) return false;
+    worker->bytes_in += len;
+
+    // anything without the save header isnt a save, dont import junk
+    if (strncmp(buf, "key,value", 9) != 0 || (buf[9] != '\n' && buf[9] != '\r')) {
+        fprintf(stderr, "Error: '%s' is not a save file (no key,value header), skipping\n", path);
+        free(buf);
+        return false;
+    }
+    csv_scan_lines(buf, len, apply_line, record);
+    free(buf);
+
+    // journal entries go on top, same as load_game
+    char journal_path[1024];
+    int path_len = snprintf(journal_path, sizeof(journal_path), "%s%s", path, SAVE_JOURNAL_SUFFIX);
+    if (path_len < 0 || (size_t)path_len >= sizeof(journal_path)) {
+        fprintf(stderr, "Error: Journal path for '%s' is too long.\n", path);
+        return false;
+    }
+    buf = read_whole_file(journal_path, &len);
+    if (buf != NULL) {
+        worker->bytes_in += len;
+        csv_scan_lines(buf, len, apply_line, record);
+        free(buf);
+    }
+    return true;
+}
+
+// free a player built by save_record_to_player (cleanup_player would
+// print a line per item, which is a lot of noise for a whole archive)
+static void free_imported_player(Player *player) {
+    if (player->inventory != NULL) {
+        for (int i = 0; i < player->inventory_size; i++) {
+            if (player->inventory[i] != NULL) {
+                free(player->inventory[i]->name);
+                free(player->inventory[i]);
+            }
+        }
+        free(player->inventory);
+    }
+    free(player->name);
+    memset(player, 0, sizeof(Player));
+}
+
+// write the pending players as one backend batch and reset it
+static void flush_batch(ImportWorker *worker) {
+    if (worker->batch_count == 0) return;
+
+    Player *players[SAVE_BATCH_MAX];
+    for (int i = 0; i < worker->batch_count; i++) players[i] = &worker->batch[i];
+
+    if (save_game_batch(players, NULL, worker->batch_count)) {
+        worker->records += worker->batch_count;
+    } else {
+        worker->skipped += worker->batch_count;
+        worker->failed = true;
+    }
+
+    for (int i = 0; i < worker->batch_count; i++) free_imported_player(&worker->batch[i]);
+    worker->batch_count = 0;
+}
+
+// thread body: keep grabbing files till there are none left
+static void *import_worker_main(void *arg) {
+    ImportWorker *worker = (ImportWorker *)arg;
+    ImportJob *job = worker->job;
+    SaveRecord record;
+    trace_set_thread_name("import worker");
+
+    for (;;) {
+        size_t index = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+        if (index >= job->count) break;
+        TRACE_SCOPE("import_save");
+
+        save_record_init(&record);
+        if (!parse_save_file(worker, job->paths[index], &record) || !record.name_found) {
+            worker->skipped++;
+            continue;
+        }
+
+        Player *player = &worker->batch[worker->batch_count];
+        if (!save_record_to_player(&record, player)) {
+            free_imported_player(player);
+            worker->skipped++;
+            continue;
+        }
+        if (++worker->batch_count == SAVE_BATCH_MAX) flush_batch(worker);
+    }
+    flush_batch(worker);
+    return NULL;
+}
+
+// does the name end in .csv?
+static bool is_csv_name(const char *name) {
+    size_t len = strlen(name);
+    return len > 4 && strcmp(name + len - 4, ".csv") == 0;
+}
+
+// collect every *.csv path in dir, returns count (paths must be freed)
+static size_t list_csv_files(const char *dir, char ***paths_out) {
+    DIR *d = opendir(dir);
+    if (d == NULL) return 0;
+
+    size_t count = 0, cap = 64;
+    char **paths = malloc(sizeof(char *) * cap);
+    struct dirent *entry;
+    while (paths != NULL && (entry = readdir(d)) != NULL) {
+        if (!is_csv_name(entry->d_name)) continue;
+        if (count == cap) {
+            char **bigger = realloc(paths, sizeof(char *) * cap * 2);
+            if (bigger == NULL) break;
+            paths = bigger;
+            cap *= 2;
+        }
+        size_t len = strlen(dir) + strlen(entry->d_name) + 2;
+        paths[count] = malloc(len);
+        if (paths[count] == NULL) break;
+        snprintf(paths[count], len, "%s/%s", dir, entry->d_name);
+        count++;
+    }
+    closedir(d);
+
+    *paths_out = paths;
+    return count;
+}
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Import every save in dir into the active save backend
+long bulk_import_saves(const char *dir, int threads) {
+    if (dir == NULL) return -1;
+
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+
+    double start = now_seconds();
+
+    ImportJob job = { NULL, 0, 0 };
+    job.count = list_csv_files(dir, &job.paths);
+    if (job.paths == NULL) {
+        fprintf(stderr, "Error: Could not read save directory '%s'\n", dir);
+        return -1;
+    }
+    if ((size_t)threads > job.count && job.count > 0) threads = (int)job.count;
+
+    ImportWorker *workers = calloc((size_t)threads, sizeof(ImportWorker));
+    if (workers == NULL) {
+        for (size_t i = 0; i < job.count; i++) free(job.paths[i]);
+        free(job.paths);
+        return -1;
+    }
+
+    // fire up the pool
+    int started = 0;
+    for (int t = 0; t < threads; t++) {
+        workers[t].job = &job;
+        if (pthread_create(&workers[t].thread, NULL, import_worker_main, &workers[t]) != 0) {
+            break;
+        }
+        started++;
+    }
+    if (started == 0) {
+        // no threads? just do it on this one
+        workers[0].job = &job;
+        import_worker_main(&workers[0]);
+        started = 1;
+    } else {
+        for (int t = 0; t < started; t++) {
+            pthread_join(workers[t].thread, NULL);
+        }
+    }
+
+    long records = 0, skipped = 0;
+    size_t bytes_in = 0;
+    bool ok = true;
+    for (int t = 0; t < started; t++) {
+        records += workers[t].records;
+        skipped += workers[t].skipped;
+        bytes_in += workers[t].bytes_in;
+        if (workers[t].failed) ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error: Some saves could not be written to the save backend\n");
+    }
+
+    double elapsed = now_seconds() - start;
+    if (elapsed <= 0) elapsed = 1e-9;
+
+    printf("Imported %ld records from '%s' (%ld skipped, %d threads)\n",
+           records, dir, skipped, started);
+    printf("%.3f s, %.0f records/sec, %zu bytes CSV read\n",
+           elapsed, records / elapsed, bytes_in);
+
+    free(workers);
+    for (size_t i = 0; i < job.count; i++) free(job.paths[i]);
+    free(job.paths);
+
+    return ok ? records : -1;
+}
@@ -0,0 +1,13 @@
+// bulk_import.h - Offline migration of CSV saves into the save backend
+#ifndef BULK_IMPORT_H
+#define BULK_IMPORT_H
+
+// import every *.csv (plus its .journal) in dir into storage_active(),
+// each one folded into a fresh snapshot so load_game picks it up as is
+// (files without the key,value header get skipped)
+// threads <= 0 means one per cpu
+// prints records/sec when done, returns number of records written or -1
+// if any of them didnt make it to the backend
+long bulk_import_saves(const char *dir, int threads);
+
+#endif // BULK_IMPORT_H
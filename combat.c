@@ -0,0 +1,278 @@
+// combat.c - Settle a fight without playing it turn by turn
+//
+// start_combat goes: player hits, enemy dead?, enemy hits, player dead?
+// When both sides do the same damage every turn that's just arithmetic:
+// the player needs ceil(enemy hp / player dmg) hits, the enemy needs
+// ceil(player hp / enemy dmg), and the player swings first so they win
+// ties. An enemy whose script only changes how hard it hits by turn
+// number ("attack 150 when every 3") repeats every few turns, so its hits
+// are whole cycles plus a bit. Anything that changes hp or damage mid
+// fight (potions, random spells, heals, enrages, dice rolls) gets
+// simulated instead, still without any printing.
+#include "combat.h"
+#include "ai.h"
+#include "game.h"
+#include "spells.h"
+#include "stats.h"
+#include "rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEFAULT_MAX_TURNS 10000
+
+// hits needed to take hp down to 0, -1 if damage cant do it
+static long long hits_needed(int hp, int damage) {
+    if (damage <= 0) return -1;
+    return ((long long)hp + damage - 1) / damage;
+}
+
+// damage the enemy does on its turn number index + 1 of the cycle
+// (same rounding as the ai's attack)
+static long long cycle_hit(int damage, const unsigned char *percent, int index) {
+    return (long long)damage * percent[index] / 100;
+}
+
+// what the enemy's first hits turns add up to
+static long long cycle_damage(int damage, const unsigned char *percent, int length, long long hits) {
+    long long per_cycle = 0, rest = 0;
+    for (int i = 0; i < length; i++) {
+        per_cycle += cycle_hit(damage, percent, i);
+        if (i < hits % length) rest += cycle_hit(damage, percent, i);
+    }
+    return hits / length * per_cycle + rest;
+}
+
+// enemy turns needed to take hp down to 0, -1 if its hits never do damage
+static long long cycle_hits_needed(int hp, int damage, const unsigned char *percent, int length) {
+    long long per_cycle = cycle_damage(damage, percent, length, length);
+    if (per_cycle <= 0) return -1;
+    // whole cycles that still leave them standing, then turn by turn
+    long long cycles = (hp - 1) / per_cycle;
+    long long done = cycles * per_cycle;
+    int i = 0;
+    while (done < hp) done += cycle_hit(damage, percent, i++);
+    return cycles * length + i;
+}
+
+// both sides do fixed damage every turn, the enemy's going round its
+// attack cycle (see ai_attack_cycle)
+static CombatResult closed_form(int player_hp, int player_damage, int enemy_hp, int enemy_damage,
+                                const unsigned char *percent, int length, int max_turns) {
+    CombatResult result = { COMBAT_STALEMATE, 0, player_hp, enemy_hp, 0, false };
+    long long player_hits = hits_needed(enemy_hp, player_damage);
+    long long enemy_hits = cycle_hits_needed(player_hp, enemy_damage, percent, length);
+
+    if (player_hits < 0 && enemy_hits < 0) {
+        result.turns = max_turns; // would go on forever
+    } else if (enemy_hits < 0 || (player_hits >= 0 && player_hits <= enemy_hits)) {
+        // player lands the last hit before the enemy gets their turn
+        result.winner = COMBAT_PLAYER_WON;
+        result.turns = (int)player_hits;
+        result.enemy_hp = 0;
+        if (enemy_damage > 0) {
+            result.player_hp = (int)(player_hp - cycle_damage(enemy_damage, percent, length, player_hits - 1));
+        }
+    } else {
+        result.winner = COMBAT_ENEMY_WON;
+        result.turns = (int)enemy_hits;
+        result.player_hp = 0;
+        if (player_damage > 0) result.enemy_hp = (int)(enemy_hp - enemy_hits * player_damage);
+    }
+
+    if (result.turns > max_turns) {
+        // longer than we're willing to wait, same as the simulation giving up
+        result.winner = COMBAT_STALEMATE;
+        result.turns = max_turns;
+    }
+    return result;
+}
+
+static int compare_desc(const void *a, const void *b) {
+    return *(const int *)b - *(const int *)a;
+}
+
+// the potion values the player is carrying, strongest first (caller frees)
+static int *collect_potions(const Player *player, int *count) {
+    *count = 0;
+    if (player->inventory_size <= 0) return NULL;
+    int *potions = malloc(sizeof(int) * player->inventory_size);
+    if (potions == NULL) return NULL;
+    for (int i = 0; i < player->inventory_size; i++) {
+        const Item *item = player->inventory[i];
+        if (item != NULL && item->type == HEALING) potions[(*count)++] = item->value;
+    }
+    qsort(potions, *count, sizeof(int), compare_desc);
+    return potions;
+}
+
+// start_combat with the choices made by the policy and nothing printed
+static CombatResult simulate(const Player *player, const Enemy *enemy,
+                             const CombatPolicy *policy, int max_turns) {
+    CombatResult result = { COMBAT_STALEMATE, 0, player->hp, enemy->hp, 0, true };
+    unsigned int rng = rng_seed(policy->seed);
+    AiState ai; // own rolls, so the enemy's script doesnt shift the spell rolls
+    ai_begin(&ai, enemy, policy->seed ^ 0x5BD1E995u);
+    bool plain = ai_is_plain(enemy->type);
+    bool casting = policy->spell >= 0;
+    SpellCast cast = { (SpellType)(casting ? policy->spell : 0), policy->spell_power, 0, 0.0f };
+    bool heal_spell = casting && spell_desc(cast.spell) != NULL &&
+                      spell_desc(cast.spell)->effect == SPELL_EFFECT_HEAL;
+
+    int potion_count = 0, next_potion = 0;
+    int *potions = policy->use_potions ? collect_potions(player, &potion_count) : NULL;
+    int potion_hp = player->maxHp * policy->potion_below_pct / 100;
+
+    while (result.player_hp > 0 && result.enemy_hp > 0) {
+        if (result.turns >= max_turns) {
+            result.winner = COMBAT_STALEMATE;
+            break;
+        }
+        result.turns++;
+
+        // player's turn: potion, spell or plain attack
+        if (next_potion < potion_count && result.player_hp <= potion_hp) {
+            result.player_hp += potions[next_potion++];
+            if (result.player_hp > player->maxHp) result.player_hp = player->maxHp;
+            result.potions_used++;
+        } else if (casting) {
+            int amount = 0;
+            if (player->playerClass == MAGE) spell_resolve_batch(&cast, 1, &amount, &rng);
+            if (heal_spell) {
+                result.player_hp += amount;
+                if (result.player_hp > player->maxHp) result.player_hp = player->maxHp;
+            } else if (amount > 0) {
+                result.enemy_hp -= amount;
+            }
+        } else {
+            result.enemy_hp -= player->damage;
+        }
+        if (result.enemy_hp <= 0) {
+            result.enemy_hp = 0;
+            result.winner = COMBAT_PLAYER_WON;
+            break;
+        }
+
+        // enemy's turn: poison, then whatever its script picks (plain
+        // attackers skip the script, it would just say attack anyway)
+        if (plain) {
+            result.player_hp -= enemy->damage;
+        } else {
+            result.player_hp -= ai_poison_tick(&ai);
+            int amount = 0; // poison got there first = no turn
+            AiAction action = AI_ATTACK;
+            if (result.player_hp > 0) {
+                action = ai_enemy_turn(&ai, result.enemy_hp, enemy->maxHp,
+                                       result.player_hp, player->maxHp, &amount);
+            }
+            if (action == AI_FLEE) {
+                result.winner = COMBAT_ENEMY_FLED;
+                break;
+            }
+            if (action == AI_HEAL) result.enemy_hp += amount;
+            else if (action == AI_ATTACK || action == AI_POISON) result.player_hp -= amount;
+        }
+        if (result.player_hp <= 0) {
+            result.player_hp = 0;
+            result.winner = COMBAT_ENEMY_WON;
+        }
+    }
+
+    free(potions);
+    return result;
+}
+
+CombatResult combat_resolve(const Player *player, const Enemy *enemy, const CombatPolicy *policy) {
+    CombatResult result = { COMBAT_STALEMATE, 0, 0, 0, 0, false };
+    if (player == NULL || enemy == NULL) return result;
+
+    CombatPolicy attack = COMBAT_POLICY_ATTACK;
+    if (policy == NULL) policy = &attack;
+    int max_turns = policy->max_turns > 0 ? policy->max_turns : DEFAULT_MAX_TURNS;
+
+    // start_combat doesnt even start if someone's already down
+    if (player->hp <= 0 || enemy->hp <= 0) {
+        result.winner = player->hp <= 0 ? COMBAT_ENEMY_WON : COMBAT_PLAYER_WON;
+        result.player_hp = player->hp > 0 ? player->hp : 0;
+        result.enemy_hp = enemy->hp > 0 ? enemy->hp : 0;
+        return result;
+    }
+
+    // potions change hp halfway through, that's simulation territory
+    // (unless there's nothing to drink)
+    bool needs_simulation = false;
+    if (policy->use_potions) {
+        for (int i = 0; i < player->inventory_size && !needs_simulation; i++) {
+            needs_simulation = player->inventory[i] != NULL && player->inventory[i]->type == HEALING;
+        }
+    }
+
+    int player_damage = player->damage;
+    if (policy->spell >= 0) {
+        const SpellDesc *desc = spell_desc((SpellType)policy->spell);
+        if (desc == NULL) {
+            player_damage = 0; // unknown spell fizzles
+        } else if (player->playerClass != MAGE) {
+            player_damage = 0; // "isn't a mage! Nothing happens."
+        } else if (desc->effect == SPELL_EFFECT_HEAL || spell_is_random(desc->type)) {
+            needs_simulation = true;
+        } else {
+            // fixed damage spell, one cast tells us what every cast does
+            SpellCast cast = { desc->type, policy->spell_power, 0, 0.0f };
+            unsigned int rng = rng_seed(policy->seed);
+            spell_resolve_batch(&cast, 1, &player_damage, &rng);
+        }
+    }
+
+    // negative damage heals the other side in the real game, let the
+    // simulation deal with that weirdness
+    if (player_damage < 0 || enemy->damage < 0) needs_simulation = true;
+
+    // heals, enrages, poison, dice... only an enemy that just goes round
+    // its attacks does the same every cycle
+    const unsigned char *percent = NULL;
+    int length = ai_attack_cycle(enemy->type, &percent);
+    if (length == 0) needs_simulation = true;
+
+    if (needs_simulation) return simulate(player, enemy, policy, max_turns);
+    return closed_form(player->hp, player_damage, enemy->hp, enemy->damage, percent, length, max_turns);
+}
+
+void auto_combat(Player *player, Enemy *enemy) {
+    if (player == NULL || enemy == NULL) {
+        return;
+    }
+
+    STATS_COUNT(COUNTER_COMBATS, 1);
+    printf("\n--- AUTO-BATTLE ---\n");
+    printf("You face a Level %d %s!\n", enemy->level, enemy->name);
+
+    // fresh dice for the enemy ai every battle, like start_combat
+    CombatPolicy policy = COMBAT_POLICY_ATTACK;
+    policy.seed = (unsigned int)rand();
+    CombatResult result = combat_resolve(player, enemy, &policy);
+    player->hp = result.player_hp;
+    mark_player_dirty(player, DIRTY_HP);
+    enemy->hp = result.enemy_hp;
+    log_event(LOG_COMBAT, "Auto-battle vs %s: %d turns, %d HP left", enemy->name, result.turns, player->hp);
+
+    switch (result.winner) {
+        case COMBAT_PLAYER_WON:
+            printf("\n%s has been defeated after %d turns! HP left: %d/%d\n",
+                   enemy->name, result.turns, player->hp, player->maxHp);
+            STATS_COUNT(COUNTER_KILLS, 1);
+            handle_enemy_defeat(player, enemy);
+            break;
+        case COMBAT_ENEMY_WON:
+            printf("\nYou have been defeated by %s after %d turns!\n", enemy->name, result.turns);
+            printf("GAME OVER\n");
+            STATS_COUNT(COUNTER_DEATHS, 1);
+            break;
+        case COMBAT_ENEMY_FLED:
+            printf("\n%s ran away after %d turns. HP left: %d/%d\n",
+                   enemy->name, result.turns, player->hp, player->maxHp);
+            break;
+        case COMBAT_STALEMATE:
+            printf("\nNeither of you can hurt the other. You back away from %s.\n", enemy->name);
+            break;
+    }
+}
@@ -0,0 +1,51 @@
+// combat.h - Settle a fight without playing it turn by turn
+#ifndef COMBAT_H
+#define COMBAT_H
+
+#include <stdbool.h>
+#include "player.h"
+#include "enemy.h"
+#include "utils.h" // SpellType
+
+typedef enum {
+    COMBAT_PLAYER_WON,
+    COMBAT_ENEMY_WON,
+    COMBAT_ENEMY_FLED, // its ai script ran away, nobody gets anything
+    COMBAT_STALEMATE  // nobody can hurt anybody (or max_turns ran out)
+} CombatWinner;
+
+typedef struct {
+    CombatWinner winner;
+    int turns;      // turns played, same counting as start_combat
+    int player_hp;  // left at the end
+    int enemy_hp;
+    int potions_used;
+    bool simulated; // had to play it out, the closed form didnt apply
+} CombatResult;
+
+// How the player fights. Plain attacks (or a spell that always does the
+// same damage) against an enemy that only attacks (see ai_attack_cycle)
+// are solved without playing the fight, potions, random spells and any
+// other enemy ai script fall back to a quiet turn by turn simulation
+typedef struct {
+    int spell;          // SpellType to cast every turn (mages), -1 = attack
+    int spell_power;    // intensity / radius / power for that spell
+    bool use_potions;   // drink the strongest potion when hp gets low
+    int potion_below_pct; // ... low meaning at or under this % of maxHp
+    unsigned int seed;  // for random spells (see rng.h)
+    int max_turns;      // simulation gives up here (0 = 10000)
+} CombatPolicy;
+
+// attack only, no potions
+#define COMBAT_POLICY_ATTACK { -1, 0, false, 0, 0, 0 }
+
+// Work out how player vs enemy ends without touching either of them (no
+// printing, no inventory changes). policy NULL = attack only with seed 0,
+// so the enemy ai rolls the same every time (live fights pass a seed)
+CombatResult combat_resolve(const Player *player, const Enemy *enemy, const CombatPolicy *policy);
+
+// start_combat but settled instantly with combat_resolve (attack only):
+// applies the result to the player and hands out rewards like a normal win
+void auto_combat(Player *player, Enemy *enemy);
+
+#endif // COMBAT_H
@@ -0,0 +1,242 @@
+// config.c - Game settings, read once into an immutable snapshot
+//
+// Only the main thread builds snapshots (startup, config_poll),
+// other threads just read config_get(). Old snapshots stay allocated until
+// config_shutdown() so a pointer someone grabbed before a reload never
+// dangles, reloads are rare enough that this costs nothing.
+#include "config.h"
+#include "utils.h" // log levels, log_event
+#include "enemy.h" // enemy type range
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <signal.h>
+
+// every setting by config file key and environment variable
+typedef enum {
+    KEY_LOG_LEVEL,
+    KEY_DIFFICULTY,
+    KEY_EASTER_EGGS,
+    KEY_ENEMY_TYPE,
+    KEY_ENEMY_HP,
+    KEY_EVENT,
+    KEY_COUNT
+} ConfigKey;
+
+static const char *CONFIG_KEYS[KEY_COUNT][2] = {
+    { "log_level",   "GAME_LOG_LEVEL" },
+    { "difficulty",  "GAME_DIFFICULTY" },
+    { "easter_eggs", "GAME_EASTER_EGGS" },
+    { "enemy_type",  "CMMO_ENEMY_TYPE" },
+    { "enemy_hp",    "CMMO_ENEMY_HP" },
+    { "event",       "GAME_EVENT" }
+};
+
+static const GameConfig DEFAULT_CONFIG = {
+    .log_level = LOG_ERROR | LOG_COMBAT,
+    .difficulty = 1,
+    .easter_eggs = 1,
+    .enemy_type = -1,
+    .enemy_hp = 0,
+    .event = "",
+    .generation = 0
+};
+
+// a published snapshot plus the list link so we can free it later
+typedef struct ConfigSnapshot {
+    GameConfig config;
+    struct ConfigSnapshot *next;
+} ConfigSnapshot;
+
+static const GameConfig *g_config = &DEFAULT_CONFIG;
+static ConfigSnapshot *g_snapshots = NULL; // every snapshot we ever made
+
+static char *g_config_file = NULL;
+static bool g_config_file_checked = false; // looked at GAME_CONFIG yet?
+static char *g_cli_values[KEY_COUNT];      // command line overrides
+
+static volatile sig_atomic_t g_reload_requested = 0;
+
+const GameConfig *config_get() {
+    return __atomic_load_n(&g_config, __ATOMIC_ACQUIRE);
+}
+
+static int find_key(const char *key) {
+    for (int i = 0; i < KEY_COUNT; i++) {
+        if (strcmp(key, CONFIG_KEYS[i][0]) == 0) return i;
+    }
+    return -1;
+}
+
+// 1/0, true/false, yes/no like get_env_bool
+static bool parse_bool(const char *value) {
+    return value[0] == '1' || tolower(value[0]) == 't' || tolower(value[0]) == 'y';
+}
+
+// put one setting into a snapshot that's still being built
+static void apply_value(GameConfig *config, int key, const char *value) {
+    int number = atoi(value);
+    switch (key) {
+        case KEY_LOG_LEVEL:
+            config->log_level = number;
+            break;
+        case KEY_DIFFICULTY:
+            config->difficulty = number;
+            break;
+        case KEY_EASTER_EGGS:
+            config->easter_eggs = parse_bool(value);
+            break;
+        case KEY_ENEMY_TYPE:
+            // bad types mean "no override", same as before
+            config->enemy_type = (number >= GOBLIN && number <= BOSS) ? number : -1;
+            break;
+        case KEY_ENEMY_HP:
+            config->enemy_hp = number > 0 ? number : 0;
+            break;
+        case KEY_EVENT:
+            // "none" (or nothing) switches an event off from a later layer
+            if (strcmp(value, "none") == 0) value = "";
+            strncpy(config->event, value, CONFIG_EVENT_LENGTH - 1);
+            config->event[CONFIG_EVENT_LENGTH - 1] = '\0';
+            break;
+    }
+}
+
+// cut spaces off both ends (in place)
+static char *trim(char *text) {
+    while (isspace((unsigned char)*text)) text++;
+    char *end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return text;
+}
+
+// "key = value" lines, # starts a comment
+static bool read_config_file(GameConfig *config, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Could not read config file '%s'.\n", path);
+        return false;
+    }
+
+    char line[256];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+
+        char *equals = strchr(line, '=');
+        if (equals == NULL) {
+            if (trim(line)[0] != '\0') {
+                fprintf(stderr, "Warning: %s:%d: expected key = value\n", path, line_number);
+            }
+            continue;
+        }
+        *equals = '\0';
+        char *key = trim(line);
+        char *value = trim(equals + 1);
+
+        int index = find_key(key);
+        if (index < 0) {
+            fprintf(stderr, "Warning: %s:%d: unknown setting '%s'\n", path, line_number, key);
+            continue;
+        }
+        apply_value(config, index, value);
+    }
+
+    fclose(file);
+    return true;
+}
+
+bool config_load(const char *file) {
+    if (file != NULL) {
+        free(g_config_file);
+        g_config_file = strdup(file);
+        g_config_file_checked = true;
+    } else if (!g_config_file_checked) {
+        const char *env_file = get_env_string("GAME_CONFIG", NULL);
+        if (env_file != NULL) g_config_file = strdup(env_file);
+        g_config_file_checked = true;
+    }
+
+    ConfigSnapshot *snapshot = malloc(sizeof(ConfigSnapshot));
+    if (snapshot == NULL) {
+        fprintf(stderr, "Error: Out of memory loading config.\n");
+        return false;
+    }
+    snapshot->config = DEFAULT_CONFIG;
+
+    // weakest first, each layer overwrites what it sets
+    bool ok = true;
+    if (g_config_file != NULL) {
+        ok = read_config_file(&snapshot->config, g_config_file);
+    }
+    for (int i = 0; i < KEY_COUNT; i++) {
+        const char *value = get_env_string(CONFIG_KEYS[i][1], NULL);
+        if (value != NULL) apply_value(&snapshot->config, i, value);
+    }
+    for (int i = 0; i < KEY_COUNT; i++) {
+        if (g_cli_values[i] != NULL) apply_value(&snapshot->config, i, g_cli_values[i]);
+    }
+    snapshot->config.generation = config_get()->generation + 1;
+
+    // keep it around for config_shutdown, then make it the live one
+    snapshot->next = g_snapshots;
+    g_snapshots = snapshot;
+    __atomic_store_n(&g_config, &snapshot->config, __ATOMIC_RELEASE);
+    return ok;
+}
+
+bool config_set(const char *key, const char *value) {
+    int index = find_key(key);
+    if (index < 0 || value == NULL) return false;
+
+    free(g_cli_values[index]);
+    g_cli_values[index] = strdup(value);
+    return true;
+}
+
+static void handle_sighup(int sig) {
+    (void)sig;
+    g_reload_requested = 1;
+}
+
+void config_watch_sighup() {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_sighup;
+    action.sa_flags = SA_RESTART; // dont break the scanf we interrupted
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGHUP, &action, NULL);
+}
+
+void config_poll() {
+    if (!g_reload_requested) return;
+    g_reload_requested = 0;
+
+    config_load(NULL);
+    const GameConfig *config = config_get();
+    printf("Config reloaded (generation %u).\n", config->generation);
+    log_event(LOG_DEBUG, "Log level 0x%X, difficulty %d, easter eggs %s",
+              config->log_level, config->difficulty, config->easter_eggs ? "ON" : "OFF");
+}
+
+void config_shutdown() {
+    signal(SIGHUP, SIG_DFL);
+    __atomic_store_n(&g_config, &DEFAULT_CONFIG, __ATOMIC_RELEASE);
+
+    while (g_snapshots != NULL) {
+        ConfigSnapshot *next = g_snapshots->next;
+        free(g_snapshots);
+        g_snapshots = next;
+    }
+    for (int i = 0; i < KEY_COUNT; i++) {
+        free(g_cli_values[i]);
+        g_cli_values[i] = NULL;
+    }
+    free(g_config_file);
+    g_config_file = NULL;
+    g_config_file_checked = false;
+}
@@ -0,0 +1,46 @@
+// config.h - Game settings, read once into an immutable snapshot
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdbool.h>
+
+#define CONFIG_EVENT_LENGTH 24
+
+// Every setting the game looks at while running. A snapshot never changes
+// after it's published, a reload builds a new one and swaps the pointer, so
+// hot paths just do config_get()->whatever with no locks and no getenv.
+typedef struct {
+    int log_level;               // LOG_* bits (GAME_LOG_LEVEL, log_level)
+    int difficulty;              // 0 easy, 1 normal, 2 hard (GAME_DIFFICULTY, difficulty)
+    unsigned int easter_eggs : 1; // fun stuff on? (GAME_EASTER_EGGS, easter_eggs)
+    int enemy_type;              // forced enemy type, -1 = random (CMMO_ENEMY_TYPE, enemy_type)
+    int enemy_hp;                // forced enemy hp, 0 = normal (CMMO_ENEMY_HP, enemy_hp)
+    char event[CONFIG_EVENT_LENGTH]; // active event for spawn overrides, "" = none (GAME_EVENT, event)
+    unsigned int generation;     // goes up by one on every reload
+} GameConfig;
+
+// the current snapshot, never NULL (built-in defaults before config_load)
+const GameConfig *config_get();
+
+// build a new snapshot and publish it, layers from weakest to strongest:
+// built-in defaults < config file < environment < command line (config_set)
+// file == NULL keeps using the last file (GAME_CONFIG the first time)
+// returns false if the file couldnt be read (the rest still gets applied)
+bool config_load(const char *file);
+
+// command line override for one key (same names as the config file),
+// kept for every later reload. it only takes effect at the next
+// config_load, so a whole command line's worth of them costs one snapshot
+// returns false for an unknown key
+bool config_set(const char *key, const char *value);
+
+// reload on SIGHUP: the handler only sets a flag, config_poll() in the main
+// loop does the actual reload (so no malloc/stdio in the handler)
+void config_watch_sighup();
+void config_poll();
+
+// free every snapshot (old ones are kept till now since someone might
+// still be holding a pointer to them)
+void config_shutdown();
+
+#endif // CONFIG_H
@@ -0,0 +1,597 @@
+// content.c - Game balance tables (enemies, areas, spells, shop, potions)
+//
+// The numbers used to live in switches all over enemy.c, game.c, items.c
+// and utils.c. Now they're one ContentTables struct: built-in defaults
+// below, or a compiled content file mmap'd read-only at startup. Compiling
+// happens offline (./game -compile-content content.txt content.bin) so the
+// game itself never parses anything, and since the mapping is shared and
+// read-only every thread (and forked process) uses the same pages.
+#include "content.h"
+#include "enemy.h"
+#include "ai.h" // checks ai lines while compiling
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h> // offsetof
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// what the game shipped with (same numbers as content.txt)
+static const ContentTables BUILTIN_CONTENT = {
+    .magic = { 'C', 'M', 'M', 'O', 'C', 'N', 'T', '1' },
+    .version = CONTENT_VERSION,
+    .size = sizeof(ContentTables),
+    .enemies = {
+        // name              lvl  hp        dmg      xp        gold
+        [GOBLIN]   = { "Goblin",         0,  20,  5,  3, 1,  20,  5,   5,  2 },
+        [SKELETON] = { "Skeleton",       1,  25,  6,  5, 1,  30,  7,   8,  2 },
+        [ZOMBIE]   = { "Zombie",         1,  40,  8,  4, 1,  40,  8,  10,  2 },
+        [TROLL]    = { "Troll",          2,  60, 10,  7, 2,  60, 10,  15,  3 },
+        [ORC]      = { "Orc Warrior",    2,  50,  8,  8, 2,  70, 12,  20,  3 },
+        [DRAGON]   = { "Fire Dragon",    4, 150, 15, 15, 3, 200, 20, 100, 10 },
+        [BOSS]     = { "Dungeon Master", 5, 300, 20, 20, 3, 500, 50, 200, 20 }
+    },
+    .spawns = {
+        // area type      weight
+        { 1, GOBLIN,   1, "" },
+        { 1, SKELETON, 1, "" },
+        { 2, GOBLIN,   1, "" },
+        { 2, SKELETON, 1, "" },
+        { 2, ZOMBIE,   1, "" },
+        { 3, GOBLIN,   1, "" },
+        { 3, SKELETON, 1, "" },
+        { 3, ZOMBIE,   1, "" },
+        { 3, TROLL,    1, "" },
+        { 4, GOBLIN,   1, "" },
+        { 4, SKELETON, 1, "" },
+        { 4, ZOMBIE,   1, "" },
+        { 4, TROLL,    1, "" },
+        { 4, ORC,      1, "" },
+        { 5, GOBLIN,   18, "" },
+        { 5, SKELETON, 18, "" },
+        { 5, ZOMBIE,   18, "" },
+        { 5, TROLL,    18, "" },
+        { 5, ORC,      18, "" },
+        { 5, DRAGON,   10, "" }  // dragons are rare
+    },
+    .spawn_count = 20,
+    .spells = {
+        // name              base scale min max rand dull
+        { "FIREBALL",        5,   2,    1,  10,  0,   0 },
+        { "FROST NOVA",      3,   3,    0,  0,   0,   0 },
+        { "LIGHTNING BOLT",  0,   4,    0,  0,   0,   0 },
+        { "HEALING LIGHT",   0,   5,    0,  0,   0,   0 },
+        { "CHAOTIC MAGIC",   1,   0,    0,  0,   15,  5 }
+    },
+    .shop = {
+        { "Health Potion",        20, 0 },
+        { "Strong Health Potion", 40, 1 },
+        { "Super Health Potion",  80, 2 }
+    },
+    .shop_count = 3,
+    .items = {
+        .heal_per_strength = 10,
+        .random_heal_per_strength = 8,
+        .random_max_strength = 5,
+        .rest_heal_per_level = 5
+    },
+    .difficulty = {
+        { 70, 150 },  // easy: enemies hit softer, spells hit harder
+        { 100, 100 },
+        { 130, 70 }   // hard
+    },
+    .loot_rolls = { 1, 1, 1, 1, 1, 1, 2 }, // the boss rolls twice
+    .loot = {
+        // name                    enemy     weight tier str
+        { "",                      GOBLIN,   70, 0, 0 },
+        { "Health Potion",         GOBLIN,   30, 0, 0 },
+        { "",                      SKELETON, 70, 0, 0 },
+        { "Health Potion",         SKELETON, 30, 0, 0 },
+        { "",                      ZOMBIE,   70, 0, 0 },
+        { "Health Potion",         ZOMBIE,   30, 0, 0 },
+        { "",                      TROLL,    70, 0, 0 },
+        { "Health Potion",         TROLL,    30, 0, 1 },
+        { "",                      ORC,      70, 0, 0 },
+        { "Health Potion",         ORC,      30, 0, 1 },
+        { "",                      DRAGON,   55, 0, 0 },
+        { "Health Potion",         DRAGON,   30, 0, 1 },
+        { "Dragon Blood Elixir",   DRAGON,   12, 2, 3 },
+        { "Phoenix Draught",       DRAGON,    3, 4, 6 },
+        { "",                      BOSS,     50, 0, 0 },
+        { "Health Potion",         BOSS,     30, 0, 1 },
+        { "Strong Health Potion",  BOSS,     15, 1, 2 },
+        { "Master's Reserve",      BOSS,      5, 3, 4 }
+    },
+    .loot_count = 18,
+    .ai_scripts = {
+        [GOBLIN]   = "flee when hp_below 25 chance 30, attack",
+        [SKELETON] = "attack 150 when every 3, attack",
+        [ZOMBIE]   = "poison 3 when not_poisoned chance 35, attack",
+        [TROLL]    = "heal 30 when hp_below 40 once, attack",
+        [ORC]      = "enrage 50 when hp_below 50 once, attack",
+        [DRAGON]   = "enrage 30 when hp_below 30 once, attack 200 when every 4, attack",
+        [BOSS]     = "heal 25 when hp_below 30 once, enrage 50 when hp_below 60 once, "
+                     "poison 4 when every 5 not_poisoned, attack"
+    },
+    .checksum = 0
+};
+
+static const ContentTables *g_content = &BUILTIN_CONTENT;
+static void *g_mapping = NULL; // the mmap'd file, NULL when using builtins
+
+static const char *ENEMY_TYPE_NAMES[CONTENT_ENEMY_TYPES] = {
+    "GOBLIN", "SKELETON", "ZOMBIE", "TROLL", "ORC", "DRAGON", "BOSS"
+};
+static const char *SPELL_NAMES[CONTENT_SPELLS] = {
+    "FIRE", "ICE", "LIGHTNING", "HEAL", "RANDOM"
+};
+static const char *DIFFICULTY_NAMES[CONTENT_DIFFICULTIES] = {
+    "easy", "normal", "hard"
+};
+static const char *TIER_NAMES[CONTENT_LOOT_TIERS] = {
+    "COMMON", "UNCOMMON", "RARE", "EPIC", "LEGENDARY"
+};
+
+const ContentTables *content_get() {
+    return g_content;
+}
+
+// FNV-1a over everything but the checksum itself
+static unsigned int content_checksum(const ContentTables *tables) {
+    const unsigned char *bytes = (const unsigned char *)tables;
+    size_t len = offsetof(ContentTables, checksum);
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// a fixed size name has to end inside its array
+static bool name_ok(const char *name, size_t size) {
+    return memchr(name, '\0', size) != NULL;
+}
+
+// everything the rest of the game indexes with or divides by, checked once
+// so a hand edited (or just broken) file cant send anyone out of bounds
+static bool tables_valid(const ContentTables *tables, const char **why) {
+    for (int i = 0; i < CONTENT_ENEMY_TYPES; i++) {
+        const EnemyDef *def = &tables->enemies[i];
+        if (!name_ok(def->name, CONTENT_NAME_LENGTH) || def->hp_base <= 0 || def->hp_per_level < 0) {
+            *why = "bad enemy (hp has to be above 0)";
+            return false;
+        }
+        if (tables->loot_rolls[i] < 0 || tables->loot_rolls[i] > CONTENT_LOOT_MAX_ROLLS ||
+            !name_ok(tables->ai_scripts[i], CONTENT_AI_SCRIPT_LENGTH)) {
+            *why = "bad loot rolls or ai script";
+            return false;
+        }
+    }
+    if (tables->spawn_count < 0 || tables->spawn_count > CONTENT_SPAWN_MAX) {
+        *why = "bad spawn count";
+        return false;
+    }
+    for (int i = 0; i < tables->spawn_count; i++) {
+        const SpawnEntry *entry = &tables->spawns[i];
+        if (entry->area < 1 || entry->area > CONTENT_AREAS || entry->weight < 0 ||
+            entry->enemy_type < 0 || entry->enemy_type >= CONTENT_ENEMY_TYPES ||
+            !name_ok(entry->when, CONTENT_NAME_LENGTH)) {
+            *why = "bad spawn entry";
+            return false;
+        }
+    }
+    for (int i = 0; i < CONTENT_SPELLS; i++) {
+        const SpellDef *def = &tables->spells[i];
+        if (!name_ok(def->name, CONTENT_NAME_LENGTH) || def->param_min > def->param_max ||
+            def->random_range < 0 || def->dull_random_range < 0) {
+            *why = "bad spell (min above max?)";
+            return false;
+        }
+    }
+    if (tables->shop_count < 0 || tables->shop_count > CONTENT_SHOP_MAX) {
+        *why = "bad shop count";
+        return false;
+    }
+    for (int i = 0; i < tables->shop_count; i++) {
+        if (!name_ok(tables->shop[i].name, CONTENT_NAME_LENGTH) || tables->shop[i].price < 0) {
+            *why = "bad shop entry";
+            return false;
+        }
+    }
+    if (tables->items.random_max_strength <= 0) {
+        *why = "bad item rules";
+        return false;
+    }
+    if (tables->loot_count < 0 || tables->loot_count > CONTENT_LOOT_MAX) {
+        *why = "bad loot count";
+        return false;
+    }
+    for (int i = 0; i < tables->loot_count; i++) {
+        const LootEntry *entry = &tables->loot[i];
+        if (entry->enemy_type < 0 || entry->enemy_type >= CONTENT_ENEMY_TYPES ||
+            entry->tier < 0 || entry->tier >= CONTENT_LOOT_TIERS || entry->weight < 0 ||
+            !name_ok(entry->name, CONTENT_NAME_LENGTH)) {
+            *why = "bad loot entry";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool content_load(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not open content file '%s'.\n", path);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size != (off_t)sizeof(ContentTables)) {
+        fprintf(stderr, "Error: Content file '%s' is the wrong size (rebuild it with -compile-content).\n", path);
+        close(fd);
+        return false;
+    }
+
+    // shared + read-only, every process using the file shares the pages
+    void *mapping = mmap(NULL, sizeof(ContentTables), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Error: Could not map content file '%s'.\n", path);
+        return false;
+    }
+
+    const ContentTables *tables = mapping;
+    if (memcmp(tables->magic, CONTENT_MAGIC, sizeof(tables->magic)) != 0 ||
+        tables->version != CONTENT_VERSION ||
+        tables->size != sizeof(ContentTables) ||
+        tables->checksum != content_checksum(tables)) {
+        fprintf(stderr, "Error: Content file '%s' is not valid (bad header or checksum).\n", path);
+        munmap(mapping, sizeof(ContentTables));
+        return false;
+    }
+
+    // the checksum only says the file is what was written, not that it's sane
+    const char *why = NULL;
+    if (!tables_valid(tables, &why)) {
+        fprintf(stderr, "Error: Content file '%s' is not valid (%s).\n", path, why);
+        munmap(mapping, sizeof(ContentTables));
+        return false;
+    }
+
+    content_shutdown(); // drop an older mapping if there was one
+    g_mapping = mapping;
+    g_content = tables;
+    return true;
+}
+
+void content_shutdown() {
+    g_content = &BUILTIN_CONTENT;
+    if (g_mapping != NULL) {
+        munmap(g_mapping, sizeof(ContentTables));
+        g_mapping = NULL;
+    }
+}
+
+// ---------------------------------------------------------------------
+// Compiler: content.txt -> content.bin
+// ---------------------------------------------------------------------
+
+#define MAX_FIELDS 16
+
+static char *trim(char *text) {
+    while (isspace((unsigned char)*text)) text++;
+    char *end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return text;
+}
+
+// split a line on commas (in place), returns the field count
+static int split_fields(char *line, char *fields[MAX_FIELDS]) {
+    int count = 0;
+    char *start = line;
+    for (;;) {
+        char *comma = strchr(start, ',');
+        if (comma != NULL) *comma = '\0';
+        if (count < MAX_FIELDS) fields[count++] = trim(start);
+        if (comma == NULL) break;
+        start = comma + 1;
+    }
+    return count;
+}
+
+// which name in a table, -1 if none (NONE is allowed where it makes sense)
+static int lookup_name(const char *name, const char **names, int count) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(name, names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static bool parse_int(const char *text, int *out) {
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (text[0] == '\0' || *end != '\0') return false;
+    *out = (int)value;
+    return true;
+}
+
+// parse fields[first..first+count) as ints into out
+static bool parse_ints(char **fields, int first, int count, int *out) {
+    for (int i = 0; i < count; i++) {
+        if (!parse_int(fields[first + i], &out[i])) return false;
+    }
+    return true;
+}
+
+static void copy_name(char *dest, const char *name) {
+    memset(dest, 0, CONTENT_NAME_LENGTH);
+    strncpy(dest, name, CONTENT_NAME_LENGTH - 1);
+}
+
+// one source line into the tables, false (with *why set) if it's bad
+static bool compile_line(ContentTables *tables, char **fields, int count,
+                         bool *shop_started, bool *spawn_started, bool *loot_started,
+                         const char **why) {
+    const char *kind = fields[0];
+    int numbers[10];
+
+    if (strcmp(kind, "enemy") == 0) {
+        // enemy,TYPE,name,level_offset,hp,hp/lvl,dmg,dmg/lvl,xp,xp/lvl,gold,gold/lvl
+        int type = count == 12 ? lookup_name(fields[1], ENEMY_TYPE_NAMES, CONTENT_ENEMY_TYPES) : -1;
+        if (type < 0 || !parse_ints(fields, 3, 9, numbers)) {
+            *why = "expected enemy,TYPE,name, then 9 numbers";
+            return false;
+        }
+        if (numbers[1] <= 0 || numbers[2] < 0) {
+            *why = "enemy hp has to be above 0 (and hp/lvl at least 0)";
+            return false;
+        }
+        EnemyDef *def = &tables->enemies[type];
+        copy_name(def->name, fields[2]);
+        def->level_offset = numbers[0];
+        def->hp_base = numbers[1];
+        def->hp_per_level = numbers[2];
+        def->damage_base = numbers[3];
+        def->damage_per_level = numbers[4];
+        def->xp_base = numbers[5];
+        def->xp_per_level = numbers[6];
+        def->gold_base = numbers[7];
+        def->gold_per_level = numbers[8];
+        return true;
+    }
+
+    if (strcmp(kind, "spawn") == 0) {
+        // spawn,AREA,TYPE,weight[,when] (the first one replaces the built-in tables)
+        int area, weight;
+        int type = (count == 4 || count == 5) ? lookup_name(fields[2], ENEMY_TYPE_NAMES, CONTENT_ENEMY_TYPES) : -1;
+        if (type < 0 || !parse_int(fields[1], &area) || area < 1 || area > CONTENT_AREAS ||
+            !parse_int(fields[3], &weight) || weight < 0) {
+            *why = "expected spawn,1-5,TYPE,weight and optionally day, night or an event name";
+            return false;
+        }
+        if (!*spawn_started) {
+            tables->spawn_count = 0;
+            *spawn_started = true;
+        }
+        if (tables->spawn_count >= CONTENT_SPAWN_MAX) {
+            *why = "too many spawn entries";
+            return false;
+        }
+        SpawnEntry *entry = &tables->spawns[tables->spawn_count++];
+        entry->area = area;
+        entry->enemy_type = type;
+        entry->weight = weight;
+        copy_name(entry->when, count == 5 ? fields[4] : "");
+        return true;
+    }
+
+    if (strcmp(kind, "spell") == 0) {
+        // spell,SPELL,name,base,scale,param_min,param_max,random_range,dull_random_range
+        int spell = count == 9 ? lookup_name(fields[1], SPELL_NAMES, CONTENT_SPELLS) : -1;
+        if (spell < 0 || !parse_ints(fields, 3, 6, numbers) || numbers[4] < 0 || numbers[5] < 0) {
+            *why = "expected spell,SPELL,name, then 6 numbers";
+            return false;
+        }
+        if (numbers[2] > numbers[3]) {
+            *why = "spell param_min is above param_max";
+            return false;
+        }
+        SpellDef *def = &tables->spells[spell];
+        copy_name(def->name, fields[2]);
+        def->base = numbers[0];
+        def->scale = numbers[1];
+        def->param_min = numbers[2];
+        def->param_max = numbers[3];
+        def->random_range = numbers[4];
+        def->dull_random_range = numbers[5];
+        return true;
+    }
+
+    if (strcmp(kind, "shop") == 0) {
+        // shop,name,price,strength_offset (the first one replaces the built-in list)
+        if (count != 4 || !parse_ints(fields, 2, 2, numbers) || numbers[0] < 0) {
+            *why = "expected shop,name,price,strength_offset";
+            return false;
+        }
+        if (!*shop_started) {
+            tables->shop_count = 0;
+            *shop_started = true;
+        }
+        if (tables->shop_count >= CONTENT_SHOP_MAX) {
+            *why = "too many shop entries";
+            return false;
+        }
+        ShopEntry *entry = &tables->shop[tables->shop_count++];
+        copy_name(entry->name, fields[1]);
+        entry->price = numbers[0];
+        entry->strength_offset = numbers[1];
+        return true;
+    }
+
+    if (strcmp(kind, "items") == 0) {
+        // items,key,value
+        int value;
+        if (count != 3 || !parse_int(fields[2], &value)) {
+            *why = "expected items,key,value";
+            return false;
+        }
+        ItemRules *rules = &tables->items;
+        const char *key = fields[1];
+        if (strcmp(key, "heal_per_strength") == 0) rules->heal_per_strength = value;
+        else if (strcmp(key, "random_heal_per_strength") == 0) rules->random_heal_per_strength = value;
+        else if (strcmp(key, "random_max_strength") == 0 && value > 0) rules->random_max_strength = value;
+        else if (strcmp(key, "rest_heal_per_level") == 0) rules->rest_heal_per_level = value;
+        else {
+            *why = "unknown items key (or bad value)";
+            return false;
+        }
+        return true;
+    }
+
+    if (strcmp(kind, "loot") == 0) {
+        // loot,TYPE,weight,TIER,strength_offset,name|NONE (the first one replaces the built-in tables)
+        int type = count == 6 ? lookup_name(fields[1], ENEMY_TYPE_NAMES, CONTENT_ENEMY_TYPES) : -1;
+        int tier = count == 6 ? lookup_name(fields[3], TIER_NAMES, CONTENT_LOOT_TIERS) : -1;
+        if (type < 0 || tier < 0 || !parse_int(fields[2], &numbers[0]) || numbers[0] < 0 ||
+            !parse_int(fields[4], &numbers[1]) || fields[5][0] == '\0') {
+            *why = "expected loot,TYPE,weight,TIER,strength_offset,name or NONE";
+            return false;
+        }
+        if (!*loot_started) {
+            tables->loot_count = 0;
+            *loot_started = true;
+        }
+        if (tables->loot_count >= CONTENT_LOOT_MAX) {
+            *why = "too many loot entries";
+            return false;
+        }
+        LootEntry *entry = &tables->loot[tables->loot_count++];
+        copy_name(entry->name, strcmp(fields[5], "NONE") == 0 ? "" : fields[5]);
+        entry->enemy_type = type;
+        entry->weight = numbers[0];
+        entry->tier = tier;
+        entry->strength_offset = numbers[1];
+        return true;
+    }
+
+    if (strcmp(kind, "lootrolls") == 0) {
+        // lootrolls,TYPE,rolls
+        int type = count == 3 ? lookup_name(fields[1], ENEMY_TYPE_NAMES, CONTENT_ENEMY_TYPES) : -1;
+        if (type < 0 || !parse_int(fields[2], &numbers[0]) || numbers[0] < 0 || numbers[0] > CONTENT_LOOT_MAX_ROLLS) {
+            *why = "expected lootrolls,TYPE,0-16";
+            return false;
+        }
+        tables->loot_rolls[type] = numbers[0];
+        return true;
+    }
+
+    if (strcmp(kind, "difficulty") == 0) {
+        // difficulty,easy|normal|hard,enemy_damage_pct,spell_damage_pct
+        int level = count == 4 ? lookup_name(fields[1], DIFFICULTY_NAMES, CONTENT_DIFFICULTIES) : -1;
+        if (level < 0 || !parse_ints(fields, 2, 2, numbers)) {
+            *why = "expected difficulty,easy|normal|hard,enemy_damage_pct,spell_damage_pct";
+            return false;
+        }
+        tables->difficulty[level].enemy_damage_pct = numbers[0];
+        tables->difficulty[level].spell_damage_pct = numbers[1];
+        return true;
+    }
+
+    if (strcmp(kind, "ai") == 0) {
+        // ai,TYPE,rule,rule... (see ai.c), stored as text and compiled at startup
+        int type = count >= 3 ? lookup_name(fields[1], ENEMY_TYPE_NAMES, CONTENT_ENEMY_TYPES) : -1;
+        if (type < 0) {
+            *why = "expected ai,TYPE, then one or more rules";
+            return false;
+        }
+        char script[CONTENT_AI_SCRIPT_LENGTH] = ""; // zeroed, the whole thing gets checksummed
+        size_t len = 0;
+        for (int i = 2; i < count; i++) {
+            int wrote = snprintf(script + len, sizeof(script) - len, "%s%s", i > 2 ? ", " : "", fields[i]);
+            if (wrote < 0 || (size_t)wrote >= sizeof(script) - len) {
+                *why = "ai script too long";
+                return false;
+            }
+            len += (size_t)wrote;
+        }
+        unsigned char code[AI_CODE_MAX * 4];
+        if (!ai_compile(script, code, why)) return false;
+        memcpy(tables->ai_scripts[type], script, sizeof(script));
+        return true;
+    }
+
+    *why = "unknown line type";
+    return false;
+}
+
+bool content_compile(const char *source_path, const char *out_path) {
+    FILE *source = fopen(source_path, "r");
+    if (source == NULL) {
+        fprintf(stderr, "Error: Could not open content source '%s'.\n", source_path);
+        return false;
+    }
+
+    // anything the source leaves out keeps its built-in value
+    ContentTables *tables = malloc(sizeof(ContentTables));
+    if (tables == NULL) {
+        fclose(source);
+        return false;
+    }
+    memcpy(tables, &BUILTIN_CONTENT, sizeof(ContentTables));
+
+    char line[256];
+    int line_number = 0;
+    bool shop_started = false;
+    bool spawn_started = false;
+    bool loot_started = false;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), source) != NULL) {
+        line_number++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+        if (trim(line)[0] == '\0') continue;
+
+        char *fields[MAX_FIELDS];
+        int count = split_fields(line, fields);
+        const char *why = NULL;
+        if (!compile_line(tables, fields, count, &shop_started, &spawn_started, &loot_started, &why)) {
+            fprintf(stderr, "Error: %s:%d: %s\n", source_path, line_number, why);
+            ok = false;
+        }
+    }
+    fclose(source);
+
+    // whatever content_load would turn away shouldnt get written at all
+    const char *why = NULL;
+    if (ok && !tables_valid(tables, &why)) {
+        fprintf(stderr, "Error: %s: %s\n", source_path, why);
+        ok = false;
+    }
+
+    if (ok) {
+        tables->checksum = content_checksum(tables);
+
+        // temp + rename so a running game never maps half a file
+        char tmp_path[512];
+        snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", out_path);
+        FILE *out = fopen(tmp_path, "wb");
+        ok = out != NULL && fwrite(tables, sizeof(ContentTables), 1, out) == 1;
+        if (out != NULL && fclose(out) != 0) ok = false;
+        if (ok && rename(tmp_path, out_path) != 0) ok = false;
+        if (!ok) {
+            fprintf(stderr, "Error: Could not write content file '%s'.\n", out_path);
+            remove(tmp_path);
+        } else {
+            printf("Compiled %d lines from '%s' into '%s' (%zu bytes).\n",
+                   line_number, source_path, out_path, sizeof(ContentTables));
+        }
+    }
+
+    free(tables);
+    return ok;
+}
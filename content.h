@@ -0,0 +1,125 @@
+// content.h - Game balance tables (enemies, areas, spells, shop, potions)
+#ifndef CONTENT_H
+#define CONTENT_H
+
+#include <stdbool.h>
+
+#define CONTENT_MAGIC "CMMOCNT1"
+#define CONTENT_VERSION 4
+#define CONTENT_NAME_LENGTH 24
+#define CONTENT_ENEMY_TYPES 7   // GOBLIN..BOSS
+#define CONTENT_AREAS 5
+#define CONTENT_SPELLS 5        // FIRE_SPELL..RANDOM_SPELL
+#define CONTENT_SHOP_MAX 8
+#define CONTENT_DIFFICULTIES 3  // easy, normal, hard
+#define CONTENT_SPAWN_MAX 256   // spawn lines for all areas together
+#define CONTENT_LOOT_MAX 1024   // loot lines for all enemy types together
+#define CONTENT_LOOT_TIERS 5    // common..legendary
+#define CONTENT_LOOT_MAX_ROLLS 16
+#define CONTENT_AI_SCRIPT_LENGTH 192 // one enemy type's ai rules
+
+// stats for one enemy type, everything scales with the enemy's level
+// (level = player level + level_offset)
+typedef struct {
+    char name[CONTENT_NAME_LENGTH];
+    int level_offset;
+    int hp_base, hp_per_level;
+    int damage_base, damage_per_level;
+    int xp_base, xp_per_level;
+    int gold_base, gold_per_level;
+} EnemyDef;
+
+// one line of an area's spawn table, a spawn picks a line with
+// probability weight / (sum of the weights in that table). Lines with a
+// "when" form a separate table that replaces the normal one while it's
+// active: "day" / "night" (local time) or an event name (config event)
+typedef struct {
+    int area;                       // 1..CONTENT_AREAS
+    int enemy_type;
+    int weight;
+    char when[CONTENT_NAME_LENGTH]; // "" = the normal table
+} SpawnEntry;
+
+// damage (or healing) = base + scale * clamp(param, param_min, param_max)
+//                       + rand() % random_range (if random_range > 0)
+// dull_random_range replaces random_range when easter eggs are off
+typedef struct {
+    char name[CONTENT_NAME_LENGTH];
+    int base;
+    int scale;
+    int param_min, param_max; // both 0 = no clamp
+    int random_range;
+    int dull_random_range;
+} SpellDef;
+
+// one line in the shop, buys a health potion of strength
+// player level + strength_offset
+typedef struct {
+    char name[CONTENT_NAME_LENGTH];
+    int price;
+    int strength_offset;
+} ShopEntry;
+
+// potion numbers
+typedef struct {
+    int heal_per_strength;        // create_health_potion
+    int random_heal_per_strength; // create_random_potion
+    int random_max_strength;
+    int rest_heal_per_level;
+} ItemRules;
+
+// one line of an enemy's loot table, each roll after a win picks one
+// line with probability weight / (sum of that enemy's weights)
+typedef struct {
+    char name[CONTENT_NAME_LENGTH]; // potion name, "" = nothing drops
+    int enemy_type;
+    int weight;
+    int tier;                       // 0 = common .. 4 = legendary
+    int strength_offset;            // potion strength = player level + this
+} LootEntry;
+
+// multipliers in percent
+typedef struct {
+    int enemy_damage_pct;
+    int spell_damage_pct;
+} DifficultyDef;
+
+// The whole thing is plain data with no pointers so a compiled content
+// file is just this struct written out, and loading it is one mmap
+typedef struct {
+    char magic[8];            // CONTENT_MAGIC (no NUL)
+    unsigned int version;     // CONTENT_VERSION
+    unsigned int size;        // sizeof(ContentTables), catches stale files
+    EnemyDef enemies[CONTENT_ENEMY_TYPES];
+    SpawnEntry spawns[CONTENT_SPAWN_MAX];
+    int spawn_count;
+    SpellDef spells[CONTENT_SPELLS];
+    ShopEntry shop[CONTENT_SHOP_MAX];
+    int shop_count;
+    ItemRules items;
+    DifficultyDef difficulty[CONTENT_DIFFICULTIES];
+    int loot_rolls[CONTENT_ENEMY_TYPES]; // loot rolls per win
+    LootEntry loot[CONTENT_LOOT_MAX];
+    int loot_count;
+    // behaviour rules per enemy type as written in the source (see ai.c,
+    // ai_init compiles them), "" = plain attacks
+    char ai_scripts[CONTENT_ENEMY_TYPES][CONTENT_AI_SCRIPT_LENGTH];
+    unsigned int checksum;    // FNV-1a of everything above
+} ContentTables;
+
+// the live tables, built-in defaults until content_load succeeds
+// (set once at startup, read-only after that so threads can share it)
+const ContentTables *content_get();
+
+// mmap a compiled content file, returns false (and keeps the current
+// tables) if it's missing, the wrong size/version or corrupted
+bool content_load(const char *path);
+
+// compile a text content file into the binary form content_load wants,
+// returns false and prints the bad line on errors
+bool content_compile(const char *source_path, const char *out_path);
+
+// unmap the file (back to built-in defaults)
+void content_shutdown();
+
+#endif // CONTENT_H
@@ -32,6 +32,10 @@ typedef struct {
 // Create an enemy based on area level and player level
 void initialize_enemy(Enemy *enemy, int area_level, int player_level);
 
+// fill in type, level, hp, damage, xp and gold for an enemy type at a
+// player level and difficulty (leaves name alone, prints nothing)
+void enemy_stats(Enemy *enemy, enum EnemyType type, int player_level, int difficulty);
+
 // clean up enemy resources
 void cleanup_enemy(Enemy *enemy);
 
@@ -4,6 +4,17 @@
 #include "enemy.h"
 #include "utils.h" // add utils header
 #include "save_game.h" // add save game header
+#include "stats.h" // latency histograms
+#include "trace.h" // timeline spans
+#include "probes.h" // USDT probes
+#include "content.h" // shop and rest numbers
+#include "spells.h" // typed spell casts
+#include "loot.h" // loot tables
+#include "combat.h" // auto-battle
+#include "leaderboard.h" // rankings
+#include "auction.h" // player auction house
+#include "broadcast.h" // area channels
+#include "ai.h" // enemy behaviour scripts
 #include <stdio.h>
 #include <stdlib.h> // For rand(), srand()
 #include <time.h>   // For time()
@@ -13,6 +24,12 @@
 // Global variable for total turns taken in current combat
 static int g_combat_turn_count = 0;
 
+// the current enemy's script state (heals used, enrage, poison...)
+static AiState g_enemy_ai;
+
+// who start_combat is fighting right now, NULL between fights
+static Enemy *g_combat_enemy = NULL;
+
 // External reference to global save filename
 extern char saveFileName[MAX_FILENAME_LENGTH];
 
@@ -40,21 +57,16 @@ bool get_yes_no(const char *prompt) {
     return (input[0] == 'y');
 }
 
-// start combat with an enemy
-void start_combat(Player *player, Enemy *enemy) {
-    if (player == NULL || enemy == NULL) {
-        return;
-    }
-    
-    // reset combat turn counter
-    g_combat_turn_count = 0;
-    
-    printf("\n--- COMBAT START ---\n");
-    printf("You face a Level %d %s!\n", enemy->level, enemy->name);
-    
+// the turns of a fight start_combat (or resume_combat) set up
+static void fight(Player *player, Enemy *enemy) {
+    g_combat_enemy = enemy;
+
     // Combat loop
     while (player->hp > 0 && enemy->hp > 0) {
+        TRACE_SCOPE("combat_turn");
+        unsigned long long turn_start = STATS_TIMER_START();
         g_combat_turn_count++;
+        GAME_PROBE3(turn__begin, g_combat_turn_count, player->hp, enemy->hp);
         printf("\n--- Turn %d ---\n", g_combat_turn_count);
         
         // Player goes first
@@ -63,22 +75,91 @@ void start_combat(Player *player, Enemy *enemy) {
         // Check if enemy is defeated
         if (enemy->hp <= 0) {
             printf("\n%s has been defeated!\n", enemy->name);
+            STATS_COUNT(COUNTER_KILLS, 1);
             handle_enemy_defeat(player, enemy);
+            STATS_TIMER_STOP(STAT_COMBAT_TURN, turn_start);
+            GAME_PROBE3(turn__end, g_combat_turn_count, player->hp, enemy->hp);
             break;
         }
         
         // Enemy's turn
-        enemy_turn(player, enemy);
+        bool stayed = enemy_turn(player, enemy);
+        STATS_TIMER_STOP(STAT_COMBAT_TURN, turn_start);
+        GAME_PROBE3(turn__end, g_combat_turn_count, player->hp, enemy->hp);
+        
+        // it ran off, no rewards
+        if (!stayed) break;
         
         // Check if player is defeated
         if (player->hp <= 0) {
             printf("\nYou have been defeated by %s!\n", enemy->name);
             printf("GAME OVER\n");
+            STATS_COUNT(COUNTER_DEATHS, 1);
             break;
         }
     }
+    
+    // poison doesnt outlast the fight
+    if (player->is_poisoned) {
+        player->is_poisoned = 0;
+        mark_player_dirty(player, DIRTY_STATUS);
+    }
+    g_combat_enemy = NULL;
+}
+
+// everyone hears how it went, and beating it is the end of the game
+static void boss_fight_over(Player *player, const Enemy *boss) {
+    broadcast_publish(player->area_level, BROADCAST_BOSS, "%s %s the final boss",
+                      player->name, boss->hp <= 0 ? "has defeated" : player->hp > 0 ? "scared off" : "fell to");
+    
+    // If player won
+    if (boss->hp <= 0) {
+        printf("\n=== YOU HAVE COMPLETED THE GAME! ===\n");
+        printf("Congratulations on defeating the final boss!\n");
+        printf("Final stats: Level %d, %d kills, %d gold\n",
+               player->level, player->kills, player->gold);
+    }
+}
+
+// start combat with an enemy
+void start_combat(Player *player, Enemy *enemy) {
+    if (player == NULL || enemy == NULL) {
+        return;
+    }
+    
+    // reset combat turn counter
+    g_combat_turn_count = 0;
+    ai_begin(&g_enemy_ai, enemy, (unsigned int)rand());
+    STATS_COUNT(COUNTER_COMBATS, 1);
+    
+    printf("\n--- COMBAT START ---\n");
+    printf("You face a Level %d %s!\n", enemy->level, enemy->name);
+    fight(player, enemy);
+}
+
+bool combat_in_progress(Enemy *enemy, AiState *ai, int *turns) {
+    if (g_combat_enemy == NULL) return false;
+    *enemy = *g_combat_enemy; // name still belongs to the fight
+    *ai = g_enemy_ai;
+    *turns = g_combat_turn_count;
+    return true;
 }
 
+void resume_combat(Player *player, Enemy *enemy, const AiState *ai, int turns) {
+    if (player == NULL || enemy == NULL || ai == NULL) {
+        return;
+    }
+
+    // the turn they were picking a move for starts over
+    g_combat_turn_count = turns > 0 ? turns - 1 : 0;
+    g_enemy_ai = *ai;
+    printf("\n--- COMBAT CONTINUES ---\n");
+    printf("Level %d %s: %d/%d HP\n", enemy->level, enemy->name, enemy->hp, enemy->maxHp);
+    fight(player, enemy);
+    if (enemy->type == BOSS) boss_fight_over(player, enemy);
+}
+
+
 // Handle rewards when enemy is defeated
 void handle_enemy_defeat(Player *player, Enemy *enemy) {
     if (player == NULL || enemy == NULL) {
@@ -89,6 +170,7 @@ void handle_enemy_defeat(Player *player, Enemy *enemy) {
     
     // Add gold
     player->gold += enemy->gold_value;
+    mark_player_dirty(player, DIRTY_GOLD);
     printf("You found %d gold! (Total: %d)\n", enemy->gold_value, player->gold);
     
     // Add XP and check for level up - actually use the return value
@@ -97,35 +179,59 @@ void handle_enemy_defeat(Player *player, Enemy *enemy) {
     
     // If level up, give a bonus
     if (leveled_up) {
-        printf("Bonus for leveling up: +10 gold!\n");
-        player->gold += 10;
+        printf("Bonus for leveling up: +%d gold!\n", LEVEL_UP_GOLD_BONUS);
+        player->gold += LEVEL_UP_GOLD_BONUS;
     }
     
     // Increment kill counter
     player->kills++;
+    mark_player_dirty(player, DIRTY_KILLS);
     
-    // Random item drop (30% chance)
-    if (rand() % 100 < 30 && player->inventory_size < player->inventory_capacity) {
-        Item *dropped_item = NULL;
-        
-        // Better enemies drop better items
-        if (enemy->type >= TROLL) {
-            dropped_item = create_health_potion(player->level + 1);
-        } else {
-            dropped_item = create_health_potion(player->level);
-        }
-        
-        if (dropped_item != NULL) {
-            player->inventory[player->inventory_size] = dropped_item;
-            player->inventory_size++;
-            printf("Enemy dropped %s! Added to inventory.\n", dropped_item->name);
-        }
-    }
+    // let everyone else in the area know
+    broadcast_publish(player->area_level, BROADCAST_KILL, "%s (Level %d) defeated a Level %d %s",
+                      player->name, player->level, enemy->level, enemy->name);
+    
+    // loot, one or more rolls on the enemy's loot table
+    loot_award(player, enemy);
+    
+    // new level/xp/kills/gold onto the leaderboards
+    leaderboard_update(player);
     
     // Autosave after battle
+    TRACE_SCOPE("autosave");
     save_game(player, saveFileName[0] != '\0' ? saveFileName : NULL);
 }
 
+// handle_enemy_defeat's gold/xp/kill rewards with no printing, no loot
+// and no autosave (for projections, keep the two in step)
+bool grant_enemy_rewards(Player *player, const Enemy *enemy) {
+    if (player == NULL || enemy == NULL) {
+        return false;
+    }
+    
+    player->gold += enemy->gold_value;
+    bool leveled_up = add_player_xp_quiet(player, enemy->xp_value);
+    if (leveled_up) {
+        player->gold += LEVEL_UP_GOLD_BONUS;
+    }
+    player->kills++;
+    mark_player_dirty(player, DIRTY_GOLD | DIRTY_KILLS);
+    return leveled_up;
+}
+
+// grant_enemy_rewards on a slice of the enemy (rounded down)
+bool grant_enemy_share(Player *player, const Enemy *enemy, long long part, long long whole) {
+    if (player == NULL || enemy == NULL || part <= 0 || whole <= 0) {
+        return false;
+    }
+    if (part > whole) part = whole;
+    
+    Enemy share = *enemy;
+    share.xp_value = (int)((double)enemy->xp_value * part / whole);
+    share.gold_value = (int)((double)enemy->gold_value * part / whole);
+    return grant_enemy_rewards(player, &share);
+}
+
 // Handles the player's turn
 void player_turn(Player *player, Enemy *enemy) {
     // bad pointers? get outta here
@@ -175,6 +281,7 @@ void player_turn(Player *player, Enemy *enemy) {
             
             // make sure hp isnt weirdly negative
             if (enemy->hp < 0) enemy->hp = 0;
+            GAME_PROBE3(player__hit, player->damage, enemy->hp, 0);
 
             printf("%s takes %d damage. Remaining HP: %d/%d\n", 
                    enemy->name, player->damage, enemy->hp, enemy->maxHp);
@@ -217,6 +324,7 @@ void player_turn(Player *player, Enemy *enemy) {
                                 if (player->hp > player->maxHp) {
                                     player->hp = player->maxHp;
                                 }
+                                mark_player_dirty(player, DIRTY_HP);
                                 printf("%s healed! Current HP: %d/%d\n", 
                                        player->name, player->hp, player->maxHp);
                                 
@@ -236,6 +344,7 @@ void player_turn(Player *player, Enemy *enemy) {
                                 }
                                 player->inventory[player->inventory_size - 1] = NULL; // clear last slot
                                 player->inventory_size--;
+                                mark_inventory_dirty(player, item_index);
 
                             } else {
                                 printf("Don't know how to use this item type yet.\n");
@@ -272,50 +381,41 @@ void player_turn(Player *player, Enemy *enemy) {
                 while ((c = getchar()) != '\n' && c != EOF);
                 
                 if (spell_choice >= 1 && spell_choice <= 5) {
-                    int spell_damage = 0;
-                    
+                    // same random params as always, now as a typed cast
+                    SpellCast cast = { RANDOM_SPELL, 0, 0, 0.0f };
                     switch (spell_choice) {
-                        case 1: { // Fireball
-                            // Use our variadic function - pass intensity and burn turns
-                            int intensity = rand() % 10 + 1;  // random 1-10
-                            int burn_turns = rand() % 3 + 1;  // random 1-3
-                            spell_damage = cast_spell(player, enemy, FIRE_SPELL, intensity, burn_turns);
+                        case 1: // Fireball - intensity 1-10, burns 1-3 turns
+                            cast.spell = FIRE_SPELL;
+                            cast.power = rand() % 10 + 1;
+                            cast.extra = rand() % 3 + 1;
                             break;
-                        }
-                        case 2: { // Frost Nova
-                            // Use our variadic function - pass radius and freeze chance
-                            int radius = rand() % 5 + 1;  // random 1-5
-                            double freeze_chance = (rand() % 100) / 100.0;  // random 0.0-1.0
-                            spell_damage = cast_spell(player, enemy, ICE_SPELL, radius, freeze_chance);
+                        case 2: // Frost Nova - radius 1-5, freeze chance 0.0-1.0
+                            cast.spell = ICE_SPELL;
+                            cast.power = rand() % 5 + 1;
+                            cast.chance = (rand() % 100) / 100.0f;
                             break;
-                        }
-                        case 3: { // Lightning
-                            // Use our variadic function - pass power and chain targets
-                            int power = rand() % 5 + 1;  // random 1-5
-                            int chain_targets = rand() % 5;  // random 0-4
-                            spell_damage = cast_spell(player, enemy, LIGHTNING_SPELL, power, chain_targets);
+                        case 3: // Lightning - power 1-5, chains to 0-4 targets
+                            cast.spell = LIGHTNING_SPELL;
+                            cast.power = rand() % 5 + 1;
+                            cast.extra = rand() % 5;
                             break;
-                        }
-                        case 4: { // Healing
-                            // Use our variadic function - pass power and duration
-                            int power = rand() % 5 + 1;  // random 1-5
-                            int duration = rand() % 3 + 1;  // random 1-3
-                            spell_damage = cast_spell(player, enemy, HEAL_SPELL, power, duration);
-                            // no damage to enemy for healing spells
-                            spell_damage = 0;
+                        case 4: // Healing - power 1-5 over 1-3 turns
+                            cast.spell = HEAL_SPELL;
+                            cast.power = rand() % 5 + 1;
+                            cast.extra = rand() % 3 + 1;
                             break;
-                        }
-                        case 5: { // Random
-                            // Use our variadic function - no extra args for random
-                            spell_damage = cast_spell(player, enemy, RANDOM_SPELL);
+                        case 5: // Random - no params
                             break;
-                        }
                     }
+                    int spell_damage = cast_spell_typed(player, enemy, &cast);
+                    // no damage to enemy for healing spells
+                    if (spell_desc(cast.spell)->effect == SPELL_EFFECT_HEAL) spell_damage = 0;
                     
                     // Apply damage if it's an offensive spell
                     if (spell_damage > 0 && enemy != NULL) {
                         enemy->hp -= spell_damage;
                         if (enemy->hp < 0) enemy->hp = 0;
+                        GAME_PROBE3(player__hit, spell_damage, enemy->hp, 1);
                         
                         printf("%s takes %d damage from the spell. Remaining HP: %d/%d\n", 
                                enemy->name, spell_damage, enemy->hp, enemy->maxHp);
@@ -349,26 +449,72 @@ void player_turn(Player *player, Enemy *enemy) {
     }
 }
 
-// Handles the enemy's turn (simple attack)
-void enemy_turn(Player *player, Enemy *enemy) {
+// Handles the enemy's turn (whatever its ai script picks)
+bool enemy_turn(Player *player, Enemy *enemy) {
     // cant attack if enemy is dead or pointers are bad
-    if (player == NULL || enemy == NULL || enemy->hp <= 0) return;
+    if (player == NULL || enemy == NULL || enemy->hp <= 0) return true;
 
     printf("\n%s's turn.\n", enemy->name); // enemy turn
+    
+    // poison from an earlier turn hits first
+    int poison = ai_poison_tick(&g_enemy_ai);
+    if (poison > 0) {
+        player->hp -= poison;
+        if (player->hp < 0) player->hp = 0;
+        mark_player_dirty(player, DIRTY_HP);
+        printf("The poison burns for %d damage. Remaining HP: %d/%d\n", poison, player->hp, player->maxHp);
+        if (player->hp <= 0) return true;
+    }
+    if (g_enemy_ai.poison_turns == 0 && player->is_poisoned) {
+        player->is_poisoned = 0;
+        mark_player_dirty(player, DIRTY_STATUS);
+        printf("The poison wears off.\n");
+    }
+    
+    int amount = 0;
+    AiAction action = ai_enemy_turn(&g_enemy_ai, enemy->hp, enemy->maxHp, player->hp, player->maxHp, &amount);
+    switch (action) {
+        case AI_HEAL:
+            enemy->hp += amount;
+            printf("%s recovers %d HP! (%d/%d)\n", enemy->name, amount, enemy->hp, enemy->maxHp);
+            log_event(LOG_COMBAT, "%s healed %d", enemy->name, amount);
+            return true;
+        case AI_ENRAGE:
+            printf("%s flies into a rage! Its attacks now deal %d damage.\n", enemy->name, amount);
+            log_event(LOG_COMBAT, "%s enraged (%d damage)", enemy->name, amount);
+            return true;
+        case AI_FLEE:
+            printf("%s turns and runs!\n", enemy->name);
+            log_event(LOG_COMBAT, "%s fled from %s", enemy->name, player->name);
+            return false;
+        case AI_ATTACK:
+        case AI_POISON:
+            break;
+    }
+    
     printf("%s attacks %s!\n", enemy->name, player->name); // enemy attack
     
     // player takes damage
-    player->hp -= enemy->damage; 
+    player->hp -= amount; 
 
     // dont let hp go below 0
     if (player->hp < 0) player->hp = 0;
+    mark_player_dirty(player, DIRTY_HP);
+    GAME_PROBE2(enemy__hit, amount, player->hp);
 
     printf("%s takes %d damage. Remaining HP: %d/%d\n", 
-           player->name, enemy->damage, player->hp, player->maxHp);
+           player->name, amount, player->hp, player->maxHp);
            
     // log enemy damage with our variadic function
     log_event(LOG_COMBAT, "%s dealt %d damage to %s", 
-             enemy->name, enemy->damage, player->name);
+             enemy->name, amount, player->name);
+    
+    if (action == AI_POISON && player->hp > 0) {
+        player->is_poisoned = 1;
+        mark_player_dirty(player, DIRTY_STATUS);
+        printf("%s is poisoned!\n", player->name);
+    }
+    return true;
 }
 
 // Show shop menu and handle purchases
@@ -377,12 +523,17 @@ void show_shop(Player *player) {
         return;
     }
     
+    // what's for sale comes from the content tables
+    const ContentTables *content = content_get();
+    int exit_choice = content->shop_count + 1;
+    
     printf("\n=== SHOP ===\n");
     printf("Your Gold: %d\n", player->gold);
-    printf("1. Health Potion (20 gold)\n");
-    printf("2. Strong Health Potion (40 gold)\n");
-    printf("3. Super Health Potion (80 gold)\n");
-    printf("4. Exit Shop\n");
+    for (int i = 0; i < content->shop_count; i++) {
+        printf("%d. %s (%d gold)\n", i + 1, content->shop[i].name, content->shop[i].price);
+    }
+    printf("%d. Exit Shop\n", exit_choice);
+    printf("%d. Auction House (trade with other players)\n", exit_choice + 1);
     
     int choice;
     printf("What would you like to buy? ");
@@ -400,64 +551,34 @@ void show_shop(Player *player) {
     while ((c = getchar()) != '\n' && c != EOF);
     
     // process choice
-    switch (choice) {
-        case 1: // Basic health potion
-            if (player->gold >= 20) {
-                if (player->inventory_size < player->inventory_capacity) {
-                    Item *potion = create_health_potion(player->level);
-                    player->inventory[player->inventory_size++] = potion;
-                    player->gold -= 20;
-                    printf("Purchased %s for 20 gold. Remaining gold: %d\n", 
-                           potion->name, player->gold);
-                } else {
-                    printf("Inventory full! Can't buy more items.\n");
-                }
+    if (choice >= 1 && choice <= content->shop_count) {
+        const ShopEntry *entry = &content->shop[choice - 1];
+        if (player->gold >= entry->price) {
+            if (player->inventory_size < player->inventory_capacity) {
+                Item *potion = create_health_potion(player->level + entry->strength_offset);
+                mark_inventory_dirty(player, player->inventory_size);
+                player->inventory[player->inventory_size++] = potion;
+                player->gold -= entry->price;
+                mark_player_dirty(player, DIRTY_GOLD);
+                printf("Purchased %s for %d gold. Remaining gold: %d\n", 
+                       potion->name, entry->price, player->gold);
             } else {
-                printf("Not enough gold!\n");
+                printf("Inventory full! Can't buy more items.\n");
             }
-            break;
-            
-        case 2: // Stronger health potion
-            if (player->gold >= 40) {
-                if (player->inventory_size < player->inventory_capacity) {
-                    Item *potion = create_health_potion(player->level + 1);
-                    player->inventory[player->inventory_size++] = potion;
-                    player->gold -= 40;
-                    printf("Purchased %s for 40 gold. Remaining gold: %d\n", 
-                           potion->name, player->gold);
-                } else {
-                    printf("Inventory full! Can't buy more items.\n");
-                }
-            } else {
-                printf("Not enough gold!\n");
-            }
-            break;
-            
-        case 3: // Super health potion
-            if (player->gold >= 80) {
-                if (player->inventory_size < player->inventory_capacity) {
-                    Item *potion = create_health_potion(player->level + 2);
-                    player->inventory[player->inventory_size++] = potion;
-                    player->gold -= 80;
-                    printf("Purchased %s for 80 gold. Remaining gold: %d\n", 
-                           potion->name, player->gold);
-                } else {
-                    printf("Inventory full! Can't buy more items.\n");
-                }
-            } else {
-                printf("Not enough gold!\n");
-            }
-            break;
-            
-        case 4: // Exit
-            printf("Thanks for visiting the shop!\n");
-            break;
-            
-        default:
-            printf("Invalid choice. Leaving shop.\n");
+        } else {
+            printf("Not enough gold!\n");
+        }
+    } else if (choice == exit_choice) {
+        printf("Thanks for visiting the shop!\n");
+    } else if (choice == exit_choice + 1) {
+        show_auction_house(player); // saves on its own
+        return;
+    } else {
+        printf("Invalid choice. Leaving shop.\n");
     }
     
-    // auto-save after shopping
+    // gold changed, so might the gold board (and auto-save after shopping)
+    leaderboard_update(player);
     save_game(player, saveFileName[0] != '\0' ? saveFileName : NULL);
 }
 
@@ -469,9 +590,11 @@ void explore_area(Player *player) {
     
     printf("\n=== AREA %d EXPLORATION ===\n", player->area_level);
     printf("1. Fight monster\n");
-    printf("2. Rest (heal %d HP)\n", player->level * 5);
+    int rest_heal = player->level * content_get()->items.rest_heal_per_level;
+    printf("2. Rest (heal %d HP)\n", rest_heal);
     printf("3. Move to next area\n");
     printf("4. Return to menu\n");
+    printf("5. Auto-battle (fight without the turn by turn)\n");
     
     int choice;
     printf("What would you like to do? ");
@@ -498,11 +621,12 @@ void explore_area(Player *player) {
         }
         
         case 2: { // Rest to heal
-            int heal_amount = player->level * 5;
+            int heal_amount = rest_heal;
             player->hp += heal_amount;
             if (player->hp > player->maxHp) {
                 player->hp = player->maxHp;
             }
+            mark_player_dirty(player, DIRTY_HP);
             printf("You rest and recover %d HP. Current HP: %d/%d\n", 
                    heal_amount, player->hp, player->maxHp);
             save_game(player, saveFileName[0] != '\0' ? saveFileName : NULL);
@@ -513,6 +637,7 @@ void explore_area(Player *player) {
             if (player->area_level < 5) {
                 if (player->level >= player->area_level + 1) {
                     player->area_level++;
+                    mark_player_dirty(player, DIRTY_AREA);
                     printf("You advance to Area %d!\n", player->area_level);
                     save_game(player, saveFileName[0] != '\0' ? saveFileName : NULL);
                 } else {
@@ -531,16 +656,10 @@ void explore_area(Player *player) {
                     boss.type = BOSS; // Override to ensure boss type
                     
                     // Fight the boss
+                    broadcast_publish(player->area_level, BROADCAST_BOSS, "%s (Level %d) is challenging the final boss!",
+                                      player->name, player->level);
                     start_combat(player, &boss);
-                    
-                    // If player won
-                    if (player->hp > 0) {
-                        printf("\n=== YOU HAVE COMPLETED THE GAME! ===\n");
-                        printf("Congratulations on defeating the final boss!\n");
-                        printf("Final stats: Level %d, %d kills, %d gold\n",
-                               player->level, player->kills, player->gold);
-                    }
-                    
+                    boss_fight_over(player, &boss);
                     cleanup_enemy(&boss);
                 }
             } else {
@@ -554,6 +673,14 @@ void explore_area(Player *player) {
             printf("Returning to main menu.\n");
             break;
             
+        case 5: { // Auto-battle, just attacks, settled in one go
+            Enemy enemy;
+            initialize_enemy(&enemy, player->area_level, player->level);
+            auto_combat(player, &enemy);
+            cleanup_enemy(&enemy);
+            break;
+        }
+            
         default:
             printf("Invalid choice.\n");
     }
@@ -565,6 +692,7 @@ void game_loop(Player *player, GameState *state) {
         return;
     }
     
+    TRACE_SCOPE("game_loop");
     int choice;
     
     switch (*state) {
@@ -611,6 +739,13 @@ void game_loop(Player *player, GameState *state) {
                     printf("Gold: %d\n", player->gold);
                     printf("Area: %d\n", player->area_level);
                     printf("Kills: %d\n", player->kills);
+                    printf("Rank: #%d of %d by level, #%d by kills, #%d by gold, #%d of %d %ss\n",
+                           leaderboard_rank(LEADERBOARD_LEVEL, player->name), leaderboard_size(LEADERBOARD_LEVEL),
+                           leaderboard_rank(LEADERBOARD_KILLS, player->name),
+                           leaderboard_rank(LEADERBOARD_GOLD, player->name),
+                           leaderboard_rank(LEADERBOARD_PALADIN + player->playerClass, player->name),
+                           leaderboard_size(LEADERBOARD_PALADIN + player->playerClass),
+                           leaderboard_name(LEADERBOARD_PALADIN + player->playerClass));
                     printf("Inventory (%d/%d):\n", player->inventory_size, player->inventory_capacity);
                     
                     if (player->inventory_size == 0) {
@@ -4,6 +4,7 @@
 
 #include "player.h"
 #include "enemy.h"
+#include "ai.h" // AiState
 
 // Game state enum
 typedef enum {
@@ -15,6 +16,9 @@ typedef enum {
     GAME_STATE_WIN
 } GameState;
 
+// extra gold for a level up after a fight
+#define LEVEL_UP_GOLD_BONUS 10
+
 // Function prototypes for game logic will go here
 // For example:
 // void start_combat(Player *player, Enemy *enemy);
@@ -22,15 +26,31 @@ typedef enum {
 // Handles the player's turn
 void player_turn(Player *player, Enemy *enemy);
 
-// Handles the enemy's turn
-void enemy_turn(Player *player, Enemy *enemy);
+// Handles the enemy's turn, false if the enemy ran away
+bool enemy_turn(Player *player, Enemy *enemy);
 
 // Start combat with an enemy
 void start_combat(Player *player, Enemy *enemy);
 
+// The fight start_combat is in the middle of (for a hot restart), false
+// if there isn't one. enemy->name still belongs to the fight
+bool combat_in_progress(Enemy *enemy, AiState *ai, int *turns);
+
+// Pick up a fight another process was in the middle of: the player picks
+// their move for turn `turns` again, the enemy's script carries on
+void resume_combat(Player *player, Enemy *enemy, const AiState *ai, int turns);
+
 // Handle enemy death rewards
 void handle_enemy_defeat(Player *player, Enemy *enemy);
 
+// the same gold/xp/kill rewards, quietly (no loot, no autosave)
+// returns true if the player leveled up
+bool grant_enemy_rewards(Player *player, const Enemy *enemy);
+
+// part/whole of the enemy's gold and xp plus the kill, for an enemy a
+// lot of players took down together (split by damage)
+bool grant_enemy_share(Player *player, const Enemy *enemy, long long part, long long whole);
+
 // Show shop menu and handle purchases
 void show_shop(Player *player);
 
@@ -0,0 +1,614 @@
+// handoff.c - Hot restart: hand live sessions to a new binary
+//
+// The new binary listens on a unix socket, the old one connects and sends
+// one packet per session: the player (in the save_record_encode format),
+// where they were in the menus, any fight in progress, the dirty bits and
+// whatever they typed ahead, with the session's connections riding along
+// as SCM_RIGHTS. The kernel
+// hands the new process its own copies of those fds, so the player on the
+// other end never sees a reconnect, just a short wait.
+//
+// SOCK_SEQPACKET keeps every packet in one piece, so there's no framing to
+// get wrong: one recvmsg is one session. Nothing is written to the save
+// files on the way: what the old process hadnt saved yet is still marked
+// dirty on the new side and goes out with the next normal save.
+//
+// After the sessions the old process writes out the shared files
+// (leaderboards, auctions) and sends "DONE", the new one only loads them
+// after that so neither side works from a stale copy.
+//
+// stdin goes through a cookie stream (fopencookie) reading from a buffer
+// we own: the wait for input polls stdin and a self-pipe the SIGUSR2
+// handler writes to, so a player sitting at a prompt gets handed off as
+// soon as the signal comes in, and the bytes read ahead go along.
+#define _GNU_SOURCE
+#include "handoff.h"
+#include "content.h" // CONTENT_ENEMY_TYPES
+#include "utils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define HANDOFF_MAGIC "HOF1"
+#define HANDOFF_DONE "DONE"
+#define HANDOFF_PACKET_MAX 8192
+
+static volatile sig_atomic_t g_handoff_requested = 0;
+static int g_wake_pipe[2] = { -1, -1 }; // the SIGUSR2 handler writes a byte
+
+// stdin's read-ahead, see handoff_wrap_stdin
+static struct {
+    char data[HANDOFF_INPUT_MAX];
+    size_t pos;
+    size_t len;
+} g_input;
+static void (*g_on_request)(void *ctx) = NULL;
+static void *g_on_request_ctx = NULL;
+
+// when the old process started sending (CLOCK_MONOTONIC is the same clock
+// in both processes), so the new one can say how long the pause was
+static long long g_send_started_ns = 0;
+
+static long long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+const char *handoff_path() {
+    const char *path = getenv("GAME_HANDOFF_SOCKET");
+    return (path != NULL && path[0] != '\0') ? path : HANDOFF_DEFAULT_PATH;
+}
+
+// --- packet building, little endian like the binary save format ---
+
+typedef struct {
+    unsigned char data[HANDOFF_PACKET_MAX];
+    size_t len;
+    bool ok; // false once something didnt fit
+} Packet;
+
+static void put_bytes(Packet *packet, const void *bytes, size_t n) {
+    if (!packet->ok || packet->len + n > sizeof(packet->data)) {
+        packet->ok = false;
+        return;
+    }
+    memcpy(packet->data + packet->len, bytes, n);
+    packet->len += n;
+}
+
+static void put_u32(Packet *packet, unsigned int v) {
+    unsigned char b[4] = { v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF, (v >> 24) & 0xFF };
+    put_bytes(packet, b, 4);
+}
+
+static void put_u64(Packet *packet, unsigned long long v) {
+    put_u32(packet, (unsigned int)(v & 0xFFFFFFFFu));
+    put_u32(packet, (unsigned int)(v >> 32));
+}
+
+static void put_str(Packet *packet, const char *str) {
+    size_t len = str != NULL ? strlen(str) : 0;
+    put_u32(packet, (unsigned int)len);
+    put_bytes(packet, str, len);
+}
+
+// readers set *ok = false instead of running off the end
+typedef struct {
+    const unsigned char *data;
+    size_t len;
+    size_t pos;
+    bool ok;
+} Reader;
+
+static const unsigned char *get_bytes(Reader *reader, size_t n) {
+    if (!reader->ok || reader->pos + n > reader->len) {
+        reader->ok = false;
+        return NULL;
+    }
+    const unsigned char *bytes = reader->data + reader->pos;
+    reader->pos += n;
+    return bytes;
+}
+
+static unsigned int get_u32(Reader *reader) {
+    const unsigned char *b = get_bytes(reader, 4);
+    if (b == NULL) return 0;
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned int)b[3] << 24);
+}
+
+static unsigned long long get_u64(Reader *reader) {
+    unsigned long long low = get_u32(reader);
+    unsigned long long high = get_u32(reader);
+    return low | (high << 32);
+}
+
+// copies into dest (cap bytes), too long counts as broken
+static void get_str(Reader *reader, char *dest, size_t cap) {
+    size_t len = get_u32(reader);
+    const unsigned char *bytes = reader->ok && len < cap ? get_bytes(reader, len) : NULL;
+    if (bytes == NULL) {
+        reader->ok = false;
+        dest[0] = '\0';
+        return;
+    }
+    memcpy(dest, bytes, len);
+    dest[len] = '\0';
+}
+
+// --- sending and receiving packets with fds attached ---
+
+static bool send_packet(int conn, const Packet *packet, const int *fds, int fd_count) {
+    struct iovec iov = { (void *)packet->data, packet->len };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * HANDOFF_MAX_FDS)];
+        struct cmsghdr align;
+    } control;
+    if (fd_count > 0) {
+        memset(&control, 0, sizeof(control));
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fd_count);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fd_count);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * fd_count);
+    }
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(conn, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    if (sent != (ssize_t)packet->len) {
+        fprintf(stderr, "Error: Handoff send failed: %s\n", sent < 0 ? strerror(errno) : "short write");
+        return false;
+    }
+    return true;
+}
+
+// returns the packet length (0 = the other side hung up, -1 on error),
+// fds gets whatever came attached (already open in this process)
+static ssize_t receive_packet(int conn, unsigned char *data, size_t cap, int *fds, int *fd_count) {
+    struct iovec iov = { data, cap };
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * HANDOFF_MAX_FDS)];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t got;
+    do {
+        got = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC);
+    } while (got < 0 && errno == EINTR);
+
+    *fd_count = 0;
+    if (got < 0) {
+        fprintf(stderr, "Error: Handoff receive failed: %s\n", strerror(errno));
+        return -1;
+    }
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+        int n = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        for (int i = 0; i < n; i++) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            if (*fd_count < HANDOFF_MAX_FDS) {
+                fds[(*fd_count)++] = fd;
+            } else {
+                close(fd);
+            }
+        }
+    }
+    if (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) {
+        fprintf(stderr, "Error: Handoff packet didnt fit\n");
+        for (int i = 0; i < *fd_count; i++) close(fds[i]);
+        *fd_count = 0;
+        return -1;
+    }
+    return got;
+}
+
+static bool fill_address(struct sockaddr_un *addr, const char *path) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (path == NULL || strlen(path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "Error: Bad handoff socket path '%s'\n", path ? path : "(null)");
+        return false;
+    }
+    strcpy(addr->sun_path, path);
+    return true;
+}
+
+// --- new process ---
+
+int handoff_listen(const char *path) {
+    struct sockaddr_un addr;
+    if (!fill_address(&addr, path)) return -1;
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not create handoff socket: %s\n", strerror(errno));
+        return -1;
+    }
+    unlink(path); // left over from an earlier restart
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 1) < 0) {
+        fprintf(stderr, "Error: Could not listen on '%s': %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int handoff_accept(int server_fd) {
+    int conn;
+    do {
+        conn = accept4(server_fd, NULL, NULL, SOCK_CLOEXEC);
+    } while (conn < 0 && errno == EINTR);
+    if (conn < 0) {
+        fprintf(stderr, "Error: Handoff accept failed: %s\n", strerror(errno));
+    }
+    return conn;
+}
+
+// unpack one session packet, false if it's broken
+static bool decode_session(Reader *reader, HandoffSession *session) {
+    session->state = (GameState)get_u32(reader);
+    session->in_combat = get_u32(reader) != 0;
+
+    char enemy_name[SAVE_RECORD_NAME_LENGTH];
+    if (session->in_combat) {
+        session->combat_turns = (int)get_u32(reader);
+        get_str(reader, enemy_name, sizeof(enemy_name));
+        Enemy *enemy = &session->enemy;
+        enemy->hp = (int)get_u32(reader);
+        enemy->maxHp = (int)get_u32(reader);
+        enemy->damage = (int)get_u32(reader);
+        enemy->type = (enum EnemyType)get_u32(reader);
+        enemy->level = (int)get_u32(reader);
+        enemy->xp_value = (int)get_u32(reader);
+        enemy->gold_value = (int)get_u32(reader);
+        if ((int)enemy->type < 0 || (int)enemy->type >= CONTENT_ENEMY_TYPES) return false;
+
+        // the script comes from this binary's tables, the rest is where it was
+        AiState *ai = &session->ai;
+        ai_begin(ai, enemy, 0);
+        ai->base_damage = (int)get_u32(reader);
+        ai->damage = (int)get_u32(reader);
+        ai->turn = (int)get_u32(reader);
+        ai->once_used = get_u32(reader);
+        ai->poison_turns = (int)get_u32(reader);
+        ai->poison_damage = (int)get_u32(reader);
+        ai->rng = get_u32(reader);
+    }
+
+    get_str(reader, session->save_file, sizeof(session->save_file));
+    session->input_len = get_u32(reader);
+    const unsigned char *input = session->input_len <= sizeof(session->input)
+                                 ? get_bytes(reader, session->input_len) : NULL;
+    if (input == NULL) return false;
+    memcpy(session->input, input, session->input_len);
+    unsigned int dirty = get_u32(reader);
+    unsigned int dirty_slots = get_u32(reader);
+
+    size_t record_len = get_u32(reader);
+    const unsigned char *record_bytes = get_bytes(reader, record_len);
+    if (!reader->ok || record_bytes == NULL) return false;
+
+    SaveRecord record;
+    if (save_record_decode(&record, record_bytes, record_len) != record_len) return false;
+    if (!save_record_to_player(&record, &session->player)) return false;
+    session->player.dirty = dirty;
+    session->player.dirty_slots = dirty_slots;
+
+    if (session->in_combat) {
+        session->enemy.name = strdup(enemy_name);
+        if (session->enemy.name == NULL) return false;
+    }
+    return true;
+}
+
+int handoff_receive(int conn, HandoffSession *sessions, int max) {
+    if (sessions == NULL || max < 0) return -1;
+
+    unsigned char *data = malloc(HANDOFF_PACKET_MAX);
+    if (data == NULL) {
+        fprintf(stderr, "Error: Could not allocate handoff buffer\n");
+        return -1;
+    }
+
+    // header: magic, when the sender started, session count
+    int fds[HANDOFF_MAX_FDS];
+    int fd_count = 0;
+    ssize_t len = receive_packet(conn, data, HANDOFF_PACKET_MAX, fds, &fd_count);
+    Reader reader = { data, len > 0 ? (size_t)len : 0, 0, len > 0 };
+    const unsigned char *magic = get_bytes(&reader, 4);
+    g_send_started_ns = (long long)get_u64(&reader);
+    int count = (int)get_u32(&reader);
+    if (magic == NULL || memcmp(magic, HANDOFF_MAGIC, 4) != 0 || !reader.ok || count < 0) {
+        fprintf(stderr, "Error: Not a handoff from this game\n");
+        for (int i = 0; i < fd_count; i++) close(fds[i]);
+        free(data);
+        return -1;
+    }
+    for (int i = 0; i < fd_count; i++) close(fds[i]); // nothing rides on the header
+
+    int received = 0;
+    for (int i = 0; i < count; i++) {
+        HandoffSession scratch;
+        HandoffSession *session = received < max ? &sessions[received] : &scratch;
+        memset(session, 0, sizeof(HandoffSession));
+
+        len = receive_packet(conn, data, HANDOFF_PACKET_MAX, session->fds, &session->fd_count);
+        Reader body = { data, len > 0 ? (size_t)len : 0, 0, len > 0 };
+        bool ok = len > 0 && decode_session(&body, session);
+        if (!ok || session != &sessions[received]) {
+            // broken or no room for it, the connection goes with it
+            if (ok) fprintf(stderr, "Error: No room for handed off session %d\n", i);
+            else fprintf(stderr, "Error: Handed off session %d is broken\n", i);
+            for (int f = 0; f < session->fd_count; f++) close(session->fds[f]);
+            cleanup_player(&session->player);
+            if (session->enemy.name != NULL) cleanup_enemy(&session->enemy);
+            if (len <= 0) break;
+            continue;
+        }
+        received++;
+    }
+    free(data);
+    return received;
+}
+
+bool handoff_wait_done(int conn) {
+    unsigned char data[16];
+    int fds[HANDOFF_MAX_FDS];
+    int fd_count = 0;
+    ssize_t len = receive_packet(conn, data, sizeof(data), fds, &fd_count);
+    for (int i = 0; i < fd_count; i++) close(fds[i]);
+    close(conn);
+
+    if (len != (ssize_t)strlen(HANDOFF_DONE) || memcmp(data, HANDOFF_DONE, len) != 0) {
+        fprintf(stderr, "Error: Old process went away before finishing the handoff\n");
+        return false;
+    }
+    if (g_send_started_ns > 0) {
+        log_event(LOG_DEBUG, "Hot restart: sessions were paused for %.1f ms",
+                  (now_ns() - g_send_started_ns) / 1e6);
+    }
+    return true;
+}
+
+// --- old process ---
+
+int handoff_connect(const char *path) {
+    struct sockaddr_un addr;
+    if (!fill_address(&addr, path)) return -1;
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not create handoff socket: %s\n", strerror(errno));
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "Error: No new process listening on '%s': %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// pack one session (player as a binary save record)
+static bool encode_session(Packet *packet, const HandoffSession *session) {
+    put_u32(packet, (unsigned int)session->state);
+    put_u32(packet, session->in_combat ? 1 : 0);
+    if (session->in_combat) {
+        const Enemy *enemy = &session->enemy;
+        put_u32(packet, (unsigned int)session->combat_turns);
+        put_str(packet, enemy->name);
+        put_u32(packet, (unsigned int)enemy->hp);
+        put_u32(packet, (unsigned int)enemy->maxHp);
+        put_u32(packet, (unsigned int)enemy->damage);
+        put_u32(packet, (unsigned int)enemy->type);
+        put_u32(packet, (unsigned int)enemy->level);
+        put_u32(packet, (unsigned int)enemy->xp_value);
+        put_u32(packet, (unsigned int)enemy->gold_value);
+
+        const AiState *ai = &session->ai; // minus the code pointer
+        put_u32(packet, (unsigned int)ai->base_damage);
+        put_u32(packet, (unsigned int)ai->damage);
+        put_u32(packet, (unsigned int)ai->turn);
+        put_u32(packet, ai->once_used);
+        put_u32(packet, (unsigned int)ai->poison_turns);
+        put_u32(packet, (unsigned int)ai->poison_damage);
+        put_u32(packet, ai->rng);
+    }
+
+    put_str(packet, session->save_file);
+    if (session->input_len > sizeof(session->input)) return false;
+    put_u32(packet, (unsigned int)session->input_len);
+    put_bytes(packet, session->input, session->input_len);
+    put_u32(packet, session->player.dirty);
+    put_u32(packet, session->player.dirty_slots);
+
+    SaveRecord record;
+    save_record_from_player(&record, &session->player);
+    unsigned char encoded[HANDOFF_PACKET_MAX / 2];
+    size_t record_len = save_record_encode(&record, encoded, sizeof(encoded));
+    if (record_len > sizeof(encoded)) return false;
+    put_u32(packet, (unsigned int)record_len);
+    put_bytes(packet, encoded, record_len);
+    return packet->ok;
+}
+
+bool handoff_send(int conn, const HandoffSession *sessions, int count) {
+    if (conn < 0 || count < 0 || (count > 0 && sessions == NULL)) return false;
+
+    Packet *packet = malloc(sizeof(Packet));
+    if (packet == NULL) {
+        fprintf(stderr, "Error: Could not allocate handoff buffer\n");
+        return false;
+    }
+
+    packet->len = 0;
+    packet->ok = true;
+    put_bytes(packet, HANDOFF_MAGIC, 4);
+    put_u64(packet, (unsigned long long)now_ns());
+    put_u32(packet, (unsigned int)count);
+    bool ok = send_packet(conn, packet, NULL, 0);
+
+    for (int i = 0; ok && i < count; i++) {
+        packet->len = 0;
+        packet->ok = true;
+        int fd_count = sessions[i].fd_count;
+        if (fd_count < 0 || fd_count > HANDOFF_MAX_FDS || !encode_session(packet, &sessions[i])) {
+            fprintf(stderr, "Error: Could not pack session %d for the handoff\n", i);
+            ok = false;
+            break;
+        }
+        ok = send_packet(conn, packet, sessions[i].fds, fd_count);
+    }
+    free(packet);
+    return ok;
+}
+
+bool handoff_done(int conn) {
+    Packet packet;
+    packet.len = 0;
+    packet.ok = true;
+    put_bytes(&packet, HANDOFF_DONE, strlen(HANDOFF_DONE));
+    bool ok = send_packet(conn, &packet, NULL, 0);
+    close(conn);
+    return ok;
+}
+
+static void handle_sigusr2(int sig) {
+    (void)sig;
+    int saved_errno = errno;
+    g_handoff_requested = 1;
+    if (g_wake_pipe[1] >= 0) {
+        char byte = 1;
+        ssize_t ignored = write(g_wake_pipe[1], &byte, 1); // full = already awake
+        (void)ignored;
+    }
+    errno = saved_errno;
+}
+
+void handoff_watch_signal() {
+    if (g_wake_pipe[0] < 0 && pipe2(g_wake_pipe, O_CLOEXEC | O_NONBLOCK) < 0) {
+        fprintf(stderr, "Error: Could not create handoff wake pipe: %s\n", strerror(errno));
+        g_wake_pipe[0] = g_wake_pipe[1] = -1;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_sigusr2;
+    // saves and the like carry on, the wait for input hears about it
+    // through the pipe instead
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR2, &action, NULL);
+}
+
+bool handoff_requested() {
+    if (!g_handoff_requested) return false;
+    g_handoff_requested = 0;
+    char drain[16];
+    while (g_wake_pipe[0] >= 0 && read(g_wake_pipe[0], drain, sizeof(drain)) > 0) {
+    }
+    return true;
+}
+
+// --- stdin ---
+
+// fill g_input from fd 0, handing the session off if SIGUSR2 comes in
+// while we wait. returns what read() did (0 = end of input)
+static ssize_t fill_input() {
+    for (;;) {
+        struct pollfd fds[2] = {
+            { STDIN_FILENO, POLLIN, 0 },
+            { g_wake_pipe[0], POLLIN, 0 }
+        };
+        // nobody to hand off to yet = leave the request for handoff_requested
+        nfds_t count = (g_on_request != NULL && g_wake_pipe[0] >= 0) ? 2 : 1;
+        if (poll(fds, count, -1) < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (count == 2 && (fds[1].revents & POLLIN)) {
+            if (handoff_requested()) g_on_request(g_on_request_ctx); // only back if nobody took it
+            continue;
+        }
+        if (fds[0].revents == 0) continue;
+
+        ssize_t got = read(STDIN_FILENO, g_input.data, sizeof(g_input.data));
+        if (got < 0 && errno == EINTR) continue;
+        if (got > 0) {
+            g_input.pos = 0;
+            g_input.len = (size_t)got;
+        }
+        return got;
+    }
+}
+
+static ssize_t input_read(void *cookie, char *buf, size_t size) {
+    (void)cookie;
+    if (g_input.pos == g_input.len) {
+        ssize_t got = fill_input();
+        if (got <= 0) return got;
+    }
+    size_t n = g_input.len - g_input.pos;
+    if (n > size) n = size;
+    memcpy(buf, g_input.data + g_input.pos, n);
+    g_input.pos += n;
+    return (ssize_t)n;
+}
+
+bool handoff_wrap_stdin() {
+    cookie_io_functions_t io = { input_read, NULL, NULL, NULL };
+    FILE *wrapped = fopencookie(NULL, "r", io);
+    if (wrapped == NULL) {
+        fprintf(stderr, "Error: Could not wrap stdin: %s\n", strerror(errno));
+        return false;
+    }
+    // stdio keeps nothing of its own, every byte ahead of the game is in g_input
+    setvbuf(wrapped, NULL, _IONBF, 0);
+    stdin = wrapped;
+    return true;
+}
+
+void handoff_on_request(void (*fn)(void *ctx), void *ctx) {
+    g_on_request = fn;
+    g_on_request_ctx = ctx;
+}
+
+size_t handoff_take_input(char *buf, size_t cap) {
+    size_t n = g_input.len - g_input.pos;
+    if (n > cap) n = cap;
+    memcpy(buf, g_input.data + g_input.pos, n);
+    g_input.pos += n;
+    return n;
+}
+
+void handoff_give_input(const char *buf, size_t len) {
+    if (len > sizeof(g_input.data)) len = sizeof(g_input.data);
+    memcpy(g_input.data, buf, len);
+    g_input.pos = 0;
+    g_input.len = len;
+}
@@ -0,0 +1,99 @@
+// handoff.h - Hot restart: hand live sessions to a new binary
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "player.h"
+#include "enemy.h"
+#include "ai.h"        // AiState
+#include "game.h"      // GameState
+#include "save_game.h" // MAX_FILENAME_LENGTH
+
+// where the new process waits for the old one (GAME_HANDOFF_SOCKET overrides)
+#define HANDOFF_DEFAULT_PATH "/tmp/cmmo-handoff.sock"
+
+// connections one session can bring along (stdin/stdout/stderr, a socket...)
+#define HANDOFF_MAX_FDS 4
+
+// stdin read ahead but not used yet (see handoff_wrap_stdin)
+#define HANDOFF_INPUT_MAX 1024
+
+// Everything a session needs to pick up where it was. The player goes
+// over with its dirty bits, so changes the old process hadnt saved yet
+// get saved by the new one whenever it would have anyway (nothing is
+// forced to disk for the handoff). Sessions move while they wait for the
+// player to type something, a fight included: the enemy, its script
+// state and the turn go along and the new process asks for the same
+// player turn again.
+typedef struct {
+    Player player;       // handoff_receive allocates name + inventory
+    GameState state;
+    bool in_combat;      // enemy, ai and combat_turns mean something
+    Enemy enemy;         // handoff_receive allocates the name
+    AiState ai;
+    int combat_turns;    // the turn the player was picking a move for
+    char save_file[MAX_FILENAME_LENGTH]; // "" = {name}.csv
+    char input[HANDOFF_INPUT_MAX]; // typed ahead, not read by the game yet
+    size_t input_len;
+    int fds[HANDOFF_MAX_FDS];
+    int fd_count;
+} HandoffSession;
+
+// the socket path to use (GAME_HANDOFF_SOCKET or the default)
+const char *handoff_path();
+
+// --- new process ---
+
+// listen on path for the old process, returns the fd (-1 on error)
+int handoff_listen(const char *path);
+
+// wait for the old process to connect, returns the connection (-1 on error)
+int handoff_accept(int server_fd);
+
+// Read the sessions the old process sent (fds arrive already open in
+// this process). returns how many sessions were received, -1 on error
+int handoff_receive(int conn, HandoffSession *sessions, int max);
+
+// block until the old process has written out its shared state
+// (leaderboards, auction books) and let go of it
+bool handoff_wait_done(int conn);
+
+// --- old process ---
+
+// connect to the new process, -1 if nobody is listening
+int handoff_connect(const char *path);
+
+// send every session, fds and all
+bool handoff_send(int conn, const HandoffSession *sessions, int count);
+
+// tell the new process it can load the shared state now, closes conn
+bool handoff_done(int conn);
+
+// SIGUSR2 asks for a hot restart, the handler only sets a flag (and
+// wakes up a wait on stdin, see handoff_wrap_stdin)
+void handoff_watch_signal();
+
+// true once per SIGUSR2
+bool handoff_requested();
+
+// --- stdin ---
+
+// Put stdin behind a read-ahead buffer of our own. Waiting for input also
+// waits for SIGUSR2, so an idle player gets handed off right away, and
+// whatever was read ahead can go along (handoff_take_input) instead of
+// being stranded in the old process. Call before anything reads stdin
+bool handoff_wrap_stdin();
+
+// fn(ctx) runs when SIGUSR2 comes in while we wait for input, it doesnt
+// return if it handed the session off. NULL = just note it for
+// handoff_requested
+void handoff_on_request(void (*fn)(void *ctx), void *ctx);
+
+// move what's been read ahead into buf (up to cap), returns how much
+size_t handoff_take_input(char *buf, size_t cap);
+
+// put input the old process had read ahead in front of stdin
+void handoff_give_input(const char *buf, size_t len);
+
+#endif // HANDOFF_H
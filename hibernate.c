@@ -0,0 +1,452 @@
+// hibernate.c - Idle sessions packed down into one small blob each
+//
+// A live Player is a dozen little heap blocks: the struct, the name, the
+// inventory array, and an Item plus a name for every item. Most connected
+// players are just sitting there though, so after idle_seconds without
+// input their player gets squashed into one malloc: the binary save record
+// (save_record_encode, names inline) plus the dirty bits, so unsaved
+// changes survive the trip. The next hibernate_acquire unpacks it again.
+//
+// Every session is on one LRU list (front = used last). When live players
+// and blobs together go past the budget, the coldest live ones get frozen
+// early, and if that's still not enough the coldest frozen ones get saved
+// and dropped altogether (they come back through load_game). Sessions
+// somebody is using right now (acquired) are never touched.
+//
+// One lock over the list, the normal acquire/release is a few pointer
+// swaps (plus an unpack when the session was frozen). Disk never gets
+// touched under it: an eviction or a thaw from disk marks the session
+// busy (io), drops the lock for the save_game/load_game, then takes it
+// back to finish up. Anyone who wants a busy session waits on io_done.
+#include "hibernate.h"
+#include "save_game.h"
+#include "utils.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// a frozen player, all in one allocation
+typedef struct {
+    unsigned int dirty;
+    unsigned int dirty_slots;
+    unsigned int version;
+    size_t len;
+    unsigned char data[]; // save_record_encode bytes
+} FrozenPlayer;
+
+struct HibernateSession {
+    HibernateSession *prev; // towards the front (used more recently)
+    HibernateSession *next;
+    HibernateState state;
+    Player *player;         // HIBERNATE_LIVE
+    FrozenPlayer *frozen;   // HIBERNATE_FROZEN
+    char *save_file;        // NULL = {name}.csv, else points just past name
+    long long last_used_ms;
+    size_t bytes;           // counted in g_hibernate.bytes
+    int pins;               // acquired and not released yet
+    bool io;                // being saved or loaded outside the lock, hands off
+    HibernateSession *evict_next; // next one to write out (enforce_budget)
+    char name[];            // always here (the save key once evicted), save_file after it
+};
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t io_done;  // some session's io just finished
+    HibernateSession *front; // used last
+    HibernateSession *back;  // coldest
+    long long idle_ms;
+    size_t budget;
+    size_t bytes;
+    long long freezes;
+    long long thaws;
+    long long evictions;
+} g_hibernate = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL,
+                  HIBERNATE_IDLE_SECONDS * 1000LL, HIBERNATE_BUDGET_BYTES, 0, 0, 0, 0 };
+
+static long long now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+// what malloc really takes for n bytes (glibc: 8 byte header, 16 byte
+// steps, 32 at least), small blocks are mostly overhead
+static size_t heap_size(size_t n) {
+    size_t size = (n + 8 + 15) & ~(size_t)15;
+    return size < 32 ? 32 : size;
+}
+
+// what a live player takes, every little block counted
+static size_t player_bytes(const Player *player) {
+    size_t bytes = heap_size(sizeof(Player)) + heap_size(sizeof(Item *) * player->inventory_capacity);
+    if (player->name != NULL) bytes += heap_size(strlen(player->name) + 1);
+    for (int i = 0; i < player->inventory_size; i++) {
+        Item *item = player->inventory[i];
+        if (item == NULL) continue;
+        bytes += heap_size(sizeof(Item));
+        if (item->name != NULL) bytes += heap_size(strlen(item->name) + 1);
+    }
+    return bytes;
+}
+
+static size_t session_bytes(const HibernateSession *session) {
+    size_t keys = strlen(session->name) + 1;
+    if (session->save_file != NULL) keys += strlen(session->save_file) + 1;
+    size_t bytes = heap_size(sizeof(HibernateSession) + keys);
+    if (session->state == HIBERNATE_LIVE) bytes += player_bytes(session->player);
+    if (session->state == HIBERNATE_FROZEN) bytes += heap_size(sizeof(FrozenPlayer) + session->frozen->len);
+    return bytes;
+}
+
+// recount a session after its state or player changed (lock held)
+static void recount(HibernateSession *session) {
+    g_hibernate.bytes -= session->bytes;
+    session->bytes = session_bytes(session);
+    g_hibernate.bytes += session->bytes;
+}
+
+// cleanup_player without the printing, and the struct too
+static void free_player(Player *player) {
+    if (player == NULL) return;
+    free(player->name);
+    if (player->inventory != NULL) {
+        for (int i = 0; i < player->inventory_size; i++) {
+            if (player->inventory[i] == NULL) continue;
+            free(player->inventory[i]->name);
+            free(player->inventory[i]);
+        }
+        free(player->inventory);
+    }
+    free(player);
+}
+
+// --- LRU list (lock held) ---
+
+static void unlink_session(HibernateSession *session) {
+    if (session->prev != NULL) session->prev->next = session->next;
+    else g_hibernate.front = session->next;
+    if (session->next != NULL) session->next->prev = session->prev;
+    else g_hibernate.back = session->prev;
+    session->prev = session->next = NULL;
+}
+
+static void push_front(HibernateSession *session) {
+    session->next = g_hibernate.front;
+    if (g_hibernate.front != NULL) g_hibernate.front->prev = session;
+    g_hibernate.front = session;
+    if (g_hibernate.back == NULL) g_hibernate.back = session;
+}
+
+static void touch(HibernateSession *session) {
+    session->last_used_ms = now_ms();
+    if (g_hibernate.front == session) return;
+    unlink_session(session);
+    push_front(session);
+}
+
+// --- state changes (lock held) ---
+
+// live -> frozen
+static bool freeze(HibernateSession *session) {
+    SaveRecord record;
+    save_record_from_player(&record, session->player);
+    size_t len = save_record_encode(&record, NULL, 0);
+    FrozenPlayer *frozen = malloc(sizeof(FrozenPlayer) + len);
+    if (frozen == NULL) return false;
+    save_record_encode(&record, frozen->data, len);
+    frozen->len = len;
+    frozen->dirty = session->player->dirty;
+    frozen->dirty_slots = session->player->dirty_slots;
+    frozen->version = session->player->version;
+
+    free_player(session->player);
+    session->player = NULL;
+    session->frozen = frozen;
+    session->state = HIBERNATE_FROZEN;
+    g_hibernate.freezes++;
+    recount(session);
+    return true;
+}
+
+// unpack a frozen player (the session keeps its blob), NULL if it's broken
+static Player *unpack(const FrozenPlayer *frozen) {
+    SaveRecord record;
+    Player *player = calloc(1, sizeof(Player));
+    if (player == NULL) return NULL;
+    if (save_record_decode(&record, frozen->data, frozen->len) != frozen->len ||
+        !save_record_to_player(&record, player)) {
+        free_player(player);
+        return NULL;
+    }
+    player->dirty = frozen->dirty;
+    player->dirty_slots = frozen->dirty_slots;
+    player->version = frozen->version;
+    return player;
+}
+
+// put a brought back player in place (lock held)
+static void install(HibernateSession *session, Player *player) {
+    free(session->frozen);
+    session->frozen = NULL;
+    session->player = player;
+    session->state = HIBERNATE_LIVE;
+    g_hibernate.thaws++;
+    recount(session);
+}
+
+// frozen -> live, all in memory so it's fine under the lock
+static bool thaw(HibernateSession *session) {
+    Player *player = unpack(session->frozen);
+    if (player == NULL) {
+        fprintf(stderr, "Error: Could not bring %s's session back\n", session->name);
+        return false;
+    }
+    install(session, player);
+    return true;
+}
+
+// read an evicted player back in (no lock, the session is marked io)
+static Player *load_evicted(const HibernateSession *session) {
+    Player *player = calloc(1, sizeof(Player));
+    if (player == NULL) return NULL;
+    player->name = strdup(session->name);
+    if (player->name == NULL || !load_game(player, session->save_file)) {
+        free_player(player);
+        return NULL;
+    }
+    return player;
+}
+
+// frozen -> evicted once there's nothing left to save (lock held)
+static void drop_frozen(HibernateSession *session) {
+    free(session->frozen);
+    session->frozen = NULL;
+    session->state = HIBERNATE_EVICTED;
+    g_hibernate.evictions++;
+    recount(session);
+    log_event(LOG_DEBUG, "Evicted %s's session (over the %zu byte budget)", session->name, g_hibernate.budget);
+}
+
+// Get back under budget, coldest first: freezing is cheap so every cold
+// live session goes before anything gets written out. Frozen sessions
+// with unsaved changes get marked io and put on *evictions instead of
+// saved here, write_evictions does that after the lock is dropped.
+// returns how many sessions got frozen or dropped right away (lock held)
+static int enforce_budget(HibernateSession **evictions) {
+    int changed = 0;
+    for (HibernateSession *session = g_hibernate.back;
+         session != NULL && g_hibernate.bytes > g_hibernate.budget; session = session->prev) {
+        if (session->pins == 0 && session->state == HIBERNATE_LIVE && freeze(session)) changed++;
+    }
+    size_t pending = 0; // blobs that go once their save is done
+    for (HibernateSession *session = g_hibernate.back;
+         session != NULL && g_hibernate.bytes > g_hibernate.budget + pending; session = session->prev) {
+        if (session->pins > 0 || session->io || session->state != HIBERNATE_FROZEN) continue;
+        if (session->frozen->dirty == 0 && session->frozen->dirty_slots == 0) {
+            drop_frozen(session); // already on disk as it is
+            changed++;
+            continue;
+        }
+        session->io = true;
+        session->evict_next = *evictions;
+        *evictions = session;
+        pending += heap_size(sizeof(FrozenPlayer) + session->frozen->len);
+    }
+    return changed;
+}
+
+// save what enforce_budget picked (lock NOT held), a session whose save
+// fails stays frozen, better than losing it. returns how many got evicted
+static int write_evictions(HibernateSession *session) {
+    int evicted = 0;
+    while (session != NULL) {
+        HibernateSession *next = session->evict_next;
+        // nobody else touches an io session, so its blob is ours to read
+        Player *player = unpack(session->frozen);
+        bool saved = player != NULL && save_game(player, session->save_file);
+        free_player(player);
+
+        pthread_mutex_lock(&g_hibernate.lock);
+        if (saved) {
+            drop_frozen(session);
+            evicted++;
+        }
+        session->io = false;
+        session->evict_next = NULL;
+        pthread_cond_broadcast(&g_hibernate.io_done);
+        pthread_mutex_unlock(&g_hibernate.lock);
+        session = next;
+    }
+    return evicted;
+}
+
+// wait till nobody is saving or loading session (lock held)
+static void wait_for_io(HibernateSession *session) {
+    while (session->io) {
+        pthread_cond_wait(&g_hibernate.io_done, &g_hibernate.lock);
+    }
+}
+
+// --- API ---
+
+bool hibernate_init(int idle_seconds, size_t budget_bytes) {
+    pthread_mutex_lock(&g_hibernate.lock);
+    g_hibernate.idle_ms = (idle_seconds > 0 ? idle_seconds : HIBERNATE_IDLE_SECONDS) * 1000LL;
+    g_hibernate.budget = budget_bytes > 0 ? budget_bytes : HIBERNATE_BUDGET_BYTES;
+    pthread_mutex_unlock(&g_hibernate.lock);
+    return true;
+}
+
+void hibernate_shutdown() {
+    pthread_mutex_lock(&g_hibernate.lock);
+    HibernateSession *session = g_hibernate.front;
+    while (session != NULL) {
+        HibernateSession *next = session->next;
+        free_player(session->player);
+        free(session->frozen);
+        free(session);
+        session = next;
+    }
+    g_hibernate.front = g_hibernate.back = NULL;
+    g_hibernate.bytes = 0;
+    g_hibernate.freezes = g_hibernate.thaws = g_hibernate.evictions = 0;
+    pthread_mutex_unlock(&g_hibernate.lock);
+}
+
+HibernateSession *hibernate_add(Player *player, const char *save_file) {
+    if (player == NULL || player->name == NULL) return NULL;
+    // one block: the session, its name and save file
+    size_t name_len = strlen(player->name) + 1;
+    size_t file_len = (save_file != NULL && save_file[0] != '\0') ? strlen(save_file) + 1 : 0;
+    HibernateSession *session = calloc(1, sizeof(HibernateSession) + name_len + file_len);
+    if (session == NULL) {
+        fprintf(stderr, "Error: Could not allocate a session for %s\n", player->name);
+        return NULL;
+    }
+    memcpy(session->name, player->name, name_len);
+    if (file_len > 0) {
+        session->save_file = session->name + name_len;
+        memcpy(session->save_file, save_file, file_len);
+    }
+    session->player = player;
+    session->state = HIBERNATE_LIVE;
+
+    HibernateSession *evictions = NULL;
+    pthread_mutex_lock(&g_hibernate.lock);
+    push_front(session);
+    session->last_used_ms = now_ms();
+    recount(session);
+    enforce_budget(&evictions);
+    pthread_mutex_unlock(&g_hibernate.lock);
+    write_evictions(evictions);
+    return session;
+}
+
+Player *hibernate_acquire(HibernateSession *session) {
+    if (session == NULL) return NULL;
+    HibernateSession *evictions = NULL;
+    pthread_mutex_lock(&g_hibernate.lock);
+    wait_for_io(session);
+    if (session->state == HIBERNATE_EVICTED) {
+        // load_game goes to disk, dont hold everyone else up for it
+        session->io = true;
+        pthread_mutex_unlock(&g_hibernate.lock);
+        Player *loaded = load_evicted(session);
+        pthread_mutex_lock(&g_hibernate.lock);
+        session->io = false;
+        pthread_cond_broadcast(&g_hibernate.io_done);
+        if (loaded == NULL) {
+            pthread_mutex_unlock(&g_hibernate.lock);
+            fprintf(stderr, "Error: Could not bring %s's session back\n", session->name);
+            return NULL;
+        }
+        install(session, loaded);
+    } else if (session->state == HIBERNATE_FROZEN && !thaw(session)) {
+        pthread_mutex_unlock(&g_hibernate.lock);
+        return NULL;
+    }
+    session->pins++;
+    touch(session);
+    enforce_budget(&evictions); // the thaw might have pushed us over
+    Player *player = session->player;
+    pthread_mutex_unlock(&g_hibernate.lock);
+    write_evictions(evictions);
+    return player;
+}
+
+void hibernate_release(HibernateSession *session) {
+    if (session == NULL) return;
+    HibernateSession *evictions = NULL;
+    pthread_mutex_lock(&g_hibernate.lock);
+    if (session->pins > 0) session->pins--;
+    touch(session);
+    recount(session); // items may have come or gone
+    enforce_budget(&evictions);
+    pthread_mutex_unlock(&g_hibernate.lock);
+    write_evictions(evictions);
+}
+
+int hibernate_sweep() {
+    HibernateSession *evictions = NULL;
+    pthread_mutex_lock(&g_hibernate.lock);
+    long long cutoff = now_ms() - g_hibernate.idle_ms;
+    int changed = 0;
+    // the list is in last used order, so stop at the first one still warm
+    for (HibernateSession *session = g_hibernate.back;
+         session != NULL && session->last_used_ms <= cutoff; session = session->prev) {
+        if (session->pins == 0 && session->state == HIBERNATE_LIVE && freeze(session)) changed++;
+    }
+    changed += enforce_budget(&evictions);
+    pthread_mutex_unlock(&g_hibernate.lock);
+    changed += write_evictions(evictions);
+    if (changed > 0) log_event(LOG_DEBUG, "Hibernated %d idle sessions", changed);
+    return changed;
+}
+
+bool hibernate_freeze(HibernateSession *session) {
+    if (session == NULL) return false;
+    pthread_mutex_lock(&g_hibernate.lock);
+    bool frozen = session->pins == 0 && session->state == HIBERNATE_LIVE && freeze(session);
+    pthread_mutex_unlock(&g_hibernate.lock);
+    return frozen;
+}
+
+void hibernate_remove(HibernateSession *session) {
+    if (session == NULL) return;
+    pthread_mutex_lock(&g_hibernate.lock);
+    wait_for_io(session);
+    unlink_session(session);
+    g_hibernate.bytes -= session->bytes;
+    pthread_mutex_unlock(&g_hibernate.lock);
+
+    free_player(session->player);
+    free(session->frozen);
+    free(session);
+}
+
+HibernateState hibernate_state(const HibernateSession *session) {
+    if (session == NULL) return HIBERNATE_EVICTED;
+    pthread_mutex_lock(&g_hibernate.lock);
+    HibernateState state = session->state;
+    pthread_mutex_unlock(&g_hibernate.lock);
+    return state;
+}
+
+void hibernate_get_stats(HibernateStats *stats) {
+    if (stats == NULL) return;
+    memset(stats, 0, sizeof(HibernateStats));
+    pthread_mutex_lock(&g_hibernate.lock);
+    for (HibernateSession *session = g_hibernate.front; session != NULL; session = session->next) {
+        if (session->state == HIBERNATE_LIVE) stats->live++;
+        else if (session->state == HIBERNATE_FROZEN) stats->frozen++;
+        else stats->evicted++;
+    }
+    stats->bytes = g_hibernate.bytes;
+    stats->budget = g_hibernate.budget;
+    stats->freezes = g_hibernate.freezes;
+    stats->thaws = g_hibernate.thaws;
+    stats->evictions = g_hibernate.evictions;
+    pthread_mutex_unlock(&g_hibernate.lock);
+}
@@ -0,0 +1,68 @@
+// hibernate.h - Idle sessions packed down into one small blob each
+#ifndef HIBERNATE_H
+#define HIBERNATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "player.h"
+
+// defaults for hibernate_init (0 = use these)
+#define HIBERNATE_IDLE_SECONDS 60
+#define HIBERNATE_BUDGET_BYTES (64u * 1024 * 1024)
+
+typedef enum {
+    HIBERNATE_LIVE,    // a real Player on the heap
+    HIBERNATE_FROZEN,  // one blob (binary save record + dirty bits)
+    HIBERNATE_EVICTED  // nothing but the name, comes back through load_game
+} HibernateState;
+
+typedef struct HibernateSession HibernateSession;
+
+typedef struct {
+    int live;
+    int frozen;
+    int evicted;
+    size_t bytes;        // what all the sessions take up right now (estimate)
+    size_t budget;
+    long long freezes;
+    long long thaws;
+    long long evictions;
+} HibernateStats;
+
+// idle_seconds: how long a session sits untouched before it gets frozen.
+// budget_bytes: cap on live players + blobs, past it the coldest sessions
+// get frozen and then evicted (saved and dropped) until it fits again
+bool hibernate_init(int idle_seconds, size_t budget_bytes);
+
+// frees every session, nothing gets saved
+void hibernate_shutdown();
+
+// Start tracking a session. Takes over player (a malloc'd Player, name and
+// inventory included). save_file can be NULL for {name}.csv
+// returns NULL if it couldnt be tracked (player is left alone then)
+HibernateSession *hibernate_add(Player *player, const char *save_file);
+
+// The session's player, brought back first if it was frozen or evicted.
+// It stays put (no freezing, no eviction) until hibernate_release, so
+// grab it when input comes in and release it once that input is handled.
+// returns NULL if it couldnt be brought back
+Player *hibernate_acquire(HibernateSession *session);
+void hibernate_release(HibernateSession *session);
+
+// freeze every session idle for longer than idle_seconds, then enforce the
+// budget. Call now and then (a timer, the accept loop...)
+// returns how many sessions got frozen or evicted
+int hibernate_sweep();
+
+// freeze a session right away instead of waiting for it to go idle
+// (false if it's acquired or already frozen/evicted)
+bool hibernate_freeze(HibernateSession *session);
+
+// stop tracking a session and free it (save first if you want to keep it)
+void hibernate_remove(HibernateSession *session);
+
+HibernateState hibernate_state(const HibernateSession *session);
+
+void hibernate_get_stats(HibernateStats *stats);
+
+#endif // HIBERNATE_H
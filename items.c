@@ -4,6 +4,8 @@
 #include <string.h> // for strcpy maybe
 #include <stdarg.h> // for variadic function
 #include <stdio.h>  // for printf
+#include "probes.h" // USDT probes
+#include "content.h" // potion numbers
 
 // Variadic function to create different items with variable parameters
 // itemType: The type of item to create
@@ -72,20 +74,31 @@ Item* create_item(enum ItemType itemType, const char* nameFormat, ...) {
     
     // Cleanup
     va_end(args);
+    GAME_PROBE3(item__create, (int)item->type, item->name, item->value);
     return item;
 }
 
 // Helper function to create a health potion with given strength
 Item* create_health_potion(int strength) {
+    // own format instead of create_named_potion, a "%s" in there makes
+    // both vsnprintf passes noticeably slower for the most common item
+    return create_item(HEALING, "Health Potion (Strength %d)", strength,
+                       strength * content_get()->items.heal_per_strength);
+}
+
+// same thing with any name (loot drops use this)
+Item* create_named_potion(const char *name, int strength) {
     // Use our variadic function to create the potion
     // The format includes the strength in the name
-    return create_item(HEALING, "Health Potion (Strength %d)", strength, strength * 10);
+    return create_item(HEALING, "%s (Strength %d)", name, strength,
+                       strength * content_get()->items.heal_per_strength);
 }
 
 // gimme a random potion... idk wut it does lol
 Item* create_random_potion() {
-    // Random strength between 1-5
-    int strength = rand() % 5 + 1;
+    // Random strength between 1 and random_max_strength (5)
+    const ItemRules *rules = &content_get()->items;
+    int strength = rand() % rules->random_max_strength + 1;
     
     // Array of funny adjectives (to show using variadic formatting)
     const char* adjectives[] = {
@@ -103,7 +116,8 @@ Item* create_random_potion() {
     int adj_index = rand() % (sizeof(adjectives) / sizeof(adjectives[0]));
     
     // Create the potion with random name and strength
-    return create_item(HEALING, "%s Health Potion", adjectives[adj_index], strength * 8);
+    return create_item(HEALING, "%s Health Potion", adjectives[adj_index],
+                       strength * rules->random_heal_per_strength);
 }
 
 // put item functions here later if needed
@@ -21,6 +21,7 @@ Item* create_item(enum ItemType itemType, const char* nameFormat, ...);
 
 // Helper functions using the variadic create_item
 Item* create_health_potion(int strength);
+Item* create_named_potion(const char *name, int strength);
 Item* create_random_potion();
 
 #endif // ITEMS_H 
\ No newline at end of file
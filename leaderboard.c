@@ -0,0 +1,570 @@
+// leaderboard.c - Player rankings, kept up to date as people play
+//
+// Every player has one entry in a hash table (by name) and one node in
+// each board they're on. A board is an order statistic skiplist: every
+// link also stores how many nodes it jumps over (its span), so adding up
+// spans on the way down gives a node's rank and following spans finds the
+// node at a rank, both O(log n) without ever scanning the board or saves/.
+//
+// On disk it's a snapshot (one line per player) plus a journal that every
+// update appends its line to, same as save files. Loading replays the
+// journal over the snapshot (later lines win), and once the journal gets
+// big it's folded into a new snapshot on the way out.
+#include "leaderboard.h"
+#include "storage.h"
+#include "utils.h"
+#include "rng.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h> // strcasecmp
+
+#define SKIP_MAX_HEIGHT 32
+#define JOURNAL_SUFFIX ".journal"
+#define SNAPSHOT_HEADER "# leaderboard v1: class,level,xp,kills,gold,name\n"
+
+typedef struct LeaderEntry {
+    char name[SAVE_RECORD_NAME_LENGTH];
+    int player_class;
+    int level;
+    int xp;
+    int kills;
+    int gold;
+    struct LeaderEntry *next; // hash chain
+} LeaderEntry;
+
+typedef struct SkipNode SkipNode;
+
+typedef struct {
+    SkipNode *next;
+    int span; // nodes between here and next, counting next
+} SkipLink;
+
+struct SkipNode {
+    long long score;
+    LeaderEntry *entry;
+    int height;
+    SkipLink links[]; // height of them
+};
+
+typedef struct {
+    SkipNode *head; // never ranked, SKIP_MAX_HEIGHT links
+    int height;     // tallest node in use
+    int length;
+} SkipList;
+
+typedef struct {
+    pthread_mutex_t lock;
+    LeaderEntry **buckets;
+    int bucket_count;
+    int entry_count;
+    SkipList boards[LEADERBOARD_COUNT];
+    unsigned int rng; // node heights
+    bool ready;
+} Leaderboards;
+
+static Leaderboards g_boards = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static const char *BOARD_NAMES[LEADERBOARD_COUNT] = {
+    "level", "kills", "gold", "paladin", "rogue", "mage"
+};
+
+// ---------------------------------------------------------------------
+// Skiplist
+// ---------------------------------------------------------------------
+
+static SkipNode *node_create(int height, long long score, LeaderEntry *entry) {
+    SkipNode *node = malloc(sizeof(SkipNode) + sizeof(SkipLink) * height);
+    if (node == NULL) return NULL;
+    node->score = score;
+    node->entry = entry;
+    node->height = height;
+    for (int i = 0; i < height; i++) {
+        node->links[i].next = NULL;
+        node->links[i].span = 0;
+    }
+    return node;
+}
+
+static bool skiplist_init(SkipList *list) {
+    list->head = node_create(SKIP_MAX_HEIGHT, 0, NULL);
+    list->height = 1;
+    list->length = 0;
+    return list->head != NULL;
+}
+
+static void skiplist_free(SkipList *list) {
+    SkipNode *node = list->head;
+    while (node != NULL) {
+        SkipNode *next = node->links[0].next;
+        free(node);
+        node = next;
+    }
+    list->head = NULL;
+    list->height = 0;
+    list->length = 0;
+}
+
+// does (score, name) rank above node? higher score first, ties by name
+static bool ranks_before(long long score, const char *name, const SkipNode *node) {
+    if (score != node->score) return score > node->score;
+    return strcmp(name, node->entry->name) < 0;
+}
+
+// each level up is half as likely (p = 1/2)
+static int random_height() {
+    uint32_t bits = rng_next(&g_boards.rng);
+    int height = 1;
+    while (height < SKIP_MAX_HEIGHT && (bits & 1u)) {
+        height++;
+        bits >>= 1;
+    }
+    return height;
+}
+
+static bool skiplist_insert(SkipList *list, long long score, LeaderEntry *entry) {
+    SkipNode *update[SKIP_MAX_HEIGHT];
+    int rank[SKIP_MAX_HEIGHT]; // rank of update[i]
+
+    // find the last node on every level that ranks before the new one
+    SkipNode *node = list->head;
+    for (int i = list->height - 1; i >= 0; i--) {
+        rank[i] = (i == list->height - 1) ? 0 : rank[i + 1];
+        while (node->links[i].next != NULL && !ranks_before(score, entry->name, node->links[i].next)) {
+            rank[i] += node->links[i].span;
+            node = node->links[i].next;
+        }
+        update[i] = node;
+    }
+
+    // allocate before touching the head, a failed malloc leaves the list as it was
+    int height = random_height();
+    SkipNode *fresh = node_create(height, score, entry);
+    if (fresh == NULL) return false;
+    if (height > list->height) {
+        for (int i = list->height; i < height; i++) {
+            rank[i] = 0;
+            update[i] = list->head;
+            update[i]->links[i].span = list->length; // head spans the whole list
+        }
+        list->height = height;
+    }
+
+    for (int i = 0; i < height; i++) {
+        fresh->links[i].next = update[i]->links[i].next;
+        update[i]->links[i].next = fresh;
+        // split update[i]'s span around the new node
+        fresh->links[i].span = update[i]->links[i].span - (rank[0] - rank[i]);
+        update[i]->links[i].span = (rank[0] - rank[i]) + 1;
+    }
+    // taller links jump over one more node now
+    for (int i = height; i < list->height; i++) {
+        update[i]->links[i].span++;
+    }
+    list->length++;
+    return true;
+}
+
+static void skiplist_remove(SkipList *list, long long score, LeaderEntry *entry) {
+    SkipNode *update[SKIP_MAX_HEIGHT];
+    SkipNode *node = list->head;
+    for (int i = list->height - 1; i >= 0; i--) {
+        while (node->links[i].next != NULL && node->links[i].next->entry != entry &&
+               !ranks_before(score, entry->name, node->links[i].next)) {
+            node = node->links[i].next;
+        }
+        update[i] = node;
+    }
+
+    SkipNode *target = node->links[0].next;
+    if (target == NULL || target->entry != entry) return; // wasnt on this board
+
+    for (int i = 0; i < list->height; i++) {
+        if (update[i]->links[i].next == target) {
+            update[i]->links[i].span += target->links[i].span - 1;
+            update[i]->links[i].next = target->links[i].next;
+        } else {
+            update[i]->links[i].span--;
+        }
+    }
+    while (list->height > 1 && list->head->links[list->height - 1].next == NULL) {
+        list->height--;
+    }
+    list->length--;
+    free(target);
+}
+
+// rank of (score, entry), 0 if it isnt there
+static int skiplist_rank(const SkipList *list, long long score, const LeaderEntry *entry) {
+    const SkipNode *node = list->head;
+    int rank = 0;
+    for (int i = list->height - 1; i >= 0; i--) {
+        while (node->links[i].next != NULL &&
+               (node->links[i].next->entry == entry || !ranks_before(score, entry->name, node->links[i].next))) {
+            rank += node->links[i].span;
+            node = node->links[i].next;
+            if (node->entry == entry) return rank;
+        }
+    }
+    return 0;
+}
+
+// node at a rank (1 based), NULL if past the end
+static const SkipNode *skiplist_at(const SkipList *list, int rank) {
+    if (rank < 1 || rank > list->length) return NULL;
+    const SkipNode *node = list->head;
+    int walked = 0;
+    for (int i = list->height - 1; i >= 0; i--) {
+        while (node->links[i].next != NULL && walked + node->links[i].span <= rank) {
+            walked += node->links[i].span;
+            node = node->links[i].next;
+        }
+        if (walked == rank) return node;
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------
+// Entries
+// ---------------------------------------------------------------------
+
+// FNV-1a like the memory storage backend
+static unsigned int hash_name(const char *name) {
+    unsigned int h = 2166136261u;
+    for (; *name; name++) {
+        h ^= (unsigned char)*name;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static LeaderEntry *find_entry(const char *name) {
+    if (g_boards.bucket_count == 0) return NULL;
+    LeaderEntry *entry = g_boards.buckets[hash_name(name) % g_boards.bucket_count];
+    for (; entry != NULL; entry = entry->next) {
+        if (strcmp(entry->name, name) == 0) return entry;
+    }
+    return NULL;
+}
+
+// double the bucket array once it's as full as it is long
+static bool grow_buckets() {
+    int count = g_boards.bucket_count == 0 ? 1024 : g_boards.bucket_count * 2;
+    LeaderEntry **buckets = calloc(count, sizeof(LeaderEntry *));
+    if (buckets == NULL) return false;
+    for (int b = 0; b < g_boards.bucket_count; b++) {
+        LeaderEntry *entry = g_boards.buckets[b];
+        while (entry != NULL) {
+            LeaderEntry *next = entry->next;
+            unsigned int slot = hash_name(entry->name) % count;
+            entry->next = buckets[slot];
+            buckets[slot] = entry;
+            entry = next;
+        }
+    }
+    free(g_boards.buckets);
+    g_boards.buckets = buckets;
+    g_boards.bucket_count = count;
+    return true;
+}
+
+static LeaderEntry *add_entry(const char *name) {
+    if (g_boards.entry_count >= g_boards.bucket_count && !grow_buckets()) return NULL;
+    LeaderEntry *entry = calloc(1, sizeof(LeaderEntry));
+    if (entry == NULL) return NULL;
+    strncpy(entry->name, name, SAVE_RECORD_NAME_LENGTH - 1);
+    unsigned int slot = hash_name(entry->name) % g_boards.bucket_count;
+    entry->next = g_boards.buckets[slot];
+    g_boards.buckets[slot] = entry;
+    g_boards.entry_count++;
+    return entry;
+}
+
+// level boards sort by level and then xp within the level
+static long long board_score(LeaderboardType board, const LeaderEntry *entry) {
+    switch (board) {
+        case LEADERBOARD_KILLS: return entry->kills;
+        case LEADERBOARD_GOLD: return entry->gold;
+        default: return ((long long)entry->level << 32) | (unsigned int)entry->xp;
+    }
+}
+
+static bool on_board(LeaderboardType board, const LeaderEntry *entry) {
+    switch (board) {
+        case LEADERBOARD_PALADIN: return entry->player_class == PALADIN;
+        case LEADERBOARD_ROGUE: return entry->player_class == ROGUE;
+        case LEADERBOARD_MAGE: return entry->player_class == MAGE;
+        default: return true;
+    }
+}
+
+// move an entry to its new numbers on every board, caller holds the lock
+static bool set_entry(LeaderEntry *entry, bool ranked, int player_class, int level, int xp, int kills, int gold) {
+    if (ranked) {
+        for (int board = 0; board < LEADERBOARD_COUNT; board++) {
+            if (on_board(board, entry)) {
+                skiplist_remove(&g_boards.boards[board], board_score(board, entry), entry);
+            }
+        }
+    }
+    entry->player_class = player_class;
+    entry->level = level;
+    entry->xp = xp;
+    entry->kills = kills;
+    entry->gold = gold;
+    bool ok = true;
+    for (int board = 0; board < LEADERBOARD_COUNT; board++) {
+        if (on_board(board, entry)) {
+            ok = skiplist_insert(&g_boards.boards[board], board_score(board, entry), entry) && ok;
+        }
+    }
+    return ok;
+}
+
+// ---------------------------------------------------------------------
+// Persistence
+// ---------------------------------------------------------------------
+
+// "class,level,xp,kills,gold,name" (name last so commas in it are fine)
+static int format_line(char *out, size_t size, const LeaderEntry *entry) {
+    return snprintf(out, size, "%d,%d,%d,%d,%d,%s\n", entry->player_class, entry->level,
+                    entry->xp, entry->kills, entry->gold, entry->name);
+}
+
+// apply every line of a snapshot/journal, caller holds the lock
+static void apply_lines(char *data) {
+    char *save_ptr = NULL;
+    for (char *line = strtok_r(data, "\n", &save_ptr); line != NULL; line = strtok_r(NULL, "\n", &save_ptr)) {
+        if (line[0] == '#') continue;
+        int player_class, level, xp, kills, gold, consumed = 0;
+        if (sscanf(line, "%d,%d,%d,%d,%d,%n", &player_class, &level, &xp, &kills, &gold, &consumed) != 5 ||
+            consumed == 0 || line[consumed] == '\0') {
+            log_event(LOG_ERROR, "Skipping bad leaderboard line: %s", line);
+            continue;
+        }
+        const char *name = line + consumed;
+        LeaderEntry *entry = find_entry(name);
+        bool ranked = entry != NULL;
+        if (entry == NULL) entry = add_entry(name);
+        if (entry == NULL || !set_entry(entry, ranked, player_class, level, xp, kills, gold)) {
+            fprintf(stderr, "Error: Out of memory loading the leaderboard.\n");
+            return;
+        }
+    }
+}
+
+// write everything into a fresh snapshot and drop the journal (one batch,
+// so we never end up with a journal on top of the wrong snapshot)
+// caller holds the lock
+static bool write_snapshot(StorageBackend *store) {
+    size_t line_max = SAVE_RECORD_NAME_LENGTH + 64;
+    size_t cap = sizeof(SNAPSHOT_HEADER) + line_max * (size_t)g_boards.entry_count;
+    char *data = malloc(cap);
+    if (data == NULL) return false;
+
+    size_t len = (size_t)snprintf(data, cap, "%s", SNAPSHOT_HEADER);
+    // level board order, so the file reads like the leaderboard
+    const SkipNode *node = g_boards.boards[LEADERBOARD_LEVEL].head->links[0].next;
+    for (; node != NULL; node = node->links[0].next) {
+        len += (size_t)format_line(data + len, cap - len, node->entry);
+    }
+
+    StorageOp ops[2] = {
+        { STORAGE_OP_PUT, LEADERBOARD_FILE, data, len },
+        { STORAGE_OP_DELETE, LEADERBOARD_FILE JOURNAL_SUFFIX, NULL, 0 }
+    };
+    bool ok = store->batch(store, ops, 2);
+    free(data);
+    return ok;
+}
+
+// ---------------------------------------------------------------------
+// Public
+// ---------------------------------------------------------------------
+
+bool leaderboard_init() {
+    leaderboard_shutdown(); // in case it's a reload
+
+    pthread_mutex_lock(&g_boards.lock);
+    g_boards.rng = rng_seed((unsigned int)rand());
+    bool ok = grow_buckets();
+    for (int board = 0; ok && board < LEADERBOARD_COUNT; board++) {
+        ok = skiplist_init(&g_boards.boards[board]);
+    }
+
+    StorageBackend *store = storage_active();
+    for (int part = 0; ok && part < 2; part++) {
+        const char *key = part == 0 ? LEADERBOARD_FILE : LEADERBOARD_FILE JOURNAL_SUFFIX;
+        char *data = store->get(store, key, NULL);
+        if (data != NULL) {
+            apply_lines(data);
+            free(data);
+        }
+    }
+    g_boards.ready = ok;
+    pthread_mutex_unlock(&g_boards.lock);
+
+    if (!ok) {
+        fprintf(stderr, "Error: Could not set up the leaderboards.\n");
+        leaderboard_shutdown();
+        return false;
+    }
+    log_event(LOG_DEBUG, "Leaderboards loaded with %d players", g_boards.entry_count);
+    return true;
+}
+
+void leaderboard_shutdown() {
+    pthread_mutex_lock(&g_boards.lock);
+    if (g_boards.ready) {
+        StorageBackend *store = storage_active();
+        if (store->size(store, LEADERBOARD_FILE JOURNAL_SUFFIX) >= LEADERBOARD_JOURNAL_MAX_BYTES) {
+            // pick up whatever other games appended since we loaded first
+            char *data = store->get(store, LEADERBOARD_FILE JOURNAL_SUFFIX, NULL);
+            if (data != NULL) {
+                apply_lines(data);
+                free(data);
+            }
+            if (!write_snapshot(store)) {
+                fprintf(stderr, "Error: Could not write the leaderboard snapshot.\n");
+            }
+        }
+    }
+
+    for (int board = 0; board < LEADERBOARD_COUNT; board++) {
+        skiplist_free(&g_boards.boards[board]);
+    }
+    for (int b = 0; b < g_boards.bucket_count; b++) {
+        LeaderEntry *entry = g_boards.buckets[b];
+        while (entry != NULL) {
+            LeaderEntry *next = entry->next;
+            free(entry);
+            entry = next;
+        }
+    }
+    free(g_boards.buckets);
+    g_boards.buckets = NULL;
+    g_boards.bucket_count = 0;
+    g_boards.entry_count = 0;
+    g_boards.ready = false;
+    pthread_mutex_unlock(&g_boards.lock);
+}
+
+bool leaderboard_update(const Player *player) {
+    if (player == NULL || player->name == NULL || player->name[0] == '\0') return false;
+
+    pthread_mutex_lock(&g_boards.lock);
+    if (!g_boards.ready) {
+        pthread_mutex_unlock(&g_boards.lock);
+        return false;
+    }
+
+    LeaderEntry *entry = find_entry(player->name);
+    bool ranked = entry != NULL;
+    if (ranked && entry->player_class == (int)player->playerClass && entry->level == player->level &&
+        entry->xp == player->xp && entry->kills == player->kills && entry->gold == player->gold) {
+        pthread_mutex_unlock(&g_boards.lock);
+        return true; // nothing moved
+    }
+    if (entry == NULL) entry = add_entry(player->name);
+    bool ok = entry != NULL &&
+              set_entry(entry, ranked, player->playerClass, player->level, player->xp, player->kills, player->gold);
+
+    // journal the new line, loading replays it over the snapshot
+    if (ok) {
+        char line[SAVE_RECORD_NAME_LENGTH + 64];
+        int len = format_line(line, sizeof(line), entry);
+        StorageBackend *store = storage_active();
+        ok = store->append(store, LEADERBOARD_FILE JOURNAL_SUFFIX, line, (size_t)len);
+    }
+    pthread_mutex_unlock(&g_boards.lock);
+
+    if (!ok) fprintf(stderr, "Error: Could not update the leaderboard for %s.\n", player->name);
+    return ok;
+}
+
+int leaderboard_rank(LeaderboardType board, const char *name) {
+    if (board < 0 || board >= LEADERBOARD_COUNT || name == NULL) return 0;
+    pthread_mutex_lock(&g_boards.lock);
+    int rank = 0;
+    const LeaderEntry *entry = g_boards.ready ? find_entry(name) : NULL;
+    if (entry != NULL && on_board(board, entry)) {
+        rank = skiplist_rank(&g_boards.boards[board], board_score(board, entry), entry);
+    }
+    pthread_mutex_unlock(&g_boards.lock);
+    return rank;
+}
+
+int leaderboard_size(LeaderboardType board) {
+    if (board < 0 || board >= LEADERBOARD_COUNT) return 0;
+    pthread_mutex_lock(&g_boards.lock);
+    int size = g_boards.ready ? g_boards.boards[board].length : 0;
+    pthread_mutex_unlock(&g_boards.lock);
+    return size;
+}
+
+int leaderboard_range(LeaderboardType board, int first, LeaderboardRow *rows, int count) {
+    if (board < 0 || board >= LEADERBOARD_COUNT || rows == NULL) return 0;
+    pthread_mutex_lock(&g_boards.lock);
+    int filled = 0;
+    const SkipNode *node = g_boards.ready ? skiplist_at(&g_boards.boards[board], first) : NULL;
+    for (; node != NULL && filled < count; node = node->links[0].next) {
+        LeaderboardRow *row = &rows[filled];
+        const LeaderEntry *entry = node->entry;
+        row->rank = first + filled;
+        strcpy(row->name, entry->name);
+        row->player_class = entry->player_class;
+        row->level = entry->level;
+        row->xp = entry->xp;
+        row->kills = entry->kills;
+        row->gold = entry->gold;
+        filled++;
+    }
+    pthread_mutex_unlock(&g_boards.lock);
+    return filled;
+}
+
+const char *leaderboard_name(LeaderboardType board) {
+    if (board < 0 || board >= LEADERBOARD_COUNT) return "unknown";
+    return BOARD_NAMES[board];
+}
+
+int leaderboard_find(const char *name) {
+    if (name == NULL) return -1;
+    for (int board = 0; board < LEADERBOARD_COUNT; board++) {
+        if (strcasecmp(name, BOARD_NAMES[board]) == 0) return board;
+    }
+    char *end = NULL;
+    long number = strtol(name, &end, 10);
+    if (end != name && *end == '\0' && number >= 0 && number < LEADERBOARD_COUNT) return (int)number;
+    return -1;
+}
+
+static void print_row(const LeaderboardRow *row) {
+    printf("%5d. %-20s %-8s %5d %6d %6d %7d\n", row->rank, row->name,
+           row->player_class == PALADIN ? "Paladin" : row->player_class == ROGUE ? "Rogue" : "Mage",
+           row->level, row->xp, row->kills, row->gold);
+}
+
+void leaderboard_print(LeaderboardType board, int count, const char *name) {
+    if (count <= 0) count = 10;
+    LeaderboardRow *rows = malloc(sizeof(LeaderboardRow) * count);
+    if (rows == NULL) return;
+
+    int filled = leaderboard_range(board, 1, rows, count);
+    printf("\n=== LEADERBOARD: %s (%d players) ===\n", leaderboard_name(board), leaderboard_size(board));
+    printf("%5s  %-20s %-8s %5s %6s %6s %7s\n", "rank", "name", "class", "level", "xp", "kills", "gold");
+    for (int i = 0; i < filled; i++) {
+        print_row(&rows[i]);
+    }
+    if (filled == 0) printf("  Nobody yet!\n");
+
+    // and where you are, if you're further down
+    int rank = name != NULL ? leaderboard_rank(board, name) : 0;
+    if (rank > filled && leaderboard_range(board, rank, rows, 1) == 1) {
+        printf("  ...\n");
+        print_row(&rows[0]);
+    }
+    free(rows);
+}
@@ -0,0 +1,67 @@
+// leaderboard.h - Player rankings, kept up to date as people play
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <stdbool.h>
+#include "player.h"
+#include "save_game.h" // DEFAULT_SAVE_DIR, SAVE_RECORD_NAME_LENGTH
+
+// snapshot of every ranked player, changes since then go in the journal
+// (same idea as save files), both through the active storage backend
+#define LEADERBOARD_FILE DEFAULT_SAVE_DIR "/leaderboard.board"
+#define LEADERBOARD_JOURNAL_MAX_BYTES (64 * 1024)
+
+typedef enum {
+    LEADERBOARD_LEVEL,   // level, then xp
+    LEADERBOARD_KILLS,
+    LEADERBOARD_GOLD,
+    LEADERBOARD_PALADIN, // level/xp, just that class
+    LEADERBOARD_ROGUE,
+    LEADERBOARD_MAGE,
+    LEADERBOARD_COUNT
+} LeaderboardType;
+
+// one line of a top N
+typedef struct {
+    int rank;
+    char name[SAVE_RECORD_NAME_LENGTH];
+    int player_class;
+    int level;
+    int xp;
+    int kills;
+    int gold;
+} LeaderboardRow;
+
+// load the snapshot + journal from the active storage backend (call after
+// storage_select), a missing snapshot just means empty boards
+bool leaderboard_init();
+
+// fold a big journal back into the snapshot and free everything
+void leaderboard_shutdown();
+
+// put the player's current level/xp/kills/gold on the boards, O(log n) per
+// board. Does nothing if none of them changed since last time.
+// returns false if the change couldnt be stored
+bool leaderboard_update(const Player *player);
+
+// 1 = top of the board, 0 = not on it. O(log n)
+int leaderboard_rank(LeaderboardType board, const char *name);
+
+// players on a board
+int leaderboard_size(LeaderboardType board);
+
+// the rows ranked first..first+count-1 (first starts at 1), O(log n) to
+// find the first one then a walk. returns how many rows were filled
+int leaderboard_range(LeaderboardType board, int first, LeaderboardRow *rows, int count);
+
+// "level", "kills", "gold", "paladin", "rogue", "mage"
+const char *leaderboard_name(LeaderboardType board);
+
+// board by name (or number), -1 if unknown
+int leaderboard_find(const char *name);
+
+// the board's top count as a table, with the player's own rank under it
+// if they didnt make the cut (name can be NULL)
+void leaderboard_print(LeaderboardType board, int count, const char *name);
+
+#endif // LEADERBOARD_H
@@ -0,0 +1,136 @@
+// loot.c - Per enemy loot tables
+//
+// Loot lines live in the content tables, one list for all enemies. At
+// startup each enemy type's lines get turned into an alias table so a roll
+// costs the same with 2 lines or 500, which also keeps big simulations of
+// drop rates cheap.
+#include "loot.h"
+#include "alias.h"
+#include "rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    AliasTable alias;
+    int *entries; // alias column -> index into content loot
+    int rolls;
+} LootTable;
+
+static LootTable g_loot[CONTENT_ENEMY_TYPES];
+
+static const char *TIER_NAMES[CONTENT_LOOT_TIERS] = {
+    "common", "uncommon", "rare", "epic", "legendary"
+};
+
+const char *loot_tier_name(int tier) {
+    if (tier < 0 || tier >= CONTENT_LOOT_TIERS) return "unknown";
+    return TIER_NAMES[tier];
+}
+
+bool loot_init() {
+    loot_shutdown(); // in case it's a rebuild
+
+    const ContentTables *content = content_get();
+    int *weights = malloc(sizeof(int) * CONTENT_LOOT_MAX);
+    if (weights == NULL) return false;
+
+    bool ok = true;
+    for (int type = 0; type < CONTENT_ENEMY_TYPES; type++) {
+        LootTable *table = &g_loot[type];
+        int count = 0;
+        for (int i = 0; i < content->loot_count; i++) {
+            if (content->loot[i].enemy_type == type) count++;
+        }
+        // no lines just means this enemy never drops anything
+        if (count == 0) continue;
+
+        table->entries = malloc(sizeof(int) * count);
+        if (table->entries == NULL) {
+            ok = false;
+            break;
+        }
+        count = 0;
+        for (int i = 0; i < content->loot_count; i++) {
+            if (content->loot[i].enemy_type != type) continue;
+            weights[count] = content->loot[i].weight;
+            table->entries[count] = i;
+            count++;
+        }
+
+        // all weight 0 is the same as no lines
+        if (!alias_build(&table->alias, weights, count)) {
+            free(table->entries);
+            table->entries = NULL;
+            continue;
+        }
+        table->rolls = content->loot_rolls[type];
+    }
+
+    free(weights);
+    if (!ok) {
+        fprintf(stderr, "Error: Could not build loot tables.\n");
+        loot_shutdown();
+    }
+    return ok;
+}
+
+void loot_shutdown() {
+    for (int type = 0; type < CONTENT_ENEMY_TYPES; type++) {
+        alias_free(&g_loot[type].alias);
+        free(g_loot[type].entries);
+        g_loot[type].entries = NULL;
+        g_loot[type].rolls = 0;
+    }
+}
+
+int loot_roll(enum EnemyType type, int *drops, int max, unsigned int *rng_state) {
+    if ((int)type < 0 || (int)type >= CONTENT_ENEMY_TYPES) return 0;
+    const LootTable *table = &g_loot[type];
+    if (table->entries == NULL) return 0;
+
+    const LootEntry *loot = content_get()->loot;
+    int found = 0;
+    for (int roll = 0; roll < table->rolls && found < max; roll++) {
+        uint32_t a = rng_next(rng_state);
+        uint32_t b = rng_next(rng_state);
+        int entry = table->entries[alias_pick(&table->alias, a, b)];
+        if (loot[entry].name[0] != '\0') { // "" is the nothing-drops line
+            drops[found++] = entry;
+        }
+    }
+    return found;
+}
+
+int loot_award(Player *player, const Enemy *enemy) {
+    if (player == NULL || enemy == NULL) return 0;
+
+    // seeded off rand() so srand still makes whole games repeatable
+    unsigned int rng = rng_seed((unsigned int)rand());
+    int drops[CONTENT_LOOT_MAX_ROLLS];
+    int count = loot_roll(enemy->type, drops, CONTENT_LOOT_MAX_ROLLS, &rng);
+
+    const LootEntry *loot = content_get()->loot;
+    int added = 0;
+    for (int i = 0; i < count; i++) {
+        const LootEntry *entry = &loot[drops[i]];
+        if (player->inventory_size >= player->inventory_capacity) {
+            printf("Enemy dropped %s, but your inventory is full!\n", entry->name);
+            continue;
+        }
+
+        Item *item = create_named_potion(entry->name, player->level + entry->strength_offset);
+        if (item == NULL) continue;
+        player->inventory[player->inventory_size] = item;
+        mark_inventory_dirty(player, player->inventory_size);
+        player->inventory_size++;
+        added++;
+
+        // commons are the boring default, anything better gets called out
+        if (entry->tier > LOOT_TIER_COMMON) {
+            printf("Enemy dropped %s [%s]! Added to inventory.\n", item->name, loot_tier_name(entry->tier));
+        } else {
+            printf("Enemy dropped %s! Added to inventory.\n", item->name);
+        }
+    }
+    return added;
+}
@@ -0,0 +1,39 @@
+// loot.h - Per enemy loot tables
+#ifndef LOOT_H
+#define LOOT_H
+
+#include <stdbool.h>
+#include "content.h"
+#include "enemy.h"
+#include "player.h"
+
+// rarity, same order as the tiers in content.txt
+typedef enum {
+    LOOT_TIER_COMMON,
+    LOOT_TIER_UNCOMMON,
+    LOOT_TIER_RARE,
+    LOOT_TIER_EPIC,
+    LOOT_TIER_LEGENDARY
+} LootTier;
+
+// build an alias table per enemy type from the current content tables
+// (call after content_load, the tables are read-only after this)
+bool loot_init();
+
+// free the tables, rolls drop nothing until loot_init runs again
+void loot_shutdown();
+
+// Roll an enemy type's loot: one pick per roll, O(1) each however big the
+// table is. Writes indexes into content_get()->loot for every roll that
+// dropped something (at most max) and returns how many that was.
+// Random numbers come from *rng_state (see rng.h)
+int loot_roll(enum EnemyType type, int *drops, int max, unsigned int *rng_state);
+
+// "common", "rare"...
+const char *loot_tier_name(int tier);
+
+// roll the enemy's loot and put the drops in the player's inventory
+// (prints what dropped, returns how many items were added)
+int loot_award(Player *player, const Enemy *enemy);
+
+#endif // LOOT_H
@@ -11,6 +11,23 @@
 #include "game.h"
 #include "utils.h" // added utils header
 #include "save_game.h" // added save game header
+#include "bulk_import.h" // offline save migration
+#include "storage.h" // where saves actually go
+#include "stats.h" // latency histograms (-stats)
+#include "trace.h" // timeline export (-trace)
+#include "config.h" // settings snapshot (-config, SIGHUP)
+#include "content.h" // balance tables (-content)
+#include "loot.h" // loot tables
+#include "ai.h" // enemy behaviour scripts
+#include "spawn.h" // spawn tables
+#include "project.h" // progression projections (-project)
+#include "leaderboard.h" // rankings (-leaderboard)
+#include "auction.h" // auction house order books
+#include "broadcast.h" // per-area channels
+#include "handoff.h" // hot restart (-resume, SIGUSR2)
+#include "player_cache.h" // recently loaded players
+#include <unistd.h> // dup2
+#include <fcntl.h>  // open
 
 // Global save filename for use across multiple functions
 char saveFileName[MAX_FILENAME_LENGTH] = {0};
@@ -29,11 +46,27 @@ void print_usage(const char* program_name) {
     printf("  -difficulty LEVEL  Same as -dif\n");
     printf("  -nofun           Disable easter eggs and fun stuff\n");
     printf("  -new             Force start a new game (ignore saved game)\n");
+    printf("  -import DIR      Copy every save in DIR into the save backend and exit\n");
+    printf("  -threads N       Worker threads for -import (default: one per CPU)\n");
+    printf("  -store BACKEND   Where saves go: file (default) or memory\n");
+    printf("  -stats           Collect latency stats (kill -USR1 to dump, printed on exit)\n");
+    printf("  -trace FILE      Record a timeline, written to FILE on exit (chrome://tracing)\n");
+    printf("  -config FILE     Read settings from FILE (key = value), kill -HUP reloads it\n");
+    printf("  -content FILE    Use compiled balance tables from FILE (see content.txt)\n");
+    printf("  -compile-content SRC OUT  Compile content source SRC into OUT and exit\n");
+    printf("  -event NAME      Turn on an event's spawn tables (see content.txt)\n");
+    printf("  -leaderboard BOARD [N]  Show the top N (default 10) of a leaderboard and exit\n");
+    printf("                   BOARD: level, kills, gold, paladin, rogue or mage\n");
+    printf("  -project CLASS AREA FIGHTS  Project a new character's progress over FIGHTS\n");
+    printf("                   fights in AREA (CLASS: paladin, rogue or mage) and exit\n");
+    printf("  -resume [SOCKET] Take over a running game's session (kill -USR2 the old one)\n");
     printf("  -help            Show this help message\n");
     printf("\nExamples:\n");
     printf("  %s -name Wizard -log 15 -dif 0\n", program_name);
     printf("  %s -save wizard.csv -god\n", program_name);
     printf("  %s -god -nofun\n", program_name);
+    printf("  %s -dif 2 -project rogue 3 500\n", program_name);
+    printf("  %s -leaderboard kills 20\n", program_name);
     printf("\n");
 }
 
@@ -73,7 +106,19 @@ const char* find_closest_param(const char* input) {
         {"-dif", "-difficulty", "-d"},
         {"-nofun", "-boring", "-serious"},
         {"-help", "--help", "-h"},
-        {"-new", "--new", "-newgame"}
+        {"-new", "--new", "-newgame"},
+        {"-import", "-migrate", ""},
+        {"-trace", "-timeline", ""}, // before -t so -tracefile still means -trace
+        {"-threads", "-t", ""},
+        {"-store", "-backend", ""},
+        {"-stats", "-metrics", ""},
+        {"-config", "-conf", "-cfg"},
+        {"-content", "-tables", ""},
+        {"-compile-content", "-compile", ""},
+        {"-event", "", ""},
+        {"-project", "-projection", ""},
+        {"-leaderboard", "-top", "-ranks"},
+        {"-resume", "-handoff", ""}
     };
     
     const int num_param_groups = sizeof(known_params) / sizeof(known_params[0]);
@@ -116,6 +161,117 @@ const char* find_closest_param(const char* input) {
     return NULL;
 }
 
+// -resume: wait on path for the running game, take over its session and
+// its terminal (or connection). false if nothing came through
+static bool resume_session(const char *path, HandoffSession *session) {
+    int server = handoff_listen(path);
+    if (server < 0) return false;
+    printf("Waiting on '%s' for a running game to hand over (kill -USR2 <pid>)...\n", path);
+    fflush(stdout);
+
+    int conn = handoff_accept(server);
+    close(server);
+    unlink(path);
+    if (conn < 0) return false;
+
+    if (handoff_receive(conn, session, 1) != 1) {
+        fprintf(stderr, "Error: The old process didnt hand over a session.\n");
+        close(conn);
+        return false;
+    }
+    // if it died before saying done the player is still ours, keep going
+    handoff_wait_done(conn);
+
+    // from here on we talk to their terminal instead of ours
+    fflush(stdout);
+    fflush(stderr);
+    for (int i = 0; i < session->fd_count; i++) {
+        if (i <= STDERR_FILENO && session->fds[i] != i) {
+            dup2(session->fds[i], i);
+        }
+        if (session->fds[i] > STDERR_FILENO) close(session->fds[i]);
+    }
+    clearerr(stdin);
+    log_event(LOG_DEBUG, "Took over %s's session", session->player.name);
+    return true;
+}
+
+// SIGUSR2: give the session (terminal included) to a -resume process,
+// along with the fight if we're in one and anything typed ahead. Nothing
+// gets saved, the dirty bits go along and the new process saves when it
+// normally would. Returns the connection to finish the handoff on after
+// the shared files are written, -1 if nobody took it (keep playing)
+static int hand_off_session(Player *player, GameState game_state) {
+    int conn = handoff_connect(handoff_path());
+    if (conn < 0) return -1;
+
+    HandoffSession session;
+    memset(&session, 0, sizeof(HandoffSession));
+    session.player = *player; // only read while sending
+    session.state = game_state;
+    session.in_combat = combat_in_progress(&session.enemy, &session.ai, &session.combat_turns);
+    strcpy(session.save_file, saveFileName);
+    session.fds[0] = STDIN_FILENO;
+    session.fds[1] = STDOUT_FILENO;
+    session.fds[2] = STDERR_FILENO;
+    session.fd_count = 3;
+
+    fflush(stdout);
+    fflush(stderr);
+    session.input_len = handoff_take_input(session.input, sizeof(session.input));
+    if (!handoff_send(conn, &session, 1)) {
+        handoff_give_input(session.input, session.input_len); // still ours
+        close(conn);
+        return -1;
+    }
+
+    // the rest of our shutdown chatter shouldnt land on their screen
+    int null_fd = open("/dev/null", O_RDWR);
+    if (null_fd >= 0) {
+        dup2(null_fd, STDIN_FILENO);
+        dup2(null_fd, STDOUT_FILENO);
+        close(null_fd);
+    }
+    log_event(LOG_DEBUG, "Handed %s's session to the new process", player->name);
+    return conn;
+}
+
+// write out the shared files, tell the new process (if any) it can load
+// them, and let go of everything
+static void shutdown_game(Player *player, int handoff_conn) {
+    cleanup_player(player);
+    auction_shutdown();
+    broadcast_shutdown();
+    leaderboard_shutdown();
+    if (handoff_conn >= 0) {
+        handoff_done(handoff_conn); // boards and books are written, new process can load them
+    }
+    storage_shutdown();
+    stats_shutdown();
+    trace_shutdown();
+    config_shutdown();
+    loot_shutdown();
+    ai_shutdown();
+    spawn_shutdown();
+    content_shutdown();
+}
+
+// what a SIGUSR2 in the middle of a prompt needs to hand the session off
+typedef struct {
+    Player *player;
+    GameState *state;
+} LiveSession;
+
+// handoff_on_request callback: hand off right where the player is
+// sitting (a fight included) and quit, or go back to waiting on them
+static void hand_off_now(void *ctx) {
+    LiveSession *live = (LiveSession *)ctx;
+    int conn = hand_off_session(live->player, *live->state);
+    if (conn < 0) return;
+    shutdown_game(live->player, conn);
+    exit(0);
+}
+
 int main(int argc, char *argv[])
 {
     // Make the random numbers actually random (kinda)
@@ -130,9 +286,19 @@ int main(int argc, char *argv[])
     bool show_help = false; // Flag to show help
     bool had_invalid_arg = false; // Flag to track invalid arguments
     bool force_new_game = false; // Flag to force starting a new game
-
-    // Initialize environment variables first thing
-    setup_env_variables();
+    const char* import_dir = NULL; // -import source directory
+    int import_threads = 0;        // 0 = one per cpu
+    const char* store_backend = NULL; // NULL = GAME_SAVE_BACKEND or file
+    bool stats_enabled = get_env_bool("GAME_STATS", false); // -stats
+    const char* trace_file = get_env_string("GAME_TRACE", NULL); // -trace
+    const char* content_file = get_env_string("GAME_CONTENT", NULL); // -content
+    const char* content_source = NULL; // -compile-content source
+    const char* content_out = NULL;    // -compile-content output
+    ProjectSpec projection = { PALADIN, 1, -1, 0, 0, 0 }; // -project
+    int show_board = -1;   // -leaderboard, -1 = just play
+    int show_board_top = 10;
+    const char* resume_path = NULL; // -resume, NULL = start normally
+    const char* config_file = NULL; // -config, NULL = GAME_CONFIG
 
     // --- Argument Parsing --- 
     for (int i = 1; i < argc; ++i) { // Start from 1 to skip program name
@@ -183,13 +349,10 @@ int main(int argc, char *argv[])
                 printf("Log level set to: 0x%X\n", log_level_override);
                 i++; // Skip the level argument
                 
-                // Set the environment variable for other modules
-                char env_var[32];
-                sprintf(env_var, "%d", log_level_override);
-                setenv("GAME_LOG_LEVEL", env_var, 1); // 1 means override
-                
-                // Reinitialize environment to apply changes
-                setup_env_variables();
+                // Command line beats env and config file
+                char value[32];
+                sprintf(value, "%d", log_level_override);
+                config_set("log_level", value);
             } else {
                 fprintf(stderr, "Error: -log flag requires a numeric argument (0-15).\n");
                 had_invalid_arg = true;
@@ -199,9 +362,9 @@ int main(int argc, char *argv[])
             if (i + 1 < argc) {
                 int difficulty = atoi(argv[i + 1]);
                 if (difficulty >= 0 && difficulty <= 2) {
-                    char env_var[32];
-                    sprintf(env_var, "%d", difficulty);
-                    setenv("GAME_DIFFICULTY", env_var, 1);
+                    char value[32];
+                    sprintf(value, "%d", difficulty);
+                    config_set("difficulty", value);
                     
                     const char* dif_name = "normal";
                     if (difficulty == 0) dif_name = "easy";
@@ -209,9 +372,6 @@ int main(int argc, char *argv[])
                     
                     printf("Difficulty set to: %s (%d)\n", dif_name, difficulty);
                     i++; // Skip the difficulty value
-                    
-                    // Reinitialize environment to apply changes
-                    setup_env_variables();
                 } else {
                     fprintf(stderr, "Error: Difficulty must be 0 (easy), 1 (normal), or 2 (hard).\n");
                     had_invalid_arg = true;
@@ -222,15 +382,128 @@ int main(int argc, char *argv[])
             }
         } else if (strcmp(arg, "-nofun") == 0) {
             // Disable Easter eggs
-            setenv("GAME_EASTER_EGGS", "0", 1);
+            config_set("easter_eggs", "0");
             printf("Easter eggs disabled. Boring mode activated.\n");
-            
-            // Reinitialize environment to apply changes
-            setup_env_variables();
         } else if (strcmp(arg, "-new") == 0) {
             // Force starting a new game
             force_new_game = true;
             printf("Starting a new game (ignoring any saved game).\n");
+        } else if (strcmp(arg, "-import") == 0) {
+            // bulk migrate a directory of saves into the save backend
+            if (i + 1 < argc) {
+                import_dir = argv[i + 1];
+                i++; // Skip the directory
+            } else {
+                fprintf(stderr, "Error: -import needs a save directory.\n");
+                had_invalid_arg = true;
+            }
+        } else if (strcmp(arg, "-threads") == 0) {
+            if (i + 1 < argc) {
+                import_threads = atoi(argv[i + 1]);
+                i++; // Skip the count
+            } else {
+                fprintf(stderr, "Error: -threads flag requires a number.\n");
+                had_invalid_arg = true;
+            }
+        } else if (strcmp(arg, "-store") == 0) {
+            if (i + 1 < argc) {
+                store_backend = argv[i + 1];
+                i++; // Skip the backend name
+            } else {
+                fprintf(stderr, "Error: -store flag requires a backend name (file or memory).\n");
+                had_invalid_arg = true;
+            }
+        } else if (strcmp(arg, "-stats") == 0) {
+            stats_enabled = true;
+        } else if (strcmp(arg, "-trace") == 0) {
+            if (i + 1 < argc) {
+                trace_file = argv[i + 1];
+                i++; // Skip the file name
+            } else {
+                fprintf(stderr, "Error: -trace flag requires a file name.\n");
+                had_invalid_arg = true;
+            }
+        } else if (strcmp(arg, "-config") == 0) {
+            if (i + 1 < argc) {
+                config_file = argv[i + 1]; // read with everything else below
+                i++; // Skip the file name
+            } else {
+                fprintf(stderr, "Error: -config flag requires a file name.\n");
+                had_invalid_arg = true;
+            }
+        } else if (strcmp(arg, "-event") == 0) {
+            if (i + 1 < argc) {
+                config_set("event", argv[i + 1]);
+                printf("Event set: %s\n", argv[i + 1]);
+                i++; // Skip the event name
+            } else {
+                fprintf(stderr, "Error: -event flag requires an event name.\n");
+                had_invalid_arg = true;
+            }
+        } else if (strcmp(arg, "-project") == 0) {
+            // class, area, number of fights
+            if (i + 3 < argc) {
+                const char* class_arg = argv[i + 1];
+                int class_choice = atoi(class_arg);
+                if (class_choice < 1 || class_choice > 3) {
+                    if (starts_with_insensitive(class_arg, "pal")) class_choice = 1;
+                    else if (starts_with_insensitive(class_arg, "rog")) class_choice = 2;
+                    else if (starts_with_insensitive(class_arg, "mag")) class_choice = 3;
+                }
+                projection.player_class = (enum ClassType)(class_choice - 1);
+                projection.area_level = atoi(argv[i + 2]);
+                projection.fights = atoi(argv[i + 3]);
+                if (class_choice < 1 || class_choice > 3 || projection.fights <= 0) {
+                    fprintf(stderr, "Error: -project needs a class (paladin, rogue or mage), an area and a number of fights.\n");
+                    had_invalid_arg = true;
+                }
+                i += 3; // Skip all three
+            } else {
+                fprintf(stderr, "Error: -project needs a class, an area and a number of fights.\n");
+                had_invalid_arg = true;
+            }
+        } else if (strcmp(arg, "-leaderboard") == 0) {
+            if (i + 1 < argc) {
+                show_board = leaderboard_find(argv[i + 1]);
+                if (show_board < 0) {
+                    fprintf(stderr, "Error: Unknown leaderboard '%s' (level, kills, gold, paladin, rogue or mage).\n", argv[i + 1]);
+                    had_invalid_arg = true;
+                }
+                i++; // Skip the board
+                // optional count
+                if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+                    show_board_top = atoi(argv[i + 1]);
+                    i++;
+                }
+            } else {
+                fprintf(stderr, "Error: -leaderboard flag requires a board name.\n");
+                had_invalid_arg = true;
+            }
+        } else if (strcmp(arg, "-resume") == 0) {
+            resume_path = handoff_path();
+            // optional socket path
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                resume_path = argv[i + 1];
+                i++;
+            }
+        } else if (strcmp(arg, "-content") == 0) {
+            if (i + 1 < argc) {
+                content_file = argv[i + 1];
+                i++; // Skip the file name
+            } else {
+                fprintf(stderr, "Error: -content flag requires a file name.\n");
+                had_invalid_arg = true;
+            }
+        } else if (strcmp(arg, "-compile-content") == 0) {
+            // offline step, needs the text source + where the binary goes
+            if (i + 2 < argc) {
+                content_source = argv[i + 1];
+                content_out = argv[i + 2];
+                i += 2; // Skip both
+            } else {
+                fprintf(stderr, "Error: -compile-content needs a source file and an output file.\n");
+                had_invalid_arg = true;
+            }
         } else if (strcmp(arg, "-help") == 0 || strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
             // Show help
             show_help = true;
@@ -246,11 +519,9 @@ int main(int argc, char *argv[])
             setenv("GAME_FART", "true", 1);
             
             // Enable funny logs for fart jokes
-            int current_log = get_env_int("GAME_LOG_LEVEL", 0);
-            char env_var[32];
-            sprintf(env_var, "%d", current_log | LOG_FUNNY);
-            setenv("GAME_LOG_LEVEL", env_var, 1);
-            setup_env_variables();
+            char value[32];
+            sprintf(value, "%d", config_get()->log_level | LOG_FUNNY);
+            config_set("log_level", value);
             
             had_invalid_arg = true;
         } else if (arg[0] == '-') {
@@ -274,24 +545,153 @@ int main(int argc, char *argv[])
     // --- Show Help and Exit if Requested ---
     if (show_help) {
         print_usage(argv[0]);
+        config_shutdown();
         return 0;
     }
 
     // If there were invalid arguments, show usage and return error
     if (had_invalid_arg) {
         printf("Use -help for more information on valid options.\n");
+        config_shutdown();
         return 1;
     }
 
-    // --- Print Welcome Message ---
-    printf("\n");
-    printf("*************************************\n");
-    printf("*      Welcome to C-MMO RPG!       *\n");
-    printf("*************************************\n");
-    printf("\n");
+    // --- Settings: defaults < config file < environment < command line, one snapshot ---
+    if (!setup_env_variables(config_file) && config_file != NULL) {
+        config_shutdown();
+        return 1;
+    }
+
+    // --- Compile content tables, no game ---
+    if (content_source != NULL) {
+        bool compiled = content_compile(content_source, content_out);
+        config_shutdown();
+        return compiled ? 0 : 1;
+    }
+
+    // --- Balance tables (mmap'd once, shared read-only from here on) ---
+    if (content_file != NULL && !content_load(content_file)) {
+        config_shutdown();
+        return 1;
+    }
+
+    // --- Timeline tracing (import workers get traced too) ---
+    if (trace_file != NULL) {
+        trace_init(trace_file);
+    }
+
+    // --- Loot, spawn and ai tables (alias tables / bytecode built from the content, read-only after) ---
+    if (!loot_init() || !spawn_init() || !ai_init()) {
+        loot_shutdown();
+        ai_shutdown();
+        spawn_shutdown();
+        trace_shutdown();
+        config_shutdown();
+        content_shutdown();
+        return 1;
+    }
+
+    // --- Progression projection, no game (difficulty comes from -dif/config) ---
+    if (projection.fights > 0) {
+        ProjectCheckpoint checkpoints[PROJECT_CHECKPOINTS];
+        projection.runs = get_env_int("GAME_PROJECT_RUNS", 0);
+        projection.seed = (unsigned int)rand();
+        int filled = project_progression(&projection, checkpoints, stdout);
+        loot_shutdown();
+        ai_shutdown();
+        spawn_shutdown();
+        trace_shutdown();
+        config_shutdown();
+        content_shutdown();
+        return filled > 0 ? 0 : 1;
+    }
+
+    // --- Pick the save backend (command line beats environment) ---
+    if (store_backend == NULL) {
+        store_backend = get_env_string("GAME_SAVE_BACKEND", "file");
+    }
+    if (!storage_select(store_backend)) {
+        fprintf(stderr, "Error: Unknown save backend '%s' (use file or memory).\n", store_backend);
+        loot_shutdown();
+        ai_shutdown();
+        spawn_shutdown();
+        trace_shutdown();
+        config_shutdown();
+        content_shutdown();
+        return 1;
+    }
+    log_event(LOG_DEBUG, "Using '%s' save backend", store_backend);
+    player_cache_set_limit((size_t)get_env_int("GAME_PLAYER_CACHE_KB", PLAYER_CACHE_DEFAULT_KB) * 1024);
+
+    // --- Offline import into the backend we just picked, no game ---
+    if (import_dir != NULL) {
+        long imported = bulk_import_saves(import_dir, import_threads);
+        storage_shutdown();
+        loot_shutdown();
+        ai_shutdown();
+        spawn_shutdown();
+        trace_shutdown();
+        config_shutdown();
+        content_shutdown();
+        return imported < 0 ? 1 : 0;
+    }
+
+    // --- Hot restart: wait for the old process to hand its session over ---
+    HandoffSession resumed;
+    bool resuming = resume_path != NULL;
+    if (resuming && !resume_session(resume_path, &resumed)) {
+        storage_shutdown();
+        loot_shutdown();
+        ai_shutdown();
+        spawn_shutdown();
+        trace_shutdown();
+        config_shutdown();
+        content_shutdown();
+        return 1;
+    }
+
+    // --- Leaderboards (snapshot + journal from the save backend) ---
+    bool boards_ready = leaderboard_init();
+    if (show_board >= 0) {
+        if (boards_ready) leaderboard_print(show_board, show_board_top, name_set_from_args ? playerName : NULL);
+        leaderboard_shutdown();
+        storage_shutdown();
+        loot_shutdown();
+        ai_shutdown();
+        spawn_shutdown();
+        trace_shutdown();
+        config_shutdown();
+        content_shutdown();
+        return boards_ready ? 0 : 1;
+    }
+
+    // from here on we're playing, and a hot restart can take stdin along
+    handoff_wrap_stdin();
+    if (resuming) handoff_give_input(resumed.input, resumed.input_len);
+
+    // --- Auction house (order books + who's owed what, same backend) ---
+    auction_init();
+
+    // --- Stats (before any other threads get started) ---
+    if (stats_enabled) {
+        stats_init(get_env_string("GAME_STATS_FILE", NULL), get_env_int("GAME_STATS_INTERVAL", 10));
+    }
+
+    // --- Print Welcome Message (they already saw it if we're taking over) ---
+    if (!resuming) {
+        printf("\n");
+        printf("*************************************\n");
+        printf("*      Welcome to C-MMO RPG!       *\n");
+        printf("*************************************\n");
+        printf("\n");
+    } else {
+        strncpy(playerName, resumed.player.name, MAX_NAME_LENGTH - 1);
+        playerName[MAX_NAME_LENGTH - 1] = '\0';
+        strcpy(saveFileName, resumed.save_file);
+    }
 
     // --- Get Player Name if Not Provided in Arguments ---
-    if (!name_set_from_args) {
+    if (!name_set_from_args && !resuming) {
         printf("Enter your name (max %d chars): ", MAX_NAME_LENGTH - 1);
         if (fgets(playerName, MAX_NAME_LENGTH, stdin) == NULL) {
             // Error reading input
@@ -312,7 +712,7 @@ int main(int argc, char *argv[])
     // --- Check for saved game data ---
     bool should_load_save = false;
     // Only check for existing saves if we have a username and not forcing new game
-    if (!force_new_game && playerName[0] != '\0') {
+    if (!force_new_game && !resuming && playerName[0] != '\0') {
         // First check if a specific save file was provided
         if (saveFileName[0] != '\0') {
             should_load_save = save_game_exists(NULL, saveFileName);
@@ -348,8 +748,14 @@ int main(int argc, char *argv[])
         }
     }
     
+    trace_set_process_name(playerName);
+
     // --- Initialize Player ---
-    if (should_load_save) {
+    bool player_loaded = resuming; // false = brand new character
+    if (resuming) {
+        // straight from the old process, unsaved changes still marked dirty
+        player = resumed.player;
+    } else if (should_load_save) {
         // Create a temporary player object
         memset(&player, 0, sizeof(Player)); // Zero-initialize
         player.name = strdup(playerName); // Use the actual player name
@@ -389,6 +795,7 @@ int main(int argc, char *argv[])
             initialize_player(&player, playerName, god_mode_enabled);
         } else {
             printf("Game loaded successfully!\n");
+            player_loaded = true;
             
             // Set god mode if enabled in command line
             if (god_mode_enabled) {
@@ -396,6 +803,7 @@ int main(int argc, char *argv[])
                 player.hp = 9999;
                 player.maxHp = 9999;
                 player.damage = 999;
+                mark_player_dirty(&player, DIRTY_HP | DIRTY_MAX_HP | DIRTY_DAMAGE);
             }
         }
     } else {
@@ -403,11 +811,44 @@ int main(int argc, char *argv[])
         initialize_player(&player, playerName, god_mode_enabled);
     }
     
+    // a crash right after an auction step can leave the save one step
+    // behind the auction journal, catch it up (new characters just start
+    // at wherever the ledger for their name is)
+    if (!player_loaded) {
+        auction_sync(&player);
+    } else if (auction_reconcile(&player)) {
+        save_game(&player, saveFileName[0] != '\0' ? saveFileName : NULL);
+    }
+    
+    // new players show up on the boards right away
+    leaderboard_update(&player);
+    
     // --- Main Game Loop ---
-    GameState game_state = GAME_STATE_MENU;
+    GameState game_state = resuming ? resumed.state : GAME_STATE_MENU;
+    config_watch_sighup(); // kill -HUP <pid> rereads config/env between menu steps
+    handoff_watch_signal(); // kill -USR2 <pid> hands the session to a -resume process
+    int handoff_conn = -1;
+    LiveSession live = { &player, &game_state };
+    bool resumed_fight = resuming && resumed.in_combat;
     
     while (game_state != GAME_STATE_GAME_OVER && game_state != GAME_STATE_WIN) {
-        game_loop(&player, &game_state);
+        config_poll();
+        if (handoff_requested()) {
+            handoff_conn = hand_off_session(&player, game_state);
+            if (handoff_conn >= 0) break; // not ours anymore
+        }
+        // a SIGUSR2 while we wait on the player hands off right there
+        handoff_on_request(hand_off_now, &live);
+        if (resumed_fight) {
+            // the old process was mid fight, finish it like explore_area would
+            resume_combat(&player, &resumed.enemy, &resumed.ai, resumed.combat_turns);
+            cleanup_enemy(&resumed.enemy);
+            resumed_fight = false;
+            game_state = GAME_STATE_MENU;
+        } else {
+            game_loop(&player, &game_state);
+        }
+        handoff_on_request(NULL, NULL);
         
         // Check for game over condition
         if (player.hp <= 0) {
@@ -436,7 +877,7 @@ int main(int argc, char *argv[])
     }
     
     // --- Cleanup ---
-    cleanup_player(&player);
+    shutdown_game(&player, handoff_conn);
     
     return 0;
 }
@@ -0,0 +1,337 @@
+// party.c - Several players against a group of enemies, on a fixed tick
+//
+// start_combat waits for one player to type something, then the enemy
+// goes. With a party that would mean everyone waits for the slowest
+// player. Instead actions get dropped into a per player slot whenever
+// they come in, and every tick the whole lot is swapped out and settled
+// at once. Whoever missed the tick just doesn't act.
+//
+// A tick goes: heals (potions, Aura of Light), then everyone's hits and
+// spells (all the spells in one spell_resolve_batch), then each enemy
+// still standing runs its ai script against somebody. Each step is one
+// pass over the actions or the party, so a tick costs the same per action
+// however big the fight gets.
+#include "party.h"
+#include "game.h"
+#include "rng.h"
+#include "utils.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void party_init(Party *party, unsigned int seed) {
+    if (party == NULL) return;
+    memset(party, 0, sizeof(Party));
+    pthread_mutex_init(&party->lock, NULL);
+    party->rng = rng_seed(seed);
+    party->outcome = PARTY_FIGHTING;
+}
+
+void party_cleanup(Party *party) {
+    if (party == NULL) return;
+    for (int i = 0; i < party->enemy_count; i++) {
+        cleanup_enemy(&party->enemies[i]);
+    }
+    party->enemy_count = 0;
+    pthread_mutex_destroy(&party->lock);
+}
+
+int party_add_player(Party *party, Player *player) {
+    if (party == NULL || player == NULL || party->player_count >= PARTY_MAX_PLAYERS) return -1;
+    party->players[party->player_count] = player;
+    return party->player_count++;
+}
+
+int party_add_enemy(Party *party, Enemy *enemy) {
+    if (party == NULL || enemy == NULL || party->enemy_count >= PARTY_MAX_ENEMIES) return -1;
+    int index = party->enemy_count;
+    party->enemies[index] = *enemy;
+    enemy->name = NULL; // ours now
+    ai_begin(&party->ai[index], &party->enemies[index], rng_next(&party->rng));
+    party->poisoned[index] = -1;
+    return party->enemy_count++;
+}
+
+bool party_submit(Party *party, int slot, const PartyAction *action) {
+    if (party == NULL || action == NULL || slot < 0 || slot >= party->player_count) return false;
+    pthread_mutex_lock(&party->lock);
+    party->pending[slot] = *action;
+    pthread_mutex_unlock(&party->lock);
+    return true;
+}
+
+// heal up to max hp, returns how much actually went in
+static int heal_player(Player *player, int amount) {
+    if (amount <= 0 || player->hp <= 0) return 0;
+    int before = player->hp;
+    player->hp += amount;
+    if (player->hp > player->maxHp) player->hp = player->maxHp;
+    mark_player_dirty(player, DIRTY_HP);
+    return player->hp - before;
+}
+
+// drink a healing item like "2: Use Item" does (item is used up)
+static int drink_potion(Player *player, int slot) {
+    if (slot < 0 || slot >= player->inventory_size) return 0;
+    Item *item = player->inventory[slot];
+    if (item == NULL || item->type != HEALING) return 0;
+
+    int healed = heal_player(player, item->value);
+    free(item->name);
+    free(item);
+    for (int j = slot; j < player->inventory_size - 1; j++) {
+        player->inventory[j] = player->inventory[j + 1];
+    }
+    player->inventory[player->inventory_size - 1] = NULL;
+    player->inventory_size--;
+    mark_inventory_dirty(player, slot);
+    return healed;
+}
+
+// still up and hasnt run off
+static bool enemy_in_fight(const Party *party, int e) {
+    return party->enemies[e].hp > 0 && !party->fled[e];
+}
+
+// the enemy they asked for, or the first one still in the fight if that
+// one's gone, -1 if there's nobody left
+static int pick_target(Party *party, int target) {
+    if (target >= 0 && target < party->enemy_count && enemy_in_fight(party, target)) {
+        return target;
+    }
+    for (int e = 0; e < party->enemy_count; e++) {
+        if (enemy_in_fight(party, e)) return e;
+    }
+    return -1;
+}
+
+// poison wore off (or its enemy is gone), clear the flag unless another
+// enemy still has some on the same player
+static void end_poison(Party *party, int e) {
+    int slot = party->poisoned[e];
+    party->poisoned[e] = -1;
+    if (slot < 0) return;
+    for (int other = 0; other < party->enemy_count; other++) {
+        if (party->poisoned[other] == slot) return;
+    }
+    Player *player = party->players[slot];
+    if (player->is_poisoned) {
+        player->is_poisoned = 0;
+        mark_player_dirty(player, DIRTY_STATUS);
+    }
+}
+
+// one enemy's turn, the ai picks what it does, same as enemy_turn
+// returns the damage the party took
+static int enemy_ai_turn(Party *party, int e, const int *living, int living_count) {
+    Enemy *enemy = &party->enemies[e];
+    AiState *ai = &party->ai[e];
+    int taken = 0;
+
+    // poison from an earlier turn hits whoever it's on first
+    int poison = ai_poison_tick(ai);
+    if (poison > 0 && party->poisoned[e] >= 0) {
+        Player *victim = party->players[party->poisoned[e]];
+        if (victim->hp > 0) {
+            victim->hp -= poison;
+            if (victim->hp < 0) victim->hp = 0;
+            mark_player_dirty(victim, DIRTY_HP);
+            taken += poison;
+        }
+    }
+    if (ai->poison_turns == 0 && party->poisoned[e] >= 0) end_poison(party, e);
+
+    // spread over the living players so one doesnt take every hit
+    int slot = -1;
+    for (int k = 0; k < living_count && slot < 0; k++) {
+        int candidate = living[(party->tick + e + k) % living_count];
+        if (party->players[candidate]->hp > 0) slot = candidate;
+    }
+    if (slot < 0) return taken;
+    Player *target = party->players[slot];
+
+    int amount = 0;
+    AiAction action = ai_enemy_turn(ai, enemy->hp, enemy->maxHp, target->hp, target->maxHp, &amount);
+    switch (action) {
+        case AI_HEAL:
+            enemy->hp += amount;
+            return taken;
+        case AI_ENRAGE:
+            return taken;
+        case AI_FLEE:
+            party->fled[e] = true;
+            end_poison(party, e);
+            return taken;
+        case AI_ATTACK:
+        case AI_POISON:
+            break;
+    }
+
+    target->hp -= amount;
+    if (target->hp < 0) target->hp = 0;
+    mark_player_dirty(target, DIRTY_HP);
+    taken += amount;
+
+    if (action == AI_POISON && target->hp > 0) {
+        if (party->poisoned[e] != slot) end_poison(party, e);
+        party->poisoned[e] = slot;
+        target->is_poisoned = 1;
+        mark_player_dirty(target, DIRTY_STATUS);
+    }
+    return taken;
+}
+
+// every killed enemy pays out once, split between the survivors by the
+// hp they took off it (grant_enemy_share, like raid_claim)
+static void grant_party_rewards(Party *party) {
+    for (int e = 0; e < party->enemy_count; e++) {
+        if (party->fled[e]) continue;
+        long long whole = 0;
+        for (int i = 0; i < party->player_count; i++) {
+            if (party->players[i]->hp > 0) whole += party->damage[e][i];
+        }
+        for (int i = 0; i < party->player_count; i++) {
+            if (party->players[i]->hp <= 0) continue;
+            grant_enemy_share(party->players[i], &party->enemies[e], party->damage[e][i], whole);
+        }
+    }
+}
+
+PartyOutcome party_tick(Party *party, PartyTickReport *report) {
+    if (party == NULL) return PARTY_LOST;
+    PartyTickReport local;
+    if (report == NULL) report = &local;
+    memset(report, 0, sizeof(PartyTickReport));
+    report->tick = party->tick;
+    if (party->outcome != PARTY_FIGHTING) return party->outcome;
+
+    // take this tick's actions, the slots start over empty
+    PartyAction actions[PARTY_MAX_PLAYERS];
+    pthread_mutex_lock(&party->lock);
+    memcpy(actions, party->pending, sizeof(PartyAction) * party->player_count);
+    memset(party->pending, 0, sizeof(party->pending));
+    pthread_mutex_unlock(&party->lock);
+    report->tick = ++party->tick;
+
+    // heals first, so a potion can still save someone this tick
+    int aura_heal = 0;
+    for (int i = 0; i < party->player_count; i++) {
+        Player *player = party->players[i];
+        if (player->hp <= 0) {
+            party->aura_ticks[i] = 0;
+            continue;
+        }
+        if (actions[i].type == PARTY_ACTION_POTION) {
+            report->healed += drink_potion(player, actions[i].slot);
+        } else if (actions[i].type == PARTY_ACTION_AURA && player->playerClass == PALADIN) {
+            party->aura_ticks[i] = PARTY_AURA_TICKS;
+        }
+        if (party->aura_ticks[i] > 0) {
+            aura_heal += PARTY_AURA_HEAL_BASE + player->level;
+            party->aura_ticks[i]--;
+        }
+    }
+    if (aura_heal > 0) {
+        for (int i = 0; i < party->player_count; i++) {
+            report->healed += heal_player(party->players[i], aura_heal);
+        }
+    }
+
+    // every spell cast this tick rolled together
+    SpellCast casts[PARTY_MAX_PLAYERS];
+    int amounts[PARTY_MAX_PLAYERS];
+    int cast_count = 0;
+    for (int i = 0; i < party->player_count; i++) {
+        if (actions[i].type == PARTY_ACTION_SPELL && party->players[i]->hp > 0 &&
+            party->players[i]->playerClass == MAGE) {
+            casts[cast_count++] = actions[i].cast;
+        }
+    }
+    if (cast_count > 0) spell_resolve_batch(casts, cast_count, amounts, &party->rng);
+
+    // hits and spells land in slot order
+    int next_cast = 0;
+    for (int i = 0; i < party->player_count; i++) {
+        Player *player = party->players[i];
+        if (actions[i].type == PARTY_ACTION_NONE || player->hp <= 0) continue;
+        report->actions++;
+
+        int damage = 0;
+        if (actions[i].type == PARTY_ACTION_ATTACK) {
+            damage = player->damage;
+        } else if (actions[i].type == PARTY_ACTION_SPELL && player->playerClass == MAGE) {
+            int amount = amounts[next_cast];
+            const SpellDesc *desc = spell_desc(casts[next_cast].spell);
+            next_cast++;
+            if (desc != NULL && desc->effect == SPELL_EFFECT_HEAL) {
+                report->healed += heal_player(player, amount); // on self, like cast_spell_typed
+            } else if (amount > 0) {
+                damage = amount;
+            }
+        }
+        if (damage == 0) continue;
+
+        int e = pick_target(party, actions[i].target);
+        if (e < 0) continue; // all down already
+        Enemy *enemy = &party->enemies[e];
+        party->damage[e][i] += damage < enemy->hp ? damage : enemy->hp;
+        enemy->hp -= damage;
+        if (enemy->hp < 0) enemy->hp = 0;
+        report->damage_dealt += damage;
+    }
+
+    // whoever is still standing on the other side takes its turn
+    int living[PARTY_MAX_PLAYERS];
+    int living_count = 0;
+    for (int i = 0; i < party->player_count; i++) {
+        if (party->players[i]->hp > 0) living[living_count++] = i;
+    }
+    for (int e = 0; e < party->enemy_count; e++) {
+        if (!enemy_in_fight(party, e)) {
+            if (party->poisoned[e] >= 0) end_poison(party, e); // it's gone, so is its poison
+            continue;
+        }
+        report->damage_taken += enemy_ai_turn(party, e, living, living_count);
+        if (enemy_in_fight(party, e)) report->enemies_alive++;
+    }
+
+    for (int i = 0; i < party->player_count; i++) {
+        if (party->players[i]->hp > 0) report->players_alive++;
+    }
+
+    if (report->enemies_alive == 0) {
+        party->outcome = PARTY_WON;
+        grant_party_rewards(party);
+    } else if (report->players_alive == 0) {
+        party->outcome = PARTY_LOST;
+    }
+
+    log_event(LOG_COMBAT, "Party tick %d: %d actions, %d dealt, %d taken, %d healed",
+              report->tick, report->actions, report->damage_dealt, report->damage_taken, report->healed);
+    return party->outcome;
+}
+
+PartyOutcome party_run(Party *party, int tick_ms, int max_ticks) {
+    if (party == NULL || tick_ms < 0) return PARTY_LOST;
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (int ticks = 0; max_ticks <= 0 || ticks < max_ticks; ticks++) {
+        // next deadline is fixed from the start, a slow tick doesnt push
+        // every later one back
+        next.tv_nsec += (long)tick_ms * 1000000L;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {
+            // signal (SIGHUP reload...), keep waiting
+        }
+
+        PartyOutcome outcome = party_tick(party, NULL);
+        if (outcome != PARTY_FIGHTING) return outcome;
+    }
+    party->outcome = PARTY_TIMED_OUT;
+    return party->outcome;
+}
@@ -0,0 +1,104 @@
+// party.h - Several players against a group of enemies, on a fixed tick
+#ifndef PARTY_H
+#define PARTY_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include "player.h"
+#include "enemy.h"
+#include "spells.h" // SpellCast
+#include "ai.h"     // AiState
+
+#define PARTY_MAX_PLAYERS 8
+#define PARTY_MAX_ENEMIES 4
+
+// Paladin's Aura of Light (design doc): heals the whole party a bit
+// every tick for a few ticks
+#define PARTY_AURA_TICKS 3
+#define PARTY_AURA_HEAL_BASE 2 // + the paladin's level
+
+typedef enum {
+    PARTY_ACTION_NONE,   // nothing sent in time, sits this tick out
+    PARTY_ACTION_ATTACK, // same hit as "1: Attack"
+    PARTY_ACTION_POTION, // drink the healing item in a slot
+    PARTY_ACTION_SPELL,  // mages only, like "3: Cast Spell"
+    PARTY_ACTION_AURA    // paladins only, Aura of Light
+} PartyActionType;
+
+typedef struct {
+    PartyActionType type;
+    int target;     // enemy index (attack / spell)
+    int slot;       // inventory slot (potion)
+    SpellCast cast; // spell
+} PartyAction;
+
+typedef enum {
+    PARTY_FIGHTING,
+    PARTY_WON,
+    PARTY_LOST,
+    PARTY_TIMED_OUT // party_run hit max_ticks
+} PartyOutcome;
+
+// what one tick did
+typedef struct {
+    int tick;
+    int actions;      // actions resolved (missed ticks not counted)
+    int damage_dealt; // to enemies
+    int damage_taken; // by players
+    int healed;
+    int players_alive;
+    int enemies_alive;
+} PartyTickReport;
+
+typedef struct {
+    Player *players[PARTY_MAX_PLAYERS]; // not owned
+    int player_count;
+    Enemy enemies[PARTY_MAX_ENEMIES];   // owned (names freed by party_cleanup)
+    int enemy_count;
+
+    // each enemy runs its own ai script, like in start_combat
+    AiState ai[PARTY_MAX_ENEMIES];
+    int poisoned[PARTY_MAX_ENEMIES];  // player slot its poison is on, -1 = none
+    bool fled[PARTY_MAX_ENEMIES];     // ran off: out of the fight, no rewards
+    long long damage[PARTY_MAX_ENEMIES][PARTY_MAX_PLAYERS]; // hp each player took off each enemy
+
+    // actions for the next tick, one slot per player (latest one wins)
+    pthread_mutex_t lock;
+    PartyAction pending[PARTY_MAX_PLAYERS];
+
+    int aura_ticks[PARTY_MAX_PLAYERS]; // pulses left on each paladin's aura
+    int tick;
+    unsigned int rng; // spell rolls (see rng.h)
+    PartyOutcome outcome;
+} Party;
+
+void party_init(Party *party, unsigned int seed);
+
+// free the enemies
+void party_cleanup(Party *party);
+
+// join the party, returns the player's slot (-1 if full)
+int party_add_player(Party *party, Player *player);
+
+// add an enemy, the party takes over its name (-1 if full)
+int party_add_enemy(Party *party, Enemy *enemy);
+
+// Send in an action for the next tick, safe from any thread. Sending
+// again before the tick replaces it. Nobody waits for anybody: whoever
+// hasn't sent one when the tick comes just does nothing.
+bool party_submit(Party *party, int slot, const PartyAction *action);
+
+// Resolve everything sent in since the last tick in one go, work is
+// linear in the number of actions (plus one pass over the party):
+// heals and auras, then every hit and spell (spells in one
+// spell_resolve_batch), then each enemy still up takes its ai turn. Same
+// numbers as player_turn/enemy_turn, nothing printed. When the last enemy
+// drops (or runs) the ones that were killed pay out, each split between
+// the players still standing by how much of its hp they took.
+PartyOutcome party_tick(Party *party, PartyTickReport *report);
+
+// call party_tick every tick_ms until the fight is over or max_ticks
+// ticks went by, ticks start on a fixed schedule however long one takes
+PartyOutcome party_run(Party *party, int tick_ms, int max_ticks);
+
+#endif // PARTY_H
@@ -7,6 +7,19 @@
 #include <ctype.h> // for isdigit maybe? nah lets just use scanf
 #include <stdbool.h> // include bool for god_mode flag
 
+// starting hp and damage per class (level 1)
+static const int CLASS_START_STATS[3][2] = {
+    { 60, 7 },  // Paladin: more hp, less dmg
+    { 40, 10 }, // Rogue: less hp, more dmg
+    { 45, 8 }   // Mage: medium everything
+};
+
+void player_class_stats(enum ClassType player_class, int *hp, int *damage) {
+    int index = (player_class >= PALADIN && player_class <= MAGE) ? (int)player_class : PALADIN;
+    *hp = CLASS_START_STATS[index][0];
+    *damage = CLASS_START_STATS[index][1];
+}
+
 // Clears the input buffer after scanf fails or reads part of a line
 void clear_input_buffer() {
     int c;
@@ -36,6 +49,12 @@ void initialize_player(Player *player, const char *name, bool god_mode) {
     player->is_poisoned = 0;
     player->is_shielded = 0;
     player->turn_skipped = 0;
+
+    // brand new character, first save has to write everything
+    player->dirty = DIRTY_FULL;
+    player->dirty_slots = 0;
+    player->version = 0;
+    player->auction_seq = 0;
     
     int choice = 0;
     int validInput = 0;
@@ -71,20 +90,17 @@ void initialize_player(Player *player, const char *name, bool god_mode) {
     switch (choice) {
         case 1: // Paladin
             player->playerClass = PALADIN;
-            player->hp = 60;    // more hp
-            player->damage = 7; // less dmg
+            player_class_stats(PALADIN, &player->hp, &player->damage); // more hp, less dmg
             printf("You are a Paladin! Holy light and stuff.\n");
             break;
         case 2: // Rogue
             player->playerClass = ROGUE;
-            player->hp = 40;    // less hp
-            player->damage = 10; // more dmg
+            player_class_stats(ROGUE, &player->hp, &player->damage); // less hp, more dmg
             printf("You are a Rogue! Sneaky sneaky.\n");
             break;
         case 3: // Mage
             player->playerClass = MAGE;
-            player->hp = 45;    // medium hp
-            player->damage = 8; // medium dmg
+            player_class_stats(MAGE, &player->hp, &player->damage); // medium everything
             printf("You are a Mage! Zap zap.\n");
             break;
         // dont need default because we looped until valid input
@@ -207,8 +223,8 @@ void cleanup_player(Player *player) {
     // player->inventory_capacity = 0;
 }
 
-// Add XP to player and level up if needed
-bool add_player_xp(Player *player, int xp_amount) {
+// the level up rules without the fanfare (projections use this directly)
+bool add_player_xp_quiet(Player *player, int xp_amount) {
     if (player == NULL || xp_amount <= 0) {
         return false; // invalid inputs
     }
@@ -219,8 +235,7 @@ bool add_player_xp(Player *player, int xp_amount) {
     
     // add the XP
     player->xp += xp_amount;
-    printf("%s gained %d XP! (Total: %d/%d)\n", 
-           player->name, xp_amount, player->xp, xp_needed);
+    mark_player_dirty(player, DIRTY_XP);
     
     // check if we leveled up
     if (player->xp >= xp_needed) {
@@ -248,15 +263,55 @@ bool add_player_xp(Player *player, int xp_amount) {
         
         // heal to full on level up cuz im nice lol
         player->hp = player->maxHp;
-        
+        mark_player_dirty(player, DIRTY_LEVEL | DIRTY_MAX_HP | DIRTY_DAMAGE | DIRTY_HP);
+        return true; // we did level up
+    }
+    
+    return false; // didn't level up
+}
+
+// Add XP to player and level up if needed
+bool add_player_xp(Player *player, int xp_amount) {
+    if (player == NULL || xp_amount <= 0) {
+        return false; // invalid inputs
+    }
+    
+    // what to show, from before the level up eats the xp
+    int xp_needed = 100 * player->level;
+    int xp_total = player->xp + xp_amount;
+    
+    bool leveled_up = add_player_xp_quiet(player, xp_amount);
+    printf("%s gained %d XP! (Total: %d/%d)\n", 
+           player->name, xp_amount, xp_total, xp_needed);
+    
+    if (leveled_up) {
         printf("\n🎉 LEVEL UP! 🎉\n");
         printf("%s is now level %d!\n", player->name, player->level);
         printf("Max HP increased to %d\n", player->maxHp);
         printf("Damage increased to %d\n", player->damage);
         printf("Health restored to full!\n");
-        
-        return true; // we did level up
     }
     
-    return false; // didn't level up
-} 
\ No newline at end of file
+    return leveled_up;
+}
+
+// remember which fields changed so the next save only writes those
+void mark_player_dirty(Player *player, unsigned int fields) {
+    if (player == NULL) return;
+    player->dirty |= fields;
+}
+
+// inventory slots are tracked one bit each, everything from first_slot
+// up is marked since removing an item shifts the rest down
+void mark_inventory_dirty(Player *player, int first_slot) {
+    if (player == NULL) return;
+    if (first_slot < 0) first_slot = 0;
+
+    int max_slot = player->inventory_capacity;
+    if (max_slot > 32) max_slot = 32; // only 32 bits to go around
+
+    for (int i = first_slot; i < max_slot; i++) {
+        player->dirty_slots |= (1u << i);
+    }
+    player->dirty |= DIRTY_INV_SIZE;
+}
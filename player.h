@@ -8,6 +8,21 @@
 #define MAX_NAME_LENGTH 50
 #define INITIAL_INVENTORY_CAPACITY 5 // how many items can we hold at start
 
+// dirty bits so save_game knows which fields changed since the last save
+// (only changed fields get appended to the journal, see save_game.c)
+#define DIRTY_HP        (1u << 0)
+#define DIRTY_MAX_HP    (1u << 1)
+#define DIRTY_DAMAGE    (1u << 2)
+#define DIRTY_XP        (1u << 3)
+#define DIRTY_LEVEL     (1u << 4)
+#define DIRTY_KILLS     (1u << 5)
+#define DIRTY_GOLD      (1u << 6)
+#define DIRTY_AREA      (1u << 7)
+#define DIRTY_STATUS    (1u << 8)
+#define DIRTY_INV_SIZE  (1u << 9)
+#define DIRTY_AUCTION   (1u << 10)
+#define DIRTY_FULL      (1u << 31) // never saved / name or class changed, write everything
+
 // define the classes
 enum ClassType {
     PALADIN, // 0
@@ -41,6 +56,16 @@ typedef struct {
     unsigned int is_shielded : 1;
     unsigned int turn_skipped : 1;
 
+    // what changed since last save (DIRTY_* bits + one bit per inventory slot)
+    unsigned int dirty;
+    unsigned int dirty_slots;
+
+    // bumped by every trade (trade.c), odd while one is writing to us
+    unsigned int version;
+
+    // auction house steps this save has seen (auction_reconcile)
+    unsigned int auction_seq;
+
 } Player;
 
 // Function prototypes for player actions will go here
@@ -53,4 +78,17 @@ void cleanup_player(Player *player); // need func to free inventory later
 // returns true if leveled up
 bool add_player_xp(Player *player, int xp_amount);
 
+// same rules, no printing
+bool add_player_xp_quiet(Player *player, int xp_amount);
+
+// level 1 hp and damage for a class
+void player_class_stats(enum ClassType player_class, int *hp, int *damage);
+
+// flag fields as changed so the next save journals them
+void mark_player_dirty(Player *player, unsigned int fields);
+
+// flag inventory slots from first_slot to the end as changed
+// (use after adding/removing items, removal shifts everything down)
+void mark_inventory_dirty(Player *player, int first_slot);
+
 #endif // PLAYER_H 
\ No newline at end of file
@@ -0,0 +1,282 @@
+// player_cache.c - Recently loaded/saved players kept in memory
+//
+// After a network blip everybody logs back in at once, and each login is
+// a save_game_exists plus a full CSV parse (snapshot + journal) for a
+// character that was in memory seconds ago. load_game asks here first and
+// fills it on a miss, save_game writes every save it makes through to it,
+// so what's cached is always what's on disk for that path.
+//
+// Entries are the binary save record (save_record_encode), one malloc
+// each with the key in front, a bit of slack on the end so the same
+// player saving again gets encoded over the old copy without a malloc.
+// The cache is split into shards by key hash,
+// each with its own lock, hash table and LRU list, and each gets an even
+// slice of the memory cap: going over pushes out that shard's coldest
+// entries.
+#include "player_cache.h"
+#include "stats.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PLAYER_CACHE_BUCKETS 256 // per shard
+#define PLAYER_CACHE_SLACK 64     // entry records get rounded up to this
+#define PLAYER_CACHE_RECORD_MAX 2048 // biggest encoded record we keep (a full inventory is ~1.5k)
+
+typedef struct CacheEntry {
+    struct CacheEntry *chain; // next in the hash bucket
+    struct CacheEntry *prev;  // LRU, towards the front (used more recently)
+    struct CacheEntry *next;
+    uint32_t hash;
+    size_t len;               // encoded record bytes
+    size_t bytes;             // whole allocation (record has room to grow)
+    char key[];               // then the record right after the key's '\0'
+} CacheEntry;
+
+typedef struct {
+    pthread_mutex_t lock;
+    CacheEntry *buckets[PLAYER_CACHE_BUCKETS];
+    CacheEntry *front; // used last
+    CacheEntry *back;  // coldest
+    size_t bytes;
+    int entries;
+    long long hits;
+    long long misses;
+    long long evictions;
+} __attribute__((aligned(64))) CacheShard;
+
+static CacheShard g_shards[PLAYER_CACHE_SHARDS];
+static pthread_once_t g_shards_once = PTHREAD_ONCE_INIT;
+static size_t g_limit = (size_t)PLAYER_CACHE_DEFAULT_KB * 1024;
+
+static void init_shards() {
+    for (int i = 0; i < PLAYER_CACHE_SHARDS; i++) {
+        pthread_mutex_init(&g_shards[i].lock, NULL);
+    }
+}
+
+// FNV-1a, same as everywhere else
+static uint32_t hash_string(const char *str) {
+    uint32_t hash = 2166136261u;
+    while (*str) {
+        hash ^= (unsigned char)*str++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static CacheShard *shard_for(uint32_t hash) {
+    pthread_once(&g_shards_once, init_shards);
+    return &g_shards[hash % PLAYER_CACHE_SHARDS];
+}
+
+static unsigned char *entry_data(CacheEntry *entry) {
+    return (unsigned char *)entry->key + strlen(entry->key) + 1;
+}
+
+// --- per shard, lock held ---
+
+static CacheEntry **find_slot(CacheShard *shard, const char *key, uint32_t hash) {
+    CacheEntry **slot = &shard->buckets[(hash / PLAYER_CACHE_SHARDS) % PLAYER_CACHE_BUCKETS];
+    while (*slot != NULL && ((*slot)->hash != hash || strcmp((*slot)->key, key) != 0)) {
+        slot = &(*slot)->chain;
+    }
+    return slot;
+}
+
+static void lru_unlink(CacheShard *shard, CacheEntry *entry) {
+    if (entry->prev != NULL) entry->prev->next = entry->next;
+    else shard->front = entry->next;
+    if (entry->next != NULL) entry->next->prev = entry->prev;
+    else shard->back = entry->prev;
+    entry->prev = entry->next = NULL;
+}
+
+static void lru_push_front(CacheShard *shard, CacheEntry *entry) {
+    entry->next = shard->front;
+    if (shard->front != NULL) shard->front->prev = entry;
+    shard->front = entry;
+    if (shard->back == NULL) shard->back = entry;
+}
+
+// take an entry out completely (slot points at it in its bucket)
+static void drop(CacheShard *shard, CacheEntry **slot) {
+    CacheEntry *entry = *slot;
+    *slot = entry->chain;
+    lru_unlink(shard, entry);
+    shard->bytes -= entry->bytes;
+    shard->entries--;
+    free(entry);
+}
+
+static void drop_key(CacheShard *shard, const char *key, uint32_t hash) {
+    CacheEntry **slot = find_slot(shard, key, hash);
+    if (*slot != NULL) drop(shard, slot);
+}
+
+static void trim(CacheShard *shard, size_t limit) {
+    while (shard->back != NULL && shard->bytes > limit) {
+        CacheEntry *coldest = shard->back;
+        drop(shard, find_slot(shard, coldest->key, coldest->hash));
+        shard->evictions++;
+    }
+}
+
+static size_t shard_limit() {
+    return __atomic_load_n(&g_limit, __ATOMIC_RELAXED) / PLAYER_CACHE_SHARDS;
+}
+
+// --- API ---
+
+void player_cache_set_limit(size_t bytes) {
+    __atomic_store_n(&g_limit, bytes, __ATOMIC_RELAXED);
+    pthread_once(&g_shards_once, init_shards);
+    for (int i = 0; i < PLAYER_CACHE_SHARDS; i++) {
+        pthread_mutex_lock(&g_shards[i].lock);
+        trim(&g_shards[i], bytes / PLAYER_CACHE_SHARDS);
+        pthread_mutex_unlock(&g_shards[i].lock);
+    }
+}
+
+bool player_cache_get(const char *key, SaveRecord *record) {
+    if (key == NULL || record == NULL || shard_limit() == 0) return false;
+    uint32_t hash = hash_string(key);
+    CacheShard *shard = shard_for(hash);
+
+    pthread_mutex_lock(&shard->lock);
+    CacheEntry *entry = *find_slot(shard, key, hash);
+    bool hit = entry != NULL && save_record_decode(record, entry_data(entry), entry->len) == entry->len;
+    if (hit) {
+        shard->hits++;
+        lru_unlink(shard, entry);
+        lru_push_front(shard, entry);
+    } else {
+        shard->misses++;
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    STATS_COUNT(hit ? COUNTER_PLAYER_CACHE_HITS : COUNTER_PLAYER_CACHE_MISSES, 1);
+    return hit;
+}
+
+bool player_cache_contains(const char *key) {
+    if (key == NULL || shard_limit() == 0) return false;
+    uint32_t hash = hash_string(key);
+    CacheShard *shard = shard_for(hash);
+    pthread_mutex_lock(&shard->lock);
+    bool found = *find_slot(shard, key, hash) != NULL;
+    pthread_mutex_unlock(&shard->lock);
+    return found;
+}
+
+// put and fill, replace = false leaves an entry that's already there alone
+static void insert(const char *key, const SaveRecord *record, bool replace) {
+    if (key == NULL || record == NULL) return;
+    size_t limit = shard_limit();
+    if (limit == 0) return;
+
+    // encode once on the stack, after that it's a memcpy wherever it goes
+    unsigned char encoded[PLAYER_CACHE_RECORD_MAX];
+    size_t len = save_record_encode(record, encoded, sizeof(encoded));
+    if (len > sizeof(encoded)) {
+        player_cache_remove(key); // dont keep an old copy of it either
+        return;
+    }
+    size_t key_len = strlen(key) + 1;
+    uint32_t hash = hash_string(key);
+    CacheShard *shard = shard_for(hash);
+
+    // already there: leave it (fill) or write over it if it still fits,
+    // which is every save after the first one in steady state
+    pthread_mutex_lock(&shard->lock);
+    CacheEntry *old = *find_slot(shard, key, hash);
+    if (old != NULL && (!replace || sizeof(CacheEntry) + key_len + len <= old->bytes)) {
+        if (replace) {
+            memcpy(entry_data(old), encoded, len);
+            old->len = len;
+            lru_unlink(shard, old);
+            lru_push_front(shard, old);
+        }
+        pthread_mutex_unlock(&shard->lock);
+        return;
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    // build a new entry before taking the lock again
+    size_t room = (len + PLAYER_CACHE_SLACK - 1) / PLAYER_CACHE_SLACK * PLAYER_CACHE_SLACK;
+    size_t bytes = sizeof(CacheEntry) + key_len + room;
+    CacheEntry *entry = bytes <= limit ? malloc(bytes) : NULL;
+    if (entry == NULL) {
+        // too big to ever fit (or no memory), at least dont keep an old copy
+        player_cache_remove(key);
+        return;
+    }
+    memset(entry, 0, sizeof(CacheEntry));
+    memcpy(entry->key, key, key_len);
+    memcpy(entry_data(entry), encoded, len);
+    entry->hash = hash;
+    entry->len = len;
+    entry->bytes = bytes;
+
+    pthread_mutex_lock(&shard->lock);
+    CacheEntry **slot = find_slot(shard, key, hash);
+    if (*slot != NULL && !replace) {
+        pthread_mutex_unlock(&shard->lock);
+        free(entry);
+        return;
+    }
+    if (*slot != NULL) drop(shard, slot);
+    slot = find_slot(shard, key, hash);
+    *slot = entry;
+    lru_push_front(shard, entry);
+    shard->bytes += bytes;
+    shard->entries++;
+    trim(shard, limit);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+void player_cache_put(const char *key, const SaveRecord *record) {
+    insert(key, record, true);
+}
+
+void player_cache_fill(const char *key, const SaveRecord *record) {
+    insert(key, record, false);
+}
+
+void player_cache_remove(const char *key) {
+    if (key == NULL) return;
+    uint32_t hash = hash_string(key);
+    CacheShard *shard = shard_for(hash);
+    pthread_mutex_lock(&shard->lock);
+    drop_key(shard, key, hash);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+void player_cache_clear() {
+    pthread_once(&g_shards_once, init_shards);
+    for (int i = 0; i < PLAYER_CACHE_SHARDS; i++) {
+        pthread_mutex_lock(&g_shards[i].lock);
+        long long evictions = g_shards[i].evictions;
+        trim(&g_shards[i], 0);
+        g_shards[i].evictions = evictions; // emptying it on purpose isnt the cap's doing
+        pthread_mutex_unlock(&g_shards[i].lock);
+    }
+}
+
+void player_cache_get_stats(PlayerCacheStats *stats) {
+    if (stats == NULL) return;
+    memset(stats, 0, sizeof(PlayerCacheStats));
+    pthread_once(&g_shards_once, init_shards);
+    for (int i = 0; i < PLAYER_CACHE_SHARDS; i++) {
+        pthread_mutex_lock(&g_shards[i].lock);
+        stats->hits += g_shards[i].hits;
+        stats->misses += g_shards[i].misses;
+        stats->evictions += g_shards[i].evictions;
+        stats->entries += g_shards[i].entries;
+        stats->bytes += g_shards[i].bytes;
+        pthread_mutex_unlock(&g_shards[i].lock);
+    }
+    stats->limit = __atomic_load_n(&g_limit, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,48 @@
+// player_cache.h - Recently loaded/saved players kept in memory
+#ifndef PLAYER_CACHE_H
+#define PLAYER_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "save_game.h" // SaveRecord
+
+// separate locks so logins for different players dont wait on each other
+#define PLAYER_CACHE_SHARDS 16
+
+// default memory cap (GAME_PLAYER_CACHE_KB overrides, 0 turns it off)
+#define PLAYER_CACHE_DEFAULT_KB 8192
+
+typedef struct {
+    long long hits;
+    long long misses;
+    long long evictions; // pushed out by the memory cap
+    int entries;
+    size_t bytes;
+    size_t limit;
+} PlayerCacheStats;
+
+// cap on what all the entries take together, 0 = off (and empties it)
+void player_cache_set_limit(size_t bytes);
+
+// the record saved under key (a save path), false on a miss
+bool player_cache_get(const char *key, SaveRecord *record);
+
+// just whether key is cached (doesnt count as a hit or miss)
+bool player_cache_contains(const char *key);
+
+// remember what's on disk under key now
+void player_cache_put(const char *key, const SaveRecord *record);
+
+// same after a read from disk: a save that got in first has the newer
+// copy, so an entry that's already there wins
+void player_cache_fill(const char *key, const SaveRecord *record);
+
+// forget key (save deleted, or a write we cant vouch for)
+void player_cache_remove(const char *key);
+
+// forget everything (backend switched...)
+void player_cache_clear();
+
+void player_cache_get_stats(PlayerCacheStats *stats);
+
+#endif // PLAYER_CACHE_H
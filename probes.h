@@ -0,0 +1,54 @@
+// probes.h - Static USDT probes for bpftrace / perf / systemtap
+//
+// Built with GAME_USE_SDT (the Makefile turns it on when <sys/sdt.h> is
+// around, `make SDT=0` turns it off) every GAME_PROBE is a single nop plus a
+// note in the ELF file telling the tracer where the arguments live. Nothing
+// runs until a tracer attaches, e.g.
+//   bpftrace -e 'usdt:./game:cmmo:enemy__hit { @hits = hist(arg0); }'
+//   perf probe -x ./game sdt_cmmo:save__done
+// Without GAME_USE_SDT they compile away to nothing.
+//
+// Durations come from start/done pairs (the tracer subtracts timestamps),
+// that way the game never reads a clock just in case someone is watching.
+#ifndef PROBES_H
+#define PROBES_H
+
+#ifdef GAME_USE_SDT
+
+#include <sys/sdt.h>
+
+#define GAME_PROBE0(name)                   DTRACE_PROBE(cmmo, name)
+#define GAME_PROBE1(name, a)                DTRACE_PROBE1(cmmo, name, a)
+#define GAME_PROBE2(name, a, b)             DTRACE_PROBE2(cmmo, name, a, b)
+#define GAME_PROBE3(name, a, b, c)          DTRACE_PROBE3(cmmo, name, a, b, c)
+#define GAME_PROBE4(name, a, b, c, d)       DTRACE_PROBE4(cmmo, name, a, b, c, d)
+#define GAME_PROBE5(name, a, b, c, d, e)    DTRACE_PROBE5(cmmo, name, a, b, c, d, e)
+
+#else
+
+// sizeof keeps "unused variable" warnings away without evaluating anything
+#define GAME_PROBE0(name)                   do { } while (0)
+#define GAME_PROBE1(name, a)                do { (void)sizeof(a); } while (0)
+#define GAME_PROBE2(name, a, b)             do { (void)sizeof(a); (void)sizeof(b); } while (0)
+#define GAME_PROBE3(name, a, b, c)          do { (void)sizeof(a); (void)sizeof(b); (void)sizeof(c); } while (0)
+#define GAME_PROBE4(name, a, b, c, d)       do { GAME_PROBE2(name, a, b); GAME_PROBE2(name, c, d); } while (0)
+#define GAME_PROBE5(name, a, b, c, d, e)    do { GAME_PROBE3(name, a, b, c); GAME_PROBE2(name, d, e); } while (0)
+
+#endif // GAME_USE_SDT
+
+// The probes (provider "cmmo"), ints unless noted:
+//   turn__begin   (turn, player_hp, enemy_hp)            start_combat
+//   turn__end     (turn, player_hp, enemy_hp)            start_combat
+//   player__hit   (damage, enemy_hp, is_spell)           player_turn
+//   enemy__hit    (damage, player_hp)                    enemy_turn
+//   enemy__spawn  (type, level, hp, damage, is_boss)     initialize_enemy
+//   item__create  (type, char *name, value)              create_item
+//   save__start   (char *path)                           save_game
+//   save__done    (char *path, bytes, full, ok)          save_game
+//   load__start   (char *filename, NULL = by player)     load_game
+//   load__done    (char *path, bytes, ok)                load_game
+// bytes are long long. Save latency in bpftrace:
+//   usdt:./game:cmmo:save__start { @s[tid] = nsecs; }
+//   usdt:./game:cmmo:save__done /@s[tid]/ { @ns = hist(nsecs - @s[tid]); delete(@s[tid]); }
+
+#endif // PROBES_H
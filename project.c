@@ -0,0 +1,250 @@
+// project.c - Fast forward a fresh character through a pile of fights
+//
+// Instead of playing fights one at a time we push a whole sample of
+// characters through each fight together: one spawn_pick_batch for
+// everybody, then each character looks up how that enemy goes for their
+// level. Characters climb to the target area the way the game lets them
+// (moving on to area N needs level N). With full hp at the start of every fight and attacks only, a fight
+// only depends on (level, enemy type) and the enemy's dice, so each pair
+// gets settled once by combat_resolve (or sampled OUTCOME_SAMPLES times
+// if the type's ai script rolls dice) and every later fight is a table
+// lookup, a roll against those odds and grant_enemy_rewards (same
+// gold/xp/level up rules as the real game).
+#include "project.h"
+#include "ai.h"
+#include "combat.h"
+#include "config.h"
+#include "content.h"
+#include "enemy.h"
+#include "game.h"
+#include "rng.h"
+#include "spawn.h"
+#include <stddef.h> // offsetof
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_RUNS 10000
+
+// fights played per (level, enemy type) when the type rolls dice
+#define OUTCOME_SAMPLES 128
+
+// how every enemy type goes for a character of one level, out of
+// OUTCOME_SAMPLES fights (the rest the enemy fled or nobody won)
+typedef struct {
+    bool ready;
+    unsigned short won[CONTENT_ENEMY_TYPES];
+    unsigned short lost[CONTENT_ENEMY_TYPES];
+    Enemy enemy[CONTENT_ENEMY_TYPES]; // just the numbers, no name
+} LevelOutcomes;
+
+typedef struct {
+    LevelOutcomes *levels; // index = level
+    int capacity;
+    int difficulty;
+    unsigned int seed;     // for the sample fights
+} OutcomeCache;
+
+static const char *CLASS_NAMES[] = { "Paladin", "Rogue", "Mage" };
+static const char *DIFFICULTY_NAMES[] = { "easy", "normal", "hard" };
+
+// outcomes for player's level, settled the first time someone gets there
+// (everyone of a class has the same stats at the same level, no shop here)
+static const LevelOutcomes *level_outcomes(OutcomeCache *cache, const Player *player) {
+    if (player->level >= cache->capacity) {
+        int capacity = cache->capacity * 2;
+        while (capacity <= player->level) capacity *= 2;
+        LevelOutcomes *levels = realloc(cache->levels, sizeof(LevelOutcomes) * capacity);
+        if (levels == NULL) return NULL;
+        memset(levels + cache->capacity, 0, sizeof(LevelOutcomes) * (capacity - cache->capacity));
+        cache->levels = levels;
+        cache->capacity = capacity;
+    }
+
+    LevelOutcomes *outcomes = &cache->levels[player->level];
+    if (!outcomes->ready) {
+        Player fresh = *player;
+        fresh.hp = fresh.maxHp;
+        for (int type = 0; type < CONTENT_ENEMY_TYPES; type++) {
+            Enemy *enemy = &outcomes->enemy[type];
+            memset(enemy, 0, sizeof(*enemy));
+            enemy_stats(enemy, (enum EnemyType)type, player->level, cache->difficulty);
+
+            // no dice = every fight goes the same way, one is enough
+            int samples = ai_is_random((enum EnemyType)type) ? OUTCOME_SAMPLES : 1;
+            int won = 0, lost = 0;
+            for (int i = 0; i < samples; i++) {
+                CombatPolicy policy = COMBAT_POLICY_ATTACK;
+                policy.seed = rng_hash(cache->seed,
+                                       (unsigned int)((player->level * CONTENT_ENEMY_TYPES + type) * OUTCOME_SAMPLES + i));
+                CombatWinner winner = combat_resolve(&fresh, enemy, &policy).winner;
+                if (winner == COMBAT_PLAYER_WON) won++;
+                else if (winner == COMBAT_ENEMY_WON) lost++;
+            }
+            outcomes->won[type] = (unsigned short)(won * OUTCOME_SAMPLES / samples);
+            outcomes->lost[type] = (unsigned short)(lost * OUTCOME_SAMPLES / samples);
+        }
+        outcomes->ready = true;
+    }
+    return outcomes;
+}
+
+// how this character's fight goes, rolled against the odds for its level
+static CombatWinner pick_outcome(const LevelOutcomes *outcomes, enum EnemyType type, unsigned int *rng) {
+    int won = outcomes->won[type];
+    int lost = outcomes->lost[type];
+    if (won == OUTCOME_SAMPLES) return COMBAT_PLAYER_WON;
+    if (lost == OUTCOME_SAMPLES) return COMBAT_ENEMY_WON;
+    if (won == 0 && lost == 0) return COMBAT_ENEMY_FLED;
+    int roll = rng_range(rng, OUTCOME_SAMPLES);
+    if (roll < won) return COMBAT_PLAYER_WON;
+    if (roll < won + lost) return COMBAT_ENEMY_WON;
+    return COMBAT_ENEMY_FLED;
+}
+
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+// p10/p50/p90 of one int field over every character
+static ProjectSpread spread(const Player *players, int runs, size_t offset, int *scratch) {
+    for (int i = 0; i < runs; i++) {
+        memcpy(&scratch[i], (const char *)&players[i] + offset, sizeof(int));
+    }
+    qsort(scratch, runs, sizeof(int), compare_ints);
+    ProjectSpread result = {
+        scratch[(runs - 1) * 10 / 100],
+        scratch[(runs - 1) * 50 / 100],
+        scratch[(runs - 1) * 90 / 100]
+    };
+    return result;
+}
+
+static void print_spread(FILE *out, ProjectSpread spread) {
+    fprintf(out, " | %6d %6d %6d", spread.p10, spread.p50, spread.p90);
+}
+
+static void print_table(FILE *out, const ProjectSpec *spec, int difficulty, int runs,
+                        const ProjectCheckpoint *checkpoints, int count) {
+    fprintf(out, "\n=== PROJECTION: %s, area %d, %s, %d fights, %d characters ===\n",
+            CLASS_NAMES[spec->player_class], spec->area_level, DIFFICULTY_NAMES[difficulty],
+            spec->fights, runs);
+    fprintf(out, "(full hp every fight, attacks only, no loot or shopping)\n\n");
+    fprintf(out, "               | %-20s | %-20s | %-20s | %-20s\n", "level", "xp", "gold", "kills");
+    fprintf(out, "  fight  alive ");
+    for (int i = 0; i < 4; i++) fprintf(out, " | %6s %6s %6s", "p10", "p50", "p90");
+    fprintf(out, "\n");
+    for (int i = 0; i < count; i++) {
+        const ProjectCheckpoint *checkpoint = &checkpoints[i];
+        fprintf(out, "%7d %5.1f%%", checkpoint->fights, checkpoint->alive_pct);
+        print_spread(out, checkpoint->level);
+        print_spread(out, checkpoint->xp);
+        print_spread(out, checkpoint->gold);
+        print_spread(out, checkpoint->kills);
+        fprintf(out, "\n");
+    }
+}
+
+int project_progression(const ProjectSpec *spec, ProjectCheckpoint *checkpoints, FILE *out) {
+    if (spec == NULL || checkpoints == NULL) return -1;
+    if (spec->player_class < PALADIN || spec->player_class > MAGE ||
+        spec->area_level < 1 || spec->area_level > CONTENT_AREAS ||
+        spec->difficulty < -1 || spec->difficulty >= CONTENT_DIFFICULTIES ||
+        spec->fights <= 0 || spec->runs < 0) {
+        fprintf(stderr, "Error: Bad projection (class 1-3, area 1-%d, difficulty 0-2, fights > 0).\n",
+                CONTENT_AREAS);
+        return -1;
+    }
+
+    int runs = spec->runs > 0 ? spec->runs : DEFAULT_RUNS;
+    int difficulty = spec->difficulty >= 0 ? spec->difficulty : config_get()->difficulty;
+    if (difficulty < 0 || difficulty >= CONTENT_DIFFICULTIES) difficulty = 1;
+    int count = spec->fights < PROJECT_CHECKPOINTS ? spec->fights : PROJECT_CHECKPOINTS;
+
+    OutcomeCache cache = { NULL, 0, difficulty, rng_hash(spec->seed, 0x5BD1E995u) };
+    cache.capacity = 16;
+    cache.levels = calloc(cache.capacity, sizeof(LevelOutcomes));
+    Player *players = calloc(runs, sizeof(Player));
+    // one batch of picks per area on the way up to the target
+    enum EnemyType *types = malloc(sizeof(enum EnemyType) * runs * spec->area_level);
+    int *scratch = malloc(sizeof(int) * runs);
+    if (cache.levels == NULL || players == NULL || types == NULL || scratch == NULL) {
+        fprintf(stderr, "Error: Not enough memory for a projection of %d characters.\n", runs);
+        free(cache.levels);
+        free(players);
+        free(types);
+        free(scratch);
+        return -1;
+    }
+
+    // everyone starts out like initialize_player made them (minus the inventory)
+    for (int i = 0; i < runs; i++) {
+        Player *player = &players[i];
+        player->playerClass = spec->player_class;
+        player_class_stats(spec->player_class, &player->hp, &player->damage);
+        player->maxHp = player->hp;
+        player->level = 1;
+        player->gold = 10;
+        player->area_level = 1;
+    }
+
+    int filled = 0;
+    int alive = runs;
+    unsigned int rng = rng_seed(spec->seed); // which way the odds go for each character
+    for (int fight = 1; fight <= spec->fights && filled >= 0; fight++) {
+        // once everyone's dead there's nothing left to play (the
+        // checkpoints still get filled in)
+        for (int area = 1; alive > 0 && area <= spec->area_level; area++) {
+            unsigned int seed = rng_hash(spec->seed, (unsigned int)(fight * CONTENT_AREAS + area));
+            spawn_pick_batch(area, types + (size_t)runs * (area - 1), runs, seed);
+        }
+
+        for (int i = 0; alive > 0 && i < runs; i++) {
+            Player *player = &players[i];
+            if (player->hp <= 0) continue; // died earlier, stays where they were
+            // move on as soon as the level allows it
+            if (player->area_level < spec->area_level && player->level >= player->area_level + 1) {
+                player->area_level++;
+            }
+            enum EnemyType type = types[(size_t)runs * (player->area_level - 1) + i];
+            const LevelOutcomes *outcomes = level_outcomes(&cache, player);
+            if (outcomes == NULL) {
+                fprintf(stderr, "Error: Not enough memory for level %d outcomes.\n", player->level);
+                filled = -1;
+                break;
+            }
+            switch (pick_outcome(outcomes, type, &rng)) {
+                case COMBAT_PLAYER_WON:
+                    grant_enemy_rewards(player, &outcomes->enemy[type]);
+                    break;
+                case COMBAT_ENEMY_WON:
+                    player->hp = 0;
+                    alive--;
+                    break;
+                case COMBAT_ENEMY_FLED:
+                case COMBAT_STALEMATE:
+                    break; // walk away, nothing gained
+            }
+        }
+
+        // evenly spaced checkpoints, the last one lands on the final fight
+        if (filled >= 0 && fight == (int)((long long)spec->fights * (filled + 1) / count)) {
+            ProjectCheckpoint *checkpoint = &checkpoints[filled++];
+            checkpoint->fights = fight;
+            checkpoint->alive_pct = 100.0f * alive / runs;
+            checkpoint->level = spread(players, runs, offsetof(Player, level), scratch);
+            checkpoint->xp = spread(players, runs, offsetof(Player, xp), scratch);
+            checkpoint->gold = spread(players, runs, offsetof(Player, gold), scratch);
+            checkpoint->kills = spread(players, runs, offsetof(Player, kills), scratch);
+        }
+    }
+
+    if (filled > 0 && out != NULL) print_table(out, spec, difficulty, runs, checkpoints, filled);
+
+    free(cache.levels);
+    free(players);
+    free(types);
+    free(scratch);
+    return filled;
+}
@@ -0,0 +1,49 @@
+// project.h - Fast forward a fresh character through a pile of fights
+#ifndef PROJECT_H
+#define PROJECT_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "player.h"
+
+// "what does a Rogue look like after 500 fights in area 3 on hard?"
+typedef struct {
+    enum ClassType player_class;
+    int area_level;     // 1-5, characters move up to it as their level allows
+                        // (area N needs level N), no boss fight
+    int difficulty;     // 0-2, -1 = whatever the config says
+    int fights;         // how many fights to fast forward
+    int runs;           // characters in the sample (0 = 10000)
+    unsigned int seed;  // spawn picks (see rng.h)
+} ProjectSpec;
+
+// Percentiles of a stat over every character in the sample
+typedef struct {
+    int p10;
+    int p50;
+    int p90;
+} ProjectSpread;
+
+typedef struct {
+    int fights;          // fights fought so far
+    float alive_pct;     // characters that havent died yet
+    ProjectSpread level;
+    ProjectSpread xp;
+    ProjectSpread gold;
+    ProjectSpread kills;
+} ProjectCheckpoint;
+
+#define PROJECT_CHECKPOINTS 10
+
+// Play spec->fights fights for spec->runs fresh level 1 characters, all
+// at once, one fight per step. Every fight starts at full hp (rest is
+// free), the player only attacks, and loot/potions/shopping are left out.
+// Dying ends that character, their numbers stay where they were. Enemies
+// whose ai script rolls dice win, lose or run away as often as they do in
+// a sample of real fights at that level (see rng.h, seed covers it too).
+// Fills up to PROJECT_CHECKPOINTS evenly spaced checkpoints (the last one
+// is always the final fight) and prints them as a table to out (NULL =
+// quiet). Returns how many checkpoints were filled, -1 on a bad spec.
+int project_progression(const ProjectSpec *spec, ProjectCheckpoint *checkpoints, FILE *out);
+
+#endif // PROJECT_H
@@ -0,0 +1,134 @@
+// raid.c - World boss raids (lots of players, one boss)
+//
+// A thousand threads all doing enemy->hp -= damage on the same int would
+// spend their time passing one cache line around. So nobody touches the
+// boss when they hit it: every attacker has its own counter on its own
+// cache line that only its session thread adds to. Once a tick, one
+// thread swaps every counter back to 0 and takes the total off the boss.
+//
+// That merge is the only place hp goes down, so the kill happens in
+// exactly one tick on exactly one thread. Whatever got merged by then is
+// what everyone's share of the rewards is worked out from, and each
+// attacker's claim flag flips once so nobody gets paid twice.
+//
+// Raids need lots of players at once, so this is for a server. The single
+// player game never starts one, only the benchmarks do.
+#include "raid.h"
+#include "game.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool raid_init(Raid *raid, Enemy *boss, long long hp, int capacity) {
+    if (raid == NULL || boss == NULL || hp <= 0) return false;
+    if (capacity <= 0 || capacity > RAID_MAX_ATTACKERS) capacity = RAID_MAX_ATTACKERS;
+
+    memset(raid, 0, sizeof(Raid));
+    raid->attackers = aligned_alloc(sizeof(RaidAttacker), sizeof(RaidAttacker) * capacity);
+    if (raid->attackers == NULL) {
+        fprintf(stderr, "Error: Could not allocate a raid for %d attackers\n", capacity);
+        return false;
+    }
+    memset(raid->attackers, 0, sizeof(RaidAttacker) * capacity);
+    raid->attacker_capacity = capacity;
+
+    raid->boss = *boss;
+    boss->name = NULL; // ours now
+    raid->max_hp = raid->hp = hp;
+    raid->state = RAID_FIGHTING;
+    pthread_mutex_init(&raid->merge_lock, NULL);
+    return true;
+}
+
+void raid_cleanup(Raid *raid) {
+    if (raid == NULL) return;
+    cleanup_enemy(&raid->boss);
+    free(raid->attackers);
+    raid->attackers = NULL;
+    raid->attacker_count = 0;
+    pthread_mutex_destroy(&raid->merge_lock);
+}
+
+int raid_join(Raid *raid, Player *player) {
+    if (raid == NULL || player == NULL) return -1;
+    if (__atomic_load_n(&raid->state, __ATOMIC_ACQUIRE) != RAID_FIGHTING) return -1;
+
+    // take the next id, unless they're all gone
+    int id = __atomic_load_n(&raid->attacker_count, __ATOMIC_RELAXED);
+    do {
+        if (id >= raid->attacker_capacity) return -1;
+    } while (!__atomic_compare_exchange_n(&raid->attacker_count, &id, id + 1, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    raid->attackers[id].player = player;
+    return id;
+}
+
+bool raid_hit(Raid *raid, int attacker, int damage) {
+    if (raid == NULL || attacker < 0 || attacker >= raid->attacker_capacity) return false;
+    if (__atomic_load_n(&raid->state, __ATOMIC_ACQUIRE) != RAID_FIGHTING) return false;
+    if (damage <= 0) return true; // a miss, still a fight going on
+
+    __atomic_fetch_add(&raid->attackers[attacker].pending, damage, __ATOMIC_RELAXED);
+    return true;
+}
+
+RaidState raid_tick(Raid *raid, RaidTickReport *report) {
+    if (raid == NULL) return RAID_DEFEATED;
+    RaidTickReport local;
+    if (report == NULL) report = &local;
+    memset(report, 0, sizeof(RaidTickReport));
+
+    pthread_mutex_lock(&raid->merge_lock);
+    if (raid->state == RAID_FIGHTING) {
+        int count = __atomic_load_n(&raid->attacker_count, __ATOMIC_RELAXED);
+        long long total = 0;
+        for (int i = 0; i < count; i++) {
+            RaidAttacker *attacker = &raid->attackers[i];
+            if (__atomic_load_n(&attacker->pending, __ATOMIC_RELAXED) == 0) continue;
+            long long damage = __atomic_exchange_n(&attacker->pending, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&attacker->counted, attacker->counted + damage, __ATOMIC_RELAXED);
+            total += damage;
+            report->attackers++;
+        }
+
+        raid->tick++;
+        raid->total_counted += total;
+        raid->hp -= total;
+        if (raid->hp <= 0) {
+            raid->hp = 0;
+            // everything above is settled before anyone sees the kill
+            __atomic_store_n(&raid->state, RAID_DEFEATED, __ATOMIC_RELEASE);
+            log_event(LOG_COMBAT, "%s went down on raid tick %d (%d attackers, %lld damage)",
+                      raid->boss.name ? raid->boss.name : "Raid boss", raid->tick,
+                      count, raid->total_counted);
+        }
+        report->damage = total;
+    }
+    report->tick = raid->tick;
+    report->hp = raid->hp;
+    report->state = (RaidState)raid->state;
+    pthread_mutex_unlock(&raid->merge_lock);
+    return report->state;
+}
+
+long long raid_contribution(const Raid *raid, int attacker) {
+    if (raid == NULL || attacker < 0 || attacker >= raid->attacker_capacity) return 0;
+    return __atomic_load_n(&raid->attackers[attacker].counted, __ATOMIC_RELAXED);
+}
+
+bool raid_claim(Raid *raid, int attacker) {
+    if (raid == NULL || attacker < 0 || attacker >= raid->attacker_capacity) return false;
+    if (__atomic_load_n(&raid->state, __ATOMIC_ACQUIRE) != RAID_DEFEATED) return false;
+
+    RaidAttacker *record = &raid->attackers[attacker];
+    if (record->player == NULL || record->counted <= 0) return false;
+
+    int unclaimed = 0;
+    if (!__atomic_compare_exchange_n(&record->claimed, &unclaimed, 1, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        return false;
+    }
+    grant_enemy_share(record->player, &raid->boss, record->counted, raid->total_counted);
+    return true;
+}
@@ -0,0 +1,77 @@
+// raid.h - World boss raids (lots of players, one boss)
+#ifndef RAID_H
+#define RAID_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include "player.h"
+#include "enemy.h"
+
+#define RAID_MAX_ATTACKERS 1024
+
+typedef enum {
+    RAID_FIGHTING,
+    RAID_DEFEATED
+} RaidState;
+
+// one attacker's damage, on its own cache line since every attacker is
+// hit from its own session thread
+typedef struct {
+    Player *player;
+    long long pending; // hits since the last tick, only ever added to or swapped out
+    long long counted; // merged into the boss's hp (merging thread only)
+    int claimed;       // rewards handed out
+} __attribute__((aligned(64))) RaidAttacker;
+
+typedef struct {
+    int tick;
+    long long damage;  // merged this tick
+    long long hp;      // boss hp left
+    int attackers;     // attackers that hit this tick
+    RaidState state;
+} RaidTickReport;
+
+typedef struct {
+    Enemy boss;        // owned (name freed by raid_cleanup), xp/gold are the whole prize
+    long long max_hp;
+    long long hp;      // only changed by raid_tick
+    int state;         // RaidState, read by any thread
+    int tick;
+    long long total_counted; // all the damage that went into the kill
+    pthread_mutex_t merge_lock;
+
+    RaidAttacker *attackers;
+    int attacker_count;
+    int attacker_capacity;
+} Raid;
+
+// Set up a raid on boss (the raid takes over its name) with hp far past
+// what an Enemy holds. capacity 0 = RAID_MAX_ATTACKERS
+bool raid_init(Raid *raid, Enemy *boss, long long hp, int capacity);
+
+void raid_cleanup(Raid *raid);
+
+// join the raid, returns the attacker id (-1 if it's full or over)
+int raid_join(Raid *raid, Player *player);
+
+// Land a hit. Only touches the attacker's own counter, so threads never
+// fight over the boss's hp. Call from the attacker's session thread.
+// returns false once the boss is down (the hit doesn't count)
+bool raid_hit(Raid *raid, int attacker, int damage);
+
+// Merge every attacker's hits since the last tick into the boss's hp.
+// The tick that takes it to 0 is the kill, exactly once: whatever was
+// merged up to then is what the rewards get split by, later hits dont
+// count. One merge at a time, any thread.
+RaidState raid_tick(Raid *raid, RaidTickReport *report);
+
+// damage an attacker got in (merged ticks only)
+long long raid_contribution(const Raid *raid, int attacker);
+
+// After the kill: the attacker's share of the boss's xp and gold (by
+// damage) plus the kill, through the same reward rules as any fight.
+// Works once per attacker, from the attacker's own thread.
+// returns false if the boss isnt down, they did no damage or already claimed
+bool raid_claim(Raid *raid, int attacker);
+
+#endif // RAID_H
@@ -0,0 +1,41 @@
+// rng.h - Small fast random numbers for batch/simulation code
+#ifndef RNG_H
+#define RNG_H
+
+// rand() is fine for one player typing commands, but it takes a lock and
+// shares one state between threads. Code that rolls thousands of times per
+// tick keeps its own state and uses this instead (xorshift32).
+
+// never hand out a zero state, xorshift gets stuck on it
+static inline unsigned int rng_seed(unsigned int seed) {
+    return seed != 0 ? seed : 0x9E3779B9u;
+}
+
+static inline unsigned int rng_next(unsigned int *state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// 0 .. range-1 (range must be > 0)
+static inline int rng_range(unsigned int *state, int range) {
+    return (int)(rng_next(state) % (unsigned int)range);
+}
+
+// a random number that only depends on (seed, counter), for loops that
+// want every iteration independent (so they can vectorize) instead of
+// carrying one state through (lowbias32 hash)
+static inline unsigned int rng_hash(unsigned int seed, unsigned int counter) {
+    unsigned int x = seed ^ (counter * 0x9E3779B9u);
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+#endif // RNG_H
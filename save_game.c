@@ -1,29 +1,14 @@
 #include "save_game.h"
-#include "utils.h"
+#include "storage.h"
+#include "utils.h" // csv_scan_lines
+#include "stats.h"
+#include "probes.h"
+#include "player_cache.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 #include <time.h>
-#include <sys/stat.h>
-#include <errno.h>
-
-// Maximum number of items that can be saved/loaded
-#define MAX_INVENTORY_CAPACITY 20
-
-#ifdef _WIN32
-#include <direct.h>  // For _mkdir on Windows
-#define mkdir(dir, mode) _mkdir(dir)  // Windows doesn't use mode
-#endif
-
-// Helper function to ensure the save directory exists
-static bool ensure_save_directory() {
-    // Create save directory if it doesn't exist
-    if (mkdir(DEFAULT_SAVE_DIR, 0755) != 0 && errno != EEXIST) {
-        printf("Warning: Could not create save directory\n");
-        return false;
-    }
-    return true;
-}
 
 // Get the full path for the save file
 void get_save_filename(char *result, const char *username, const char *filename) {
@@ -32,11 +17,9 @@ void get_save_filename(char *result, const char *username, const char *filename)
     }
     
     // Initialize the result buffer
+    // (the file backend makes the save directory when it first writes)
     result[0] = '\0';
     
-    // Ensure save directory exists
-    ensure_save_directory();
-    
     // Construct the filename
     if (filename != NULL) {
         // Use the provided filename
@@ -50,247 +33,450 @@ void get_save_filename(char *result, const char *username, const char *filename)
     }
 }
 
-// Save player stats to a CSV file
-bool save_game(Player *player, const char *filename) {
-    if (player == NULL) {
-        printf("Error: Can't save NULL player\n");
+// Get the journal path that goes with a save file (saves/foo.csv.journal),
+// result should have MAX_FILENAME_LENGTH + sizeof(SAVE_JOURNAL_SUFFIX)
+// bytes. false if the path doesnt fit (save paths are never longer than
+// MAX_FILENAME_LENGTH - 1, the precision just tells the compiler so)
+static bool get_journal_filename(char *result, size_t size, const char *save_path) {
+    if (strlen(save_path) >= MAX_FILENAME_LENGTH) return false;
+    int len = snprintf(result, size, "%.*s%s", MAX_FILENAME_LENGTH - 1, save_path, SAVE_JOURNAL_SUFFIX);
+    return len >= 0 && (size_t)len < size;
+}
+
+// The cache holds what one backend has on disk, start over if somebody
+// switched backends since (the benchmarks do)
+// returns true if it's still the same backend, so the cache can be trusted
+static bool cache_follow_storage() {
+    static unsigned int cached_generation = 0;
+    unsigned int generation = storage_generation();
+    if (__atomic_exchange_n(&cached_generation, generation, __ATOMIC_RELAXED) != generation) {
+        player_cache_clear();
         return false;
     }
+    return true;
+}
+
+// write a player that was just saved through to the cache
+static void cache_player(const char *save_path, const Player *player) {
+    SaveRecord record;
+    save_record_from_player(&record, player);
+    player_cache_put(save_path, &record);
+}
+
+// growable text buffer so a save can be built up before handing it
+// to the storage backend in one go
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} SaveBuffer;
+
+// printf onto the end of a SaveBuffer, returns bytes added (0 on failure)
+static long buf_printf(SaveBuffer *buf, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list args_copy;
+    va_copy(args_copy, args);
+    int needed = vsnprintf(NULL, 0, format, args_copy);
+    va_end(args_copy);
+    
+    if (needed < 0) {
+        va_end(args);
+        return 0;
+    }
     
-    char save_path[MAX_FILENAME_LENGTH];
-    get_save_filename(save_path, player->name, filename);
-    
-    FILE *file = fopen(save_path, "w");
-    if (file == NULL) {
-        printf("Error: Could not open save file '%s'\n", save_path);
-        return false;
+    // grow if it doesnt fit (+1 for the null terminator vsnprintf wants)
+    if (buf->len + needed + 1 > buf->cap) {
+        size_t new_cap = buf->cap == 0 ? 512 : buf->cap * 2;
+        while (new_cap < buf->len + needed + 1) new_cap *= 2;
+        char *bigger = realloc(buf->data, new_cap);
+        if (bigger == NULL) {
+            va_end(args);
+            return 0;
+        }
+        buf->data = bigger;
+        buf->cap = new_cap;
     }
     
-    // Write CSV header
-    fprintf(file, "key,value\n");
+    vsnprintf(buf->data + buf->len, needed + 1, format, args);
+    buf->len += needed;
+    va_end(args);
+    return needed;
+}
+
+// Write the key,value lines for the fields flagged in dirty/dirty_slots
+// full saves just pass every bit, delta saves only pass what changed
+// returns number of bytes written
+static long write_player_fields(SaveBuffer *file, Player *player, unsigned int dirty, unsigned int dirty_slots) {
+    long bytes = 0;
     
     // Write basic player stats
-    fprintf(file, "NAME,%s\n", player->name);
-    fprintf(file, "CLASS,%d\n", player->playerClass);
-    fprintf(file, "HP,%d\n", player->hp);
-    fprintf(file, "MAX_HP,%d\n", player->maxHp);
-    fprintf(file, "DAMAGE,%d\n", player->damage);
+    if (dirty & DIRTY_FULL) {
+        bytes += buf_printf(file, "NAME,%s\n", player->name);
+        bytes += buf_printf(file, "CLASS,%d\n", player->playerClass);
+    }
+    if (dirty & DIRTY_HP) bytes += buf_printf(file, "HP,%d\n", player->hp);
+    if (dirty & DIRTY_MAX_HP) bytes += buf_printf(file, "MAX_HP,%d\n", player->maxHp);
+    if (dirty & DIRTY_DAMAGE) bytes += buf_printf(file, "DAMAGE,%d\n", player->damage);
     
     // Write progression stats
-    fprintf(file, "XP,%d\n", player->xp);
-    fprintf(file, "LEVEL,%d\n", player->level);
-    fprintf(file, "KILLS,%d\n", player->kills);
-    fprintf(file, "GOLD,%d\n", player->gold);
-    fprintf(file, "AREA,%d\n", player->area_level);
+    if (dirty & DIRTY_XP) bytes += buf_printf(file, "XP,%d\n", player->xp);
+    if (dirty & DIRTY_LEVEL) bytes += buf_printf(file, "LEVEL,%d\n", player->level);
+    if (dirty & DIRTY_KILLS) bytes += buf_printf(file, "KILLS,%d\n", player->kills);
+    if (dirty & DIRTY_GOLD) bytes += buf_printf(file, "GOLD,%d\n", player->gold);
+    if (dirty & DIRTY_AREA) bytes += buf_printf(file, "AREA,%d\n", player->area_level);
     
     // Write status flags
-    fprintf(file, "IS_POISONED,%d\n", (int)player->is_poisoned);
-    fprintf(file, "IS_SHIELDED,%d\n", (int)player->is_shielded);
-    fprintf(file, "TURN_SKIPPED,%d\n", (int)player->turn_skipped);
+    if (dirty & DIRTY_STATUS) {
+        bytes += buf_printf(file, "IS_POISONED,%d\n", (int)player->is_poisoned);
+        bytes += buf_printf(file, "IS_SHIELDED,%d\n", (int)player->is_shielded);
+        bytes += buf_printf(file, "TURN_SKIPPED,%d\n", (int)player->turn_skipped);
+    }
     
     // Write inventory data
-    fprintf(file, "INV_SIZE,%d\n", player->inventory_size);
-    fprintf(file, "INV_CAPACITY,%d\n", player->inventory_capacity);
+    if (dirty & DIRTY_INV_SIZE) {
+        bytes += buf_printf(file, "INV_SIZE,%d\n", player->inventory_size);
+        bytes += buf_printf(file, "INV_CAPACITY,%d\n", player->inventory_capacity);
+    }
+    if (dirty & DIRTY_AUCTION) bytes += buf_printf(file, "AUCTION_SEQ,%u\n", player->auction_seq);
     
-    // Save each inventory item
+    // Save each (changed) inventory item
     for (int i = 0; i < player->inventory_size; i++) {
         Item *item = player->inventory[i];
-        if (item != NULL) {
-            fprintf(file, "ITEM_%d_TYPE,%d\n", i, item->type);
-            fprintf(file, "ITEM_%d_NAME,%s\n", i, item->name);
-            fprintf(file, "ITEM_%d_VALUE,%d\n", i, item->value);
+        bool slot_dirty = (i >= 32) || (dirty_slots & (1u << i));
+        if (item != NULL && slot_dirty) {
+            bytes += buf_printf(file, "ITEM_%d_TYPE,%d\n", i, item->type);
+            bytes += buf_printf(file, "ITEM_%d_NAME,%s\n", i, item->name);
+            bytes += buf_printf(file, "ITEM_%d_VALUE,%d\n", i, item->value);
         }
     }
     
-    // Write timestamp
-    fprintf(file, "TIMESTAMP,%ld\n", (long)time(NULL));
+    return bytes;
+}
+
+// the whole save file: header, every field, timestamp
+static void write_snapshot(SaveBuffer *buf, Player *player) {
+    // Write CSV header
+    buf_printf(buf, "key,value\n");
     
-    fclose(file);
+    // everything counts as changed for a full snapshot
+    write_player_fields(buf, player, DIRTY_FULL | ~0u, ~0u);
     
-    printf("Game saved successfully for %s (Level %d) to '%s'!\n", 
-           player->name, player->level, save_path);
-    return true;
+    // Write timestamp
+    buf_printf(buf, "TIMESTAMP,%ld\n", (long)time(NULL));
 }
 
-// Helper function to read a line from CSV and extract value
-static bool read_csv_value(FILE *file, char *key, char *value, size_t max_len) {
-    char line[512];
-    
-    // Read next line
-    if (fgets(line, sizeof(line), file) == NULL) {
+// Save player stats to a CSV file
+// Only the first save (or one after the journal gets too big) writes the
+// whole file, everything else appends the changed fields to the journal
+bool save_game(Player *player, const char *filename) {
+    if (player == NULL) {
+        printf("Error: Can't save NULL player\n");
         return false;
     }
     
-    // Split line by comma
-    char *comma = strchr(line, ',');
-    if (comma == NULL) {
+    unsigned long long save_start = STATS_TIMER_START();
+    StorageBackend *store = storage_active();
+    
+    char save_path[MAX_FILENAME_LENGTH];
+    get_save_filename(save_path, player->name, filename);
+    GAME_PROBE1(save__start, save_path);
+    
+    char journal_path[MAX_FILENAME_LENGTH + sizeof(SAVE_JOURNAL_SUFFIX)];
+    if (!get_journal_filename(journal_path, sizeof(journal_path), save_path)) {
+        printf("Error: Save path '%s' is too long\n", save_path);
         return false;
     }
     
-    // Extract key
-    size_t key_len = comma - line;
-    if (key_len >= max_len) {
-        key_len = max_len - 1;
+    // figure out if we can get away with a delta
+    bool full_save = (player->dirty & DIRTY_FULL) ||
+                     !store->exists(store, save_path) ||
+                     store->size(store, journal_path) >= SAVE_JOURNAL_MAX_BYTES;
+    
+    SaveBuffer buf = { NULL, 0, 0 };
+    bool ok = true;
+    long long bytes_written = 0;
+    
+    if (!full_save) {
+        long bytes = write_player_fields(&buf, player, player->dirty, player->dirty_slots);
+        if (bytes > 0 && !store->append(store, journal_path, buf.data, buf.len)) {
+            // cant append for some reason, fall back to a full save
+            full_save = true;
+            buf.len = 0;
+        } else {
+            log_event(LOG_DEBUG, "Journaled %ld bytes of changes to '%s'", bytes, journal_path);
+            STATS_COUNT(COUNTER_SAVES_DELTA, 1);
+            STATS_COUNT(COUNTER_SAVE_BYTES, bytes);
+            bytes_written = bytes;
+        }
     }
-    strncpy(key, line, key_len);
-    key[key_len] = '\0';
     
-    // Extract value
-    size_t value_len = strlen(comma + 1);
-    if (value_len >= max_len) {
-        value_len = max_len - 1;
+    if (full_save) {
+        write_snapshot(&buf, player);
+        
+        // snapshot has everything now so old journal entries are stale,
+        // both go in one batch so we never keep a journal for the wrong snapshot
+        StorageOp ops[2] = {
+            { STORAGE_OP_PUT, save_path, buf.data, buf.len },
+            { STORAGE_OP_DELETE, journal_path, NULL, 0 }
+        };
+        ok = buf.data != NULL && store->batch(store, ops, 2);
+        if (ok) {
+            log_event(LOG_DEBUG, "Wrote full snapshot (%zu bytes) to '%s'", buf.len, save_path);
+            STATS_COUNT(COUNTER_SAVES_FULL, 1);
+            STATS_COUNT(COUNTER_SAVE_BYTES, (long)buf.len);
+            bytes_written = (long long)buf.len;
+        }
     }
-    strncpy(value, comma + 1, value_len);
-    
-    // Remove newline character if present
-    if (value[value_len - 1] == '\n') {
-        value[value_len - 1] = '\0';
-    } else {
-        value[value_len] = '\0';
+    free(buf.data);
+    STATS_TIMER_STOP(STAT_SAVE_GAME, save_start);
+    GAME_PROBE4(save__done, save_path, bytes_written, (int)full_save, (int)ok);
+    
+    cache_follow_storage();
+    if (!ok) {
+        player_cache_remove(save_path); // cant tell what made it to disk
+        printf("Error: Could not write save file '%s'\n", save_path);
+        return false;
     }
     
+    // disk matches memory again
+    player->dirty = 0;
+    player->dirty_slots = 0;
+    cache_player(save_path, player);
+    
+    printf("Game saved successfully for %s (Level %d) to '%s'!\n", 
+           player->name, player->level, save_path);
     return true;
 }
 
-// Load player stats from a CSV file
-bool load_game(Player *player, const char *filename) {
-    if (player == NULL) {
-        printf("Error: Can't load to NULL player\n");
+// Save several players in one storage batch
+// Always full snapshots: a put is staged in a temp file before anything
+// real gets touched, a journal append isnt, so this is the only way to
+// get all of them on disk or none of them
+bool save_game_batch(Player **players, const char **filenames, int count) {
+    if (players == NULL || count <= 0 || count > SAVE_BATCH_MAX) {
+        printf("Error: Can't save a batch of %d players\n", count);
         return false;
     }
     
-    char save_path[MAX_FILENAME_LENGTH];
-    
-    // The key fix: using the global saveFileName if provided, otherwise check for player->name.csv
-    // But we should only use player->name if it's not the temporary name "temp"
-    const char* username = (player->name != NULL && strcmp(player->name, "temp") != 0) ? player->name : NULL;
+    unsigned long long save_start = STATS_TIMER_START();
+    StorageBackend *store = storage_active();
+    
+    char save_paths[SAVE_BATCH_MAX][MAX_FILENAME_LENGTH];
+    char journal_paths[SAVE_BATCH_MAX][MAX_FILENAME_LENGTH + sizeof(SAVE_JOURNAL_SUFFIX)];
+    SaveBuffer bufs[SAVE_BATCH_MAX];
+    StorageOp ops[SAVE_BATCH_MAX * 2];
+    bool ok = true;
+    long long bytes_written = 0;
+    
+    for (int i = 0; i < count; i++) {
+        bufs[i] = (SaveBuffer){ NULL, 0, 0 };
+        if (players[i] == NULL) {
+            ok = false;
+            continue;
+        }
+        
+        get_save_filename(save_paths[i], players[i]->name, filenames ? filenames[i] : NULL);
+        if (!get_journal_filename(journal_paths[i], sizeof(journal_paths[i]), save_paths[i])) ok = false;
+        write_snapshot(&bufs[i], players[i]);
+        if (bufs[i].data == NULL) ok = false;
+        
+        ops[i * 2] = (StorageOp){ STORAGE_OP_PUT, save_paths[i], bufs[i].data, bufs[i].len };
+        ops[i * 2 + 1] = (StorageOp){ STORAGE_OP_DELETE, journal_paths[i], NULL, 0 };
+        bytes_written += (long long)bufs[i].len;
+    }
     
-    // Determine the path to the save file based on provided filename or username
-    get_save_filename(save_path, username, filename);
+    ok = ok && store->batch(store, ops, count * 2);
     
-    // Check if save file exists
-    if (!save_game_exists(username, filename)) {
-        printf("No saved game found at '%s'!\n", save_path);
-        return false;
+    for (int i = 0; i < count; i++) {
+        free(bufs[i].data);
     }
+    STATS_TIMER_STOP(STAT_SAVE_GAME, save_start);
     
-    FILE *file = fopen(save_path, "r");
-    if (file == NULL) {
-        printf("Error: Could not open save file '%s'\n", save_path);
+    cache_follow_storage();
+    if (!ok) {
+        for (int i = 0; i < count; i++) {
+            if (players[i] != NULL) player_cache_remove(save_paths[i]);
+        }
+        printf("Error: Could not write a batch of %d saves\n", count);
         return false;
     }
     
-    // Skip header line
-    char line[512];
-    if (fgets(line, sizeof(line), file) == NULL || strncmp(line, "key,value", 9) != 0) {
-        printf("Error: Invalid save file format - missing header\n");
-        fclose(file);
-        return false;
-    }
+    log_event(LOG_DEBUG, "Wrote %d snapshots (%lld bytes) in one batch", count, bytes_written);
+    STATS_COUNT(COUNTER_SAVES_FULL, count);
+    STATS_COUNT(COUNTER_SAVE_BYTES, bytes_written);
     
-    // Read and parse each line
-    char key[100];
-    char value[400];
-    bool name_found = false;
-    int saved_inventory_size = 0;
-    int saved_inventory_capacity = INITIAL_INVENTORY_CAPACITY;
-    
-    // Arrays to temporarily store item data while parsing
-    int item_types[MAX_INVENTORY_CAPACITY];
-    char item_names[MAX_INVENTORY_CAPACITY][64];
-    int item_values[MAX_INVENTORY_CAPACITY];
-    bool item_exists[MAX_INVENTORY_CAPACITY] = {false};
-    
-    while (read_csv_value(file, key, value, sizeof(key))) {
-        if (strcmp(key, "NAME") == 0) {
-            // Free old name if it exists
-            if (player->name != NULL) {
-                free(player->name);
+    for (int i = 0; i < count; i++) {
+        players[i]->dirty = 0;
+        players[i]->dirty_slots = 0;
+        cache_player(save_paths[i], players[i]);
+    }
+    return true;
+}
+
+// Reset a record to what a save with no fields in it would give you
+void save_record_init(SaveRecord *record) {
+    if (record == NULL) return;
+    memset(record, 0, sizeof(SaveRecord));
+    record->inventory_capacity = INITIAL_INVENTORY_CAPACITY;
+}
+
+// Apply one key,value pair from a save (or journal) line to the record
+// later values just overwrite earlier ones, thats what makes the journal work
+void save_record_apply(SaveRecord *record, const char *key, const char *value) {
+    if (record == NULL || key == NULL || value == NULL) return;
+    
+    if (strcmp(key, "NAME") == 0) {
+        strncpy(record->name, value, SAVE_RECORD_NAME_LENGTH - 1);
+        record->name[SAVE_RECORD_NAME_LENGTH - 1] = '\0';
+        record->name_found = true;
+    } 
+    else if (strcmp(key, "CLASS") == 0) {
+        record->playerClass = atoi(value);
+    }
+    else if (strcmp(key, "HP") == 0) {
+        record->hp = atoi(value);
+    }
+    else if (strcmp(key, "MAX_HP") == 0) {
+        record->maxHp = atoi(value);
+    }
+    else if (strcmp(key, "DAMAGE") == 0) {
+        record->damage = atoi(value);
+    }
+    else if (strcmp(key, "XP") == 0) {
+        record->xp = atoi(value);
+    }
+    else if (strcmp(key, "LEVEL") == 0) {
+        record->level = atoi(value);
+    }
+    else if (strcmp(key, "KILLS") == 0) {
+        record->kills = atoi(value);
+    }
+    else if (strcmp(key, "GOLD") == 0) {
+        record->gold = atoi(value);
+    }
+    else if (strcmp(key, "AREA") == 0) {
+        record->area_level = atoi(value);
+    }
+    else if (strcmp(key, "IS_POISONED") == 0) {
+        record->is_poisoned = (atoi(value) != 0);
+    }
+    else if (strcmp(key, "IS_SHIELDED") == 0) {
+        record->is_shielded = (atoi(value) != 0);
+    }
+    else if (strcmp(key, "TURN_SKIPPED") == 0) {
+        record->turn_skipped = (atoi(value) != 0);
+    }
+    else if (strcmp(key, "INV_SIZE") == 0) {
+        record->inventory_size = atoi(value);
+    }
+    else if (strcmp(key, "INV_CAPACITY") == 0) {
+        record->inventory_capacity = atoi(value);
+    }
+    else if (strcmp(key, "AUCTION_SEQ") == 0) {
+        record->auction_seq = (unsigned int)strtoul(value, NULL, 10);
+    }
+    // Check for item data - parse keys like ITEM_0_TYPE, ITEM_0_NAME, etc.
+    else if (strncmp(key, "ITEM_", 5) == 0) {
+        // Extract item index from the key (e.g., from "ITEM_0_TYPE" get 0)
+        int item_index = atoi(key + 5);
+        if (item_index >= 0 && item_index < MAX_INVENTORY_CAPACITY) {
+            // Check which property this is (TYPE, NAME, VALUE)
+            if (strstr(key, "_TYPE") != NULL) {
+                record->item_types[item_index] = atoi(value);
+                record->item_exists[item_index] = true;
             }
-            
-            // Allocate and copy new name
-            player->name = malloc(strlen(value) + 1);
-            if (player->name == NULL) {
-                printf("Error: Failed to allocate memory for player name\n");
-                fclose(file);
-                return false;
+            else if (strstr(key, "_NAME") != NULL) {
+                strncpy(record->item_names[item_index], value, SAVE_RECORD_NAME_LENGTH - 1);
+                record->item_names[item_index][SAVE_RECORD_NAME_LENGTH - 1] = '\0'; // Ensure null-termination
             }
-            strcpy(player->name, value);
-            name_found = true;
-        } 
-        else if (strcmp(key, "CLASS") == 0) {
-            player->playerClass = atoi(value);
-        }
-        else if (strcmp(key, "HP") == 0) {
-            player->hp = atoi(value);
-        }
-        else if (strcmp(key, "MAX_HP") == 0) {
-            player->maxHp = atoi(value);
-        }
-        else if (strcmp(key, "DAMAGE") == 0) {
-            player->damage = atoi(value);
-        }
-        else if (strcmp(key, "XP") == 0) {
-            player->xp = atoi(value);
-        }
-        else if (strcmp(key, "LEVEL") == 0) {
-            player->level = atoi(value);
-        }
-        else if (strcmp(key, "KILLS") == 0) {
-            player->kills = atoi(value);
-        }
-        else if (strcmp(key, "GOLD") == 0) {
-            player->gold = atoi(value);
-        }
-        else if (strcmp(key, "AREA") == 0) {
-            player->area_level = atoi(value);
-        }
-        else if (strcmp(key, "IS_POISONED") == 0) {
-            player->is_poisoned = (atoi(value) != 0);
-        }
-        else if (strcmp(key, "IS_SHIELDED") == 0) {
-            player->is_shielded = (atoi(value) != 0);
-        }
-        else if (strcmp(key, "TURN_SKIPPED") == 0) {
-            player->turn_skipped = (atoi(value) != 0);
-        }
-        else if (strcmp(key, "INV_SIZE") == 0) {
-            saved_inventory_size = atoi(value);
-        }
-        else if (strcmp(key, "INV_CAPACITY") == 0) {
-            saved_inventory_capacity = atoi(value);
-        }
-        // Check for item data - parse keys like ITEM_0_TYPE, ITEM_0_NAME, etc.
-        else if (strncmp(key, "ITEM_", 5) == 0) {
-            // Extract item index from the key (e.g., from "ITEM_0_TYPE" get 0)
-            int item_index = atoi(key + 5);
-            if (item_index >= 0 && item_index < MAX_INVENTORY_CAPACITY) {
-                // Check which property this is (TYPE, NAME, STRENGTH)
-                if (strstr(key, "_TYPE") != NULL) {
-                    item_types[item_index] = atoi(value);
-                    item_exists[item_index] = true;
-                }
-                else if (strstr(key, "_NAME") != NULL) {
-                    strncpy(item_names[item_index], value, 63);
-                    item_names[item_index][63] = '\0'; // Ensure null-termination
-                }
-                else if (strstr(key, "_VALUE") != NULL) {
-                    item_values[item_index] = atoi(value);
-                }
+            else if (strstr(key, "_VALUE") != NULL) {
+                record->item_values[item_index] = atoi(value);
             }
         }
-        // Ignore any other keys (like TIMESTAMP)
+    }
+    // Ignore any other keys (like TIMESTAMP)
+}
+
+// csv_scan_lines callback for load_game
+static void apply_save_line(const char *key, const char *value, void *ctx) {
+    save_record_apply((SaveRecord *)ctx, key, value);
+}
+
+// Copy a live player into a record (names longer than the record holds get cut)
+void save_record_from_player(SaveRecord *record, const Player *player) {
+    save_record_init(record);
+    if (record == NULL || player == NULL) return;
+
+    if (player->name != NULL) {
+        strncpy(record->name, player->name, SAVE_RECORD_NAME_LENGTH - 1);
+        record->name_found = true;
+    }
+    record->playerClass = player->playerClass;
+    record->hp = player->hp;
+    record->maxHp = player->maxHp;
+    record->damage = player->damage;
+    record->xp = player->xp;
+    record->level = player->level;
+    record->kills = player->kills;
+    record->gold = player->gold;
+    record->area_level = player->area_level;
+    record->is_poisoned = player->is_poisoned;
+    record->is_shielded = player->is_shielded;
+    record->turn_skipped = player->turn_skipped;
+    record->inventory_capacity = player->inventory_capacity;
+    record->auction_seq = player->auction_seq;
+
+    int count = player->inventory_size;
+    if (count > MAX_INVENTORY_CAPACITY) count = MAX_INVENTORY_CAPACITY;
+    record->inventory_size = count;
+    for (int i = 0; i < count; i++) {
+        Item *item = player->inventory[i];
+        if (item == NULL) continue;
+        record->item_exists[i] = true;
+        record->item_types[i] = item->type;
+        record->item_values[i] = item->value;
+        if (item->name != NULL) {
+            strncpy(record->item_names[i], item->name, SAVE_RECORD_NAME_LENGTH - 1);
+        }
+    }
+}
+
+// Turn a parsed record into a real player (allocates name + inventory)
+bool save_record_to_player(const SaveRecord *record, Player *player) {
+    // Free old name if it exists
+    if (player->name != NULL) {
+        free(player->name);
     }
     
-    fclose(file);
-    
-    if (!name_found) {
-        printf("Error: Corrupted save - missing name\n");
+    // Allocate and copy new name
+    player->name = malloc(strlen(record->name) + 1);
+    if (player->name == NULL) {
+        printf("Error: Failed to allocate memory for player name\n");
         return false;
     }
-    
-    // Initialize inventory
-    player->inventory_capacity = saved_inventory_capacity;
+    strcpy(player->name, record->name);
+    
+    player->playerClass = record->playerClass;
+    player->hp = record->hp;
+    player->maxHp = record->maxHp;
+    player->damage = record->damage;
+    player->xp = record->xp;
+    player->level = record->level;
+    player->kills = record->kills;
+    player->gold = record->gold;
+    player->area_level = record->area_level;
+    player->is_poisoned = record->is_poisoned;
+    player->is_shielded = record->is_shielded;
+    player->turn_skipped = record->turn_skipped;
+    player->auction_seq = record->auction_seq;
+    
+    // Initialize inventory (never smaller than what we saved)
+    int saved_inventory_size = record->inventory_size;
+    if (saved_inventory_size > MAX_INVENTORY_CAPACITY) saved_inventory_size = MAX_INVENTORY_CAPACITY;
+    player->inventory_capacity = record->inventory_capacity;
+    if (player->inventory_capacity < saved_inventory_size) player->inventory_capacity = saved_inventory_size;
+    if (player->inventory_capacity < 1) player->inventory_capacity = INITIAL_INVENTORY_CAPACITY;
     player->inventory_size = 0; // Will be incremented as we add items
     player->inventory = malloc(sizeof(Item*) * player->inventory_capacity);
     
@@ -306,23 +492,23 @@ bool load_game(Player *player, const char *filename) {
     
     // Create items from saved data
     for (int i = 0; i < saved_inventory_size; i++) {
-        if (item_exists[i]) {
+        if (record->item_exists[i]) {
             // Allocate memory for the item
             Item *item = malloc(sizeof(Item));
             if (item != NULL) {
-                item->type = item_types[i];
+                item->type = record->item_types[i];
                 
                 // Fix: Allocate memory for item name instead of just copying
-                item->name = malloc(strlen(item_names[i]) + 1);
+                item->name = malloc(strlen(record->item_names[i]) + 1);
                 if (item->name == NULL) {
                     // Handle allocation failure
                     printf("Error: Failed to allocate memory for item name\n");
                     free(item);
                     continue;
                 }
-                strcpy(item->name, item_names[i]);
+                strcpy(item->name, record->item_names[i]);
                 
-                item->value = item_values[i];
+                item->value = record->item_values[i];
                 
                 // Add to inventory
                 player->inventory[player->inventory_size] = item;
@@ -331,12 +517,103 @@ bool load_game(Player *player, const char *filename) {
         }
     }
     
+    return true;
+}
+
+// Read and replay a save (snapshot + journal) from the backend into record
+static bool read_save_record(const char *save_path, const char *username, const char *filename,
+                             SaveRecord *record, long long *bytes_out) {
+    // Check if save file exists
+    if (!save_game_exists(username, filename)) {
+        printf("No saved game found at '%s'!\n", save_path);
+        return false;
+    }
+    
+    StorageBackend *store = storage_active();
+    char *data = store->get(store, save_path, NULL);
+    if (data == NULL) {
+        printf("Error: Could not open save file '%s'\n", save_path);
+        return false;
+    }
+    
+    // Check header line
+    if (strncmp(data, "key,value", 9) != 0) {
+        printf("Error: Invalid save file format - missing header\n");
+        free(data);
+        return false;
+    }
+    
+    // Parse each line, first the snapshot then any journal entries on
+    // top of it (journal lines use the same keys so the later value just
+    // overwrites the earlier one)
+    char journal_path[MAX_FILENAME_LENGTH + sizeof(SAVE_JOURNAL_SUFFIX)];
+    if (!get_journal_filename(journal_path, sizeof(journal_path), save_path)) {
+        printf("Error: Save path '%s' is too long\n", save_path);
+        free(data);
+        return false;
+    }
+    
+    save_record_init(record);
+    
+    for (int src = 0; src < 2 && data != NULL; src++) {
+        size_t len = strlen(data);
+        *bytes_out += (long long)len;
+        csv_scan_lines(data, len, apply_save_line, record);
+        free(data);
+        data = (src == 0) ? store->get(store, journal_path, NULL) : NULL;
+    }
+    
+    if (!record->name_found) {
+        printf("Error: Corrupted save - missing name\n");
+        return false;
+    }
+    return true;
+}
+
+// Load player stats from a CSV file (load_game wraps this with timing)
+// save_path gets the key we loaded from, bytes_out how much we read
+static bool load_game_from_store(Player *player, const char *filename,
+                                 char *save_path, long long *bytes_out) {
+    save_path[0] = '\0';
+    if (player == NULL) {
+        printf("Error: Can't load to NULL player\n");
+        return false;
+    }
+    
+    // The key fix: using the global saveFileName if provided, otherwise check for player->name.csv
+    // But we should only use player->name if it's not the temporary name "temp"
+    const char* username = (player->name != NULL && strcmp(player->name, "temp") != 0) ? player->name : NULL;
+    
+    // Determine the path to the save file based on provided filename or username
+    get_save_filename(save_path, username, filename);
+    
+    // someone who was just here comes straight out of memory
+    cache_follow_storage();
+    SaveRecord record;
+    if (player_cache_get(save_path, &record)) {
+        log_event(LOG_DEBUG, "Loaded '%s' from the player cache", save_path);
+    } else if (read_save_record(save_path, username, filename, &record, bytes_out)) {
+        player_cache_fill(save_path, &record);
+    } else {
+        return false;
+    }
+    
+    if (!save_record_to_player(&record, player)) {
+        return false;
+    }
+    
+    // what we have in memory now matches what's on disk
+    player->dirty = 0;
+    player->dirty_slots = 0;
+    player->version = 0;
+    
     // If inventory is empty (possibly due to error), add a health potion
     if (player->inventory_size == 0) {
         Item *potion = create_health_potion(player->level);
         if (potion != NULL) {
             player->inventory[0] = potion;
             player->inventory_size = 1;
+            mark_inventory_dirty(player, 0);
         }
     }
     
@@ -345,6 +622,139 @@ bool load_game(Player *player, const char *filename) {
     return true;
 }
 
+// Load player stats from a CSV file
+bool load_game(Player *player, const char *filename) {
+    unsigned long long load_start = STATS_TIMER_START();
+    GAME_PROBE1(load__start, filename);
+    
+    char save_path[MAX_FILENAME_LENGTH];
+    long long bytes_read = 0;
+    bool loaded = load_game_from_store(player, filename, save_path, &bytes_read);
+    
+    STATS_TIMER_STOP(STAT_LOAD_GAME, load_start);
+    GAME_PROBE3(load__done, save_path, bytes_read, (int)loaded);
+    return loaded;
+}
+
+// little endian helpers for the binary format
+static size_t put_u8(unsigned char *out, size_t pos, size_t cap, unsigned int v) {
+    if (pos + 1 <= cap) out[pos] = (unsigned char)v;
+    return pos + 1;
+}
+
+static size_t put_i32(unsigned char *out, size_t pos, size_t cap, int v) {
+    unsigned int u = (unsigned int)v;
+    if (pos + 4 <= cap) {
+        out[pos] = u & 0xFF;
+        out[pos + 1] = (u >> 8) & 0xFF;
+        out[pos + 2] = (u >> 16) & 0xFF;
+        out[pos + 3] = (u >> 24) & 0xFF;
+    }
+    return pos + 4;
+}
+
+static size_t put_str(unsigned char *out, size_t pos, size_t cap, const char *str) {
+    size_t len = strlen(str);
+    if (len > 255) len = 255; // length has to fit in one byte
+    pos = put_u8(out, pos, cap, (unsigned int)len);
+    if (pos + len <= cap) memcpy(out + pos, str, len);
+    return pos + len;
+}
+
+// Pack a record into the compact binary form
+// returns bytes needed, only writes if it fits in cap (call with cap 0 to size it)
+size_t save_record_encode(const SaveRecord *record, unsigned char *out, size_t cap) {
+    size_t pos = 0;
+    pos = put_str(out, pos, cap, record->name);
+    pos = put_u8(out, pos, cap, (unsigned int)record->playerClass);
+    pos = put_i32(out, pos, cap, record->hp);
+    pos = put_i32(out, pos, cap, record->maxHp);
+    pos = put_i32(out, pos, cap, record->damage);
+    pos = put_i32(out, pos, cap, record->xp);
+    pos = put_i32(out, pos, cap, record->level);
+    pos = put_i32(out, pos, cap, record->kills);
+    pos = put_i32(out, pos, cap, record->gold);
+    pos = put_u8(out, pos, cap, (unsigned int)record->area_level);
+    pos = put_u8(out, pos, cap, record->is_poisoned | (record->is_shielded << 1) | (record->turn_skipped << 2));
+    pos = put_u8(out, pos, cap, (unsigned int)record->inventory_capacity);
+    
+    // only items that actually exist, so count them first
+    int count = 0;
+    for (int i = 0; i < record->inventory_size && i < MAX_INVENTORY_CAPACITY; i++) {
+        if (record->item_exists[i]) count++;
+    }
+    pos = put_u8(out, pos, cap, (unsigned int)count);
+    for (int i = 0; i < record->inventory_size && i < MAX_INVENTORY_CAPACITY; i++) {
+        if (!record->item_exists[i]) continue;
+        pos = put_u8(out, pos, cap, (unsigned int)record->item_types[i]);
+        pos = put_i32(out, pos, cap, record->item_values[i]);
+        pos = put_str(out, pos, cap, record->item_names[i]);
+    }
+    pos = put_i32(out, pos, cap, (int)record->auction_seq);
+    return pos;
+}
+
+// readers for decode, they set *ok = false instead of running off the end
+static unsigned int get_u8(const unsigned char *in, size_t len, size_t *pos, bool *ok) {
+    if (*pos + 1 > len) { *ok = false; return 0; }
+    return in[(*pos)++];
+}
+
+static int get_i32(const unsigned char *in, size_t len, size_t *pos, bool *ok) {
+    if (*pos + 4 > len) { *ok = false; return 0; }
+    unsigned int u = in[*pos] | (in[*pos + 1] << 8) | (in[*pos + 2] << 16) | ((unsigned int)in[*pos + 3] << 24);
+    *pos += 4;
+    return (int)u;
+}
+
+static void get_str(const unsigned char *in, size_t len, size_t *pos, bool *ok, char *dest) {
+    size_t n = get_u8(in, len, pos, ok);
+    if (!*ok || *pos + n > len || n >= SAVE_RECORD_NAME_LENGTH) { *ok = false; dest[0] = '\0'; return; }
+    memcpy(dest, in + *pos, n);
+    dest[n] = '\0';
+    *pos += n;
+}
+
+// Unpack a record written by save_record_encode
+// returns bytes consumed, 0 if the data is broken
+size_t save_record_decode(SaveRecord *record, const unsigned char *in, size_t len) {
+    bool ok = true;
+    size_t pos = 0;
+    save_record_init(record);
+    
+    get_str(in, len, &pos, &ok, record->name);
+    record->name_found = ok;
+    record->playerClass = get_u8(in, len, &pos, &ok);
+    record->hp = get_i32(in, len, &pos, &ok);
+    record->maxHp = get_i32(in, len, &pos, &ok);
+    record->damage = get_i32(in, len, &pos, &ok);
+    record->xp = get_i32(in, len, &pos, &ok);
+    record->level = get_i32(in, len, &pos, &ok);
+    record->kills = get_i32(in, len, &pos, &ok);
+    record->gold = get_i32(in, len, &pos, &ok);
+    record->area_level = get_u8(in, len, &pos, &ok);
+    unsigned int flags = get_u8(in, len, &pos, &ok);
+    record->is_poisoned = flags & 1;
+    record->is_shielded = (flags >> 1) & 1;
+    record->turn_skipped = (flags >> 2) & 1;
+    record->inventory_capacity = get_u8(in, len, &pos, &ok);
+    
+    int count = get_u8(in, len, &pos, &ok);
+    if (count > MAX_INVENTORY_CAPACITY) ok = false;
+    for (int i = 0; ok && i < count; i++) {
+        record->item_types[i] = get_u8(in, len, &pos, &ok);
+        record->item_values[i] = get_i32(in, len, &pos, &ok);
+        get_str(in, len, &pos, &ok, record->item_names[i]);
+        record->item_exists[i] = true;
+    }
+    record->inventory_size = count;
+    
+    // added later, records from before it just stop here
+    if (ok && pos < len) record->auction_seq = (unsigned int)get_i32(in, len, &pos, &ok);
+    
+    return ok ? pos : 0;
+}
+
 // Check if a saved game exists
 bool save_game_exists(const char *username, const char *filename) {
     char save_path[MAX_FILENAME_LENGTH];
@@ -362,16 +772,16 @@ bool save_game_exists(const char *username, const char *filename) {
         get_save_filename(save_path, NULL, "default.csv");
     }
     
-    // Debug print to see what path is being checked
-    printf("Checking for save file at: %s\n", save_path);
+    // everything that writes or deletes a save goes through here and keeps
+    // the cache in step, so a cached player is on disk as long as the
+    // backend hasnt been switched. only a miss has to ask the store
+    if (cache_follow_storage() && player_cache_contains(save_path)) return true;
     
-    FILE *file = fopen(save_path, "r");
-    if (file == NULL) {
-        return false;
-    }
-    
-    fclose(file);
-    return true;
+    log_event(LOG_DEBUG, "Checking for save file at: %s", save_path);
+    StorageBackend *store = storage_active();
+    if (store->exists(store, save_path)) return true;
+    player_cache_remove(save_path);
+    return false;
 }
 
 // Clear saved game data
@@ -379,7 +789,17 @@ bool clear_save(const char *filename) {
     char save_path[MAX_FILENAME_LENGTH];
     get_save_filename(save_path, NULL, filename);
     
-    if (remove(save_path) != 0) {
+    // journal goes too, dont care if there wasnt one
+    char journal_path[MAX_FILENAME_LENGTH + sizeof(SAVE_JOURNAL_SUFFIX)];
+    if (!get_journal_filename(journal_path, sizeof(journal_path), save_path)) {
+        printf("Error: Save path '%s' is too long\n", save_path);
+        return false;
+    }
+    StorageBackend *store = storage_active();
+    player_cache_remove(save_path);
+    store->remove(store, journal_path);
+    
+    if (!store->remove(store, save_path)) {
         printf("Warning: Could not delete save file '%s'\n", save_path);
         return false;
     }
@@ -5,6 +5,7 @@
 #include "player.h"
 #include "enemy.h"
 #include <stdbool.h>
+#include <stddef.h> // size_t
 
 // Default directory for save files
 #define DEFAULT_SAVE_DIR "saves"
@@ -12,17 +13,69 @@
 // Maximum length for save filename
 #define MAX_FILENAME_LENGTH 100
 
+// changed fields get appended to {savefile}.journal instead of rewriting
+// the whole CSV, once the journal grows past this we write a full snapshot
+#define SAVE_JOURNAL_SUFFIX ".journal"
+#define SAVE_JOURNAL_MAX_BYTES 4096
+
+// Maximum number of items that can be saved/loaded
+#define MAX_INVENTORY_CAPACITY 20
+
+// longest name (player or item) a save record holds
+#define SAVE_RECORD_NAME_LENGTH 64
+
+// Everything a save file holds, as plain data (no mallocs)
+// load_game parses into one of these first, the bulk importer
+// uses it directly
+typedef struct {
+    char name[SAVE_RECORD_NAME_LENGTH];
+    bool name_found;
+    int playerClass;
+    int hp;
+    int maxHp;
+    int damage;
+    int xp;
+    int level;
+    int kills;
+    int gold;
+    int area_level;
+    unsigned int is_poisoned : 1;
+    unsigned int is_shielded : 1;
+    unsigned int turn_skipped : 1;
+    int inventory_size;
+    int inventory_capacity;
+    unsigned int auction_seq;
+    
+    // items by slot
+    int item_types[MAX_INVENTORY_CAPACITY];
+    char item_names[MAX_INVENTORY_CAPACITY][SAVE_RECORD_NAME_LENGTH];
+    int item_values[MAX_INVENTORY_CAPACITY];
+    bool item_exists[MAX_INVENTORY_CAPACITY];
+} SaveRecord;
+
 // save player stats to a CSV file
 // if filename is NULL, uses {username}.csv
+// only fields marked dirty get written (appended to the journal),
+// full snapshot when the player is new or the journal is too big
 // returns true if save was successful
 bool save_game(Player *player, const char *filename);
 
+// most players save_game_batch takes at once
+#define SAVE_BATCH_MAX 8
+
+// full snapshots of several players in one storage batch, so either all
+// of them land or none do (filenames can be NULL, or have NULL entries)
+// returns true if every save was written
+bool save_game_batch(Player **players, const char **filenames, int count);
+
 // load player stats from a CSV file
 // if filename is NULL, tries to load {username}.csv
+// replays the journal (if any) on top of the snapshot
 // returns true if load was successful 
 bool load_game(Player *player, const char *filename);
 
-// check if a saved game exists
+// check if a saved game exists (a player in the cache is, anything else
+// gets looked up in the storage backend)
 // if filename is NULL, checks for {username}.csv
 bool save_game_exists(const char *username, const char *filename);
 
@@ -35,4 +88,21 @@ bool clear_save(const char *filename);
 // result must be pre-allocated with at least MAX_FILENAME_LENGTH bytes
 void get_save_filename(char *result, const char *username, const char *filename);
 
+// reset a record to defaults (empty save)
+void save_record_init(SaveRecord *record);
+
+// apply one key,value line from a save or journal to the record
+void save_record_apply(SaveRecord *record, const char *key, const char *value);
+
+// copy a player into a record / build a player from one (allocates the
+// name and inventory, player->name must be NULL or malloc'd)
+void save_record_from_player(SaveRecord *record, const Player *player);
+bool save_record_to_player(const SaveRecord *record, Player *player);
+
+// compact binary form of a record (little endian, length prefixed strings)
+// encode returns bytes needed and only writes if cap is big enough
+// decode returns bytes consumed or 0 if the data is bad
+size_t save_record_encode(const SaveRecord *record, unsigned char *out, size_t cap);
+size_t save_record_decode(SaveRecord *record, const unsigned char *in, size_t len);
+
 #endif // SAVE_GAME_H 
\ No newline at end of file
@@ -0,0 +1,305 @@
+// shard.c - Sessions run by area, one worker thread per area (or per slice of one)
+//
+// Every area has its own worker (or a few, splitting the area's players
+// by a hash of their name). A worker owns its sessions outright: the list
+// of who lives there, the rng its spawns come from, the counters. None of
+// that is shared, so the workers never take a lock to play a fight and
+// never bounce each other's cache lines around.
+//
+// The only way into a shard is its handoff queue, a lock-free stack that
+// anybody can push onto with one CAS. The worker swaps the whole stack
+// out, flips it back into arrival order and adopts everything on it.
+// When a player levels up enough for the next area the worker pushes
+// the session onto that area's queue and forgets about it.
+//
+// Workers with nothing to do sleep on a condition variable, whoever pushes
+// onto an empty queue wakes them up.
+//
+// This is for a server running lots of sessions. The single player game
+// doesnt start any shards, only the benchmarks do.
+#include "shard.h"
+#include "broadcast.h"
+#include "combat.h"
+#include "config.h"
+#include "enemy.h"
+#include "game.h"
+#include "rng.h"
+#include "spawn.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// each shard on its own cache lines, so one worker bumping its counters
+// doesnt slow down the one next to it
+typedef struct {
+    int area;
+    int partition;
+    unsigned int rng;   // spawns, this worker only
+    pthread_t thread;
+
+    ShardSession *inbox; // handoff queue, any thread pushes
+    pthread_mutex_t sleep_lock;
+    pthread_cond_t wake;
+
+    // worker only
+    ShardSession **residents;
+    int resident_count;
+    int resident_capacity;
+
+    // written by the worker, read by shard_stats
+    unsigned long long fights;
+    unsigned long long arrivals;
+    unsigned long long departures;
+} __attribute__((aligned(64))) Shard;
+
+static Shard g_shards[SHARD_MAX];
+static int g_shard_count = 0;
+static int g_partitions = 1;
+static int g_difficulty = 1;
+static bool g_running = false;
+static ShardSession *g_done = NULL; // finished sessions, lock-free stack too
+
+// FNV-1a like everywhere else
+static unsigned int hash_string(const char *text) {
+    unsigned int h = 2166136261u;
+    for (; *text; text++) {
+        h ^= (unsigned char)*text;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// which shard a player belongs on
+static Shard *shard_for(const Player *player) {
+    int area = player->area_level;
+    if (area < 1) area = 1;
+    if (area > CONTENT_AREAS) area = CONTENT_AREAS;
+    int partition = g_partitions > 1 ? (int)(hash_string(player->name) % g_partitions) : 0;
+    return &g_shards[(area - 1) * g_partitions + partition];
+}
+
+// push onto a lock-free stack, true if it was empty before
+// (the old head is kept in a local, once the CAS lands the session
+// belongs to whoever pops it and ->next can change under us)
+static bool push_session(ShardSession **stack, ShardSession *session) {
+    ShardSession *head = __atomic_load_n(stack, __ATOMIC_RELAXED);
+    do {
+        session->next = head;
+    } while (!__atomic_compare_exchange_n(stack, &head, session, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    return head == NULL;
+}
+
+static void handoff(Shard *shard, ShardSession *session) {
+    if (push_session(&shard->inbox, session)) {
+        // might be asleep, taking the lock means it's either still
+        // checking the queue or already waiting for this signal
+        pthread_mutex_lock(&shard->sleep_lock);
+        pthread_cond_signal(&shard->wake);
+        pthread_mutex_unlock(&shard->sleep_lock);
+    }
+}
+
+// move everything in the handoff queue onto the resident list, oldest first
+static void adopt_arrivals(Shard *shard) {
+    ShardSession *stack = __atomic_exchange_n(&shard->inbox, NULL, __ATOMIC_ACQUIRE);
+    ShardSession *ordered = NULL;
+    while (stack != NULL) {
+        ShardSession *next = stack->next;
+        stack->next = ordered;
+        ordered = stack;
+        stack = next;
+    }
+
+    for (; ordered != NULL; ordered = ordered->next) {
+        if (shard->resident_count == shard->resident_capacity) {
+            int capacity = shard->resident_capacity == 0 ? 64 : shard->resident_capacity * 2;
+            ShardSession **bigger = realloc(shard->residents, sizeof(ShardSession *) * capacity);
+            if (bigger == NULL) {
+                // cant keep it, send it back out rather than lose it
+                fprintf(stderr, "Error: Area %d shard is out of memory\n", shard->area);
+                ShardSession *rest = ordered;
+                while (rest != NULL) {
+                    ShardSession *next = rest->next;
+                    push_session(&g_done, rest);
+                    rest = next;
+                }
+                return;
+            }
+            shard->residents = bigger;
+            shard->resident_capacity = capacity;
+        }
+        shard->residents[shard->resident_count++] = ordered;
+        __atomic_store_n(&shard->arrivals, shard->arrivals + 1, __ATOMIC_RELAXED);
+    }
+}
+
+// take residents[index] off the list (last one fills the hole)
+static ShardSession *remove_resident(Shard *shard, int index) {
+    ShardSession *session = shard->residents[index];
+    shard->residents[index] = shard->residents[--shard->resident_count];
+    return session;
+}
+
+// one fight for one session, like picking "Fight monster" after resting up
+// returns false if the session left the shard
+static bool play_fight(Shard *shard, int index) {
+    ShardSession *session = shard->residents[index];
+    Player *player = session->player;
+
+    if (session->fights_left <= 0 || player->hp <= 0) {
+        push_session(&g_done, remove_resident(shard, index));
+        return false;
+    }
+
+    Enemy enemy;
+    memset(&enemy, 0, sizeof(enemy));
+    enum EnemyType type = spawn_pick(shard->area, &shard->rng);
+    enemy_stats(&enemy, type, player->level, g_difficulty);
+
+    player->hp = player->maxHp;
+    CombatPolicy policy = COMBAT_POLICY_ATTACK;
+    policy.seed = rng_next(&shard->rng); // the enemy ai rolls off the shard's dice
+    CombatResult result = combat_resolve(player, &enemy, &policy);
+    player->hp = result.player_hp;
+    mark_player_dirty(player, DIRTY_HP);
+    session->fights++;
+    session->fights_left--;
+    __atomic_store_n(&shard->fights, shard->fights + 1, __ATOMIC_RELAXED);
+
+    if (result.winner == COMBAT_PLAYER_WON) {
+        grant_enemy_rewards(player, &enemy);
+        broadcast_publish(shard->area, BROADCAST_KILL, "%s (Level %d) defeated a Level %d %s",
+                          player->name, player->level, enemy.level, content_get()->enemies[type].name);
+    }
+
+    // high enough for the next area, off they go
+    if (player->hp > 0 && player->area_level < CONTENT_AREAS &&
+        player->level >= player->area_level + 1) {
+        player->area_level++;
+        mark_player_dirty(player, DIRTY_AREA);
+        session->moves++;
+        remove_resident(shard, index);
+        __atomic_store_n(&shard->departures, shard->departures + 1, __ATOMIC_RELAXED);
+        handoff(shard_for(player), session);
+        return false;
+    }
+    return true;
+}
+
+static void *shard_worker(void *arg) {
+    Shard *shard = arg;
+
+    while (__atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) {
+        adopt_arrivals(shard);
+
+        if (shard->resident_count == 0) {
+            pthread_mutex_lock(&shard->sleep_lock);
+            while (__atomic_load_n(&shard->inbox, __ATOMIC_ACQUIRE) == NULL &&
+                   __atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) {
+                pthread_cond_wait(&shard->wake, &shard->sleep_lock);
+            }
+            pthread_mutex_unlock(&shard->sleep_lock);
+            continue;
+        }
+
+        // backwards so removing one doesnt skip the next
+        for (int i = shard->resident_count - 1; i >= 0; i--) {
+            play_fight(shard, i);
+        }
+    }
+    return NULL;
+}
+
+bool shard_start(int partitions, int difficulty, unsigned int seed) {
+    if (g_running) {
+        fprintf(stderr, "Error: Shards are already running\n");
+        return false;
+    }
+    if (partitions < 1 || partitions > SHARD_MAX_PARTITIONS) {
+        fprintf(stderr, "Error: Shard partitions must be 1-%d\n", SHARD_MAX_PARTITIONS);
+        return false;
+    }
+
+    g_partitions = partitions;
+    g_difficulty = difficulty >= 0 ? difficulty : config_get()->difficulty;
+    if (g_difficulty < 0 || g_difficulty >= CONTENT_DIFFICULTIES) g_difficulty = 1;
+    g_shard_count = CONTENT_AREAS * partitions;
+    __atomic_store_n(&g_running, true, __ATOMIC_RELEASE);
+
+    for (int i = 0; i < g_shard_count; i++) {
+        Shard *shard = &g_shards[i];
+        memset(shard, 0, sizeof(Shard));
+        shard->area = i / partitions + 1;
+        shard->partition = i % partitions;
+        shard->rng = rng_seed(rng_hash(seed, (unsigned int)i));
+        pthread_mutex_init(&shard->sleep_lock, NULL);
+        pthread_cond_init(&shard->wake, NULL);
+    }
+
+    for (int i = 0; i < g_shard_count; i++) {
+        if (pthread_create(&g_shards[i].thread, NULL, shard_worker, &g_shards[i]) != 0) {
+            fprintf(stderr, "Error: Could not start shard worker %d\n", i);
+            g_shard_count = i;
+            shard_stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool shard_submit(ShardSession *session) {
+    if (session == NULL || session->player == NULL || session->player->name == NULL) return false;
+    if (!__atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) return false;
+    handoff(shard_for(session->player), session);
+    return true;
+}
+
+ShardSession *shard_collect() {
+    return __atomic_exchange_n(&g_done, NULL, __ATOMIC_ACQUIRE);
+}
+
+void shard_stop() {
+    if (!__atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) return;
+    __atomic_store_n(&g_running, false, __ATOMIC_RELEASE);
+
+    for (int i = 0; i < g_shard_count; i++) {
+        Shard *shard = &g_shards[i];
+        pthread_mutex_lock(&shard->sleep_lock);
+        pthread_cond_signal(&shard->wake);
+        pthread_mutex_unlock(&shard->sleep_lock);
+        pthread_join(shard->thread, NULL);
+    }
+
+    // all quiet now, whatever is left goes back to the caller
+    for (int i = 0; i < g_shard_count; i++) {
+        Shard *shard = &g_shards[i];
+        adopt_arrivals(shard);
+        while (shard->resident_count > 0) {
+            push_session(&g_done, remove_resident(shard, shard->resident_count - 1));
+        }
+        free(shard->residents);
+        shard->residents = NULL;
+        shard->resident_capacity = 0;
+        pthread_mutex_destroy(&shard->sleep_lock);
+        pthread_cond_destroy(&shard->wake);
+    }
+    g_shard_count = 0;
+}
+
+int shard_count() {
+    return __atomic_load_n(&g_running, __ATOMIC_ACQUIRE) ? g_shard_count : 0;
+}
+
+bool shard_stats(int index, ShardStats *stats) {
+    if (stats == NULL || index < 0 || index >= shard_count()) return false;
+    const Shard *shard = &g_shards[index];
+    stats->area = shard->area;
+    stats->partition = shard->partition;
+    stats->residents = __atomic_load_n(&shard->resident_count, __ATOMIC_RELAXED);
+    stats->fights = __atomic_load_n(&shard->fights, __ATOMIC_RELAXED);
+    stats->arrivals = __atomic_load_n(&shard->arrivals, __ATOMIC_RELAXED);
+    stats->departures = __atomic_load_n(&shard->departures, __ATOMIC_RELAXED);
+    return true;
+}
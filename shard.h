@@ -0,0 +1,59 @@
+// shard.h - Sessions run by area, one worker thread per area (or per slice of one)
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <stdbool.h>
+#include "player.h"
+#include "content.h" // CONTENT_AREAS
+
+// a busy area can be split between this many workers (by player name)
+#define SHARD_MAX_PARTITIONS 8
+#define SHARD_MAX (CONTENT_AREAS * SHARD_MAX_PARTITIONS)
+
+// A player being run by a shard. The shard owns it (and its player) from
+// shard_submit until it comes back out of shard_collect, nothing else
+// should touch either in between.
+typedef struct ShardSession {
+    Player *player;
+    int fights_left;    // stops after this many fights (or when they die)
+    int fights;         // played so far
+    int moves;          // shards it went through after the first
+    struct ShardSession *next; // handoff / collect lists
+} ShardSession;
+
+typedef struct {
+    int area;
+    int partition;
+    int residents;                 // sessions living here right now
+    unsigned long long fights;
+    unsigned long long arrivals;   // sessions handed in (submitted or moved)
+    unsigned long long departures; // moved on to the next area
+} ShardStats;
+
+// Start a worker for every area (partitions workers each, 1 = one per
+// area). Each worker has its own spawn rng and session list and only
+// talks to the others through their handoff queues.
+// difficulty -1 = whatever the config says
+bool shard_start(int partitions, int difficulty, unsigned int seed);
+
+// Hand a session to the shard for its player's area_level, safe from any
+// thread without a lock. Every tick the shard gives each of its sessions a
+// fight in its area (full hp, attacks only, same rewards as the game),
+// and when they're high enough level for the next area ("Move to next
+// area") they go there through that shard's handoff queue.
+bool shard_submit(ShardSession *session);
+
+// sessions that ran out of fights or died, as a list through ->next
+// (NULL if none yet), safe from any thread
+ShardSession *shard_collect();
+
+// stop every worker, sessions still running go on the collect list
+void shard_stop();
+
+// number of shards running (areas * partitions), 0 if stopped
+int shard_count();
+
+// how one shard is doing (index 0 .. shard_count()-1)
+bool shard_stats(int index, ShardStats *stats);
+
+#endif // SHARD_H
@@ -0,0 +1,187 @@
+// spawn.c - Per area spawn tables
+//
+// Spawn lines live in the content tables. At startup every (area, when)
+// group becomes an alias table, with the enemy type for both sides of each
+// column stored right next to the threshold so a pick is one lookup. Which
+// table is live gets decided per pick (or once per batch): the configured
+// event if the area has a table for it, then day/night, then the normal one.
+#include "spawn.h"
+#include "alias.h"
+#include "config.h"
+#include "content.h"
+#include "rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    char when[CONTENT_NAME_LENGTH]; // "" = normal table
+    int count;
+    uint32_t *threshold;
+    int *keep_type;  // column's own enemy type
+    int *alias_type; // enemy type of the column's alias
+} SpawnTable;
+
+typedef struct {
+    SpawnTable *tables;
+    int table_count;
+    bool has_day_night; // only look at the clock if it matters
+} AreaSpawns;
+
+static AreaSpawns g_areas[CONTENT_AREAS];
+
+static const SpawnTable *find_table(const AreaSpawns *spawns, const char *when) {
+    for (int i = 0; i < spawns->table_count; i++) {
+        if (strcmp(spawns->tables[i].when, when) == 0) return &spawns->tables[i];
+    }
+    return NULL;
+}
+
+// alias table for one area + when, false if there's nothing to pick from
+static bool build_table(SpawnTable *table, const ContentTables *content, int area,
+                        const char *when, int *weights, int *types) {
+    int count = 0;
+    for (int i = 0; i < content->spawn_count; i++) {
+        const SpawnEntry *entry = &content->spawns[i];
+        if (entry->area != area || strcmp(entry->when, when) != 0) continue;
+        weights[count] = entry->weight;
+        types[count] = entry->enemy_type;
+        count++;
+    }
+
+    AliasTable alias;
+    if (!alias_build(&alias, weights, count)) return false;
+
+    memset(table, 0, sizeof(*table));
+    strncpy(table->when, when, CONTENT_NAME_LENGTH - 1);
+    table->keep_type = malloc(sizeof(int) * count);
+    table->alias_type = malloc(sizeof(int) * count);
+    if (table->keep_type == NULL || table->alias_type == NULL) {
+        free(table->keep_type);
+        free(table->alias_type);
+        alias_free(&alias);
+        return false;
+    }
+    for (int column = 0; column < count; column++) {
+        table->keep_type[column] = types[column];
+        table->alias_type[column] = types[alias.alias[column]];
+    }
+    // keep the thresholds, the alias indexes are baked into alias_type now
+    table->threshold = alias.threshold;
+    table->count = count;
+    free(alias.alias);
+    return true;
+}
+
+bool spawn_init() {
+    spawn_shutdown(); // in case it's a rebuild
+
+    const ContentTables *content = content_get();
+    int *weights = malloc(sizeof(int) * CONTENT_SPAWN_MAX);
+    int *types = malloc(sizeof(int) * CONTENT_SPAWN_MAX);
+    bool ok = weights != NULL && types != NULL;
+
+    for (int area = 1; ok && area <= CONTENT_AREAS; area++) {
+        AreaSpawns *spawns = &g_areas[area - 1];
+        // at most one table per line, usually just one
+        spawns->tables = malloc(sizeof(SpawnTable) * (content->spawn_count + 1));
+        if (spawns->tables == NULL) {
+            ok = false;
+            break;
+        }
+
+        for (int i = 0; i < content->spawn_count; i++) {
+            const SpawnEntry *entry = &content->spawns[i];
+            if (entry->area != area || find_table(spawns, entry->when) != NULL) continue;
+            SpawnTable *table = &spawns->tables[spawns->table_count];
+            if (!build_table(table, content, area, entry->when, weights, types)) {
+                continue; // all weights 0, this table just doesnt exist
+            }
+            spawns->table_count++;
+            if (strcmp(entry->when, "day") == 0 || strcmp(entry->when, "night") == 0) {
+                spawns->has_day_night = true;
+            }
+        }
+    }
+
+    free(weights);
+    free(types);
+    if (!ok) {
+        fprintf(stderr, "Error: Could not build spawn tables.\n");
+        spawn_shutdown();
+    }
+    return ok;
+}
+
+void spawn_shutdown() {
+    for (int area = 0; area < CONTENT_AREAS; area++) {
+        AreaSpawns *spawns = &g_areas[area];
+        for (int i = 0; i < spawns->table_count; i++) {
+            free(spawns->tables[i].threshold);
+            free(spawns->tables[i].keep_type);
+            free(spawns->tables[i].alias_type);
+        }
+        free(spawns->tables);
+        spawns->tables = NULL;
+        spawns->table_count = 0;
+        spawns->has_day_night = false;
+    }
+}
+
+// night is 20:00 to 6:00 local time
+static bool is_night() {
+    time_t now = time(NULL);
+    struct tm local;
+    if (localtime_r(&now, &local) == NULL) return false;
+    return local.tm_hour >= 20 || local.tm_hour < 6;
+}
+
+static const SpawnTable *active_table(int area_level) {
+    if (area_level < 1 || area_level > CONTENT_AREAS) return NULL;
+    const AreaSpawns *spawns = &g_areas[area_level - 1];
+    const SpawnTable *table = NULL;
+
+    const char *event = config_get()->event;
+    if (event[0] != '\0') table = find_table(spawns, event);
+    if (table == NULL && spawns->has_day_night) table = find_table(spawns, is_night() ? "night" : "day");
+    if (table == NULL) table = find_table(spawns, "");
+    return table;
+}
+
+const char *spawn_active_table(int area_level) {
+    const SpawnTable *table = active_table(area_level);
+    return table != NULL ? table->when : "";
+}
+
+enum EnemyType spawn_pick(int area_level, unsigned int *rng_state) {
+    const SpawnTable *table = active_table(area_level);
+    if (table == NULL) return GOBLIN; // no table, goblins it is
+
+    uint32_t a = rng_next(rng_state);
+    uint32_t b = rng_next(rng_state);
+    int column = (int)(((uint64_t)a * (uint32_t)table->count) >> 32);
+    return (enum EnemyType)(b < table->threshold[column] ? table->keep_type[column] : table->alias_type[column]);
+}
+
+void spawn_pick_batch(int area_level, enum EnemyType *restrict out, int count, unsigned int seed) {
+    const SpawnTable *table = active_table(area_level);
+    if (table == NULL) {
+        for (int i = 0; i < count; i++) out[i] = GOBLIN;
+        return;
+    }
+
+    // pull everything into locals so the loop is just math and loads
+    const uint32_t *threshold = table->threshold;
+    const int *keep_type = table->keep_type;
+    const int *alias_type = table->alias_type;
+    uint64_t columns = (uint32_t)table->count;
+    for (int i = 0; i < count; i++) {
+        uint32_t a = rng_hash(seed, 2u * (unsigned int)i);
+        uint32_t b = rng_hash(seed, 2u * (unsigned int)i + 1u);
+        int column = (int)(((uint64_t)a * columns) >> 32);
+        int keep = keep_type[column];
+        int other = alias_type[column];
+        out[i] = (enum EnemyType)(b < threshold[column] ? keep : other);
+    }
+}
@@ -0,0 +1,28 @@
+// spawn.h - Per area spawn tables
+#ifndef SPAWN_H
+#define SPAWN_H
+
+#include <stdbool.h>
+#include "enemy.h"
+
+// build the alias tables for every area (and every day/night/event
+// override) from the current content tables, call after content_load
+bool spawn_init();
+
+// free the tables, spawns fall back to goblins until spawn_init runs again
+void spawn_shutdown();
+
+// which enemy shows up in an area, O(1) whatever the table size
+// random numbers come from *rng_state (see rng.h)
+enum EnemyType spawn_pick(int area_level, unsigned int *rng_state);
+
+// Pick count enemy types at once into out. Picks only depend on seed and
+// their position (no state carried between them) and the loop has no
+// branches, so the compiler can vectorize it. The active table is looked
+// up once for the whole batch.
+void spawn_pick_batch(int area_level, enum EnemyType *restrict out, int count, unsigned int seed);
+
+// the override an area is using right now ("" = the normal table)
+const char *spawn_active_table(int area_level);
+
+#endif // SPAWN_H
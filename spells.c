@@ -0,0 +1,197 @@
+// spells.c - Table driven spell engine
+//
+// Every spell is a SpellDesc (behaviour, here) plus a SpellDef (numbers,
+// from the content tables). Casting looks both up instead of switching on
+// the spell type, and spell_resolve_batch flattens them into one small
+// table per batch so resolving thousands of casts is a tight loop.
+#include "spells.h"
+#include "config.h"
+#include "content.h"
+#include "rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const SpellDesc SPELL_DESCS[CONTENT_SPELLS] = {
+    { FIRE_SPELL, SPELL_EFFECT_DAMAGE, SPELL_EXTRA_BURN, "intensity",
+      "Flames burn for %d turns!", 10, false, "🔥🔥🔥 IT'S SUPER EFFECTIVE! 🔥🔥🔥" },
+    { ICE_SPELL, SPELL_EFFECT_DAMAGE, SPELL_EXTRA_FREEZE, "radius",
+      NULL, 5, false, "❄️❄️❄️ WINTER IS COMING! ❄️❄️❄️" },
+    { LIGHTNING_SPELL, SPELL_EFFECT_DAMAGE, SPELL_EXTRA_CHAIN, "power",
+      "Lightning chains to %d additional targets!", 3, true, "⚡⚡⚡ UNLIMITED POWER! ⚡⚡⚡" },
+    { HEAL_SPELL, SPELL_EFFECT_HEAL, SPELL_EXTRA_HOT, "power",
+      "Healing continues for %d turns.", 5, false, "✨✨✨ WELLNESS INTENSIFIES! ✨✨✨" },
+    { RANDOM_SPELL, SPELL_EFFECT_CHAOS, SPELL_EXTRA_NONE, NULL,
+      NULL, 0, false, NULL }
+};
+
+// silly things chaos magic does (easter eggs on)
+static const char *CHAOS_EFFECTS[] = {
+    "turns target into a sheep",
+    "summons dancing skeletons",
+    "creates a pizza out of thin air",
+    "makes everything smell like elderberries",
+    "plays elevator music from nowhere",
+    "causes target to speak in rhymes",
+    "changes gravity direction temporarily"
+};
+
+// a spell's numbers with config already folded in
+typedef struct {
+    int base;
+    int scale;
+    int param_min, param_max;
+    int clamp;  // 0 = no limits on power
+    int range;  // random part, 0 = none
+    int pct;    // difficulty multiplier in percent (100 for heals)
+} ResolvedSpell;
+
+const SpellDesc *spell_desc(SpellType type) {
+    if ((int)type < 0 || (int)type >= CONTENT_SPELLS) return NULL;
+    return &SPELL_DESCS[type];
+}
+
+static void resolve_spell(ResolvedSpell *out, SpellType type, const ContentTables *content,
+                          const GameConfig *config) {
+    const SpellDef *def = &content->spells[type];
+    out->base = def->base;
+    out->scale = def->scale;
+    out->param_min = def->param_min;
+    out->param_max = def->param_max;
+    out->clamp = def->param_min != 0 || def->param_max != 0;
+    out->range = config->easter_eggs ? def->random_range : def->dull_random_range;
+    out->pct = 100;
+    if (SPELL_DESCS[type].effect != SPELL_EFFECT_HEAL &&
+        config->difficulty >= 0 && config->difficulty < CONTENT_DIFFICULTIES) {
+        out->pct = content->difficulty[config->difficulty].spell_damage_pct;
+    }
+}
+
+static int clamp_power(const ResolvedSpell *spell, int power) {
+    if (!spell->clamp) return power;
+    if (power < spell->param_min) return spell->param_min;
+    if (power > spell->param_max) return spell->param_max;
+    return power;
+}
+
+// base + scale * power + roll % range, before the difficulty multiplier
+static int raw_amount(const ResolvedSpell *spell, int power, unsigned int roll) {
+    int amount = spell->base + spell->scale * power;
+    if (spell->range > 0) amount += (int)(roll % (unsigned int)spell->range);
+    return amount;
+}
+
+bool spell_is_random(SpellType type) {
+    if (spell_desc(type) == NULL) return false;
+    ResolvedSpell spell;
+    resolve_spell(&spell, type, content_get(), config_get());
+    return spell.range > 0;
+}
+
+int cast_spell_typed(Player *caster, Enemy *target, const SpellCast *cast) {
+    if (caster == NULL || cast == NULL) {
+        log_event(LOG_ERROR, "Null caster trying to cast spell");
+        return 0;
+    }
+
+    // only mages can cast spells duh
+    if (caster->playerClass != MAGE) {
+        printf("%s tries to cast a spell but isn't a mage! Nothing happens.\n", caster->name);
+        return 0;
+    }
+
+    const SpellDesc *desc = spell_desc(cast->spell);
+    if (desc == NULL) {
+        log_event(LOG_ERROR, "Unknown spell type %d", (int)cast->spell);
+        return 0;
+    }
+
+    // one snapshot for the whole cast so a reload cant change things halfway
+    const GameConfig *config = config_get();
+    const ContentTables *content = content_get();
+    const char *spell_name = content->spells[cast->spell].name;
+    const char *target_name = target != NULL ? target->name : "nothing";
+
+    ResolvedSpell spell;
+    resolve_spell(&spell, cast->spell, content, config);
+
+    // cap values cuz people will try to cheat
+    int power = clamp_power(&spell, cast->power);
+
+    if (desc->effect == SPELL_EFFECT_CHAOS) {
+        // completely random spell with random effects lol
+        if (config->easter_eggs) {
+            int effect_index = rand() % (sizeof(CHAOS_EFFECTS) / sizeof(CHAOS_EFFECTS[0]));
+            int damage = raw_amount(&spell, power, spell.range > 0 ? (unsigned int)rand() : 0);
+            printf("%s casts %s at %s!\n", caster->name, spell_name, target_name);
+            printf("Random effect: %s\n", CHAOS_EFFECTS[effect_index]);
+            log_event(LOG_FUNNY, "Random spell cast: %s (dmg=%d)", CHAOS_EFFECTS[effect_index], damage);
+            return damage * spell.pct / 100;
+        }
+        printf("%s tries to cast random magic, but nothing interesting happens.\n", caster->name);
+        return raw_amount(&spell, power, spell.range > 0 ? (unsigned int)rand() : 0) * spell.pct / 100;
+    }
+
+    int amount = raw_amount(&spell, power, spell.range > 0 ? (unsigned int)rand() : 0);
+
+    // the "casts" line, ice also shows its freeze chance
+    if (desc->effect == SPELL_EFFECT_HEAL) {
+        printf("%s casts %s (%s: %d) on self!\n", caster->name, spell_name, desc->param_label, power);
+    } else if (desc->extra == SPELL_EXTRA_FREEZE) {
+        printf("%s casts %s (%s: %d, freeze: %.1f%%) at %s!\n", caster->name, spell_name,
+               desc->param_label, power, cast->chance * 100, target_name);
+    } else {
+        printf("%s casts %s (%s: %d) at %s!\n", caster->name, spell_name, desc->param_label, power, target_name);
+    }
+    if (desc->extra_text != NULL) {
+        printf(desc->extra_text, cast->extra);
+        printf("\n");
+    }
+
+    if (desc->effect == SPELL_EFFECT_HEAL) {
+        // actually heal the player
+        caster->hp += amount;
+        if (caster->hp > caster->maxHp) {
+            caster->hp = caster->maxHp; // dont overheal
+        }
+        mark_player_dirty(caster, DIRTY_HP);
+    }
+
+    // easter egg for big spells
+    int easter_value = desc->easter_on_extra ? cast->extra : power;
+    if (config->easter_eggs && desc->easter_threshold > 0 && easter_value >= desc->easter_threshold) {
+        printf("%s\n", desc->easter_text);
+    }
+
+    log_event(LOG_DEBUG, "Cast %s amount=%d, %s=%d, extra=%d",
+              spell_name, amount, desc->param_label, power, cast->extra);
+
+    // apply difficulty modifier to damage (heals have pct 100)
+    return amount * spell.pct / 100;
+}
+
+void spell_resolve_batch(const SpellCast *casts, int count, int *amounts,
+                         unsigned int *rng_state) {
+    if (casts == NULL || amounts == NULL || count <= 0) return;
+
+    // fold config + content into one tiny table up front, the loop below
+    // then only touches the casts, this table and the output
+    const GameConfig *config = config_get();
+    const ContentTables *content = content_get();
+    ResolvedSpell table[CONTENT_SPELLS];
+    for (int s = 0; s < CONTENT_SPELLS; s++) {
+        resolve_spell(&table[s], (SpellType)s, content, config);
+    }
+
+    unsigned int state = rng_seed(rng_state != NULL ? *rng_state : 0);
+    for (int i = 0; i < count; i++) {
+        unsigned int type = (unsigned int)casts[i].spell;
+        if (type >= CONTENT_SPELLS) {
+            amounts[i] = 0;
+            continue;
+        }
+        const ResolvedSpell *spell = &table[type];
+        unsigned int roll = spell->range > 0 ? rng_next(&state) : 0;
+        amounts[i] = raw_amount(spell, clamp_power(spell, casts[i].power), roll) * spell->pct / 100;
+    }
+    if (rng_state != NULL) *rng_state = state;
+}
@@ -0,0 +1,63 @@
+// spells.h - Table driven spell engine
+#ifndef SPELLS_H
+#define SPELLS_H
+
+#include <stdbool.h>
+#include "utils.h" // SpellType, Player, Enemy
+
+// what a spell does to its target
+typedef enum {
+    SPELL_EFFECT_DAMAGE, // hits the enemy
+    SPELL_EFFECT_HEAL,   // heals the caster (difficulty doesnt touch it)
+    SPELL_EFFECT_CHAOS   // random damage with a random silly effect
+} SpellEffect;
+
+// the second number a cast carries
+typedef enum {
+    SPELL_EXTRA_NONE,
+    SPELL_EXTRA_BURN,   // burn turns
+    SPELL_EXTRA_FREEZE, // freeze chance (uses SpellCast.chance)
+    SPELL_EXTRA_CHAIN,  // chain targets
+    SPELL_EXTRA_HOT     // heal over time turns
+} SpellExtra;
+
+// How a spell behaves. The numbers (base, scaling, limits) are in the
+// content tables, this is the part that doesnt change between balance passes
+typedef struct {
+    SpellType type;
+    SpellEffect effect;
+    SpellExtra extra;
+    const char *param_label;    // what SpellCast.power means ("intensity"...)
+    const char *extra_text;     // printf format for the extra, one %d (NULL = none)
+    int easter_threshold;       // easter egg when power (or extra) reaches this, 0 = never
+    bool easter_on_extra;       // compare the extra instead of power
+    const char *easter_text;
+} SpellDesc;
+
+// one cast, fully typed (no va_arg guessing)
+typedef struct {
+    SpellType spell;
+    int power;    // intensity / radius / power
+    int extra;    // burn turns / chain targets / heal turns
+    float chance; // freeze chance 0.0-1.0 (ice only)
+} SpellCast;
+
+// descriptor for a spell type, NULL if it's out of range
+const SpellDesc *spell_desc(SpellType type);
+
+// does this spell roll dice with the current config? (false means the
+// same cast always does the same amount)
+bool spell_is_random(SpellType type);
+
+// cast one spell with all the messages (what player_turn uses)
+// heals are applied to the caster, returns the damage dealt (or amount healed)
+int cast_spell_typed(Player *caster, Enemy *target, const SpellCast *cast);
+
+// Resolve lots of casts at once with no printing and no shared state:
+// amounts[i] = damage (difficulty applied) or healing for casts[i].
+// Random rolls come from *rng_state (see rng.h) so threads can each run
+// their own batches. Uses the current config and content tables.
+void spell_resolve_batch(const SpellCast *casts, int count, int *amounts,
+                         unsigned int *rng_state);
+
+#endif // SPELLS_H
@@ -0,0 +1,376 @@
+// stats.c - Low overhead latency histograms and counters
+//
+// Every thread gets its own block of histograms so recording never takes a
+// lock or bounces a cache line. Only the owning thread writes a block; dumps
+// just read them all (relaxed atomics, numbers may be a sample or two behind
+// which is fine for stats).
+//
+// There's no reporter thread on purpose: a second thread makes glibc lock
+// stdio and malloc on every call, which costs more than the stats themselves.
+// SIGUSR1 dumps straight from the signal handler (only write(2) and our own
+// number formatting, so it's async-signal-safe) and the periodic file write
+// piggybacks on whichever stats_record call notices it's due.
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // __rdtsc
+#define STATS_USE_TSC 1
+#endif
+
+// log-linear buckets like HDR histogram: 16 sub-buckets per power of two,
+// so any value is off by at most ~6%
+#define SUB_BITS 4
+#define SUB_COUNT (1 << SUB_BITS)
+#define MAX_MAGNITUDE 47 // biggest power of two we keep apart (~39 hours of ns)
+#define STATS_BUCKETS ((MAX_MAGNITUDE - SUB_BITS + 2) * SUB_COUNT)
+
+bool g_stats_enabled = false;
+
+static const char *STAT_NAMES[STAT_COUNT] = {
+    "combat_turn",
+    "save_game",
+    "load_game",
+    "initialize_enemy",
+    "log_event"
+};
+
+static const char *COUNTER_NAMES[COUNTER_COUNT] = {
+    "combats",
+    "kills",
+    "deaths",
+    "saves_full",
+    "saves_delta",
+    "save_bytes",
+    "trades",
+    "trade_retries",
+    "player_cache_hits",
+    "player_cache_misses"
+};
+
+// one of these per thread that ever recorded something
+typedef struct StatsThread {
+    unsigned long long buckets[STAT_COUNT][STATS_BUCKETS];
+    unsigned long long count[STAT_COUNT];
+    unsigned long long sum[STAT_COUNT];
+    unsigned long long max[STAT_COUNT];
+    long counters[COUNTER_COUNT];
+    struct StatsThread *next;
+} StatsThread;
+
+static __thread StatsThread *t_stats = NULL;
+static StatsThread *g_threads = NULL; // lock-free list of every block
+
+// ns per tick, stored as fixed point (x1024) so the signal handler
+// doesnt need floating point
+static unsigned long long g_ns_per_tick_x1024 = 1024;
+
+// periodic file output
+static char *g_stats_file = NULL;
+static unsigned long long g_interval_ticks = 0;
+static unsigned long long g_next_write = 0;
+
+// single writer so a relaxed load + store is enough (no lock prefix)
+#define BUMP(field, amount) \
+    __atomic_store_n(&(field), __atomic_load_n(&(field), __ATOMIC_RELAXED) + (amount), __ATOMIC_RELAXED)
+
+static unsigned long long clock_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+unsigned long long stats_ticks() {
+#ifdef STATS_USE_TSC
+    return __rdtsc(); // a few ns instead of a clock_gettime call
+#else
+    return clock_ns();
+#endif
+}
+
+// figure out how long a tick is (only matters for the TSC)
+static void calibrate_ticks() {
+#ifdef STATS_USE_TSC
+    unsigned long long ns_start = clock_ns();
+    unsigned long long tick_start = stats_ticks();
+    struct timespec pause = { 0, 20 * 1000000 }; // 20ms is plenty
+    nanosleep(&pause, NULL);
+    unsigned long long ns_elapsed = clock_ns() - ns_start;
+    unsigned long long ticks_elapsed = stats_ticks() - tick_start;
+    if (ticks_elapsed > 0) {
+        g_ns_per_tick_x1024 = ns_elapsed * 1024 / ticks_elapsed;
+        if (g_ns_per_tick_x1024 == 0) g_ns_per_tick_x1024 = 1;
+    }
+#endif
+}
+
+static unsigned long long ticks_to_ns(unsigned long long ticks) {
+    return ticks / 1024 * g_ns_per_tick_x1024 + (ticks % 1024) * g_ns_per_tick_x1024 / 1024;
+}
+
+// which bucket does a value go in
+static int bucket_index(unsigned long long value) {
+    if (value < SUB_COUNT) return (int)value;
+    int msb = 63 - __builtin_clzll(value);
+    if (msb > MAX_MAGNITUDE) {
+        return STATS_BUCKETS - 1; // off the chart, lump it in the top bucket
+    }
+    int shift = msb - SUB_BITS;
+    int sub = (int)((value >> shift) & (SUB_COUNT - 1));
+    return (shift + 1) * SUB_COUNT + sub;
+}
+
+// middle of a bucket, what we report for percentiles
+static unsigned long long bucket_value(int index) {
+    if (index < SUB_COUNT) return (unsigned long long)index;
+    int shift = index / SUB_COUNT - 1;
+    unsigned long long low = (unsigned long long)(SUB_COUNT + index % SUB_COUNT) << shift;
+    return low + ((1ull << shift) >> 1);
+}
+
+// get (or make) this thread's block
+static StatsThread *thread_stats() {
+    if (t_stats != NULL) return t_stats;
+
+    StatsThread *block = calloc(1, sizeof(StatsThread));
+    if (block == NULL) return NULL;
+
+    // push onto the list without a lock so the signal handler can walk it
+    block->next = __atomic_load_n(&g_threads, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&g_threads, &block->next, block, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        // block->next got refreshed, try again
+    }
+
+    t_stats = block;
+    return block;
+}
+
+static void write_stats_file();
+
+void stats_record(StatId id, unsigned long long start, unsigned long long end) {
+    StatsThread *block = thread_stats();
+    if (block == NULL || id >= STAT_COUNT) return;
+
+    unsigned long long ticks = end - start;
+    BUMP(block->buckets[id][bucket_index(ticks)], 1);
+    BUMP(block->count[id], 1);
+    BUMP(block->sum[id], ticks);
+    if (ticks > block->max[id]) {
+        __atomic_store_n(&block->max[id], ticks, __ATOMIC_RELAXED);
+    }
+
+    // time for the periodic file? first thread to bump the deadline writes it
+    unsigned long long due = __atomic_load_n(&g_next_write, __ATOMIC_RELAXED);
+    if (g_stats_file != NULL && end >= due &&
+        __atomic_compare_exchange_n(&g_next_write, &due, end + g_interval_ticks, false,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        write_stats_file();
+    }
+}
+
+void stats_count(CounterId id, long amount) {
+    StatsThread *block = thread_stats();
+    if (block == NULL || id >= COUNTER_COUNT) return;
+    BUMP(block->counters[id], amount);
+}
+
+// ---------------------------------------------------------------------
+// Dump formatting, no stdio or malloc so the signal handler can use it
+// ---------------------------------------------------------------------
+
+typedef struct {
+    char data[4096];
+    size_t len;
+} DumpBuffer;
+
+static void dump_text(DumpBuffer *out, const char *text, int width) {
+    size_t len = strlen(text);
+    for (int pad = width - (int)len; pad > 0 && out->len < sizeof(out->data); pad--) {
+        out->data[out->len++] = ' ';
+    }
+    for (size_t i = 0; i < len && out->len < sizeof(out->data); i++) {
+        out->data[out->len++] = text[i];
+    }
+}
+
+// unsigned number, right aligned in width
+static void dump_number(DumpBuffer *out, unsigned long long value, int width) {
+    char digits[24];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    char text[24];
+    for (int i = 0; i < n; i++) text[i] = digits[n - 1 - i];
+    text[n] = '\0';
+    dump_text(out, text, width);
+}
+
+// nanoseconds shown as microseconds with 2 decimals
+static void dump_us(DumpBuffer *out, unsigned long long ns, int width) {
+    unsigned long long hundredths = (ns + 5) / 10;
+    char text[32];
+    DumpBuffer whole = { {0}, 0 };
+    dump_number(&whole, hundredths / 100, 0);
+    memcpy(text, whole.data, whole.len);
+    text[whole.len] = '.';
+    text[whole.len + 1] = (char)('0' + (hundredths / 10) % 10);
+    text[whole.len + 2] = (char)('0' + hundredths % 10);
+    text[whole.len + 3] = '\0';
+    dump_text(out, text, width);
+}
+
+// value (in ns) at a percentile of one merged histogram
+static unsigned long long percentile_ns(const unsigned long long *buckets, unsigned long long total,
+                                        unsigned long long max, int pct) {
+    if (total == 0) return 0;
+    unsigned long long target = total * pct / 100;
+    if (target < 1) target = 1;
+    unsigned long long seen = 0;
+    for (int b = 0; b < STATS_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= target) return ticks_to_ns(bucket_value(b));
+    }
+    return ticks_to_ns(max);
+}
+
+// merge every thread and format the whole report into out
+static void format_dump(DumpBuffer *out) {
+    static const int PERCENTILES[3] = { 50, 90, 99 };
+    unsigned long long merged[STATS_BUCKETS];
+    StatsThread *head = __atomic_load_n(&g_threads, __ATOMIC_ACQUIRE);
+
+    out->len = 0;
+    dump_text(out, "=== STATS (pid ", 0);
+    dump_number(out, (unsigned long long)getpid(), 0);
+    dump_text(out, ") ===\n", 0);
+    dump_text(out, "name", 0);
+    dump_text(out, "count", 24);
+    dump_text(out, "mean_us", 11);
+    dump_text(out, "p50_us", 11);
+    dump_text(out, "p90_us", 11);
+    dump_text(out, "p99_us", 11);
+    dump_text(out, "max_us", 11);
+    dump_text(out, "\n", 0);
+
+    for (int s = 0; s < STAT_COUNT; s++) {
+        unsigned long long count = 0, sum = 0, max = 0;
+        memset(merged, 0, sizeof(merged));
+        for (StatsThread *t = head; t != NULL; t = t->next) {
+            for (int b = 0; b < STATS_BUCKETS; b++) {
+                merged[b] += __atomic_load_n(&t->buckets[s][b], __ATOMIC_RELAXED);
+            }
+            count += __atomic_load_n(&t->count[s], __ATOMIC_RELAXED);
+            sum += __atomic_load_n(&t->sum[s], __ATOMIC_RELAXED);
+            unsigned long long t_max = __atomic_load_n(&t->max[s], __ATOMIC_RELAXED);
+            if (t_max > max) max = t_max;
+        }
+
+        dump_text(out, STAT_NAMES[s], 0);
+        dump_number(out, count, 28 - (int)strlen(STAT_NAMES[s]));
+        dump_us(out, count > 0 ? ticks_to_ns(sum) / count : 0, 11);
+        for (int p = 0; p < 3; p++) {
+            dump_us(out, percentile_ns(merged, count, max, PERCENTILES[p]), 11);
+        }
+        dump_us(out, ticks_to_ns(max), 11);
+        dump_text(out, "\n", 0);
+    }
+
+    dump_text(out, "counters:", 0);
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        long total = 0;
+        for (StatsThread *t = head; t != NULL; t = t->next) {
+            total += __atomic_load_n(&t->counters[c], __ATOMIC_RELAXED);
+        }
+        dump_text(out, " ", 0);
+        dump_text(out, COUNTER_NAMES[c], 0);
+        dump_text(out, "=", 0);
+        dump_number(out, total < 0 ? 0 : (unsigned long long)total, 0);
+    }
+    dump_text(out, "\n", 0);
+}
+
+void stats_dump(FILE *out) {
+    if (out == NULL) return;
+    DumpBuffer buf;
+    format_dump(&buf);
+    fwrite(buf.data, 1, buf.len, out);
+    fflush(out);
+}
+
+// kill -USR1 <pid> lands here
+static void handle_sigusr1(int sig) {
+    (void)sig;
+    DumpBuffer buf;
+    format_dump(&buf);
+    ssize_t ignored = write(STDERR_FILENO, buf.data, buf.len);
+    (void)ignored;
+}
+
+// overwrite the stats file with the latest numbers (temp + rename so
+// whoever is tailing it never sees half a dump)
+static void write_stats_file() {
+    if (g_stats_file == NULL) return;
+
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", g_stats_file);
+    FILE *file = fopen(tmp_path, "w");
+    if (file == NULL) return;
+    stats_dump(file);
+    fclose(file);
+    rename(tmp_path, g_stats_file);
+}
+
+void stats_init(const char *file, int interval_sec) {
+    if (g_stats_enabled) return;
+
+    calibrate_ticks();
+    if (interval_sec <= 0) interval_sec = 10;
+    g_interval_ticks = (unsigned long long)interval_sec * 1000000000ull * 1024 / g_ns_per_tick_x1024;
+    g_next_write = stats_ticks() + g_interval_ticks;
+    if (file != NULL && file[0] != '\0') {
+        g_stats_file = malloc(strlen(file) + 1);
+        if (g_stats_file != NULL) strcpy(g_stats_file, file);
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_sigusr1;
+    action.sa_flags = SA_RESTART; // dont break the scanf we interrupted
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, NULL);
+
+    g_stats_enabled = true;
+}
+
+void stats_shutdown() {
+    if (!g_stats_enabled) return;
+    g_stats_enabled = false;
+    signal(SIGUSR1, SIG_DFL);
+
+    // final numbers on the way out
+    if (g_stats_file != NULL) {
+        write_stats_file();
+    } else {
+        stats_dump(stderr);
+    }
+
+    StatsThread *t = __atomic_exchange_n(&g_threads, NULL, __ATOMIC_ACQ_REL);
+    while (t != NULL) {
+        StatsThread *next = t->next;
+        free(t);
+        t = next;
+    }
+    t_stats = NULL;
+
+    free(g_stats_file);
+    g_stats_file = NULL;
+}
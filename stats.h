@@ -0,0 +1,66 @@
+// stats.h - Low overhead latency histograms and counters
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// things we time (one histogram each)
+typedef enum {
+    STAT_COMBAT_TURN,      // one turn of start_combat (includes waiting for input)
+    STAT_SAVE_GAME,        // save_game, delta or full
+    STAT_LOAD_GAME,        // load_game incl. journal replay
+    STAT_INITIALIZE_ENEMY, // enemy spawn
+    STAT_LOG_EVENT,        // formatting + printing an enabled log line
+    STAT_COUNT
+} StatId;
+
+// things we just count
+typedef enum {
+    COUNTER_COMBATS,
+    COUNTER_KILLS,
+    COUNTER_DEATHS,
+    COUNTER_SAVES_FULL,
+    COUNTER_SAVES_DELTA,
+    COUNTER_SAVE_BYTES,
+    COUNTER_TRADES,
+    COUNTER_TRADE_RETRIES,
+    COUNTER_PLAYER_CACHE_HITS,
+    COUNTER_PLAYER_CACHE_MISSES,
+    COUNTER_COUNT
+} CounterId;
+
+// global on/off switch, checked before doing anything else
+extern bool g_stats_enabled;
+
+// timestamp in "ticks" (TSC on x86, nanoseconds elsewhere)
+unsigned long long stats_ticks();
+
+// record one sample, start and end are stats_ticks() values
+void stats_record(StatId id, unsigned long long start, unsigned long long end);
+
+// add to a counter
+void stats_count(CounterId id, long amount);
+
+// wrap a hot path like:
+//   unsigned long long t = STATS_TIMER_START();
+//   ...
+//   STATS_TIMER_STOP(STAT_SAVE_GAME, t);
+#define STATS_TIMER_START() (g_stats_enabled ? stats_ticks() : 0)
+#define STATS_TIMER_STOP(id, start) \
+    do { if (g_stats_enabled) stats_record((id), (start), stats_ticks()); } while (0)
+#define STATS_COUNT(id, amount) \
+    do { if (g_stats_enabled) stats_count((id), (amount)); } while (0)
+
+// turn stats on, SIGUSR1 dumps to stderr from then on
+// if file is set the stats are also rewritten there every interval_sec
+// seconds (checked when something gets recorded) and at exit
+void stats_init(const char *file, int interval_sec);
+
+// print every histogram and counter, merged across threads
+void stats_dump(FILE *out);
+
+// final dump (to the file if there is one), free everything
+void stats_shutdown();
+
+#endif // STATS_H
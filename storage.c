@@ -0,0 +1,605 @@
+// storage.c - File and in-memory storage backends
+#include "storage.h"
+#include "save_game.h" // DEFAULT_SAVE_DIR
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>  // For _mkdir on Windows
+#include <io.h>
+#define mkdir(dir, mode) _mkdir(dir)  // Windows doesn't use mode
+#define fsync(fd) _commit(fd)
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// the file backend's list of what a batch is about to do, see file_batch
+#define BATCH_INTENT_FILE DEFAULT_SAVE_DIR "/storage.batch"
+#define BATCH_INTENT_HEADER "# batch v1\n"
+
+// backend save_game/load_game talk to
+static StorageBackend *g_active_backend = NULL;
+static pthread_mutex_t g_backend_lock = PTHREAD_MUTEX_INITIALIZER; // creating/switching it
+static unsigned int g_generation = 0; // bumped on every switch
+
+// ---------------------------------------------------------------------
+// File backend
+// ---------------------------------------------------------------------
+
+// make the directory part of a path if it isnt there yet ("saves/x.csv" -> "saves")
+static void make_parent_dir(const char *path) {
+    const char *slash = strrchr(path, '/');
+    if (slash == NULL || slash == path) return;
+
+    char dir[512];
+    size_t len = (size_t)(slash - path);
+    if (len >= sizeof(dir)) return;
+    memcpy(dir, path, len);
+    dir[len] = '\0';
+
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        printf("Warning: Could not create save directory\n");
+    }
+}
+
+// fopen that creates the save directory the first time it's missing
+static FILE *open_for_write(const char *path, const char *mode) {
+    FILE *file = fopen(path, mode);
+    if (file == NULL && errno == ENOENT) {
+        make_parent_dir(path);
+        file = fopen(path, mode);
+    }
+    return file;
+}
+
+// durable = fsync before closing, so it's really on disk when we return
+static bool write_file(const char *path, const char *mode, const char *data, size_t len, bool durable) {
+    FILE *file = open_for_write(path, mode);
+    if (file == NULL) return false;
+    bool ok = fwrite(data, 1, len, file) == len;
+    if (durable && (fflush(file) != 0 || fsync(fileno(file)) != 0)) ok = false;
+    if (fclose(file) != 0) ok = false;
+    return ok;
+}
+
+// write to a temp file next to it, caller renames it into place
+static bool write_temp(const char *key, const char *data, size_t len, char *tmp_path, size_t tmp_size, bool durable) {
+    int needed = snprintf(tmp_path, tmp_size, "%s.tmp", key);
+    if (needed < 0 || (size_t)needed >= tmp_size) return false;
+    return write_file(tmp_path, "wb", data, len, durable);
+}
+
+// make renames/removes in the directory holding path stick (fsync the dir)
+static bool sync_parent_dir(const char *path) {
+#ifdef _WIN32
+    (void)path;
+    return true;
+#else
+    char dir[512] = ".";
+    const char *slash = strrchr(path, '/');
+    if (slash != NULL) {
+        size_t len = slash == path ? 1 : (size_t)(slash - path);
+        if (len >= sizeof(dir)) return false;
+        memcpy(dir, path, len);
+        dir[len] = '\0';
+    }
+    int fd = open(dir, O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+#endif
+}
+
+// Writers stage in key.tmp, the same name a batch stages in and renames
+// over the key, so every write to the files goes under this lock. There's
+// also only one intent file
+static pthread_mutex_t g_batch_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool finish_batch();
+
+// take g_batch_lock, finishing a batch that didnt get all the way first
+// so its renames cant land on top of newer writes
+static void lock_files() {
+    pthread_mutex_lock(&g_batch_lock);
+    if (!finish_batch()) {
+        fprintf(stderr, "Error: An earlier storage batch still isn't finished.\n");
+    }
+}
+
+// caller holds g_batch_lock
+static bool put_locked(const char *key, const char *data, size_t len) {
+    char tmp_path[600];
+    if (!write_temp(key, data, len, tmp_path, sizeof(tmp_path), false)) return false;
+    // rename is atomic so a crash never leaves half a save
+    if (rename(tmp_path, key) != 0) {
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+static bool file_put(StorageBackend *self, const char *key, const char *data, size_t len) {
+    (void)self;
+    lock_files();
+    bool ok = put_locked(key, data, len);
+    pthread_mutex_unlock(&g_batch_lock);
+    return ok;
+}
+
+static bool file_append(StorageBackend *self, const char *key, const char *data, size_t len) {
+    (void)self;
+    lock_files();
+    bool ok = write_file(key, "ab", data, len, false);
+    pthread_mutex_unlock(&g_batch_lock);
+    return ok;
+}
+
+static char *file_get(StorageBackend *self, const char *key, size_t *len_out) {
+    (void)self;
+    FILE *file = fopen(key, "rb");
+    if (file == NULL) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    char *buf = malloc((size_t)size + 1);
+    if (buf != NULL) {
+        size_t got = fread(buf, 1, (size_t)size, file);
+        buf[got] = '\0';
+        if (len_out != NULL) *len_out = got;
+    }
+    fclose(file);
+    return buf;
+}
+
+static long file_size(StorageBackend *self, const char *key) {
+    (void)self;
+    struct stat st;
+    if (stat(key, &st) != 0) return -1;
+    return (long)st.st_size;
+}
+
+static bool file_exists(StorageBackend *self, const char *key) {
+    return file_size(self, key) >= 0;
+}
+
+static bool file_remove(StorageBackend *self, const char *key) {
+    (void)self;
+    return remove(key) == 0;
+}
+
+// Do what the intent says: "P,key" renames key.tmp over key, "D,key"
+// removes key. Safe to run more than once (a missing .tmp means that
+// rename already happened), so a crash halfway through just means doing
+// it again. Removes the intent file once everything stuck.
+// caller holds g_batch_lock, intent gets chopped up
+static bool apply_intent(char *intent) {
+    bool ok = true;
+    char tmp_path[600];
+    char *save_ptr = NULL;
+    for (char *line = strtok_r(intent, "\n", &save_ptr); line != NULL; line = strtok_r(NULL, "\n", &save_ptr)) {
+        if (line[0] == '#' || line[1] != ',') continue;
+        const char *key = line + 2;
+        if (line[0] == 'P') {
+            int needed = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", key);
+            if (needed < 0 || (size_t)needed >= sizeof(tmp_path)) {
+                ok = false;
+                continue;
+            }
+            if (rename(tmp_path, key) != 0 && errno != ENOENT) ok = false;
+        } else if (line[0] == 'D') {
+            if (remove(key) != 0 && errno != ENOENT) ok = false;
+        }
+        if (!sync_parent_dir(key)) ok = false;
+    }
+
+    if (ok && (remove(BATCH_INTENT_FILE) != 0 || !sync_parent_dir(BATCH_INTENT_FILE))) ok = false;
+    return ok;
+}
+
+// finish whatever batch the intent file on disk describes
+static bool finish_batch() {
+    char *intent = file_get(NULL, BATCH_INTENT_FILE, NULL);
+    if (intent == NULL) return true; // nothing half done
+    bool ok = apply_intent(intent);
+    free(intent);
+    return ok;
+}
+
+// Crash safe, the intent file is what makes it all or nothing:
+//  1. every put goes to key.tmp (appends too, as old value + new data,
+//     so doing one twice cant double it), fsynced
+//  2. the list of renames/deletes goes to the intent file (written to a
+//     temp, fsynced, renamed in, dir fsynced). Once that's on disk the
+//     batch has happened, before that nothing real was touched
+//  3. apply_intent does the renames/deletes and removes the intent file
+// If we die in 3 the next storage_file_create finishes the job. If 3
+// fails for some other reason the batch still counts as done (returns
+// true) and gets finished by the next batch or the next write, readers
+// can see part of it until then.
+// Deleting a key that isnt there is nothing to do, and a batch that only
+// really does one thing is that one plain write (a full save with no
+// journal yet shouldnt pay for five fsyncs).
+static bool file_batch(StorageBackend *self, const StorageOp *ops, int count) {
+    (void)self;
+    char tmp_path[600];
+    bool ok = true;
+
+    lock_files();
+    int real = 0;
+    const StorageOp *only = NULL;
+    for (int i = 0; i < count; i++) {
+        if (ops[i].type == STORAGE_OP_DELETE && file_size(NULL, ops[i].key) < 0) continue;
+        real++;
+        only = &ops[i];
+    }
+    if (real <= 1) {
+        if (only == NULL) ok = true;
+        else if (only->type == STORAGE_OP_PUT) ok = put_locked(only->key, only->data, only->len);
+        else if (only->type == STORAGE_OP_APPEND) ok = write_file(only->key, "ab", only->data, only->len, false);
+        else ok = remove(only->key) == 0 || errno == ENOENT;
+        pthread_mutex_unlock(&g_batch_lock);
+        return ok;
+    }
+
+    // step 1: every put (and append) to a temp file, nothing real touched yet
+    int written = 0;
+    for (; written < count && ok; written++) {
+        const StorageOp *op = &ops[written];
+        if (op->type == STORAGE_OP_PUT) {
+            ok = write_temp(op->key, op->data, op->len, tmp_path, sizeof(tmp_path), true);
+        } else if (op->type == STORAGE_OP_APPEND) {
+            size_t old_len = 0;
+            char *old = file_get(NULL, op->key, &old_len);
+            char *joined = malloc(old_len + op->len + 1);
+            if (joined != NULL) {
+                if (old_len > 0) memcpy(joined, old, old_len);
+                memcpy(joined + old_len, op->data, op->len);
+                ok = write_temp(op->key, joined, old_len + op->len, tmp_path, sizeof(tmp_path), true);
+            } else {
+                ok = false;
+            }
+            free(joined);
+            free(old);
+        }
+    }
+
+    // step 2: the intent file
+    char *intent = NULL;
+    size_t intent_len = 0;
+    if (ok) {
+        size_t capacity = sizeof(BATCH_INTENT_HEADER);
+        for (int i = 0; i < count; i++) capacity += strlen(ops[i].key) + 3;
+        intent = malloc(capacity);
+        ok = intent != NULL;
+    }
+    if (ok) {
+        intent_len = (size_t)sprintf(intent, "%s", BATCH_INTENT_HEADER);
+        for (int i = 0; i < count; i++) {
+            char tag = ops[i].type == STORAGE_OP_DELETE ? 'D' : 'P';
+            intent_len += (size_t)sprintf(intent + intent_len, "%c,%s\n", tag, ops[i].key);
+        }
+        ok = write_temp(BATCH_INTENT_FILE, intent, intent_len, tmp_path, sizeof(tmp_path), true) &&
+             rename(tmp_path, BATCH_INTENT_FILE) == 0 && sync_parent_dir(BATCH_INTENT_FILE);
+    }
+
+    if (!ok) {
+        free(intent);
+        // never committed, clean up the temp files
+        for (int i = 0; i < written; i++) {
+            if (ops[i].type == STORAGE_OP_DELETE) continue;
+            snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", ops[i].key);
+            remove(tmp_path);
+        }
+        snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", BATCH_INTENT_FILE);
+        remove(tmp_path);
+        pthread_mutex_unlock(&g_batch_lock);
+        return false;
+    }
+
+    // step 3: committed, make it real
+    if (!apply_intent(intent)) {
+        fprintf(stderr, "Error: Could not finish a storage batch, it gets retried on the next one.\n");
+    }
+    free(intent);
+    pthread_mutex_unlock(&g_batch_lock);
+    return true;
+}
+
+static void file_destroy(StorageBackend *self) {
+    free(self);
+}
+
+StorageBackend *storage_file_create() {
+    StorageBackend *backend = malloc(sizeof(StorageBackend));
+    if (backend == NULL) return NULL;
+
+    backend->name = "file";
+    backend->put = file_put;
+    backend->append = file_append;
+    backend->get = file_get;
+    backend->exists = file_exists;
+    backend->size = file_size;
+    backend->remove = file_remove;
+    backend->batch = file_batch;
+    backend->destroy = file_destroy;
+
+    // a batch that got cut off by a crash last time
+    lock_files();
+    pthread_mutex_unlock(&g_batch_lock);
+    return backend;
+}
+
+// ---------------------------------------------------------------------
+// Memory backend
+// ---------------------------------------------------------------------
+
+#define MEMORY_BUCKETS 256
+
+// one key in the hash table (chained)
+typedef struct MemoryEntry {
+    char *key;
+    char *data;
+    size_t len;
+    size_t cap;
+    struct MemoryEntry *next;
+} MemoryEntry;
+
+// the base struct has to come first so we can cast back and forth
+typedef struct {
+    StorageBackend base;
+    pthread_mutex_t lock;
+    MemoryEntry *buckets[MEMORY_BUCKETS];
+} MemoryBackend;
+
+// FNV-1a, good enough for save names
+static unsigned int hash_key(const char *key) {
+    unsigned int h = 2166136261u;
+    for (; *key; key++) {
+        h ^= (unsigned char)*key;
+        h *= 16777619u;
+    }
+    return h % MEMORY_BUCKETS;
+}
+
+// find an entry, caller holds the lock
+static MemoryEntry *memory_find(MemoryBackend *mem, const char *key) {
+    for (MemoryEntry *e = mem->buckets[hash_key(key)]; e != NULL; e = e->next) {
+        if (strcmp(e->key, key) == 0) return e;
+    }
+    return NULL;
+}
+
+// find or create, caller holds the lock
+static MemoryEntry *memory_find_or_add(MemoryBackend *mem, const char *key) {
+    MemoryEntry *e = memory_find(mem, key);
+    if (e != NULL) return e;
+
+    e = calloc(1, sizeof(MemoryEntry));
+    if (e == NULL) return NULL;
+    e->key = malloc(strlen(key) + 1);
+    if (e->key == NULL) {
+        free(e);
+        return NULL;
+    }
+    strcpy(e->key, key);
+
+    unsigned int b = hash_key(key);
+    e->next = mem->buckets[b];
+    mem->buckets[b] = e;
+    return e;
+}
+
+// copy data into the entry (at offset), growing it if needed
+static bool memory_write(MemoryEntry *e, size_t offset, const char *data, size_t len) {
+    if (offset + len > e->cap) {
+        size_t new_cap = e->cap == 0 ? 256 : e->cap;
+        while (new_cap < offset + len) new_cap *= 2;
+        char *bigger = realloc(e->data, new_cap);
+        if (bigger == NULL) return false;
+        e->data = bigger;
+        e->cap = new_cap;
+    }
+    memcpy(e->data + offset, data, len);
+    e->len = offset + len;
+    return true;
+}
+
+// unlink and free, caller holds the lock
+static bool memory_unlink(MemoryBackend *mem, const char *key) {
+    MemoryEntry **link = &mem->buckets[hash_key(key)];
+    for (; *link != NULL; link = &(*link)->next) {
+        if (strcmp((*link)->key, key) == 0) {
+            MemoryEntry *dead = *link;
+            *link = dead->next;
+            free(dead->key);
+            free(dead->data);
+            free(dead);
+            return true;
+        }
+    }
+    return false;
+}
+
+// apply one op, caller holds the lock
+static bool memory_apply(MemoryBackend *mem, const StorageOp *op) {
+    if (op->type == STORAGE_OP_DELETE) {
+        memory_unlink(mem, op->key);
+        return true;
+    }
+    MemoryEntry *e = memory_find_or_add(mem, op->key);
+    if (e == NULL) return false;
+    size_t offset = (op->type == STORAGE_OP_APPEND) ? e->len : 0;
+    return memory_write(e, offset, op->data, op->len);
+}
+
+static bool memory_put(StorageBackend *self, const char *key, const char *data, size_t len) {
+    StorageOp op = { STORAGE_OP_PUT, key, data, len };
+    return self->batch(self, &op, 1);
+}
+
+static bool memory_append(StorageBackend *self, const char *key, const char *data, size_t len) {
+    StorageOp op = { STORAGE_OP_APPEND, key, data, len };
+    return self->batch(self, &op, 1);
+}
+
+static char *memory_get(StorageBackend *self, const char *key, size_t *len_out) {
+    MemoryBackend *mem = (MemoryBackend *)self;
+    char *copy = NULL;
+
+    pthread_mutex_lock(&mem->lock);
+    MemoryEntry *e = memory_find(mem, key);
+    if (e != NULL) {
+        copy = malloc(e->len + 1);
+        if (copy != NULL) {
+            if (e->len > 0) memcpy(copy, e->data, e->len);
+            copy[e->len] = '\0';
+            if (len_out != NULL) *len_out = e->len;
+        }
+    }
+    pthread_mutex_unlock(&mem->lock);
+    return copy;
+}
+
+static long memory_size(StorageBackend *self, const char *key) {
+    MemoryBackend *mem = (MemoryBackend *)self;
+    pthread_mutex_lock(&mem->lock);
+    MemoryEntry *e = memory_find(mem, key);
+    long size = e != NULL ? (long)e->len : -1;
+    pthread_mutex_unlock(&mem->lock);
+    return size;
+}
+
+static bool memory_exists(StorageBackend *self, const char *key) {
+    return memory_size(self, key) >= 0;
+}
+
+static bool memory_remove(StorageBackend *self, const char *key) {
+    MemoryBackend *mem = (MemoryBackend *)self;
+    pthread_mutex_lock(&mem->lock);
+    bool found = memory_unlink(mem, key);
+    pthread_mutex_unlock(&mem->lock);
+    return found;
+}
+
+// one lock for the whole batch so readers see all of it or none of it
+static bool memory_batch(StorageBackend *self, const StorageOp *ops, int count) {
+    MemoryBackend *mem = (MemoryBackend *)self;
+    bool ok = true;
+    pthread_mutex_lock(&mem->lock);
+    for (int i = 0; i < count; i++) {
+        if (!memory_apply(mem, &ops[i])) ok = false;
+    }
+    pthread_mutex_unlock(&mem->lock);
+    return ok;
+}
+
+static void memory_destroy(StorageBackend *self) {
+    MemoryBackend *mem = (MemoryBackend *)self;
+    for (int b = 0; b < MEMORY_BUCKETS; b++) {
+        MemoryEntry *e = mem->buckets[b];
+        while (e != NULL) {
+            MemoryEntry *next = e->next;
+            free(e->key);
+            free(e->data);
+            free(e);
+            e = next;
+        }
+    }
+    pthread_mutex_destroy(&mem->lock);
+    free(mem);
+}
+
+StorageBackend *storage_memory_create() {
+    MemoryBackend *mem = calloc(1, sizeof(MemoryBackend));
+    if (mem == NULL) return NULL;
+
+    pthread_mutex_init(&mem->lock, NULL);
+    mem->base.name = "memory";
+    mem->base.put = memory_put;
+    mem->base.append = memory_append;
+    mem->base.get = memory_get;
+    mem->base.exists = memory_exists;
+    mem->base.size = memory_size;
+    mem->base.remove = memory_remove;
+    mem->base.batch = memory_batch;
+    mem->base.destroy = memory_destroy;
+    return &mem->base;
+}
+
+// ---------------------------------------------------------------------
+// Picking a backend
+// ---------------------------------------------------------------------
+
+StorageBackend *storage_create(const char *name) {
+    if (name == NULL || strcmp(name, "file") == 0) {
+        return storage_file_create();
+    }
+    if (strcmp(name, "memory") == 0) {
+        return storage_memory_create();
+    }
+    return NULL;
+}
+
+StorageBackend *storage_active() {
+    // trade/shard/auction threads all get here, only one of them gets to
+    // create the default backend
+    StorageBackend *backend = __atomic_load_n(&g_active_backend, __ATOMIC_ACQUIRE);
+    if (backend != NULL) return backend;
+
+    pthread_mutex_lock(&g_backend_lock);
+    backend = g_active_backend;
+    if (backend == NULL) {
+        backend = storage_file_create();
+        __atomic_store_n(&g_active_backend, backend, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&g_backend_lock);
+
+    if (backend == NULL) {
+        fprintf(stderr, "Fatal Error: Could not create storage backend.\n");
+        exit(1);
+    }
+    return backend;
+}
+
+bool storage_select(const char *name) {
+    StorageBackend *backend = storage_create(name);
+    if (backend == NULL) {
+        return false;
+    }
+    pthread_mutex_lock(&g_backend_lock);
+    StorageBackend *old = g_active_backend;
+    __atomic_store_n(&g_active_backend, backend, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&g_generation, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_backend_lock);
+    if (old != NULL) {
+        old->destroy(old);
+    }
+    return true;
+}
+
+void storage_shutdown() {
+    pthread_mutex_lock(&g_backend_lock);
+    StorageBackend *old = g_active_backend;
+    __atomic_store_n(&g_active_backend, NULL, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&g_generation, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_backend_lock);
+    if (old != NULL) {
+        old->destroy(old);
+    }
+}
+
+unsigned int storage_generation() {
+    return __atomic_load_n(&g_generation, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,86 @@
+// storage.h - Pluggable storage backends for save data
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// what a batch entry does
+typedef enum {
+    STORAGE_OP_PUT,     // replace the whole value
+    STORAGE_OP_APPEND,  // add data to the end (creates if missing)
+    STORAGE_OP_DELETE   // remove the key, missing is fine
+} StorageOpType;
+
+// one entry in a batch
+typedef struct {
+    StorageOpType type;
+    const char *key;
+    const char *data; // ignored for delete
+    size_t len;
+} StorageOp;
+
+// A storage backend is a table of function pointers (a "vtable")
+// keys are save paths like "saves/Bob.csv", values are raw bytes
+typedef struct StorageBackend StorageBackend;
+struct StorageBackend {
+    const char *name;
+
+    // store data under key, replacing what was there
+    bool (*put)(StorageBackend *self, const char *key, const char *data, size_t len);
+
+    // add data to the end of key (journal writes)
+    bool (*append)(StorageBackend *self, const char *key, const char *data, size_t len);
+
+    // get a malloc'd copy of the value (null terminated, caller frees)
+    // returns NULL if the key isnt there
+    char *(*get)(StorageBackend *self, const char *key, size_t *len_out);
+
+    // is the key there?
+    bool (*exists)(StorageBackend *self, const char *key);
+
+    // size of the value in bytes, -1 if missing
+    long (*size)(StorageBackend *self, const char *key);
+
+    // remove a key, returns false if it wasnt there
+    bool (*remove)(StorageBackend *self, const char *key);
+
+    // apply several ops together, all or nothing even across a crash: the
+    // file backend stages them in temp files plus an fsynced intent file
+    // and finishes a cut-off batch on the next start (other threads can
+    // see it half done while it renames). A batch that only really does
+    // one thing (deleting a missing key doesnt count) is just that write.
+    // false = none of it happened
+    bool (*batch)(StorageBackend *self, const StorageOp *ops, int count);
+
+    // free the backend and everything in it
+    void (*destroy)(StorageBackend *self);
+};
+
+// plain files on disk, the key is the path
+StorageBackend *storage_file_create();
+
+// everything in a hash table in memory, gone on exit (benchmarks/tests)
+StorageBackend *storage_memory_create();
+
+// make a backend by name ("file" or "memory"), NULL if unknown
+StorageBackend *storage_create(const char *name);
+
+// the backend save_game/load_game use (file backend if nobody picked one,
+// safe to call from any thread)
+StorageBackend *storage_active();
+
+// switch the active backend by name, false if the name is unknown.
+// The old backend is freed, so do this before other threads start
+// saving (main does it right after reading the options)
+bool storage_select(const char *name);
+
+// free the active backend at exit (same rule as storage_select)
+void storage_shutdown();
+
+// changes every time storage_select/storage_shutdown swaps the backend
+// out, anything caching what's in it starts over when this moves (a new
+// backend can land at the old one's address, so dont compare pointers)
+unsigned int storage_generation();
+
+#endif // STORAGE_H
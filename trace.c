@@ -0,0 +1,244 @@
+// trace.c - Scoped trace spans exported as Chrome trace JSON
+//
+// Each thread appends finished spans to its own chunked buffer, so recording
+// is a clock read and a few stores, no locks. Nothing gets formatted until
+// trace_shutdown() writes the whole thing out as Chrome "complete" events,
+// which chrome://tracing and ui.perfetto.dev both open as a timeline.
+#define _GNU_SOURCE // syscall(SYS_gettid)
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#define TRACE_CHUNK_EVENTS 4096
+#define TRACE_MAX_CHUNKS_PER_THREAD 64 // ~256k spans (6MB) per thread, then we drop
+
+bool g_trace_enabled = false;
+
+typedef struct {
+    const char *name;
+    unsigned long long start;
+    unsigned long long end;
+} TraceEvent;
+
+typedef struct TraceChunk {
+    TraceEvent events[TRACE_CHUNK_EVENTS];
+    int used;
+    struct TraceChunk *next;
+} TraceChunk;
+
+// one of these per thread that ever recorded a span
+typedef struct TraceThread {
+    long tid;
+    char name[32];
+    TraceChunk *first;
+    TraceChunk *current;
+    int chunk_count;
+    unsigned long long dropped;
+    struct TraceThread *next;
+} TraceThread;
+
+static __thread TraceThread *t_trace = NULL;
+static TraceThread *g_trace_threads = NULL; // lock-free list of every buffer
+
+static char *g_trace_file = NULL;
+static char g_process_name[64] = "c-mmo";
+static unsigned long long g_trace_origin = 0; // trace_init time, ts 0 in the file
+
+unsigned long long trace_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// get (or make) this thread's buffer
+static TraceThread *thread_trace() {
+    if (t_trace != NULL) return t_trace;
+
+    TraceThread *block = calloc(1, sizeof(TraceThread));
+    if (block == NULL) return NULL;
+    block->tid = (long)syscall(SYS_gettid);
+    snprintf(block->name, sizeof(block->name), "thread %ld", block->tid);
+
+    block->next = __atomic_load_n(&g_trace_threads, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&g_trace_threads, &block->next, block, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        // block->next got refreshed, try again
+    }
+
+    t_trace = block;
+    return block;
+}
+
+void trace_span(const char *name, unsigned long long start, unsigned long long end) {
+    if (!g_trace_enabled || start == 0) return;
+    TraceThread *block = thread_trace();
+    if (block == NULL) return;
+
+    TraceChunk *chunk = block->current;
+    if (chunk == NULL || chunk->used == TRACE_CHUNK_EVENTS) {
+        // keep a runaway session from eating all the memory
+        if (block->chunk_count >= TRACE_MAX_CHUNKS_PER_THREAD) {
+            block->dropped++;
+            return;
+        }
+        TraceChunk *fresh = malloc(sizeof(TraceChunk));
+        if (fresh == NULL) {
+            block->dropped++;
+            return;
+        }
+        fresh->used = 0;
+        fresh->next = NULL;
+        if (chunk == NULL) {
+            block->first = fresh;
+        } else {
+            chunk->next = fresh;
+        }
+        block->current = fresh;
+        block->chunk_count++;
+        chunk = fresh;
+    }
+
+    TraceEvent *event = &chunk->events[chunk->used++];
+    event->name = name;
+    event->start = start;
+    event->end = end;
+}
+
+void trace_scope_end(TraceScope *scope) {
+    if (scope->start != 0 && g_trace_enabled) {
+        trace_span(scope->name, scope->start, trace_now());
+    }
+}
+
+void trace_set_process_name(const char *name) {
+    if (name == NULL) return;
+    snprintf(g_process_name, sizeof(g_process_name), "c-mmo %s", name);
+}
+
+void trace_set_thread_name(const char *name) {
+    if (!g_trace_enabled || name == NULL) return;
+    TraceThread *block = thread_trace();
+    if (block == NULL) return;
+    snprintf(block->name, sizeof(block->name), "%s", name);
+}
+
+void trace_init(const char *file) {
+    if (g_trace_enabled || file == NULL || file[0] == '\0') return;
+
+    // expand %p to the pid so every session gets its own file
+    char path[512];
+    size_t len = 0;
+    for (const char *c = file; *c != '\0' && len < sizeof(path) - 1; c++) {
+        if (c[0] == '%' && c[1] == 'p') {
+            len += snprintf(path + len, sizeof(path) - len, "%ld", (long)getpid());
+            if (len >= sizeof(path)) len = sizeof(path) - 1;
+            c++;
+        } else {
+            path[len++] = *c;
+        }
+    }
+    path[len] = '\0';
+
+    g_trace_file = malloc(len + 1);
+    if (g_trace_file == NULL) return;
+    strcpy(g_trace_file, path);
+
+    g_trace_origin = trace_now();
+    g_trace_enabled = true;
+    trace_set_thread_name("main");
+}
+
+// json string with the few escapes a name could need
+static void write_json_string(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const char *c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', out);
+            fputc(*c, out);
+        } else if ((unsigned char)*c < 0x20) {
+            fprintf(out, "\\u%04x", (unsigned char)*c);
+        } else {
+            fputc(*c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+// nanoseconds since trace_init as the microseconds chrome wants
+static void write_us(FILE *out, unsigned long long ns) {
+    fprintf(out, "%llu.%03llu", ns / 1000, ns % 1000);
+}
+
+static bool write_trace_file(TraceThread *threads, unsigned long long *spans_out, unsigned long long *dropped_out) {
+    FILE *out = fopen(g_trace_file, "w");
+    if (out == NULL) {
+        fprintf(stderr, "Error: Could not write trace file '%s'.\n", g_trace_file);
+        return false;
+    }
+
+    long pid = (long)getpid();
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":0,\"args\":{\"name\":", pid);
+    write_json_string(out, g_process_name);
+    fprintf(out, "}}");
+
+    for (TraceThread *t = threads; t != NULL; t = t->next) {
+        fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":", pid, t->tid);
+        write_json_string(out, t->name);
+        fprintf(out, "}}");
+
+        for (TraceChunk *chunk = t->first; chunk != NULL; chunk = chunk->next) {
+            for (int i = 0; i < chunk->used; i++) {
+                TraceEvent *event = &chunk->events[i];
+                unsigned long long start = event->start > g_trace_origin ? event->start - g_trace_origin : 0;
+                fprintf(out, ",\n{\"name\":");
+                write_json_string(out, event->name);
+                fprintf(out, ",\"cat\":\"game\",\"ph\":\"X\",\"ts\":");
+                write_us(out, start);
+                fprintf(out, ",\"dur\":");
+                write_us(out, event->end - event->start);
+                fprintf(out, ",\"pid\":%ld,\"tid\":%ld}", pid, t->tid);
+            }
+            *spans_out += chunk->used;
+        }
+        *dropped_out += t->dropped;
+    }
+
+    fprintf(out, "\n]}\n");
+    bool ok = !ferror(out);
+    if (fclose(out) != 0) ok = false;
+    return ok;
+}
+
+void trace_shutdown() {
+    if (!g_trace_enabled) return;
+    g_trace_enabled = false;
+
+    TraceThread *threads = __atomic_exchange_n(&g_trace_threads, NULL, __ATOMIC_ACQ_REL);
+    unsigned long long spans = 0, dropped = 0;
+    if (write_trace_file(threads, &spans, &dropped)) {
+        printf("Trace: wrote %llu spans to %s", spans, g_trace_file);
+        if (dropped > 0) printf(" (%llu dropped, buffer full)", dropped);
+        printf("\n");
+    }
+
+    while (threads != NULL) {
+        TraceThread *next = threads->next;
+        TraceChunk *chunk = threads->first;
+        while (chunk != NULL) {
+            TraceChunk *next_chunk = chunk->next;
+            free(chunk);
+            chunk = next_chunk;
+        }
+        free(threads);
+        threads = next;
+    }
+    t_trace = NULL;
+
+    free(g_trace_file);
+    g_trace_file = NULL;
+}
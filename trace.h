@@ -0,0 +1,47 @@
+// trace.h - Scoped trace spans exported as Chrome trace JSON
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+
+// global on/off switch, spans cost one branch when it's off
+extern bool g_trace_enabled;
+
+// timestamp for spans (nanoseconds, monotonic)
+unsigned long long trace_now();
+
+// record a finished span, name must be a string literal (we keep the pointer)
+void trace_span(const char *name, unsigned long long start, unsigned long long end);
+
+// what TRACE_SCOPE puts on the stack
+typedef struct {
+    const char *name;
+    unsigned long long start; // 0 = tracing was off when the scope opened
+} TraceScope;
+
+// called by the cleanup attribute when a TRACE_SCOPE goes out of scope
+void trace_scope_end(TraceScope *scope);
+
+// time everything from here to the end of the enclosing block:
+//   TRACE_SCOPE("save_game");
+// works with early returns and breaks, the compiler closes the span for us
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) \
+    TraceScope TRACE_CONCAT(trace_scope_, __LINE__) __attribute__((cleanup(trace_scope_end))) = \
+        { (name), g_trace_enabled ? trace_now() : 0 }
+
+// start recording, spans go to file as Chrome trace JSON at trace_shutdown()
+// a "%p" in file is replaced by the pid so several sessions can trace at once
+void trace_init(const char *file);
+
+// label this process in the timeline (the player's name for a game session)
+void trace_set_process_name(const char *name);
+
+// label the calling thread in the timeline
+void trace_set_thread_name(const char *name);
+
+// write the JSON file and free every buffer
+void trace_shutdown();
+
+#endif // TRACE_H
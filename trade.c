@@ -0,0 +1,250 @@
+// trade.c - Player to player trades (gold and items, both ways at once)
+//
+// Every player has a version counter. Even means nobody is changing it,
+// odd means someone has claimed it. A trade reads both versions, claims
+// each one with a single CAS (even -> odd), and if either CAS loses it
+// lets go of what it had and tries again. Nobody ever waits while holding
+// a claim, so two trades going opposite ways can't deadlock, they just
+// retry.
+//
+// With both claimed the offers get checked against what the players
+// actually have right now, so an item traded away a moment ago can't be
+// traded again. Then both sides move and both saves go out in one storage
+// batch (save_game_batch) before the claims are dropped (version + 2). If
+// the batch fails both players get put back the way they were.
+#include "trade.h"
+#include "save_game.h"
+#include "stats.h"
+#include "utils.h"
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+
+static const char *RESULT_NAMES[] = {
+    "ok",
+    "invalid trade",
+    "not enough gold",
+    "item not in inventory",
+    "inventory full",
+    "players busy",
+    "save failed"
+};
+
+// enough to undo a trade if the save fails
+typedef struct {
+    Item *inventory[MAX_INVENTORY_CAPACITY];
+    int inventory_size;
+    int gold;
+    unsigned int dirty;
+    unsigned int dirty_slots;
+} PlayerBackup;
+
+const char *trade_result_name(TradeResult result) {
+    if (result < TRADE_OK || result > TRADE_SAVE_FAILED) return "unknown";
+    return RESULT_NAMES[result];
+}
+
+void trade_side_init(TradeSide *side, Player *player, const char *save_file) {
+    if (side == NULL) return;
+    memset(side, 0, sizeof(TradeSide));
+    side->player = player;
+    side->save_file = save_file;
+}
+
+bool trade_offer_slot(TradeSide *side, int slot) {
+    if (side == NULL || side->player == NULL) return false;
+    if (slot < 0 || slot >= side->player->inventory_size) return false;
+    if (side->item_count >= TRADE_MAX_ITEMS) return false;
+
+    Item *item = side->player->inventory[slot];
+    if (item == NULL) return false;
+    for (int i = 0; i < side->item_count; i++) {
+        if (side->items[i] == item) return false; // already offered
+    }
+    side->items[side->item_count++] = item;
+    return true;
+}
+
+// back off a bit more every time we lose, yielding so whoever holds the
+// claim gets to finish
+static void backoff(int attempt) {
+    int spins = 1 << (attempt < 6 ? attempt : 6);
+    for (int i = 0; i < spins; i++) {
+        sched_yield();
+    }
+}
+
+// try to take the player from an even version we saw to the odd one
+static bool try_claim(Player *player, unsigned int seen) {
+    if (seen & 1u) return false;
+    return __atomic_compare_exchange_n(&player->version, &seen, seen + 1, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+unsigned int player_claim(Player *player) {
+    for (int attempt = 0; ; attempt++) {
+        unsigned int seen = __atomic_load_n(&player->version, __ATOMIC_ACQUIRE);
+        if (try_claim(player, seen)) return seen;
+        backoff(attempt);
+    }
+}
+
+void player_release(Player *player, unsigned int claimed, bool changed) {
+    __atomic_store_n(&player->version, changed ? claimed + 2 : claimed, __ATOMIC_RELEASE);
+}
+
+// where the item sits in the player's inventory, -1 if it doesnt
+static int find_item(const Player *player, const Item *item) {
+    for (int i = 0; i < player->inventory_size; i++) {
+        if (player->inventory[i] == item) return i;
+    }
+    return -1;
+}
+
+// can giver hand over its offer, and can receiver fit it?
+// only called with both players claimed
+static TradeResult check_side(const TradeSide *giver, const TradeSide *receiver) {
+    const Player *from = giver->player;
+    const Player *to = receiver->player;
+
+    if (giver->gold < 0 || giver->item_count < 0 || giver->item_count > TRADE_MAX_ITEMS) {
+        return TRADE_INVALID;
+    }
+    if (from->inventory_capacity > MAX_INVENTORY_CAPACITY) return TRADE_INVALID;
+    if (giver->gold > from->gold) return TRADE_NO_GOLD;
+
+    for (int i = 0; i < giver->item_count; i++) {
+        if (giver->items[i] == NULL || find_item(from, giver->items[i]) < 0) {
+            return TRADE_NO_ITEM;
+        }
+        for (int j = 0; j < i; j++) {
+            if (giver->items[j] == giver->items[i]) return TRADE_INVALID;
+        }
+    }
+
+    // what they keep + what they get
+    int after = to->inventory_size - receiver->item_count + giver->item_count;
+    if (after > to->inventory_capacity) return TRADE_NO_ROOM;
+    return TRADE_OK;
+}
+
+static void backup_player(PlayerBackup *backup, const Player *player) {
+    memcpy(backup->inventory, player->inventory, sizeof(Item *) * player->inventory_size);
+    backup->inventory_size = player->inventory_size;
+    backup->gold = player->gold;
+    backup->dirty = player->dirty;
+    backup->dirty_slots = player->dirty_slots;
+}
+
+static void restore_player(Player *player, const PlayerBackup *backup) {
+    memcpy(player->inventory, backup->inventory, sizeof(Item *) * backup->inventory_size);
+    player->inventory_size = backup->inventory_size;
+    player->gold = backup->gold;
+    player->dirty = backup->dirty;
+    player->dirty_slots = backup->dirty_slots;
+}
+
+// take the offered items out of the giver's inventory, keeping the order
+// of whats left (both sides come out before either goes in, so a full
+// inventory can still swap one for one)
+static void remove_offer(TradeSide *giver) {
+    Player *from = giver->player;
+
+    for (int i = 0; i < giver->item_count; i++) {
+        int slot = find_item(from, giver->items[i]);
+        memmove(&from->inventory[slot], &from->inventory[slot + 1],
+                sizeof(Item *) * (from->inventory_size - slot - 1));
+        from->inventory_size--;
+        from->inventory[from->inventory_size] = NULL;
+        mark_inventory_dirty(from, slot);
+    }
+}
+
+// put the giver's items on the end of the receiver's inventory, and move the gold
+static void add_offer(TradeSide *giver, TradeSide *receiver) {
+    Player *from = giver->player;
+    Player *to = receiver->player;
+
+    for (int i = 0; i < giver->item_count; i++) {
+        to->inventory[to->inventory_size] = giver->items[i];
+        mark_inventory_dirty(to, to->inventory_size);
+        to->inventory_size++;
+    }
+
+    from->gold -= giver->gold;
+    to->gold += giver->gold;
+    if (giver->gold != 0) {
+        mark_player_dirty(from, DIRTY_GOLD);
+        mark_player_dirty(to, DIRTY_GOLD);
+    }
+}
+
+TradeResult trade_execute(TradeSide *a, TradeSide *b) {
+    if (a == NULL || b == NULL || a->player == NULL || b->player == NULL ||
+        a->player == b->player) {
+        return TRADE_INVALID;
+    }
+
+    // always claim in the same order, so two trades between the same pair
+    // fight over the first claim instead of each getting one
+    TradeSide *first = a, *second = b;
+    if ((uintptr_t)b->player < (uintptr_t)a->player) {
+        first = b;
+        second = a;
+    }
+
+    for (int attempt = 0; attempt < TRADE_MAX_RETRIES; attempt++) {
+        if (attempt > 0) {
+            STATS_COUNT(COUNTER_TRADE_RETRIES, 1);
+            backoff(attempt);
+        }
+
+        unsigned int v1 = __atomic_load_n(&first->player->version, __ATOMIC_ACQUIRE);
+        unsigned int v2 = __atomic_load_n(&second->player->version, __ATOMIC_ACQUIRE);
+        if (!try_claim(first->player, v1)) continue;
+        if (!try_claim(second->player, v2)) {
+            player_release(first->player, v1, false);
+            continue;
+        }
+
+        // both ours, nobody can change them until we let go
+        TradeResult result = check_side(a, b);
+        if (result == TRADE_OK) result = check_side(b, a);
+        if (result != TRADE_OK) {
+            player_release(second->player, v2, false);
+            player_release(first->player, v1, false);
+            return result;
+        }
+
+        PlayerBackup backup_a, backup_b;
+        backup_player(&backup_a, a->player);
+        backup_player(&backup_b, b->player);
+
+        remove_offer(a);
+        remove_offer(b);
+        add_offer(a, b);
+        add_offer(b, a);
+
+        Player *players[2] = { a->player, b->player };
+        const char *files[2] = { a->save_file, b->save_file };
+        bool saved = save_game_batch(players, files, 2);
+        if (!saved) {
+            restore_player(a->player, &backup_a);
+            restore_player(b->player, &backup_b);
+        }
+
+        player_release(second->player, v2, saved);
+        player_release(first->player, v1, saved);
+
+        if (!saved) return TRADE_SAVE_FAILED;
+        STATS_COUNT(COUNTER_TRADES, 1);
+        log_event(LOG_DEBUG, "%s traded %d gold + %d items to %s for %d gold + %d items",
+                  a->player->name, a->gold, a->item_count,
+                  b->player->name, b->gold, b->item_count);
+        return TRADE_OK;
+    }
+
+    log_event(LOG_ERROR, "Trade between %s and %s gave up after %d tries",
+              a->player->name, b->player->name, TRADE_MAX_RETRIES);
+    return TRADE_BUSY;
+}
@@ -0,0 +1,60 @@
+// trade.h - Player to player trades (gold and items, both ways at once)
+#ifndef TRADE_H
+#define TRADE_H
+
+#include <stdbool.h>
+#include "player.h"
+
+// most items one side can put up in a single trade
+#define TRADE_MAX_ITEMS 8
+
+// how many times a trade goes back for another try when someone else
+// is in the middle of changing one of the players
+#define TRADE_MAX_RETRIES 10000
+
+typedef enum {
+    TRADE_OK,
+    TRADE_INVALID,      // NULL player, same player twice, bad amounts
+    TRADE_NO_GOLD,      // a side doesnt have the gold it offered
+    TRADE_NO_ITEM,      // an offered item isnt in that inventory (anymore)
+    TRADE_NO_ROOM,      // a side cant fit what it would get
+    TRADE_BUSY,         // ran out of retries
+    TRADE_SAVE_FAILED   // couldnt store it, nothing changed
+} TradeResult;
+
+// what one player hands over
+typedef struct {
+    Player *player;
+    const char *save_file; // NULL = {name}.csv
+    int gold;
+    Item *items[TRADE_MAX_ITEMS]; // pointers into player->inventory
+    int item_count;
+} TradeSide;
+
+// start an empty offer for a player
+void trade_side_init(TradeSide *side, Player *player, const char *save_file);
+
+// put the item in an inventory slot up for trade
+// returns false if the slot is empty or the offer is full
+bool trade_offer_slot(TradeSide *side, int slot);
+
+// Swap both offers in one go, safe to call from any thread with any
+// players. No locks: each player has a version counter, a trade claims
+// both by bumping them to odd (retrying if someone else got there first),
+// checks the offers, moves everything and saves both players in one
+// storage batch before letting go. A failed save puts everything back.
+// Whoever else changes a player while trades can happen has to claim it
+// the same way (player_claim/player_release).
+TradeResult trade_execute(TradeSide *a, TradeSide *b);
+
+// short description of a result ("ok", "not enough gold", ...)
+const char *trade_result_name(TradeResult result);
+
+// claim a player for changes, spins (yielding) until it gets it
+// returns the version to hand back to player_release
+unsigned int player_claim(Player *player);
+
+// done changing, changed = false if nothing was actually touched
+void player_release(Player *player, unsigned int claimed, bool changed);
+
+#endif // TRADE_H
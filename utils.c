@@ -1,4 +1,8 @@
 #include "utils.h"
+#include "stats.h"
+#include "trace.h"
+#include "config.h"
+#include "spells.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,14 +10,9 @@
 #include <ctype.h>
 #include <stdarg.h>
 
-// global variable to store log level from environment
-static int g_log_level = LOG_ERROR | LOG_COMBAT; // default log stuff
-
-// game difficulty (from env)
-static int g_difficulty = 1; // normal difficulty
-
-// enable easter eggs
-static bool g_enable_easter_eggs = true;
+#ifdef __SSE2__
+#include <emmintrin.h> // 16 byte vector compares
+#endif
 
 // this function grabs int from environment... duh
 int get_env_int(const char* var_name, int default_val) {
@@ -49,25 +48,28 @@ bool get_env_bool(const char* var_name, bool default_val) {
 }
 
 // init env variables at start
-void setup_env_variables() {
-    // set log level - example: "GAME_LOG_LEVEL=15" for all logs
-    g_log_level = get_env_int("GAME_LOG_LEVEL", g_log_level);
-    
+// reads them (and the config file) into a fresh config snapshot,
+// nothing calls getenv for settings after this
+bool setup_env_variables(const char *config_file) {
+    // log level - example: "GAME_LOG_LEVEL=15" for all logs
     // game difficulty 1=normal, 0=easy, 2=hard
-    g_difficulty = get_env_int("GAME_DIFFICULTY", g_difficulty);
-    
-    // enable easter eggs and funny stuff
-    g_enable_easter_eggs = get_env_bool("GAME_EASTER_EGGS", g_enable_easter_eggs);
+    // easter eggs and funny stuff - GAME_EASTER_EGGS
+    bool ok = config_load(config_file);
     
     // log settings if debug is on
-    log_event(LOG_DEBUG, "Log level set to 0x%X", g_log_level);
-    log_event(LOG_DEBUG, "Game difficulty set to %d", g_difficulty);
-    log_event(LOG_DEBUG, "Easter eggs: %s", g_enable_easter_eggs ? "ON" : "OFF");
+    const GameConfig *config = config_get();
+    log_event(LOG_DEBUG, "Log level set to 0x%X", config->log_level);
+    log_event(LOG_DEBUG, "Game difficulty set to %d", config->difficulty);
+    log_event(LOG_DEBUG, "Easter eggs: %s", config->easter_eggs ? "ON" : "OFF");
+    if (config->event[0] != '\0') {
+        log_event(LOG_DEBUG, "Event: %s", config->event);
+    }
+    return ok;
 }
 
 // checks if specific log level bit is enabled
 bool is_logging_enabled(int level) {
-    return (g_log_level & level) != 0;
+    return (config_get()->log_level & level) != 0;
 }
 
 // log stuff with variable arguments
@@ -77,6 +79,10 @@ void log_event(int log_level, const char* format, ...) {
         return;
     }
     
+    // only time logs that actually print, disabled ones are just the check above
+    TRACE_SCOPE("log_event");
+    unsigned long long log_start = STATS_TIMER_START();
+    
     // figure out prefix for different logs
     const char* prefix = "";
     if (log_level & LOG_ERROR) prefix = "[ERROR] ";
@@ -93,158 +99,100 @@ void log_event(int log_level, const char* format, ...) {
     printf("\n"); // end line
     
     va_end(args);
+    STATS_TIMER_STOP(STAT_LOG_EVENT, log_start);
 }
 
 // this is where the real variadic fun happens!!
+// the args depend on the spell, this just unpacks them into a SpellCast
+// and the spell engine (spells.c) does the rest
 int cast_spell(Player* caster, Enemy* target, SpellType spell_type, ...) {
-    if (caster == NULL) {
-        log_event(LOG_ERROR, "Null caster trying to cast spell");
-        return 0;
-    }
-    
-    // only mages can cast spells duh
-    if (caster->playerClass != MAGE) {
-        printf("%s tries to cast a spell but isn't a mage! Nothing happens.\n", caster->name);
-        return 0;
-    }
+    SpellCast cast = { spell_type, 0, 0, 0.0f };
     
     va_list args;
     va_start(args, spell_type);
     
-    int damage = 0; // how much damage/healing
-    
     switch (spell_type) {
-        case FIRE_SPELL: {
-            // fire takes intensity (1-10) and burns for X turns
-            int intensity = va_arg(args, int);
-            int burn_turns = va_arg(args, int);
-            
-            // cap values cuz people will try to cheat
-            if (intensity < 1) intensity = 1;
-            if (intensity > 10) intensity = 10;
-            
-            damage = 5 + (intensity * 2);
-            
-            printf("%s casts FIREBALL (intensity: %d) at %s!\n", 
-                   caster->name, intensity, target->name);
-            printf("Flames burn for %d turns!\n", burn_turns);
-            
-            // easter egg for max intensity fire
-            if (g_enable_easter_eggs && intensity >= 10) {
-                printf("🔥🔥🔥 IT'S SUPER EFFECTIVE! 🔥🔥🔥\n");
-            }
-            
-            log_event(LOG_DEBUG, "Cast fire spell dmg=%d, burn=%d", damage, burn_turns);
+        case FIRE_SPELL:      // intensity, burn turns
+        case LIGHTNING_SPELL: // power, chain targets
+        case HEAL_SPELL:      // power, duration
+            cast.power = va_arg(args, int);
+            cast.extra = va_arg(args, int);
             break;
-        }
-        
-        case ICE_SPELL: {
-            // ice takes radius (area) and freeze chance
-            int radius = va_arg(args, int);
-            float freeze_chance = (float)va_arg(args, double); // doubles in varargs!
-            
-            damage = 3 + (radius * 3);
-            
-            printf("%s casts FROST NOVA (radius: %d, freeze: %.1f%%) at %s!\n", 
-                   caster->name, radius, freeze_chance * 100, target->name);
-                   
-            // easter egg for big ice spell
-            if (g_enable_easter_eggs && radius >= 5) {
-                printf("❄️❄️❄️ WINTER IS COMING! ❄️❄️❄️\n");
-            }
-            
-            log_event(LOG_DEBUG, "Cast ice spell dmg=%d, radius=%d, freeze=%.2f", 
-                     damage, radius, freeze_chance);
+        case ICE_SPELL:       // radius, freeze chance
+            cast.power = va_arg(args, int);
+            cast.chance = (float)va_arg(args, double); // doubles in varargs!
             break;
-        }
-        
-        case LIGHTNING_SPELL: {
-            // lightning takes power and number of chain targets
-            int power = va_arg(args, int);
-            int chain_targets = va_arg(args, int);
-            
-            damage = power * 4;
-            
-            printf("%s casts LIGHTNING BOLT (power: %d) at %s!\n", 
-                   caster->name, power, target->name);
-            printf("Lightning chains to %d additional targets!\n", chain_targets);
-            
-            // easter egg for high chain lightning
-            if (g_enable_easter_eggs && chain_targets >= 3) {
-                printf("⚡⚡⚡ UNLIMITED POWER! ⚡⚡⚡\n");
-            }
-            
-            log_event(LOG_DEBUG, "Cast lightning spell dmg=%d, chain=%d", 
-                     damage, chain_targets);
-            break;
-        }
-        
-        case HEAL_SPELL: {
-            // heal takes power and duration (hot)
-            int power = va_arg(args, int);
-            int duration = va_arg(args, int);
-            
-            // damage is actually healing for this one
-            damage = power * 5;
-            
-            printf("%s casts HEALING LIGHT (power: %d) on self!\n", caster->name, power);
-            printf("Healing continues for %d turns.\n", duration);
-            
-            // actually heal the player
-            caster->hp += damage;
-            if (caster->hp > caster->maxHp) {
-                caster->hp = caster->maxHp; // dont overheal
-            }
-            
-            // easter egg for big heals
-            if (g_enable_easter_eggs && power >= 5) {
-                printf("✨✨✨ WELLNESS INTENSIFIES! ✨✨✨\n");
-            }
-            
-            log_event(LOG_DEBUG, "Cast heal spell amount=%d, duration=%d", 
-                     damage, duration);
+        case RANDOM_SPELL:    // nothing
             break;
-        }
-        
-        case RANDOM_SPELL: {
-            // completely random spell with random effects lol
-            if (g_enable_easter_eggs) {
-                const char* random_effects[] = {
-                    "turns target into a sheep",
-                    "summons dancing skeletons",
-                    "creates a pizza out of thin air",
-                    "makes everything smell like elderberries",
-                    "plays elevator music from nowhere",
-                    "causes target to speak in rhymes",
-                    "changes gravity direction temporarily"
-                };
-                
-                int effect_index = rand() % (sizeof(random_effects) / sizeof(random_effects[0]));
-                damage = rand() % 15 + 1;
-                
-                printf("%s casts CHAOTIC MAGIC at %s!\n", caster->name, target->name);
-                printf("Random effect: %s\n", random_effects[effect_index]);
-                
-                log_event(LOG_FUNNY, "Random spell cast: %s (dmg=%d)", 
-                         random_effects[effect_index], damage);
-            } else {
-                printf("%s tries to cast random magic, but nothing interesting happens.\n", 
-                       caster->name);
-                damage = rand() % 5 + 1;
-            }
-            break;
-        }
     }
     
     va_end(args);
     
-    // apply difficulty modifier to damage
-    if (g_difficulty == 0) { // easy
-        damage = damage * 1.5; // 50% more damage
-    } else if (g_difficulty == 2) { // hard
-        damage = damage * 0.7; // 30% less damage
+    return cast_spell_typed(caster, target, &cast);
+}
+
+// Scanner state for one line (where it starts and its first comma)
+typedef struct {
+    char *line_start;
+    char *comma;
+    size_t lines;
+} ScanState;
+
+// handle one delimiter the scanner found at p
+static void scan_delimiter(ScanState *st, char *p, CsvLineCallback callback, void *ctx) {
+    if (*p == ',') {
+        // only the first comma splits key and value, names can have commas
+        if (st->comma == NULL) st->comma = p;
+        return;
     }
-    
-    // return damage dealt
-    return damage;
-} 
\ No newline at end of file
+
+    // newline = end of line
+    if (st->comma != NULL) {
+        *st->comma = '\0';
+        *p = '\0';
+        if (p > st->comma + 1 && p[-1] == '\r') p[-1] = '\0'; // windows line endings
+        callback(st->line_start, st->comma + 1, ctx);
+        st->lines++;
+    }
+    st->line_start = p + 1;
+    st->comma = NULL;
+}
+
+// Split a buffer into key,value lines
+size_t csv_scan_lines(char *buf, size_t len, CsvLineCallback callback, void *ctx) {
+    ScanState st = { buf, NULL, 0 };
+    size_t i = 0;
+
+#ifdef __SSE2__
+    // classify 16 bytes at once, then walk the set bits of the mask
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i comma = _mm_set1_epi8(',');
+    for (; i + 16 <= len; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(buf + i));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, newline), _mm_cmpeq_epi8(chunk, comma)));
+        while (mask != 0) {
+            int bit = __builtin_ctz(mask);
+            scan_delimiter(&st, buf + i + bit, callback, ctx);
+            mask &= mask - 1; // clear lowest bit
+        }
+    }
+#endif
+
+    // leftovers (or everything, without SSE2)
+    for (; i < len; i++) {
+        if (buf[i] == '\n' || buf[i] == ',') {
+            scan_delimiter(&st, buf + i, callback, ctx);
+        }
+    }
+
+    // last line might not have a newline
+    if (st.comma != NULL) {
+        *st.comma = '\0';
+        buf[len] = '\0'; // caller gives us len + 1 bytes
+        callback(st.line_start, st.comma + 1, ctx);
+        st.lines++;
+    }
+
+    return st.lines;
+}
@@ -4,6 +4,7 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "player.h"
 #include "enemy.h"
 
@@ -38,8 +39,10 @@ bool get_env_bool(const char* var_name, bool default_val);
 // variadic function for logging game events
 void log_event(int log_level, const char* format, ...);
 
-// environment variables setup function
-void setup_env_variables();
+// environment variables setup function, builds the config snapshot from
+// config_file (NULL = GAME_CONFIG), the environment and any config_set()
+// overrides, returns false if the config file couldnt be read
+bool setup_env_variables(const char *config_file);
 
 // variadic magic spell function (number of args depends on spell)
 int cast_spell(Player* caster, Enemy* target, SpellType spell_type, ...);
@@ -47,4 +50,13 @@ int cast_spell(Player* caster, Enemy* target, SpellType spell_type, ...);
 // check if logging is enabled for a specific level
 bool is_logging_enabled(int level);
 
+// callback for every key,value line the scanner finds
+// key and value are null terminated in place (the buffer gets modified)
+typedef void (*CsvLineCallback)(const char *key, const char *value, void *ctx);
+
+// split a buffer into key,value lines using vector compares where we can
+// buffer is modified in place (delimiters become '\0')
+// returns number of lines handed to the callback
+size_t csv_scan_lines(char *buf, size_t len, CsvLineCallback callback, void *ctx);
+
 #endif // UTILS_H 
\ No newline at end of file